@@ -40,62 +40,116 @@
 #include "cairo-error-private.h"
 #include "cairo-output-stream-private.h"
 
+#define BASE64_BUFFER_SIZE 4096
+
 typedef struct _cairo_base64_stream {
     cairo_output_stream_t base;
     cairo_output_stream_t *output;
     unsigned int in_mem;
-    unsigned int trailing;
     unsigned char src[3];
 } cairo_base64_stream_t;
 
 static char const base64_table[64] =
 "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
 
+#define LANES(x) ((uint64_t) (x) * ((((uint64_t) 0x01010101) << 32) | 0x01010101))
+
+#ifdef WORDS_BIGENDIAN
+#define LANE(bits, k) ((uint64_t) (bits) << (56 - 8 * (k)))
+#else
+#define LANE(bits, k) ((uint64_t) (bits) << (8 * (k)))
+#endif
+
+static void
+_base64_encode_3 (const unsigned char *src, unsigned char *dst)
+{
+    dst[0] = base64_table[src[0] >> 2];
+    dst[1] = base64_table[(src[0] & 0x03) << 4 | src[1] >> 4];
+    dst[2] = base64_table[(src[1] & 0x0f) << 2 | src[2] >> 6];
+    dst[3] = base64_table[src[2] & 0x3f];
+}
+
+/* Encode six bytes into eight digits using the eight bytes of a 64-bit
+ * word as lanes.  Each lane holds a 6-bit index which is mapped onto
+ * the alphabet by adding the offset of the range it falls into; the
+ * ranges are selected with per-lane comparisons, and since every
+ * intermediate value stays below 256 no carry crosses into the
+ * neighbouring lane.
+ */
+static void
+_base64_encode_6 (const unsigned char *src, unsigned char *dst)
+{
+    uint64_t bits, idx, chr;
+
+    bits = (uint64_t) src[0] << 40 | (uint64_t) src[1] << 32 |
+	   (uint64_t) src[2] << 24 | (uint64_t) src[3] << 16 |
+	   (uint64_t) src[4] << 8 | src[5];
+
+    idx = LANE ((bits >> 42) & 0x3f, 0) | LANE ((bits >> 36) & 0x3f, 1) |
+	  LANE ((bits >> 30) & 0x3f, 2) | LANE ((bits >> 24) & 0x3f, 3) |
+	  LANE ((bits >> 18) & 0x3f, 4) | LANE ((bits >> 12) & 0x3f, 5) |
+	  LANE ((bits >>  6) & 0x3f, 6) | LANE (bits & 0x3f, 7);
+
+    /* 'A'..'Z', 'a'..'z', '0'..'9', '+', '/' */
+    chr = idx + LANES ('A');
+    chr += (((idx + LANES (128 - 26)) >> 7) & LANES (1)) * ('a' - 'A' - 26);
+    chr -= (((idx + LANES (128 - 52)) >> 7) & LANES (1)) * ('a' + 26 - '0');
+    chr -= (((idx + LANES (128 - 62)) >> 7) & LANES (1)) * ('0' + 10 - '+');
+    chr += (((idx + LANES (128 - 63)) >> 7) & LANES (1)) * ('/' - '+' - 1);
+
+    memcpy (dst, &chr, 8);
+}
+
 static cairo_status_t
 _cairo_base64_stream_write (cairo_output_stream_t *base,
 			    const unsigned char	  *data,
 			    unsigned int	   length)
 {
     cairo_base64_stream_t * stream = (cairo_base64_stream_t *) base;
-    unsigned char *src = stream->src;
-    unsigned int i;
+    unsigned char buffer[BASE64_BUFFER_SIZE];
+    unsigned int i, n;
 
     if (stream->in_mem + length < 3) {
-	for (i = 0; i < length; i++) {
-	    src[i + stream->in_mem] = *data++;
-	}
+	for (i = 0; i < length; i++)
+	    stream->src[i + stream->in_mem] = *data++;
 	stream->in_mem += length;
 	return CAIRO_STATUS_SUCCESS;
     }
 
-    do {
-	unsigned char dst[4];
-
+    n = 0;
+    if (stream->in_mem) {
 	for (i = stream->in_mem; i < 3; i++) {
-	    src[i] = *data++;
+	    stream->src[i] = *data++;
 	    length--;
 	}
 	stream->in_mem = 0;
 
-	dst[0] = base64_table[src[0] >> 2];
-	dst[1] = base64_table[(src[0] & 0x03) << 4 | src[1] >> 4];
-	dst[2] = base64_table[(src[1] & 0x0f) << 2 | src[2] >> 6];
-	dst[3] = base64_table[src[2] & 0xfc >> 2];
-	/* Special case for the last missing bits */
-	switch (stream->trailing) {
-	    case 2:
-		dst[2] = '=';
-	    case 1:
-		dst[3] = '=';
-	    default:
-		break;
+	_base64_encode_3 (stream->src, buffer);
+	n = 4;
+    }
+
+    while (length >= 3) {
+	if (n + 8 > BASE64_BUFFER_SIZE) {
+	    _cairo_output_stream_write (stream->output, buffer, n);
+	    n = 0;
 	}
-	_cairo_output_stream_write (stream->output, dst, 4);
-    } while (length >= 3);
 
-    for (i = 0; i < length; i++) {
-	src[i] = *data++;
+	if (length >= 6) {
+	    _base64_encode_6 (data, buffer + n);
+	    data += 6;
+	    length -= 6;
+	    n += 8;
+	} else {
+	    _base64_encode_3 (data, buffer + n);
+	    data += 3;
+	    length -= 3;
+	    n += 4;
+	}
     }
+    _cairo_output_stream_write (stream->output, buffer, n);
+
+    for (i = 0; i < length; i++)
+	stream->src[i] = *data++;
     stream->in_mem = length;
 
     return _cairo_output_stream_get_status (stream->output);
@@ -105,16 +159,21 @@ static cairo_status_t
 _cairo_base64_stream_close (cairo_output_stream_t *base)
 {
     cairo_base64_stream_t *stream = (cairo_base64_stream_t *) base;
-    cairo_status_t status = CAIRO_STATUS_SUCCESS;
+    unsigned char dst[4];
 
     if (stream->in_mem > 0) {
 	memset (stream->src + stream->in_mem, 0, 3 - stream->in_mem);
-	stream->trailing = 3 - stream->in_mem;
-	stream->in_mem = 3;
-	status = _cairo_base64_stream_write (base, NULL, 0);
+	_base64_encode_3 (stream->src, dst);
+
+	/* Special case for the last missing bits */
+	dst[3] = '=';
+	if (stream->in_mem == 1)
+	    dst[2] = '=';
+
+	_cairo_output_stream_write (stream->output, dst, 4);
     }
 
-    return status;
+    return _cairo_output_stream_get_status (stream->output);
 }
 
 cairo_output_stream_t *
@@ -138,7 +197,6 @@ _cairo_base64_stream_create (cairo_output_stream_t *output)
 
     stream->output = output;
     stream->in_mem = 0;
-    stream->trailing = 0;
 
     return &stream->base;
 }
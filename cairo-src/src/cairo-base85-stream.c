@@ -38,6 +38,8 @@
 #include "cairo-error-private.h"
 #include "cairo-output-stream-private.h"
 
+#define BASE85_BUFFER_SIZE 4096
+
 typedef struct _cairo_base85_stream {
     cairo_output_stream_t base;
     cairo_output_stream_t *output;
@@ -46,47 +48,74 @@ typedef struct _cairo_base85_stream {
 } cairo_base85_stream_t;
 
 static void
-_expand_four_tuple_to_five (unsigned char four_tuple[4],
-			    unsigned char five_tuple[5],
-			    cairo_bool_t *all_zero)
+_expand_four_tuple_to_five (const unsigned char four_tuple[4],
+			    unsigned char five_tuple[5])
 {
     uint32_t value;
-    int digit, i;
+    int i;
 
-    value = four_tuple[0] << 24 | four_tuple[1] << 16 | four_tuple[2] << 8 | four_tuple[3];
-    if (all_zero)
-	*all_zero = TRUE;
+    value = (uint32_t) four_tuple[0] << 24 | four_tuple[1] << 16 | four_tuple[2] << 8 | four_tuple[3];
     for (i = 0; i < 5; i++) {
-	digit = value % 85;
-	if (digit != 0 && all_zero)
-	    *all_zero = FALSE;
-	five_tuple[4-i] = digit + 33;
+	five_tuple[4-i] = value % 85 + 33;
 	value = value / 85;
     }
 }
 
+/* Encodes a four-tuple into dst, returning the number of digits
+ * written: a single 'z' stands for a tuple of zeros. */
+static unsigned int
+_encode_four_tuple (const unsigned char four_tuple[4],
+		    unsigned char *dst)
+{
+    if ((four_tuple[0] | four_tuple[1] | four_tuple[2] | four_tuple[3]) == 0) {
+	dst[0] = 'z';
+	return 1;
+    }
+
+    _expand_four_tuple_to_five (four_tuple, dst);
+    return 5;
+}
+
 static cairo_status_t
 _cairo_base85_stream_write (cairo_output_stream_t *base,
 			    const unsigned char	  *data,
 			    unsigned int	   length)
 {
     cairo_base85_stream_t *stream = (cairo_base85_stream_t *) base;
-    const unsigned char *ptr = data;
-    unsigned char five_tuple[5];
-    cairo_bool_t is_zero;
-
-    while (length) {
-	stream->four_tuple[stream->pending++] = *ptr++;
-	length--;
-	if (stream->pending == 4) {
-	    _expand_four_tuple_to_five (stream->four_tuple, five_tuple, &is_zero);
-	    if (is_zero)
-		_cairo_output_stream_write (stream->output, "z", 1);
-	    else
-		_cairo_output_stream_write (stream->output, five_tuple, 5);
-	    stream->pending = 0;
+    unsigned char buffer[BASE85_BUFFER_SIZE];
+    unsigned int n;
+
+    if (stream->pending + length < 4) {
+	while (length--)
+	    stream->four_tuple[stream->pending++] = *data++;
+	return CAIRO_STATUS_SUCCESS;
+    }
+
+    n = 0;
+    if (stream->pending) {
+	while (stream->pending < 4) {
+	    stream->four_tuple[stream->pending++] = *data++;
+	    length--;
+	}
+	stream->pending = 0;
+
+	n = _encode_four_tuple (stream->four_tuple, buffer);
+    }
+
+    while (length >= 4) {
+	if (n + 5 > BASE85_BUFFER_SIZE) {
+	    _cairo_output_stream_write (stream->output, buffer, n);
+	    n = 0;
 	}
+
+	n += _encode_four_tuple (data, buffer + n);
+	data += 4;
+	length -= 4;
     }
+    _cairo_output_stream_write (stream->output, buffer, n);
+
+    while (length--)
+	stream->four_tuple[stream->pending++] = *data++;
 
     return _cairo_output_stream_get_status (stream->output);
 }
@@ -99,7 +128,7 @@ _cairo_base85_stream_close (cairo_output_stream_t *base)
 
     if (stream->pending) {
 	memset (stream->four_tuple + stream->pending, 0, 4 - stream->pending);
-	_expand_four_tuple_to_five (stream->four_tuple, five_tuple, NULL);
+	_expand_four_tuple_to_five (stream->four_tuple, five_tuple);
 	_cairo_output_stream_write (stream->output, five_tuple, stream->pending + 1);
     }
 
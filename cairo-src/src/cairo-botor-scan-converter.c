@@ -346,8 +346,19 @@ edges_compare_x_for_y_general (const cairo_edge_t *a,
 	    bdx_ady = _cairo_int32x32_64_mul (bdx, ady);
 
 	    return _cairo_int64_cmp (adx_bdy, bdx_ady);
-	} else
+	} else {
+	    int sign;
+
+	    if (_cairo_filtered_sign (0.,
+				      (double) adx * bdy * (y - a->line.p1.y),
+				      (double) bdx * ady * (y - b->line.p1.y),
+				      &sign))
+	    {
+		return sign;
+	    }
+
 	    return _cairo_int128_cmp (A, B);
+	}
     case HAVE_DX_ADX:
 	/* A_dy * (A_x - B_x) ∘ - (Y - A_y) * A_dx */
 	if ((-adx ^ dx) < 0) {
@@ -374,6 +385,17 @@ edges_compare_x_for_y_general (const cairo_edge_t *a,
 	}
     case HAVE_ALL:
 	/* XXX try comparing (a->line.p2.x - b->line.p2.x) et al */
+	{
+	    int sign;
+
+	    if (_cairo_filtered_sign ((double) ady * bdy * dx,
+				      (double) adx * bdy * (y - a->line.p1.y),
+				      (double) bdx * ady * (y - b->line.p1.y),
+				      &sign))
+	    {
+		return sign;
+	    }
+	}
 	return _cairo_int128_cmp (L, _cairo_int128_sub (B, A));
     }
 #undef B
@@ -46,7 +46,8 @@ extern const cairo_private cairo_rectangle_list_t _cairo_rectangles_nil;
 enum {
     CAIRO_CLIP_PATH_HAS_REGION = 0x1,
     CAIRO_CLIP_PATH_REGION_IS_UNSUPPORTED = 0x2,
-    CAIRO_CLIP_PATH_IS_BOX = 0x4
+    CAIRO_CLIP_PATH_IS_BOX = 0x4,
+    CAIRO_CLIP_PATH_IS_BAND = 0x8
 };
 
 struct _cairo_clip_path {
@@ -84,6 +85,10 @@ _cairo_clip_init_copy_transformed (cairo_clip_t    *clip,
 				   cairo_clip_t    *other,
 				   const cairo_matrix_t *matrix);
 
+cairo_private cairo_status_t
+_cairo_clip_init_deep_copy (cairo_clip_t *clip,
+			    cairo_clip_t *other);
+
 cairo_private void
 _cairo_clip_reset (cairo_clip_t *clip);
 
@@ -40,6 +40,7 @@
  */
 
 #include "cairoint.h"
+#include "cairo-cache-private.h"
 #include "cairo-clip-private.h"
 #include "cairo-error-private.h"
 #include "cairo-freed-pool-private.h"
@@ -47,6 +48,7 @@
 #include "cairo-path-fixed-private.h"
 #include "cairo-composite-rectangles-private.h"
 #include "cairo-region-private.h"
+#include "cairo-thread-cache-private.h"
 
 #if HAS_FREED_POOL
 static freed_pool_t clip_path_pool;
@@ -512,6 +514,45 @@ _cairo_clip_init_copy_transformed (cairo_clip_t    *clip,
     return status;
 }
 
+/* Copies @other into a fresh chain of clip paths that shares no
+ * mutable state with the original, so that the copy may be used (and
+ * its caches populated) on another thread while the original remains
+ * in use. The cached clip surfaces are not carried over, as those are
+ * handed to the backends by reference.
+ */
+cairo_status_t
+_cairo_clip_init_deep_copy (cairo_clip_t *clip,
+			    cairo_clip_t *other)
+{
+    cairo_clip_path_t *clip_path;
+    cairo_status_t status;
+
+    _cairo_clip_init (clip);
+
+    if (other->all_clipped) {
+	clip->all_clipped = TRUE;
+	return CAIRO_STATUS_SUCCESS;
+    }
+
+    if (other->path == NULL)
+	return CAIRO_STATUS_SUCCESS;
+
+    status = _cairo_clip_path_reapply_clip_path_translate (clip,
+							   other->path,
+							   0, 0);
+    if (unlikely (status)) {
+	_cairo_clip_reset (clip);
+	return status;
+    }
+
+    for (clip_path = clip->path; clip_path != NULL; clip_path = clip_path->prev) {
+	cairo_surface_destroy (clip_path->surface);
+	clip_path->surface = NULL;
+    }
+
+    return CAIRO_STATUS_SUCCESS;
+}
+
 static cairo_status_t
 _cairo_clip_apply_clip_path (cairo_clip_t *clip,
 			     const cairo_clip_path_t *path)
@@ -948,13 +989,325 @@ _cairo_clip_path_to_boxes (cairo_clip_path_t *clip_path,
     return CAIRO_STATUS_SUCCESS;
 }
 
+/* Clip masks are expensive to rasterise yet the same clip, a rounded
+ * rectangle around a widget say, tends to be rebuilt for every frame by
+ * a fresh context.  Masks rendered into image surfaces are therefore
+ * remembered by the geometry of the clip paths that produced them, and
+ * stored compressed as per-row runs of constant coverage whenever that
+ * is smaller than the raw A8 pixels.  Every hit is decoded into a new
+ * surface, so no pixman image is ever shared between contexts.  The
+ * cache is kept per thread, so that concurrent renderers never wait
+ * upon one another; see cairo-thread-cache-private.h.
+ */
+
+#define CLIP_MASK_CACHE_MAX_SIZE (4 << 20)
+#define CLIP_MASK_MAX_PATHS 8
+
+typedef struct _cairo_clip_mask_path {
+    const cairo_path_fixed_t *path;
+    cairo_fill_rule_t fill_rule;
+    double tolerance;
+    cairo_antialias_t antialias;
+} cairo_clip_mask_path_t;
+
+typedef struct _cairo_clip_mask {
+    cairo_cache_entry_t cache_entry;
+
+    cairo_rectangle_int_t extents;
+    int num_paths;
+    cairo_clip_mask_path_t paths[CLIP_MASK_MAX_PATHS];
+
+    /* only set for entries owned by the cache */
+    cairo_path_fixed_t *path_copies;
+    cairo_bool_t is_rle;
+    unsigned long length;
+    uint8_t *data;
+} cairo_clip_mask_t;
+
+static cairo_bool_t
+_cairo_clip_mask_equal (const void *A, const void *B)
+{
+    const cairo_clip_mask_t *a = A, *b = B;
+    int n;
+
+    if (a->num_paths != b->num_paths)
+	return FALSE;
+
+    if (a->extents.x != b->extents.x ||
+	a->extents.y != b->extents.y ||
+	a->extents.width  != b->extents.width ||
+	a->extents.height != b->extents.height)
+    {
+	return FALSE;
+    }
+
+    for (n = 0; n < a->num_paths; n++) {
+	if (a->paths[n].fill_rule != b->paths[n].fill_rule ||
+	    a->paths[n].tolerance != b->paths[n].tolerance ||
+	    a->paths[n].antialias != b->paths[n].antialias)
+	{
+	    return FALSE;
+	}
+
+	if (! _cairo_path_fixed_equal (a->paths[n].path, b->paths[n].path))
+	    return FALSE;
+    }
+
+    return TRUE;
+}
+
+static void
+_cairo_clip_mask_destroy (void *entry)
+{
+    cairo_clip_mask_t *mask = entry;
+    int n;
+
+    for (n = 0; n < mask->num_paths; n++)
+	_cairo_path_fixed_fini (&mask->path_copies[n]);
+    free (mask);
+}
+
+static cairo_status_t
+_cairo_clip_mask_cache_init (void *cache)
+{
+    return _cairo_cache_init (cache,
+			      _cairo_clip_mask_equal,
+			      NULL,
+			      _cairo_clip_mask_destroy,
+			      CLIP_MASK_CACHE_MAX_SIZE);
+}
+
+/* Hands @mask over to @cache, unless the cache already holds an equal
+ * mask. */
+static cairo_bool_t
+_cairo_clip_mask_cache_insert (cairo_cache_t *cache,
+			       cairo_clip_mask_t *mask)
+{
+    if (_cairo_cache_lookup (cache, &mask->cache_entry) != NULL)
+	return FALSE;
+
+    return _cairo_cache_insert (cache, &mask->cache_entry) == CAIRO_STATUS_SUCCESS;
+}
+
+static void
+_cairo_clip_mask_cache_fini (void *cache)
+{
+    _cairo_cache_fini (cache);
+}
+
+static cairo_thread_cache_t _cairo_clip_mask_cache =
+    CAIRO_THREAD_CACHE_INIT (CAIRO_THREAD_CACHE_CLIP_MASK,
+			     cairo_cache_t,
+			     _cairo_clip_mask_cache_init,
+			     _cairo_clip_mask_cache_fini,
+			     _cairo_clip_mask_cache_mutex);
+
+/* Describes the mask that _cairo_clip_path_get_surface() would render
+ * for @clip_path, or returns FALSE if the chain is too long to key.
+ * Pixel-aligned boxes only restrict the extents and so are not part of
+ * the key.
+ */
+static cairo_bool_t
+_cairo_clip_mask_init_key (cairo_clip_mask_t *key,
+			   cairo_clip_path_t *clip_path)
+{
+    unsigned long hash = _CAIRO_HASH_INIT_VALUE;
+
+    key->extents = clip_path->extents;
+    key->num_paths = 0;
+    key->path_copies = NULL;
+
+    hash = _cairo_hash_bytes (hash, &key->extents, sizeof (key->extents));
+    do {
+	cairo_clip_mask_path_t *path;
+
+	if (clip_path->flags & CAIRO_CLIP_PATH_IS_BOX &&
+	    clip_path->path.maybe_fill_region)
+	{
+	    continue;
+	}
+
+	if (key->num_paths == CLIP_MASK_MAX_PATHS)
+	    return FALSE;
+
+	path = &key->paths[key->num_paths++];
+	path->path = &clip_path->path;
+	path->fill_rule = clip_path->fill_rule;
+	path->tolerance = clip_path->tolerance;
+	path->antialias = clip_path->antialias;
+
+	hash = _cairo_hash_bytes (hash, &path->fill_rule, sizeof (path->fill_rule));
+	hash = _cairo_hash_bytes (hash, &path->tolerance, sizeof (path->tolerance));
+	hash = _cairo_hash_bytes (hash, &path->antialias, sizeof (path->antialias));
+	hash ^= _cairo_path_fixed_hash (path->path);
+	hash *= 31;
+    } while ((clip_path = clip_path->prev) != NULL);
+
+    key->cache_entry.hash = hash;
+    return TRUE;
+}
+
+static void
+_cairo_clip_mask_unpack (const cairo_clip_mask_t *mask,
+			 cairo_image_surface_t *image)
+{
+    const uint8_t *src;
+    uint8_t *row;
+    int y;
+
+    src = mask->data;
+    row = image->data;
+    for (y = 0; y < image->height; y++) {
+	if (mask->is_rle) {
+	    int x = 0;
+
+	    while (x < image->width) {
+		memset (row + x, src[1], src[0]);
+		x += src[0];
+		src += 2;
+	    }
+	} else {
+	    memcpy (row, src, image->width);
+	    src += image->width;
+	}
+	row += image->stride;
+    }
+
+    image->base.is_clear = FALSE;
+}
+
+static cairo_bool_t
+_cairo_clip_mask_cache_lookup (cairo_clip_mask_t *key,
+			       cairo_image_surface_t *image)
+{
+    cairo_clip_mask_t *mask;
+    cairo_cache_t *cache;
+
+    cache = _cairo_thread_cache_get (&_cairo_clip_mask_cache);
+    if (unlikely (cache == NULL))
+	return FALSE;
+
+    mask = _cairo_cache_lookup (cache, &key->cache_entry);
+    if (mask != NULL)
+	_cairo_clip_mask_unpack (mask, image);
+    _cairo_thread_cache_put (&_cairo_clip_mask_cache, cache);
+
+    return mask != NULL;
+}
+
+static unsigned long
+_cairo_clip_mask_rle_length (const cairo_image_surface_t *image)
+{
+    const uint8_t *row = image->data;
+    unsigned long length = 0;
+    int x, y;
+
+    for (y = 0; y < image->height; y++) {
+	int run = 0;
+
+	for (x = 0; x < image->width; x++) {
+	    if (run == 0 || run == 255 || row[x] != row[x-1]) {
+		length += 2;
+		run = 0;
+	    }
+	    run++;
+	}
+	row += image->stride;
+    }
+
+    return length;
+}
+
+static void
+_cairo_clip_mask_cache_add (const cairo_clip_mask_t *key,
+			    cairo_image_surface_t *image)
+{
+    cairo_clip_mask_t *mask;
+    unsigned long raw_length, rle_length, size;
+    const uint8_t *row;
+    uint8_t *dst;
+    cairo_status_t status;
+    cairo_cache_t *cache;
+    int n, x, y;
+
+    raw_length = (unsigned long) image->width * image->height;
+    if (raw_length > CLIP_MASK_CACHE_MAX_SIZE / 4)
+	return;
+
+    rle_length = _cairo_clip_mask_rle_length (image);
+
+    mask = malloc (sizeof (cairo_clip_mask_t) +
+		   key->num_paths * sizeof (cairo_path_fixed_t) +
+		   MIN (raw_length, rle_length));
+    if (unlikely (mask == NULL))
+	return;
+
+    *mask = *key;
+    mask->path_copies = (cairo_path_fixed_t *) (mask + 1);
+    mask->is_rle = rle_length < raw_length;
+    mask->length = MIN (raw_length, rle_length);
+    mask->data = (uint8_t *) (mask->path_copies + key->num_paths);
+
+    size = sizeof (cairo_clip_mask_t) + mask->length;
+    for (n = 0; n < key->num_paths; n++) {
+	status = _cairo_path_fixed_init_copy (&mask->path_copies[n],
+					      key->paths[n].path);
+	if (unlikely (status)) {
+	    mask->num_paths = n;
+	    _cairo_clip_mask_destroy (mask);
+	    return;
+	}
+
+	mask->paths[n].path = &mask->path_copies[n];
+	size += sizeof (cairo_path_fixed_t) +
+		_cairo_path_fixed_size (&mask->path_copies[n]);
+    }
+    mask->cache_entry.size = size;
+
+    row = image->data;
+    dst = mask->data;
+    for (y = 0; y < image->height; y++) {
+	if (mask->is_rle) {
+	    for (x = 0; x < image->width; ) {
+		int run = 1;
+
+		while (run < 255 &&
+		       x + run < image->width &&
+		       row[x + run] == row[x])
+		{
+		    run++;
+		}
+
+		*dst++ = run;
+		*dst++ = row[x];
+		x += run;
+	    }
+	} else {
+	    memcpy (dst, row, image->width);
+	    dst += image->width;
+	}
+	row += image->stride;
+    }
+
+    cache = _cairo_thread_cache_get (&_cairo_clip_mask_cache);
+    if (likely (cache != NULL)) {
+	if (_cairo_clip_mask_cache_insert (cache, mask))
+	    mask = NULL;
+	_cairo_thread_cache_put (&_cairo_clip_mask_cache, cache);
+    }
+
+    if (mask != NULL)
+	_cairo_clip_mask_destroy (mask);
+}
+
 static cairo_surface_t *
 _cairo_clip_path_get_surface (cairo_clip_path_t *clip_path,
 			      cairo_surface_t *target,
 			      int *tx, int *ty)
 {
     const cairo_rectangle_int_t *clip_extents = &clip_path->extents;
-    cairo_bool_t need_translate;
+    cairo_bool_t need_translate, use_cache;
+    cairo_clip_mask_t key;
     cairo_surface_t *surface;
     cairo_clip_path_t *prev;
     cairo_status_t status;
@@ -987,6 +1340,15 @@ _cairo_clip_path_get_surface (cairo_clip_path_t *clip_path,
     if (unlikely (surface->status))
 	return surface;
 
+    use_cache = _cairo_surface_is_image (surface) &&
+	((cairo_image_surface_t *) surface)->format == CAIRO_FORMAT_A8 &&
+	_cairo_clip_mask_init_key (&key, clip_path);
+    if (use_cache &&
+	_cairo_clip_mask_cache_lookup (&key, (cairo_image_surface_t *) surface))
+    {
+	goto DONE;
+    }
+
     need_translate = clip_extents->x | clip_extents->y;
     if (clip_path->flags & CAIRO_CLIP_PATH_IS_BOX &&
 	clip_path->path.maybe_fill_region)
@@ -1094,6 +1456,10 @@ _cairo_clip_path_get_surface (cairo_clip_path_t *clip_path,
 	prev = prev->prev;
     }
 
+    if (use_cache)
+	_cairo_clip_mask_cache_add (&key, (cairo_image_surface_t *) surface);
+
+  DONE:
     *tx = clip_extents->x;
     *ty = clip_extents->y;
     cairo_surface_destroy (clip_path->surface);
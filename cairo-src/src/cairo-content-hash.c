@@ -0,0 +1,398 @@
+/* cairo - a vector graphics library with display and print output
+ *
+ * Copyright © 2010 the cairo graphics library authors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it either under the terms of the GNU Lesser General Public
+ * License version 2.1 as published by the Free Software Foundation
+ * (the "LGPL") or, at your option, under the terms of the Mozilla
+ * Public License Version 1.1 (the "MPL"). If you do not alter this
+ * notice, a recipient may use your version of this file under either
+ * the MPL or the LGPL.
+ *
+ * You should have received a copy of the LGPL along with this library
+ * in the file COPYING-LGPL-2.1; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA 02110-1335, USA
+ * You should have received a copy of the MPL along with this library
+ * in the file COPYING-MPL-1.1
+ *
+ * The contents of this file are subject to the Mozilla Public License
+ * Version 1.1 (the "License"); you may not use this file except in
+ * compliance with the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY
+ * OF ANY KIND, either express or implied. See the LGPL or the MPL for
+ * the specific language governing rights and limitations.
+ *
+ * The Original Code is the cairo graphics library.
+ */
+
+/* Hashes of what a surface looks like, rather than of which surface it
+ * is, so that separately created copies of the same image or drawing
+ * can be recognised. The hashes are 64 bits wide so that, barring
+ * deliberately crafted input, equal hashes can be taken to mean equal
+ * content.
+ */
+
+#include "cairoint.h"
+
+#include "cairo-error-private.h"
+#include "cairo-path-fixed-private.h"
+#include "cairo-recording-surface-private.h"
+#include "cairo-scaled-font-private.h"
+#include "cairo-surface-snapshot-private.h"
+#include "cairo-surface-subsurface-private.h"
+
+#define HASH_M ((((uint64_t) 0xc6a4a793) << 32) | 0x5bd1e995)
+
+/* MurmurHash64A, chained through @hash */
+static uint64_t
+_hash_bytes (uint64_t hash, const void *ptr, unsigned long length)
+{
+    const uint8_t *bytes = ptr;
+    uint64_t k;
+
+    hash ^= length * HASH_M;
+
+    while (length >= 8) {
+	memcpy (&k, bytes, 8);
+	k *= HASH_M;
+	k ^= k >> 47;
+	k *= HASH_M;
+
+	hash ^= k;
+	hash *= HASH_M;
+
+	bytes += 8;
+	length -= 8;
+    }
+
+    if (length) {
+	k = 0;
+	memcpy (&k, bytes, length);
+	hash ^= k;
+	hash *= HASH_M;
+    }
+
+    hash ^= hash >> 47;
+    hash *= HASH_M;
+    hash ^= hash >> 47;
+
+    return hash;
+}
+
+#define HASH(hash, v) _hash_bytes (hash, &(v), sizeof (v))
+
+static cairo_status_t
+_hash_surface (uint64_t *hash, cairo_surface_t *surface);
+
+static uint64_t
+_hash_path (uint64_t hash, const cairo_path_fixed_t *path)
+{
+    const cairo_path_buf_t *buf = &path->buf.base;
+
+    do {
+	hash = _hash_bytes (hash, buf->op,
+			    buf->num_ops * sizeof (buf->op[0]));
+	hash = _hash_bytes (hash, buf->points,
+			    buf->num_points * sizeof (buf->points[0]));
+
+	buf = cairo_list_entry (buf->link.next, cairo_path_buf_t, link);
+    } while (buf != &path->buf.base);
+
+    return hash;
+}
+
+static uint64_t
+_hash_clip (uint64_t hash, const cairo_clip_t *clip)
+{
+    const cairo_clip_path_t *clip_path;
+
+    hash = HASH (hash, clip->all_clipped);
+    for (clip_path = clip->path; clip_path != NULL; clip_path = clip_path->prev) {
+	hash = _hash_path (hash, &clip_path->path);
+	hash = HASH (hash, clip_path->fill_rule);
+	hash = HASH (hash, clip_path->tolerance);
+	hash = HASH (hash, clip_path->antialias);
+    }
+
+    return hash;
+}
+
+static uint64_t
+_hash_stroke_style (uint64_t hash, const cairo_stroke_style_t *style)
+{
+    hash = HASH (hash, style->line_width);
+    hash = HASH (hash, style->line_cap);
+    hash = HASH (hash, style->line_join);
+    hash = HASH (hash, style->miter_limit);
+    hash = HASH (hash, style->dash_offset);
+    return _hash_bytes (hash, style->dash,
+			style->num_dashes * sizeof (style->dash[0]));
+}
+
+/* Scaled fonts are told apart by their face, which is identified by
+ * address, and by their key parameters. */
+static uint64_t
+_hash_scaled_font (uint64_t hash, const cairo_scaled_font_t *scaled_font)
+{
+    unsigned long options;
+
+    options = cairo_font_options_hash (&scaled_font->options);
+
+    hash = HASH (hash, scaled_font->font_face);
+    hash = HASH (hash, scaled_font->font_matrix);
+    hash = HASH (hash, scaled_font->ctm);
+    return HASH (hash, options);
+}
+
+static cairo_status_t
+_hash_pattern (uint64_t *hash, const cairo_pattern_t *pattern)
+{
+    const cairo_gradient_pattern_t *gradient;
+    unsigned int n;
+
+    *hash = HASH (*hash, pattern->type);
+    if (pattern->type != CAIRO_PATTERN_TYPE_SOLID) {
+	*hash = HASH (*hash, pattern->matrix);
+	*hash = HASH (*hash, pattern->filter);
+	*hash = HASH (*hash, pattern->extend);
+	*hash = HASH (*hash, pattern->has_component_alpha);
+    }
+
+    switch (pattern->type) {
+    case CAIRO_PATTERN_TYPE_SOLID:
+	*hash = HASH (*hash, ((cairo_solid_pattern_t *) pattern)->color);
+	return CAIRO_STATUS_SUCCESS;
+
+    case CAIRO_PATTERN_TYPE_LINEAR:
+	*hash = HASH (*hash, ((cairo_linear_pattern_t *) pattern)->p1);
+	*hash = HASH (*hash, ((cairo_linear_pattern_t *) pattern)->p2);
+	break;
+
+    case CAIRO_PATTERN_TYPE_RADIAL:
+	*hash = HASH (*hash, ((cairo_radial_pattern_t *) pattern)->c1);
+	*hash = HASH (*hash, ((cairo_radial_pattern_t *) pattern)->r1);
+	*hash = HASH (*hash, ((cairo_radial_pattern_t *) pattern)->c2);
+	*hash = HASH (*hash, ((cairo_radial_pattern_t *) pattern)->r2);
+	break;
+
+    case CAIRO_PATTERN_TYPE_SURFACE:
+	return _hash_surface (hash, ((cairo_surface_pattern_t *) pattern)->surface);
+
+    default:
+	ASSERT_NOT_REACHED;
+	return CAIRO_STATUS_SUCCESS;
+    }
+
+    gradient = (cairo_gradient_pattern_t *) pattern;
+    *hash = HASH (*hash, gradient->n_stops);
+    for (n = 0; n < gradient->n_stops; n++) {
+	*hash = HASH (*hash, gradient->stops[n].offset);
+	*hash = HASH (*hash, gradient->stops[n].color);
+    }
+
+    return CAIRO_STATUS_SUCCESS;
+}
+
+/* The commands are hashed together with what they draw with, but not
+ * with the results of any earlier analysis of them. */
+static cairo_status_t
+_hash_recording (uint64_t *hash, cairo_recording_surface_t *recording)
+{
+    cairo_command_t **elements;
+    cairo_status_t status;
+    int i, num_elements;
+
+    *hash = HASH (*hash, recording->content);
+    *hash = HASH (*hash, recording->unbounded);
+    *hash = HASH (*hash, recording->extents_pixels);
+    *hash = _hash_clip (*hash, &recording->clip);
+
+    num_elements = recording->commands.num_elements;
+    elements = _cairo_array_index (&recording->commands, 0);
+    for (i = 0; i < num_elements; i++) {
+	cairo_command_t *command = elements[i];
+
+	*hash = HASH (*hash, command->header.type);
+	*hash = HASH (*hash, command->header.op);
+	*hash = _hash_clip (*hash, &command->header.clip);
+
+	switch (command->header.type) {
+	case CAIRO_COMMAND_PAINT:
+	    status = _hash_pattern (hash, command->paint.source);
+	    break;
+
+	case CAIRO_COMMAND_MASK:
+	    status = _hash_pattern (hash, command->mask.source);
+	    if (likely (status == CAIRO_STATUS_SUCCESS))
+		status = _hash_pattern (hash, command->mask.mask);
+	    break;
+
+	case CAIRO_COMMAND_STROKE:
+	    *hash = _hash_path (*hash, command->stroke.path);
+	    *hash = _hash_stroke_style (*hash, command->stroke.style);
+	    *hash = HASH (*hash, command->stroke.ctm);
+	    *hash = HASH (*hash, command->stroke.tolerance);
+	    *hash = HASH (*hash, command->stroke.antialias);
+	    status = _hash_pattern (hash, command->stroke.source);
+	    break;
+
+	case CAIRO_COMMAND_FILL:
+	    *hash = _hash_path (*hash, command->fill.path);
+	    *hash = HASH (*hash, command->fill.fill_rule);
+	    *hash = HASH (*hash, command->fill.tolerance);
+	    *hash = HASH (*hash, command->fill.antialias);
+	    status = _hash_pattern (hash, command->fill.source);
+	    break;
+
+	case CAIRO_COMMAND_SHOW_TEXT_GLYPHS:
+	    *hash = _hash_bytes (*hash,
+				 command->show_text_glyphs.utf8,
+				 command->show_text_glyphs.utf8_len);
+	    *hash = _hash_bytes (*hash,
+				 command->show_text_glyphs.glyphs,
+				 command->show_text_glyphs.num_glyphs *
+				 sizeof (cairo_glyph_t));
+	    *hash = _hash_bytes (*hash,
+				 command->show_text_glyphs.clusters,
+				 command->show_text_glyphs.num_clusters *
+				 sizeof (cairo_text_cluster_t));
+	    *hash = HASH (*hash, command->show_text_glyphs.cluster_flags);
+	    *hash = _hash_scaled_font (*hash,
+				       command->show_text_glyphs.scaled_font);
+	    status = _hash_pattern (hash, command->show_text_glyphs.source);
+	    break;
+
+	default:
+	    ASSERT_NOT_REACHED;
+	    status = CAIRO_STATUS_SUCCESS;
+	}
+
+	if (unlikely (status))
+	    return status;
+    }
+
+    return CAIRO_STATUS_SUCCESS;
+}
+
+static uint64_t
+_hash_image (uint64_t hash, const cairo_image_surface_t *image)
+{
+    int row_length, y;
+
+    hash = HASH (hash, image->pixman_format);
+    hash = HASH (hash, image->width);
+    hash = HASH (hash, image->height);
+
+    row_length = (image->width * PIXMAN_FORMAT_BPP (image->pixman_format) + 7) / 8;
+    for (y = 0; y < image->height; y++)
+	hash = _hash_bytes (hash, image->data + y * image->stride, row_length);
+
+    return hash;
+}
+
+/* Mime data is hashed as well as the pixels, as a backend may embed
+ * the former instead of the latter. */
+static uint64_t
+_hash_mime_data (uint64_t hash, cairo_surface_t *surface)
+{
+    static const char *mime_types[] = {
+	CAIRO_MIME_TYPE_JPEG,
+	CAIRO_MIME_TYPE_PNG,
+	CAIRO_MIME_TYPE_JP2,
+	CAIRO_MIME_TYPE_URI,
+    };
+    const unsigned char *data;
+    unsigned long length;
+    unsigned int i;
+
+    for (i = 0; i < ARRAY_LENGTH (mime_types); i++) {
+	cairo_surface_get_mime_data (surface, mime_types[i], &data, &length);
+	if (data != NULL) {
+	    hash = _hash_bytes (hash, mime_types[i], strlen (mime_types[i]));
+	    hash = _hash_bytes (hash, data, length);
+	}
+    }
+
+    return hash;
+}
+
+static cairo_status_t
+_hash_surface (uint64_t *hash, cairo_surface_t *surface)
+{
+    cairo_image_surface_t *image;
+    void *image_extra;
+    cairo_status_t status;
+
+    if (surface->type == CAIRO_SURFACE_TYPE_RECORDING) {
+	if (surface->backend->type ==
+	    (cairo_surface_type_t) CAIRO_INTERNAL_SURFACE_TYPE_SNAPSHOT)
+	{
+	    surface = _cairo_surface_snapshot_get_target (surface);
+	}
+
+	if (surface->backend->type == CAIRO_SURFACE_TYPE_SUBSURFACE) {
+	    cairo_surface_subsurface_t *sub = (cairo_surface_subsurface_t *) surface;
+
+	    *hash = HASH (*hash, sub->extents);
+	    return _hash_surface (hash, sub->target);
+	}
+
+	if (_cairo_surface_is_recording (surface))
+	    return _hash_recording (hash, (cairo_recording_surface_t *) surface);
+    }
+
+    *hash = _hash_mime_data (*hash, surface);
+
+    status = _cairo_surface_acquire_source_image (surface, &image, &image_extra);
+    if (unlikely (status))
+	return status;
+
+    *hash = _hash_image (*hash, image);
+
+    _cairo_surface_release_source_image (surface, image, image_extra);
+
+    return CAIRO_STATUS_SUCCESS;
+}
+
+/**
+ * _cairo_surface_get_content_hash:
+ * @surface: a #cairo_surface_t
+ * @hash: return location for the hash
+ *
+ * Computes a hash of the pixels, or for recording surfaces of the
+ * drawing commands, of @surface, such that surfaces with equal hashes
+ * may be substituted for one another.
+ *
+ * Return value: %CAIRO_STATUS_SUCCESS, or the error raised when
+ * acquiring the contents of @surface.
+ **/
+cairo_status_t
+_cairo_surface_get_content_hash (cairo_surface_t *surface,
+				 uint64_t *hash)
+{
+    *hash = 0;
+    return _hash_surface (hash, surface);
+}
+
+/**
+ * _cairo_content_hash_bytes:
+ * @hash: the hash of any preceding data, or 0
+ * @bytes: the data to hash
+ * @length: the length of @bytes
+ *
+ * Chains @bytes onto @hash, using the same function as
+ * _cairo_surface_get_content_hash(), for backends that hash content
+ * of their own.
+ *
+ * Return value: the new hash
+ **/
+uint64_t
+_cairo_content_hash_bytes (uint64_t hash,
+			   const void *bytes,
+			   unsigned long length)
+{
+    return _hash_bytes (hash, bytes, length);
+}
@@ -34,6 +34,8 @@
  */
 
 #include "cairoint.h"
+#include "cairo-parallel-private.h"
+#include "cairo-thread-cache-private.h"
 
 /**
  * cairo_debug_reset_static_data:
@@ -77,6 +79,10 @@ cairo_debug_reset_static_data (void)
 
     _cairo_clip_reset_static_data ();
 
+    _cairo_thread_cache_reset_static_data ();
+
+    _cairo_parallel_reset_static_data ();
+
 #if CAIRO_HAS_DRM_SURFACE
     _cairo_drm_device_reset_static_data ();
 #endif
@@ -37,6 +37,7 @@
 #include "cairoint.h"
 #include "cairo-error-private.h"
 #include "cairo-output-stream-private.h"
+#include "cairo-parallel-private.h"
 #include <zlib.h>
 
 #define BUFFER_SIZE 16384
@@ -149,3 +150,155 @@ _cairo_deflate_stream_create (cairo_output_stream_t *output)
 
     return &stream->base;
 }
+
+/* A deflate job holds a complete buffer until it is compressed. Jobs
+ * are independent of one another, so that a caller with several of
+ * them pending may compress them together with _cairo_parallel_for().
+ */
+struct _cairo_deflate_job {
+    unsigned char *data;
+    unsigned long length;
+
+    unsigned char *compressed;
+    unsigned long compressed_length;
+    cairo_status_t status;
+
+    cairo_bool_t done;
+};
+
+/**
+ * _cairo_deflate_job_can_run_in_parallel:
+ *
+ * Returns whether there is more than one processor to compress deflate
+ * jobs on, and so whether it is worth collecting them.
+ **/
+cairo_bool_t
+_cairo_deflate_job_can_run_in_parallel (void)
+{
+    return _cairo_parallel_num_threads () > 1;
+}
+
+/**
+ * _cairo_deflate_job_create:
+ * @data: the data to compress, allocated with malloc()
+ * @length: the length of @data
+ *
+ * Creates a job to compress @data, taking ownership of it.
+ *
+ * Return value: the new job, or %NULL if out of memory, in which case
+ * @data has been freed.
+ **/
+cairo_deflate_job_t *
+_cairo_deflate_job_create (unsigned char *data,
+			   unsigned long  length)
+{
+    cairo_deflate_job_t *job;
+
+    job = malloc (sizeof (cairo_deflate_job_t));
+    if (unlikely (job == NULL)) {
+	free (data);
+	_cairo_error_throw (CAIRO_STATUS_NO_MEMORY);
+	return NULL;
+    }
+
+    job->data = data;
+    job->length = length;
+    job->compressed = NULL;
+    job->compressed_length = 0;
+    job->status = CAIRO_STATUS_SUCCESS;
+    job->done = FALSE;
+
+    return job;
+}
+
+/**
+ * _cairo_deflate_job_compress:
+ * @job: a deflate job
+ *
+ * Compresses @job, unless it is already done, and releases its input.
+ * Distinct jobs may be compressed concurrently.
+ **/
+void
+_cairo_deflate_job_compress (cairo_deflate_job_t *job)
+{
+    uLongf length;
+
+    if (job->done)
+	return;
+
+    length = compressBound (job->length);
+    job->compressed = malloc (length);
+    if (unlikely (job->compressed == NULL)) {
+	job->status = _cairo_error (CAIRO_STATUS_NO_MEMORY);
+    } else if (compress (job->compressed, &length,
+			 job->data, job->length) != Z_OK)
+    {
+	job->status = _cairo_error (CAIRO_STATUS_NO_MEMORY);
+    } else {
+	job->compressed_length = length;
+    }
+
+    free (job->data);
+    job->data = NULL;
+
+    job->done = TRUE;
+}
+
+/**
+ * _cairo_deflate_job_is_done:
+ * @job: a deflate job
+ *
+ * Returns whether @job has been compressed, so that writing it out
+ * will not have to compress it first.
+ **/
+cairo_bool_t
+_cairo_deflate_job_is_done (cairo_deflate_job_t *job)
+{
+    return job->done;
+}
+
+/**
+ * _cairo_deflate_job_destroy:
+ * @job: a deflate job
+ *
+ * Discards @job without writing it out.
+ **/
+void
+_cairo_deflate_job_destroy (cairo_deflate_job_t *job)
+{
+    free (job->data);
+    free (job->compressed);
+    free (job);
+}
+
+/**
+ * _cairo_deflate_job_write:
+ * @job: a deflate job
+ * @output: the stream to write the compressed data to
+ *
+ * Compresses @job if that has not been done yet, writes out the
+ * compressed data, in the zlib format of _cairo_deflate_stream_create(),
+ * and frees @job.
+ *
+ * Return value: the status of the compression or of @output.
+ **/
+cairo_status_t
+_cairo_deflate_job_write (cairo_deflate_job_t	*job,
+			  cairo_output_stream_t	*output)
+{
+    cairo_status_t status;
+
+    _cairo_deflate_job_compress (job);
+
+    status = job->status;
+    if (likely (status == CAIRO_STATUS_SUCCESS)) {
+	_cairo_output_stream_write (output,
+				    job->compressed,
+				    job->compressed_length);
+	status = _cairo_output_stream_get_status (output);
+    }
+
+    _cairo_deflate_job_destroy (job);
+
+    return status;
+}
@@ -90,6 +90,11 @@
  */
 #define MAX_OPEN_FACES 10
 
+/* This is the max number of bytes of font tables we keep in memory at
+ * once, across all the unscaled fonts
+ */
+#define MAX_CACHED_TABLE_SIZE (32 * 1024 * 1024)
+
 /**
  * SECTION:cairo-ft
  * @Title: FreeType Fonts
@@ -134,6 +139,21 @@ typedef struct _cairo_ft_font_transform {
 
 typedef struct _cairo_ft_font_face cairo_ft_font_face_t;
 
+/* A copy of an sfnt table, as read by the font subsetters. The tables
+ * live as long as the unscaled font, and are never modified once
+ * added to its list.
+ */
+typedef struct _cairo_ft_table cairo_ft_table_t;
+
+struct _cairo_ft_table {
+    cairo_ft_table_t *next;
+
+    FT_ULong tag;
+    cairo_int_status_t status; /* UNSUPPORTED if the font lacks the table */
+    FT_Byte *data;
+    FT_ULong length;
+};
+
 struct _cairo_ft_unscaled_font {
     cairo_unscaled_font_t base;
 
@@ -157,6 +177,8 @@ struct _cairo_ft_unscaled_font {
     int lock_count;
 
     cairo_ft_font_face_t *faces;	/* Linked list of faces for this font */
+
+    cairo_ft_table_t *tables;		/* Linked list of cached sfnt tables */
 };
 
 static int
@@ -166,6 +188,9 @@ _cairo_ft_unscaled_font_keys_equal (const void *key_a,
 static void
 _cairo_ft_unscaled_font_fini (cairo_ft_unscaled_font_t *unscaled);
 
+static void
+_cairo_ft_unscaled_font_fini_tables (cairo_ft_unscaled_font_t *unscaled);
+
 typedef enum _cairo_ft_extra_flags {
     CAIRO_FT_OPTIONS_HINT_METRICS = (1 << 0),
     CAIRO_FT_OPTIONS_EMBOLDEN = (1 << 1)
@@ -409,6 +434,7 @@ _cairo_ft_unscaled_font_init (cairo_ft_unscaled_font_t *unscaled,
     unscaled->lock_count = 0;
 
     unscaled->faces = NULL;
+    unscaled->tables = NULL;
 
     return CAIRO_STATUS_SUCCESS;
 }
@@ -429,6 +455,8 @@ _cairo_ft_unscaled_font_fini (cairo_ft_unscaled_font_t *unscaled)
 {
     assert (unscaled->face == NULL);
 
+    _cairo_ft_unscaled_font_fini_tables (unscaled);
+
     if (unscaled->filename) {
 	free (unscaled->filename);
 	unscaled->filename = NULL;
@@ -1288,6 +1316,7 @@ _render_glyph_outline (FT_Face                    face,
 
     case CAIRO_ANTIALIAS_DEFAULT:
     case CAIRO_ANTIALIAS_GRAY:
+    case CAIRO_ANTIALIAS_FAST:
 	render_mode = FT_RENDER_MODE_NORMAL;
     }
 
@@ -2358,6 +2387,143 @@ _cairo_ft_ucs4_to_index (void	    *abstract_font,
     return index;
 }
 
+/* Bytes held by the cached tables of every unscaled font */
+static unsigned long _cairo_ft_table_cache_size;
+
+static void
+_cairo_ft_unscaled_font_fini_tables (cairo_ft_unscaled_font_t *unscaled)
+{
+    cairo_ft_table_t *table, *next;
+    unsigned long size = 0;
+
+    for (table = unscaled->tables; table != NULL; table = next) {
+	next = table->next;
+
+	size += table->length;
+	free (table->data);
+	free (table);
+    }
+    unscaled->tables = NULL;
+
+    if (size) {
+	CAIRO_MUTEX_LOCK (_cairo_ft_table_cache_mutex);
+	_cairo_ft_table_cache_size -= size;
+	CAIRO_MUTEX_UNLOCK (_cairo_ft_table_cache_mutex);
+    }
+}
+
+#if HAVE_FT_LOAD_SFNT_TABLE
+/* Must be called with the unscaled font mutex held. */
+static cairo_ft_table_t *
+_cairo_ft_unscaled_font_find_table (cairo_ft_unscaled_font_t *unscaled,
+				    FT_ULong		      tag)
+{
+    cairo_ft_table_t *table;
+
+    for (table = unscaled->tables; table != NULL; table = table->next) {
+	if (table->tag == tag)
+	    return table;
+    }
+
+    return NULL;
+}
+
+/* Reads the whole of the table into the list of cached tables, unless
+ * that would take the cache over MAX_CACHED_TABLE_SIZE, in which case
+ * *table_out is set to %NULL. Must be called with the face locked.
+ */
+static cairo_status_t
+_cairo_ft_unscaled_font_cache_table (cairo_ft_unscaled_font_t	 *unscaled,
+				     FT_Face			  face,
+				     FT_ULong			  tag,
+				     cairo_ft_table_t		**table_out)
+{
+    cairo_ft_table_t *table;
+    FT_ULong length = 0;
+    cairo_bool_t has_room;
+
+    *table_out = NULL;
+
+    table = malloc (sizeof (cairo_ft_table_t));
+    if (unlikely (table == NULL))
+	return _cairo_error (CAIRO_STATUS_NO_MEMORY);
+
+    table->tag = tag;
+    table->status = CAIRO_INT_STATUS_UNSUPPORTED;
+    table->data = NULL;
+    table->length = 0;
+
+    if (FT_IS_SFNT (face) &&
+	FT_Load_Sfnt_Table (face, tag, 0, NULL, &length) == 0)
+    {
+	CAIRO_MUTEX_LOCK (_cairo_ft_table_cache_mutex);
+	has_room = length <= MAX_CACHED_TABLE_SIZE - _cairo_ft_table_cache_size;
+	if (has_room)
+	    _cairo_ft_table_cache_size += length;
+	CAIRO_MUTEX_UNLOCK (_cairo_ft_table_cache_mutex);
+
+	if (! has_room) {
+	    free (table);
+	    return CAIRO_STATUS_SUCCESS;
+	}
+
+	table->length = length;
+	if (length > 0) {
+	    table->data = malloc (length);
+	    if (unlikely (table->data == NULL)) {
+		CAIRO_MUTEX_LOCK (_cairo_ft_table_cache_mutex);
+		_cairo_ft_table_cache_size -= length;
+		CAIRO_MUTEX_UNLOCK (_cairo_ft_table_cache_mutex);
+
+		free (table);
+		return _cairo_error (CAIRO_STATUS_NO_MEMORY);
+	    }
+	}
+
+	if (length == 0 ||
+	    FT_Load_Sfnt_Table (face, tag, 0, table->data, &length) == 0)
+	{
+	    table->status = CAIRO_STATUS_SUCCESS;
+	}
+    }
+
+    table->next = unscaled->tables;
+    unscaled->tables = table;
+
+    *table_out = table;
+    return CAIRO_STATUS_SUCCESS;
+}
+
+static cairo_int_status_t
+_cairo_ft_unscaled_font_read_table (cairo_ft_unscaled_font_t *unscaled,
+				    FT_ULong		      tag,
+				    long		      offset,
+				    unsigned char	     *buffer,
+				    unsigned long	     *length)
+{
+    FT_Face face;
+    cairo_int_status_t status = CAIRO_INT_STATUS_UNSUPPORTED;
+
+    face = _cairo_ft_unscaled_font_lock_face (unscaled);
+    if (!face)
+	return _cairo_error (CAIRO_STATUS_NO_MEMORY);
+
+    if (FT_IS_SFNT (face) &&
+	FT_Load_Sfnt_Table (face, tag, offset, buffer, length) == 0)
+        status = CAIRO_STATUS_SUCCESS;
+
+    _cairo_ft_unscaled_font_unlock_face (unscaled);
+
+    return status;
+}
+#endif
+
+/* The font subsetters read the same few tables for every subset of a
+ * font, and of every document using it, so keep a copy of each table
+ * with the unscaled font; it is shared by every face and size of the
+ * font file. Reads of the whole font file (a tag of 0), and reads
+ * that stray outside of a table, go straight to FreeType.
+ */
 static cairo_int_status_t
 _cairo_ft_load_truetype_table (void	       *abstract_font,
                               unsigned long     tag,
@@ -2367,22 +2533,67 @@ _cairo_ft_load_truetype_table (void	       *abstract_font,
 {
     cairo_ft_scaled_font_t *scaled_font = abstract_font;
     cairo_ft_unscaled_font_t *unscaled = scaled_font->unscaled;
-    FT_Face face;
-    cairo_status_t status = CAIRO_INT_STATUS_UNSUPPORTED;
+    cairo_int_status_t status = CAIRO_INT_STATUS_UNSUPPORTED;
 
     if (_cairo_ft_scaled_font_is_vertical (&scaled_font->base))
         return CAIRO_INT_STATUS_UNSUPPORTED;
 
 #if HAVE_FT_LOAD_SFNT_TABLE
-    face = _cairo_ft_unscaled_font_lock_face (unscaled);
-    if (!face)
-	return _cairo_error (CAIRO_STATUS_NO_MEMORY);
+    {
+	cairo_ft_table_t *table = NULL;
+	unsigned long size;
 
-    if (FT_IS_SFNT (face) &&
-	FT_Load_Sfnt_Table (face, tag, offset, buffer, length) == 0)
-        status = CAIRO_STATUS_SUCCESS;
+	if (tag != 0) {
+	    /* Cached tables do not need the face to be opened. */
+	    CAIRO_MUTEX_LOCK (unscaled->mutex);
+	    table = _cairo_ft_unscaled_font_find_table (unscaled, tag);
+	    CAIRO_MUTEX_UNLOCK (unscaled->mutex);
 
-    _cairo_ft_unscaled_font_unlock_face (unscaled);
+	    if (table == NULL) {
+		FT_Face face;
+
+		face = _cairo_ft_unscaled_font_lock_face (unscaled);
+		if (!face)
+		    return _cairo_error (CAIRO_STATUS_NO_MEMORY);
+
+		table = _cairo_ft_unscaled_font_find_table (unscaled, tag);
+		if (table == NULL)
+		    status = _cairo_ft_unscaled_font_cache_table (unscaled, face,
+								  tag, &table);
+		else
+		    status = CAIRO_STATUS_SUCCESS;
+
+		_cairo_ft_unscaled_font_unlock_face (unscaled);
+
+		if (unlikely (status))
+		    return status;
+	    }
+	}
+
+	if (table == NULL)
+	    return _cairo_ft_unscaled_font_read_table (unscaled, tag, offset,
+						       buffer, length);
+
+	if (table->status)
+	    return table->status;
+
+	if (length != NULL && *length == 0) {
+	    *length = table->length;
+	    return CAIRO_STATUS_SUCCESS;
+	}
+
+	size = length != NULL ? *length : table->length;
+	if (offset < 0 ||
+	    (unsigned long) offset > table->length ||
+	    size > table->length - offset)
+	{
+	    return _cairo_ft_unscaled_font_read_table (unscaled, tag, offset,
+						       buffer, length);
+	}
+
+	memcpy (buffer, table->data + offset, size);
+	status = CAIRO_STATUS_SUCCESS;
+    }
 #endif
 
     return status;
@@ -465,6 +465,7 @@ _cairo_gl_texture_set_filter (cairo_gl_context_t *ctx,
 	glTexParameteri (target, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 	break;
     case CAIRO_FILTER_GOOD:
+    case CAIRO_FILTER_MIPMAP:
     case CAIRO_FILTER_BEST:
     case CAIRO_FILTER_BILINEAR:
 	glTexParameteri (target, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
@@ -0,0 +1,500 @@
+/* cairo - a vector graphics library with display and print output
+ *
+ * Copyright © 2010 the cairo graphics library authors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it either under the terms of the GNU Lesser General Public
+ * License version 2.1 as published by the Free Software Foundation
+ * (the "LGPL") or, at your option, under the terms of the Mozilla
+ * Public License Version 1.1 (the "MPL"). If you do not alter this
+ * notice, a recipient may use your version of this file under either
+ * the MPL or the LGPL.
+ *
+ * You should have received a copy of the LGPL along with this library
+ * in the file COPYING-LGPL-2.1; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA 02110-1335, USA
+ * You should have received a copy of the MPL along with this library
+ * in the file COPYING-MPL-1.1
+ *
+ * The contents of this file are subject to the Mozilla Public License
+ * Version 1.1 (the "License"); you may not use this file except in
+ * compliance with the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY
+ * OF ANY KIND, either express or implied. See the LGPL or the MPL for
+ * the specific language governing rights and limitations.
+ *
+ * The Original Code is the cairo graphics library.
+ */
+
+/* A scan converter for hairlines: strokes no wider than a device pixel.
+ *
+ * Rather than tessellating the outline of the stroke and feeding the
+ * resulting polygon through a general scan converter, each line is
+ * treated as a thin band around its centre line. The band is box
+ * filtered across the minor axis and point sampled at the centre of
+ * each pixel (or partial pixel at the ends) along the major axis, in
+ * the manner of Wu's antialiased lines. Coverage is accumulated a row
+ * at a time and emitted as spans, so the cost is proportional to the
+ * number of pixels touched rather than to the complexity of the
+ * outline.
+ *
+ * Overlapping lines add their coverage (saturating at full coverage)
+ * instead of taking the union, which is indistinguishable for the thin
+ * lines handled here.
+ */
+
+#include "cairoint.h"
+
+#include "cairo-combsort-private.h"
+#include "cairo-error-private.h"
+#include "cairo-spans-private.h"
+
+typedef struct _line {
+    /* The centre line, in device pixels, ordered along the major axis. */
+    double x1, y1, x2, y2;
+    /* Change in the minor coordinate per unit along the major axis. */
+    double slope;
+    /* Half of the extent of the band measured along the minor axis. */
+    double half;
+    cairo_bool_t x_major;
+    int top, bottom;
+} line_t;
+
+static inline int
+line_compare_top (const line_t *a,
+		  const line_t *b)
+{
+    return a->top - b->top;
+}
+
+CAIRO_COMBSORT_DECLARE (line_sort, line_t *, line_compare_top)
+
+static inline double
+_overlap (double a1, double a2, double b1, double b2)
+{
+    return MIN (a2, b2) - MAX (a1, b1);
+}
+
+typedef struct _row {
+    int xmin, xmax;
+    int lo, hi;
+    int *coverage;
+    cairo_half_open_span_t *spans;
+} row_t;
+
+static inline void
+_row_add (row_t *row, int x, double coverage)
+{
+    if (coverage <= 0.)
+	return;
+
+    row->coverage[x - row->xmin] += coverage * CAIRO_SPANS_UNIT_COVERAGE + .5;
+    if (x < row->lo)
+	row->lo = x;
+    if (x >= row->hi)
+	row->hi = x + 1;
+}
+
+static void
+_row_add_x_major (row_t *row, const line_t *line, int y)
+{
+    double left, right;
+    int x, x_end;
+
+    /* Find the section of the centre line whose band reaches this row. */
+    left = line->x1;
+    right = line->x2;
+    if (line->slope != 0.) {
+	double xa, xb;
+
+	xa = line->x1 + (y - line->half - line->y1) / line->slope;
+	xb = line->x1 + (y + 1 + line->half - line->y1) / line->slope;
+	if (xa > xb) {
+	    double t = xa;
+	    xa = xb;
+	    xb = t;
+	}
+	left = MAX (left, xa);
+	right = MIN (right, xb);
+    }
+
+    if (left < row->xmin)
+	left = row->xmin;
+    if (right > row->xmax)
+	right = row->xmax;
+
+    x = floor (left);
+    x_end = ceil (right);
+
+    for (; x < x_end; x++) {
+	double x1, x2, yc;
+
+	x1 = MAX (x, line->x1);
+	x2 = MIN (x + 1, line->x2);
+	if (x2 <= x1)
+	    continue;
+
+	yc = line->y1 + line->slope * ((x1 + x2) * .5 - line->x1);
+	_row_add (row, x,
+		  (x2 - x1) * _overlap (yc - line->half, yc + line->half,
+					y, y + 1));
+    }
+}
+
+static void
+_row_add_y_major (row_t *row, const line_t *line, int y)
+{
+    double y1, y2, xc, height;
+    int x, x_end;
+
+    y1 = MAX (y, line->y1);
+    y2 = MIN (y + 1, line->y2);
+    height = y2 - y1;
+    if (height <= 0.)
+	return;
+
+    xc = line->x1 + line->slope * ((y1 + y2) * .5 - line->y1);
+    if (xc + line->half <= row->xmin || xc - line->half >= row->xmax)
+	return;
+
+    x = xc - line->half <= row->xmin ? row->xmin : floor (xc - line->half);
+    x_end = xc + line->half >= row->xmax ? row->xmax : ceil (xc + line->half);
+
+    for (; x < x_end; x++) {
+	_row_add (row, x,
+		  height * _overlap (xc - line->half, xc + line->half,
+				     x, x + 1));
+    }
+}
+
+static unsigned int
+_row_to_spans (row_t *row)
+{
+    cairo_half_open_span_t *spans = row->spans;
+    unsigned int num_spans = 0;
+    int last = -1;
+    int x;
+
+    for (x = row->lo; x < row->hi; x++) {
+	int coverage = row->coverage[x - row->xmin];
+
+	row->coverage[x - row->xmin] = 0;
+	if (coverage > CAIRO_SPANS_UNIT_COVERAGE)
+	    coverage = CAIRO_SPANS_UNIT_COVERAGE;
+
+	if (coverage != last) {
+	    spans[num_spans].x = x;
+	    spans[num_spans].coverage = coverage;
+	    num_spans++;
+	    last = coverage;
+	}
+    }
+
+    spans[num_spans].x = row->hi;
+    spans[num_spans].coverage = 0;
+    num_spans++;
+
+    row->lo = row->xmax;
+    row->hi = row->xmin;
+
+    return num_spans;
+}
+
+static cairo_status_t
+generate (cairo_hairline_scan_converter_t *self,
+	  cairo_span_renderer_t	*renderer,
+	  line_t **lines,
+	  int num_lines)
+{
+    int coverage_stack[CAIRO_STACK_ARRAY_LENGTH (int)];
+    cairo_half_open_span_t spans_stack[CAIRO_STACK_ARRAY_LENGTH (cairo_half_open_span_t)];
+    line_t *active_stack[CAIRO_STACK_ARRAY_LENGTH (line_t *)];
+    line_t **active;
+    row_t row;
+    int width, num_active, next, y, empty_y;
+    cairo_status_t status = CAIRO_STATUS_SUCCESS;
+
+    width = self->xmax - self->xmin;
+
+    row.xmin = self->xmin;
+    row.xmax = self->xmax;
+    row.lo = row.xmax;
+    row.hi = row.xmin;
+    row.coverage = coverage_stack;
+    row.spans = spans_stack;
+    active = active_stack;
+
+    if (width > ARRAY_LENGTH (coverage_stack)) {
+	row.coverage = _cairo_malloc_ab (width, sizeof (int));
+	if (unlikely (row.coverage == NULL))
+	    return _cairo_error (CAIRO_STATUS_NO_MEMORY);
+    }
+    if (width + 1 > ARRAY_LENGTH (spans_stack)) {
+	row.spans = _cairo_malloc_ab (width + 1,
+				      sizeof (cairo_half_open_span_t));
+	if (unlikely (row.spans == NULL)) {
+	    status = _cairo_error (CAIRO_STATUS_NO_MEMORY);
+	    goto BAIL;
+	}
+    }
+    if (num_lines > ARRAY_LENGTH (active_stack)) {
+	active = _cairo_malloc_ab (num_lines, sizeof (line_t *));
+	if (unlikely (active == NULL)) {
+	    status = _cairo_error (CAIRO_STATUS_NO_MEMORY);
+	    goto BAIL;
+	}
+    }
+    memset (row.coverage, 0, width * sizeof (int));
+
+    num_active = next = 0;
+    empty_y = y = self->ymin;
+    while (y < self->ymax) {
+	unsigned int num_spans;
+	int i, j;
+
+	if (num_active == 0) {
+	    if (next == num_lines)
+		break;
+
+	    y = lines[next]->top;
+	}
+
+	while (next < num_lines && lines[next]->top == y)
+	    active[num_active++] = lines[next++];
+
+	for (i = 0; i < num_active; i++) {
+	    if (active[i]->x_major)
+		_row_add_x_major (&row, active[i], y);
+	    else
+		_row_add_y_major (&row, active[i], y);
+	}
+
+	for (i = j = 0; i < num_active; i++) {
+	    if (active[i]->bottom > y + 1)
+		active[j++] = active[i];
+	}
+	num_active = j;
+
+	if (row.hi > row.lo) {
+	    if (y > empty_y) {
+		status = renderer->render_rows (renderer,
+						empty_y, y - empty_y,
+						NULL, 0);
+		if (unlikely (status))
+		    goto BAIL;
+	    }
+
+	    num_spans = _row_to_spans (&row);
+	    status = renderer->render_rows (renderer, y, 1,
+					    row.spans, num_spans);
+	    if (unlikely (status))
+		goto BAIL;
+
+	    empty_y = y + 1;
+	}
+
+	y++;
+    }
+
+    if (self->ymax > empty_y) {
+	status = renderer->render_rows (renderer,
+					empty_y, self->ymax - empty_y,
+					NULL, 0);
+    }
+
+  BAIL:
+    if (active != active_stack)
+	free (active);
+    if (row.spans != spans_stack)
+	free (row.spans);
+    if (row.coverage != coverage_stack)
+	free (row.coverage);
+
+    return status;
+}
+
+static cairo_status_t
+_cairo_hairline_scan_converter_generate (void			*converter,
+					 cairo_span_renderer_t	*renderer)
+{
+    cairo_hairline_scan_converter_t *self = converter;
+    line_t *lines_stack[CAIRO_STACK_ARRAY_LENGTH (line_t *)];
+    line_t **lines;
+    struct _cairo_hairline_scan_converter_chunk *chunk;
+    cairo_status_t status;
+    int i, j;
+
+    if (unlikely (self->num_lines == 0 || self->xmin >= self->xmax)) {
+	return renderer->render_rows (renderer,
+				      self->ymin, self->ymax - self->ymin,
+				      NULL, 0);
+    }
+
+    lines = lines_stack;
+    if (unlikely (self->num_lines > ARRAY_LENGTH (lines_stack))) {
+	lines = _cairo_malloc_ab (self->num_lines, sizeof (line_t *));
+	if (unlikely (lines == NULL))
+	    return _cairo_error (CAIRO_STATUS_NO_MEMORY);
+    }
+
+    j = 0;
+    for (chunk = &self->chunks; chunk != NULL; chunk = chunk->next) {
+	line_t *line;
+
+	line = chunk->base;
+	for (i = 0; i < chunk->count; i++)
+	    lines[j++] = &line[i];
+    }
+    line_sort (lines, j);
+
+    status = generate (self, renderer, lines, j);
+
+    if (lines != lines_stack)
+	free (lines);
+
+    return status;
+}
+
+static line_t *
+_allocate_line (cairo_hairline_scan_converter_t *self)
+{
+    line_t *line;
+    struct _cairo_hairline_scan_converter_chunk *chunk;
+
+    chunk = self->tail;
+    if (chunk->count == chunk->size) {
+	int size;
+
+	size = chunk->size * 2;
+	chunk->next = _cairo_malloc_ab_plus_c (size,
+					       sizeof (line_t),
+					       sizeof (struct _cairo_hairline_scan_converter_chunk));
+
+	if (unlikely (chunk->next == NULL))
+	    return NULL;
+
+	chunk = chunk->next;
+	chunk->next = NULL;
+	chunk->count = 0;
+	chunk->size = size;
+	chunk->base = chunk + 1;
+	self->tail = chunk;
+    }
+
+    line = chunk->base;
+    return line + chunk->count++;
+}
+
+/* Adds a line from (x1, y1) to (x2, y2), in device pixels, stroked to
+ * the given width (measured perpendicular to the line). Any caps must
+ * already have been applied by extending the end points.
+ */
+cairo_status_t
+_cairo_hairline_scan_converter_add_line (cairo_hairline_scan_converter_t *self,
+					 double x1, double y1,
+					 double x2, double y2,
+					 double width)
+{
+    line_t *line;
+    double dx, dy, lo, hi, half;
+
+    dx = x2 - x1;
+    dy = y2 - y1;
+    if (dx == 0. && dy == 0.)
+	return CAIRO_STATUS_SUCCESS;
+    if (! (width > 0.))
+	return CAIRO_STATUS_SUCCESS;
+
+    half = width * .5;
+
+    /* Discard lines that cannot reach the extents. */
+    if (MAX (x1, x2) + half <= self->xmin ||
+	MIN (x1, x2) - half >= self->xmax ||
+	MAX (y1, y2) + half <= self->ymin ||
+	MIN (y1, y2) - half >= self->ymax)
+    {
+	return CAIRO_STATUS_SUCCESS;
+    }
+
+    line = _allocate_line (self);
+    if (unlikely (line == NULL))
+	return _cairo_error (CAIRO_STATUS_NO_MEMORY);
+
+    if (fabs (dx) >= fabs (dy)) {
+	line->x_major = TRUE;
+	if (dx < 0.) {
+	    line->x1 = x2; line->y1 = y2;
+	    line->x2 = x1; line->y2 = y1;
+	} else {
+	    line->x1 = x1; line->y1 = y1;
+	    line->x2 = x2; line->y2 = y2;
+	}
+	line->slope = dy / dx;
+	line->half = half * sqrt (1. + line->slope * line->slope);
+
+	lo = MIN (y1, y2) - line->half;
+	hi = MAX (y1, y2) + line->half;
+    } else {
+	line->x_major = FALSE;
+	if (dy < 0.) {
+	    line->x1 = x2; line->y1 = y2;
+	    line->x2 = x1; line->y2 = y1;
+	} else {
+	    line->x1 = x1; line->y1 = y1;
+	    line->x2 = x2; line->y2 = y2;
+	}
+	line->slope = dx / dy;
+	line->half = half * sqrt (1. + line->slope * line->slope);
+
+	lo = line->y1;
+	hi = line->y2;
+    }
+
+    line->top = lo <= self->ymin ? self->ymin : floor (lo);
+    line->bottom = hi >= self->ymax ? self->ymax : ceil (hi);
+    if (line->bottom <= line->top) {
+	self->tail->count--;
+	return CAIRO_STATUS_SUCCESS;
+    }
+
+    self->num_lines++;
+
+    return CAIRO_STATUS_SUCCESS;
+}
+
+static void
+_cairo_hairline_scan_converter_destroy (void *converter)
+{
+    cairo_hairline_scan_converter_t *self = converter;
+    struct _cairo_hairline_scan_converter_chunk *chunk, *next;
+
+    for (chunk = self->chunks.next; chunk != NULL; chunk = next) {
+	next = chunk->next;
+	free (chunk);
+    }
+}
+
+void
+_cairo_hairline_scan_converter_init (cairo_hairline_scan_converter_t *self,
+				     const cairo_rectangle_int_t *extents)
+{
+    self->base.destroy = _cairo_hairline_scan_converter_destroy;
+    self->base.add_edge = NULL;
+    self->base.add_polygon = NULL;
+    self->base.generate = _cairo_hairline_scan_converter_generate;
+
+    self->xmin = extents->x;
+    self->xmax = extents->x + extents->width;
+    self->ymin = extents->y;
+    self->ymax = extents->y + extents->height;
+
+    self->chunks.base = self->buf;
+    self->chunks.next = NULL;
+    self->chunks.count = 0;
+    self->chunks.size = sizeof (self->buf) / sizeof (line_t);
+    self->tail = &self->chunks;
+
+    self->num_lines = 0;
+}
@@ -0,0 +1,383 @@
+/* cairo - a vector graphics library with display and print output
+ *
+ * Copyright © 2010 the cairo graphics library authors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it either under the terms of the GNU Lesser General Public
+ * License version 2.1 as published by the Free Software Foundation
+ * (the "LGPL") or, at your option, under the terms of the Mozilla
+ * Public License Version 1.1 (the "MPL"). If you do not alter this
+ * notice, a recipient may use your version of this file under either
+ * the MPL or the LGPL.
+ *
+ * You should have received a copy of the LGPL along with this library
+ * in the file COPYING-LGPL-2.1; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA 02110-1335, USA
+ * You should have received a copy of the MPL along with this library
+ * in the file COPYING-MPL-1.1
+ *
+ * The contents of this file are subject to the Mozilla Public License
+ * Version 1.1 (the "License"); you may not use this file except in
+ * compliance with the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY
+ * OF ANY KIND, either express or implied. See the LGPL or the MPL for
+ * the specific language governing rights and limitations.
+ *
+ * The Original Code is the cairo graphics library.
+ */
+
+#include "cairoint.h"
+
+#include "cairo-error-private.h"
+
+#include <errno.h>
+#include <fcntl.h>
+
+#if HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
+#if HAVE_MMAP && HAVE_SYS_MMAN_H && HAVE_UNISTD_H
+#include <sys/mman.h>
+#include <sys/stat.h>
+#define CAIRO_HAS_IMAGE_FILE 1
+#endif
+
+#ifndef O_BINARY
+#define O_BINARY 0
+#endif
+
+/**
+ * SECTION:cairo-image-file
+ * @Title: Mapped image files
+ * @Short_Description: Image surfaces backed by memory-mapped files
+ * @See_Also: #cairo_surface_t
+ *
+ * An image surface can keep its pixels in a file that is mapped into
+ * memory instead of on the heap. Other processes mapping the same file
+ * see the pixels as they are drawn, and the operating system pages
+ * them in and out as needed, so rasters far larger than the available
+ * memory can be worked upon without any copying.
+ *
+ * The file starts with a 64-byte header followed by the rows of
+ * pixels, exactly as they are laid out in memory by an image surface
+ * of the same format. The header holds, in the native byte order of
+ * the machine that created the file, the 8 bytes "CAIROIMG", a version
+ * number of 1, the #cairo_format_t, the width, height and stride of
+ * the image and the offset of the first row from the start of the
+ * file, each as a 32-bit unsigned integer.
+ */
+
+#define IMAGE_FILE_MAGIC "CAIROIMG"
+#define IMAGE_FILE_VERSION 1
+#define IMAGE_FILE_HEADER_SIZE 64
+
+/* the limit upon the size of an image surface, see cairo-image-surface.c */
+#define MAX_IMAGE_SIZE 32767
+
+typedef struct _cairo_image_file_header {
+    char magic[8];
+    uint32_t version;
+    uint32_t format;
+    uint32_t width;
+    uint32_t height;
+    uint32_t stride;
+    uint32_t offset;
+    uint8_t reserved[IMAGE_FILE_HEADER_SIZE - 32];
+} cairo_image_file_header_t;
+
+typedef struct _cairo_image_file_mapping {
+    void *addr;
+    size_t size;
+} cairo_image_file_mapping_t;
+
+static const cairo_user_data_key_t image_file_key;
+
+#if CAIRO_HAS_IMAGE_FILE
+
+static cairo_status_t
+_cairo_image_file_error (cairo_status_t fallback)
+{
+    switch (errno) {
+    case ENOMEM:
+	return _cairo_error (CAIRO_STATUS_NO_MEMORY);
+    case ENOENT:
+	return _cairo_error (CAIRO_STATUS_FILE_NOT_FOUND);
+    default:
+	return _cairo_error (fallback);
+    }
+}
+
+static void
+_cairo_image_file_unmap (void *closure)
+{
+    cairo_image_file_mapping_t *mapping = closure;
+
+    munmap (mapping->addr, mapping->size);
+    free (mapping);
+}
+
+/* Wraps the mapped pixels in an image surface that unmaps them again
+ * once it is destroyed. The mapping is released upon failure.
+ */
+static cairo_surface_t *
+_cairo_image_file_create_surface (void		*addr,
+				  size_t	 size,
+				  const cairo_image_file_header_t *header)
+{
+    cairo_image_file_mapping_t *mapping;
+    cairo_surface_t *surface;
+    cairo_status_t status;
+
+    mapping = malloc (sizeof (cairo_image_file_mapping_t));
+    if (unlikely (mapping == NULL)) {
+	munmap (addr, size);
+	return _cairo_surface_create_in_error (_cairo_error (CAIRO_STATUS_NO_MEMORY));
+    }
+
+    mapping->addr = addr;
+    mapping->size = size;
+
+    surface = cairo_image_surface_create_for_data ((unsigned char *) addr + header->offset,
+						   header->format,
+						   header->width,
+						   header->height,
+						   header->stride);
+    if (unlikely (surface->status)) {
+	_cairo_image_file_unmap (mapping);
+	return surface;
+    }
+
+    status = cairo_surface_set_user_data (surface, &image_file_key,
+					  mapping, _cairo_image_file_unmap);
+    if (unlikely (status)) {
+	_cairo_image_file_unmap (mapping);
+	cairo_surface_destroy (surface);
+	return _cairo_surface_create_in_error (status);
+    }
+
+    /* the file may already hold an image, so make no assumptions */
+    surface->is_clear = FALSE;
+
+    return surface;
+}
+
+#endif
+
+/**
+ * cairo_image_surface_create_for_file:
+ * @filename: name of the file to create
+ * @format: format of pixels in the surface to create
+ * @width: width of the surface, in pixels
+ * @height: height of the surface, in pixels
+ *
+ * Creates an image surface whose pixels are stored in a new file that
+ * is mapped into memory, replacing any existing file of that name. The
+ * pixels are initially all 0 and the file is laid out as described in
+ * the <link linkend="cairo-cairo-image-file.description">overview</link>,
+ * so that it can be mapped again with cairo_image_surface_create_from_file(),
+ * possibly by another process.
+ *
+ * The contents of the file are updated as the surface is drawn upon;
+ * cairo_surface_flush() additionally waits until they have been
+ * written out to storage. Note that the mapping is only released once
+ * the surface is destroyed.
+ *
+ * Return value: a pointer to the newly created surface. The caller
+ * owns the surface and should call cairo_surface_destroy() when done
+ * with it.
+ *
+ * This function always returns a valid pointer, but it will return a
+ * pointer to a "nil" surface if an error occurs, such as
+ * %CAIRO_STATUS_INVALID_SIZE, %CAIRO_STATUS_NO_MEMORY or
+ * %CAIRO_STATUS_WRITE_ERROR if the file cannot be created or mapped
+ * on this system. You can use cairo_surface_status() to check for
+ * this.
+ *
+ * Since: 1.12
+ **/
+cairo_surface_t *
+cairo_image_surface_create_for_file (const char	*filename,
+				     cairo_format_t	 format,
+				     int		 width,
+				     int		 height)
+{
+#if CAIRO_HAS_IMAGE_FILE
+    cairo_image_file_header_t header;
+    cairo_surface_t *surface;
+    cairo_status_t status;
+    size_t size;
+    void *addr;
+    int stride;
+    int fd;
+
+    if (! CAIRO_FORMAT_VALID (format))
+	return _cairo_surface_create_in_error (_cairo_error (CAIRO_STATUS_INVALID_FORMAT));
+
+    /* check everything the image surface will, before the file is
+     * truncated */
+    stride = cairo_format_stride_for_width (format, width);
+    if (stride < 0 ||
+	width < 0 || width > MAX_IMAGE_SIZE ||
+	height < 0 || height > MAX_IMAGE_SIZE)
+    {
+	return _cairo_surface_create_in_error (_cairo_error (CAIRO_STATUS_INVALID_SIZE));
+    }
+
+    memset (&header, 0, sizeof (header));
+    memcpy (header.magic, IMAGE_FILE_MAGIC, sizeof (header.magic));
+    header.version = IMAGE_FILE_VERSION;
+    header.format = format;
+    header.width = width;
+    header.height = height;
+    header.stride = stride;
+    header.offset = IMAGE_FILE_HEADER_SIZE;
+
+    size = header.offset + (size_t) stride * height;
+
+    fd = open (filename, O_RDWR | O_CREAT | O_TRUNC | O_BINARY, 0666);
+    if (fd == -1)
+	return _cairo_surface_create_in_error (_cairo_image_file_error (CAIRO_STATUS_WRITE_ERROR));
+
+    /* grow the file without writing out the pixels, which are all 0 */
+    if (ftruncate (fd, size) == -1 ||
+	write (fd, &header, sizeof (header)) != sizeof (header))
+    {
+	status = _cairo_image_file_error (CAIRO_STATUS_WRITE_ERROR);
+	close (fd);
+	unlink (filename);
+	return _cairo_surface_create_in_error (status);
+    }
+
+    addr = mmap (NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (addr == MAP_FAILED) {
+	status = _cairo_image_file_error (CAIRO_STATUS_WRITE_ERROR);
+	close (fd);
+	unlink (filename);
+	return _cairo_surface_create_in_error (status);
+    }
+
+    close (fd);
+
+    /* do not leave a file behind that no surface refers to */
+    surface = _cairo_image_file_create_surface (addr, size, &header);
+    if (unlikely (surface->status))
+	unlink (filename);
+
+    return surface;
+#else
+    return _cairo_surface_create_in_error (_cairo_error (CAIRO_STATUS_WRITE_ERROR));
+#endif
+}
+
+/**
+ * cairo_image_surface_create_from_file:
+ * @filename: name of a file previously created by
+ * cairo_image_surface_create_for_file()
+ *
+ * Creates an image surface whose pixels are those stored in an
+ * existing image file, by mapping the file into memory. No pixels are
+ * read until they are used.
+ *
+ * If the file can be written to, anything drawn onto the surface is
+ * written back into the file and visible to any other process that
+ * has it mapped; cairo_surface_flush() waits until the changes have
+ * been written out to storage. Otherwise the surface can still be
+ * drawn upon, but the file remains unchanged.
+ *
+ * Return value: a new #cairo_surface_t sharing the contents of the
+ * file, or a "nil" surface if any error occurred. A nil surface can be
+ * checked for with cairo_surface_status(surface) which may return one
+ * of the following values:
+ *
+ *	%CAIRO_STATUS_NO_MEMORY
+ *	%CAIRO_STATUS_FILE_NOT_FOUND
+ *	%CAIRO_STATUS_READ_ERROR
+ *
+ * Since: 1.12
+ **/
+cairo_surface_t *
+cairo_image_surface_create_from_file (const char *filename)
+{
+#if CAIRO_HAS_IMAGE_FILE
+    cairo_image_file_header_t header;
+    cairo_status_t status;
+    struct stat st;
+    cairo_bool_t writable = TRUE;
+    size_t size;
+    void *addr;
+    int fd;
+
+    fd = open (filename, O_RDWR | O_BINARY);
+    if (fd == -1 && (errno == EACCES || errno == EROFS || errno == EPERM)) {
+	fd = open (filename, O_RDONLY | O_BINARY);
+	writable = FALSE;
+    }
+    if (fd == -1)
+	return _cairo_surface_create_in_error (_cairo_image_file_error (CAIRO_STATUS_READ_ERROR));
+
+    if (fstat (fd, &st) == -1 ||
+	read (fd, &header, sizeof (header)) != sizeof (header))
+    {
+	status = _cairo_image_file_error (CAIRO_STATUS_READ_ERROR);
+	close (fd);
+	return _cairo_surface_create_in_error (status);
+    }
+
+    /* a byte-swapped version also marks a file from a foreign machine */
+    if (memcmp (header.magic, IMAGE_FILE_MAGIC, sizeof (header.magic)) != 0 ||
+	header.version != IMAGE_FILE_VERSION ||
+	! CAIRO_FORMAT_VALID ((cairo_format_t) header.format) ||
+	header.width > MAX_IMAGE_SIZE || header.height > MAX_IMAGE_SIZE ||
+	header.stride > INT32_MAX ||
+	header.offset < sizeof (header) || header.offset % 4 != 0)
+    {
+	close (fd);
+	return _cairo_surface_create_in_error (_cairo_error (CAIRO_STATUS_READ_ERROR));
+    }
+
+    size = header.offset + (size_t) header.stride * header.height;
+    if ((uint64_t) st.st_size < size) {
+	close (fd);
+	return _cairo_surface_create_in_error (_cairo_error (CAIRO_STATUS_READ_ERROR));
+    }
+
+    addr = mmap (NULL, size, PROT_READ | PROT_WRITE,
+		 writable ? MAP_SHARED : MAP_PRIVATE,
+		 fd, 0);
+    if (addr == MAP_FAILED) {
+	status = _cairo_image_file_error (CAIRO_STATUS_READ_ERROR);
+	close (fd);
+	return _cairo_surface_create_in_error (status);
+    }
+
+    close (fd);
+
+    return _cairo_image_file_create_surface (addr, size, &header);
+#else
+    return _cairo_surface_create_in_error (_cairo_error (CAIRO_STATUS_READ_ERROR));
+#endif
+}
+
+/* Writes the pixels of an image surface created for a file out to
+ * storage; does nothing for any other image surface.
+ */
+cairo_status_t
+_cairo_image_file_flush (cairo_image_surface_t *surface)
+{
+#if CAIRO_HAS_IMAGE_FILE
+    cairo_image_file_mapping_t *mapping;
+
+    mapping = _cairo_user_data_array_get_data (&surface->base.user_data,
+					       &image_file_key);
+    if (mapping == NULL)
+	return CAIRO_STATUS_SUCCESS;
+
+    if (msync (mapping->addr, mapping->size, MS_SYNC) == -1)
+	return _cairo_error (CAIRO_STATUS_WRITE_ERROR);
+#endif
+
+    return CAIRO_STATUS_SUCCESS;
+}
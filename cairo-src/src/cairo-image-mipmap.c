@@ -0,0 +1,205 @@
+/* cairo - a vector graphics library with display and print output
+ *
+ * Copyright © 2010 the cairo graphics library authors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it either under the terms of the GNU Lesser General Public
+ * License version 2.1 as published by the Free Software Foundation
+ * (the "LGPL") or, at your option, under the terms of the Mozilla
+ * Public License Version 1.1 (the "MPL"). If you do not alter this
+ * notice, a recipient may use your version of this file under either
+ * the MPL or the LGPL.
+ *
+ * You should have received a copy of the LGPL along with this library
+ * in the file COPYING-LGPL-2.1; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA 02110-1335, USA
+ * You should have received a copy of the MPL along with this library
+ * in the file COPYING-MPL-1.1
+ *
+ * The contents of this file are subject to the Mozilla Public License
+ * Version 1.1 (the "License"); you may not use this file except in
+ * compliance with the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY
+ * OF ANY KIND, either express or implied. See the LGPL or the MPL for
+ * the specific language governing rights and limitations.
+ *
+ * The Original Code is the cairo graphics library.
+ */
+
+/* Mipmaps for images sampled with CAIRO_FILTER_MIPMAP.
+ *
+ * The reductions of an image, each half the size of the previous one
+ * and box filtered from it, are built on demand and kept together in a
+ * snapshot of the image, so that they are discarded along with any
+ * other snapshot as soon as the image is modified or flushed.
+ */
+
+#include "cairoint.h"
+
+#include "cairo-error-private.h"
+
+#define CAIRO_IMAGE_MIPMAP_MAX_LEVELS 16
+
+typedef struct _cairo_image_mipmap {
+    cairo_surface_t base;
+
+    int num_levels;
+    cairo_image_surface_t *levels[CAIRO_IMAGE_MIPMAP_MAX_LEVELS];
+} cairo_image_mipmap_t;
+
+static const cairo_surface_backend_t _cairo_image_mipmap_backend;
+
+static cairo_status_t
+_cairo_image_mipmap_finish (void *abstract_surface)
+{
+    cairo_image_mipmap_t *mipmap = abstract_surface;
+
+    while (mipmap->num_levels--)
+	cairo_surface_destroy (&mipmap->levels[mipmap->num_levels]->base);
+
+    return CAIRO_STATUS_SUCCESS;
+}
+
+static const cairo_surface_backend_t _cairo_image_mipmap_backend = {
+    (cairo_surface_type_t) CAIRO_INTERNAL_SURFACE_TYPE_MIPMAP,
+
+    NULL, /* create similar */
+    _cairo_image_mipmap_finish,
+};
+
+/* Averages each 2x2 block of @src, repeating the last row and column of
+ * odd sized images. Premultiplied pixels may be averaged channel by
+ * channel.
+ */
+static cairo_image_surface_t *
+_cairo_image_mipmap_reduce (const cairo_image_surface_t *src)
+{
+    cairo_image_surface_t *dst;
+    int bpp = PIXMAN_FORMAT_BPP (src->pixman_format) / 8;
+    int x, y, c;
+
+    dst = (cairo_image_surface_t *)
+	_cairo_image_surface_create_with_pixman_format (NULL,
+							src->pixman_format,
+							(src->width  + 1) / 2,
+							(src->height + 1) / 2,
+							0);
+    if (unlikely (dst->base.status))
+	return dst;
+
+    for (y = 0; y < dst->height; y++) {
+	const uint8_t *row0 = src->data + 2 * y * src->stride;
+	const uint8_t *row1 = row0;
+	uint8_t *d = dst->data + y * dst->stride;
+
+	if (2 * y + 1 < src->height)
+	    row1 += src->stride;
+
+	for (x = 0; x < dst->width; x++) {
+	    int x0 = 2 * x * bpp;
+	    int x1 = 2 * x + 1 < src->width ? x0 + bpp : x0;
+
+	    for (c = 0; c < bpp; c++) {
+		*d++ = (row0[x0 + c] + row0[x1 + c] +
+			row1[x0 + c] + row1[x1 + c] + 2) >> 2;
+	    }
+	}
+    }
+
+    dst->base.is_clear = FALSE;
+    return dst;
+}
+
+/**
+ * _cairo_image_surface_get_mipmap:
+ * @image: an image surface
+ * @level: the reduction wanted, updated to the one returned
+ *
+ * Looks up, building it if needed, the @level-th reduction of @image,
+ * 1/2^@level of its size. Smaller levels are returned if @image is
+ * too small to be reduced that far.
+ *
+ * Return value: the reduction, owned by @image, or %NULL if @image
+ * cannot be reduced.
+ **/
+cairo_image_surface_t *
+_cairo_image_surface_get_mipmap (cairo_image_surface_t *image,
+				 int *level)
+{
+    cairo_image_mipmap_t *mipmap;
+
+    switch (image->pixman_format) {
+    case PIXMAN_a8r8g8b8:
+    case PIXMAN_x8r8g8b8:
+    case PIXMAN_a8b8g8r8:
+    case PIXMAN_x8b8g8r8:
+    case PIXMAN_a8:
+	break;
+    case PIXMAN_a1:       case PIXMAN_r5g6b5:   case PIXMAN_r8g8b8:
+    case PIXMAN_b8g8r8:   case PIXMAN_b5g6r5:
+    case PIXMAN_a1r5g5b5: case PIXMAN_x1r5g5b5: case PIXMAN_a1b5g5r5:
+    case PIXMAN_x1b5g5r5: case PIXMAN_a4r4g4b4: case PIXMAN_x4r4g4b4:
+    case PIXMAN_a4b4g4r4: case PIXMAN_x4b4g4r4: case PIXMAN_r3g3b2:
+    case PIXMAN_b2g3r3:   case PIXMAN_a2r2g2b2: case PIXMAN_a2b2g2r2:
+    case PIXMAN_c8:       case PIXMAN_g8:       case PIXMAN_x4a4:
+    case PIXMAN_a4:       case PIXMAN_r1g2b1:   case PIXMAN_b1g2r1:
+    case PIXMAN_a1r1g1b1: case PIXMAN_a1b1g1r1: case PIXMAN_c4:
+    case PIXMAN_g4:       case PIXMAN_g1:
+    case PIXMAN_yuy2:     case PIXMAN_yv12:
+    case PIXMAN_b8g8r8x8:
+    case PIXMAN_b8g8r8a8:
+    case PIXMAN_x2b10g10r10:
+    case PIXMAN_a2b10g10r10:
+    case PIXMAN_x2r10g10b10:
+    case PIXMAN_a2r10g10b10:
+#if PIXMAN_VERSION >= PIXMAN_VERSION_ENCODE(0,19,4)
+    case PIXMAN_x14r6g6b6:
+#endif
+    default:
+	return NULL;
+    }
+
+    mipmap = (cairo_image_mipmap_t *)
+	_cairo_surface_has_snapshot (&image->base, &_cairo_image_mipmap_backend);
+    if (mipmap == NULL) {
+	mipmap = malloc (sizeof (cairo_image_mipmap_t));
+	if (unlikely (mipmap == NULL))
+	    return NULL;
+
+	_cairo_surface_init (&mipmap->base,
+			     &_cairo_image_mipmap_backend,
+			     NULL, /* device */
+			     image->base.content);
+	mipmap->num_levels = 0;
+
+	_cairo_surface_attach_snapshot (&image->base, &mipmap->base, NULL);
+	cairo_surface_destroy (&mipmap->base);
+    }
+
+    if (*level > CAIRO_IMAGE_MIPMAP_MAX_LEVELS)
+	*level = CAIRO_IMAGE_MIPMAP_MAX_LEVELS;
+
+    while (mipmap->num_levels < *level) {
+	cairo_image_surface_t *src, *dst;
+
+	src = mipmap->num_levels ? mipmap->levels[mipmap->num_levels - 1] : image;
+	if (src->width == 1 && src->height == 1)
+	    break;
+
+	dst = _cairo_image_mipmap_reduce (src);
+	if (unlikely (dst->base.status)) {
+	    cairo_surface_destroy (&dst->base);
+	    break;
+	}
+
+	mipmap->levels[mipmap->num_levels++] = dst;
+    }
+
+    *level = mipmap->num_levels;
+    if (*level == 0)
+	return NULL;
+
+    return mipmap->levels[*level - 1];
+}
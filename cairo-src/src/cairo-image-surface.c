@@ -47,6 +47,8 @@
 #include "cairo-scaled-font-private.h"
 #include "cairo-surface-snapshot-private.h"
 #include "cairo-surface-subsurface-private.h"
+#include "cairo-thread-cache-private.h"
+#include "cairo-tiled-image-surface-private.h"
 
 /* Limit on the width / height of an image surface in pixels.  This is
  * mainly determined by coordinates of things sent to pixman at the
@@ -88,6 +90,9 @@ _cairo_image_surface_fill (void *dst,
 static pixman_image_t *
 _pixman_image_for_solid (const cairo_solid_pattern_t *pattern);
 
+static void
+_cairo_image_source_cache_destroy (struct _cairo_image_source_cache *cache);
+
 static cairo_bool_t
 _cairo_image_surface_is_size_valid (int width, int height)
 {
@@ -165,6 +170,7 @@ _cairo_image_surface_create_for_pixman_image (pixman_image_t		*pixman_image,
 			 _cairo_content_from_pixman_format (pixman_format));
 
     surface->pixman_image = pixman_image;
+    surface->source_cache = NULL;
 
     surface->pixman_format = pixman_format;
     surface->format = _cairo_format_from_pixman_format (pixman_format);
@@ -725,6 +731,11 @@ _cairo_image_surface_finish (void *abstract_surface)
 {
     cairo_image_surface_t *surface = abstract_surface;
 
+    if (surface->source_cache) {
+	_cairo_image_source_cache_destroy (surface->source_cache);
+	surface->source_cache = NULL;
+    }
+
     if (surface->pixman_image) {
 	pixman_image_unref (surface->pixman_image);
 	surface->pixman_image = NULL;
@@ -744,6 +755,12 @@ _cairo_image_surface_assume_ownership_of_data (cairo_image_surface_t *surface)
     surface->owns_data = TRUE;
 }
 
+static cairo_status_t
+_cairo_image_surface_flush (void *abstract_surface)
+{
+    return _cairo_image_file_flush (abstract_surface);
+}
+
 static cairo_status_t
 _cairo_image_surface_acquire_source_image (void                    *abstract_surface,
 					   cairo_image_surface_t  **image_out,
@@ -995,18 +1012,77 @@ hars_petruska_f54_1_random (void)
 #undef rol
 }
 
-static pixman_image_t *
-_pixman_image_for_solid (const cairo_solid_pattern_t *pattern)
-{
-    static struct {
+/* Solid colours are looked up in a small cache, kept per thread so that
+ * concurrent solid fills need not serialise on a lock; see
+ * cairo-thread-cache-private.h.
+ */
+typedef struct _cairo_image_solid_cache {
+    struct {
 	cairo_color_t color;
 	pixman_image_t *image;
     } cache[16];
-    static int n_cached;
-    pixman_color_t color;
+    int size;
+    int next;
+} cairo_image_solid_cache_t;
+
+static void
+_cairo_image_solid_cache_fini (void *closure)
+{
+    cairo_image_solid_cache_t *cache = closure;
+
+    while (cache->size)
+	pixman_image_unref (cache->cache[--cache->size].image);
+}
+
+static cairo_thread_cache_t _cairo_image_solid_cache =
+    CAIRO_THREAD_CACHE_INIT (CAIRO_THREAD_CACHE_SOLID_IMAGE,
+			     cairo_image_solid_cache_t,
+			     NULL, _cairo_image_solid_cache_fini,
+			     _cairo_image_solid_cache_mutex);
+
+static pixman_image_t *
+_cairo_image_solid_cache_lookup (cairo_image_solid_cache_t *cache,
+				 const cairo_color_t *color)
+{
+    pixman_color_t pixman_color;
     pixman_image_t *image;
     int i;
 
+    if (likely (cache != NULL)) {
+	for (i = 0; i < cache->size; i++) {
+	    if (_cairo_color_equal (&cache->cache[i].color, color))
+		return pixman_image_ref (cache->cache[i].image);
+	}
+    }
+
+    pixman_color.red   = color->red_short;
+    pixman_color.green = color->green_short;
+    pixman_color.blue  = color->blue_short;
+    pixman_color.alpha = color->alpha_short;
+
+    image = pixman_image_create_solid_fill (&pixman_color);
+    if (image == NULL || cache == NULL)
+	return image;
+
+    if (cache->size < ARRAY_LENGTH (cache->cache)) {
+	i = cache->size++;
+    } else {
+	i = cache->next;
+	cache->next = (i + 1) % ARRAY_LENGTH (cache->cache);
+	pixman_image_unref (cache->cache[i].image);
+    }
+    cache->cache[i].image = pixman_image_ref (image);
+    cache->cache[i].color = *color;
+
+    return image;
+}
+
+static pixman_image_t *
+_pixman_image_for_solid (const cairo_solid_pattern_t *pattern)
+{
+    cairo_image_solid_cache_t *cache;
+    pixman_image_t *image;
+
 #if HAS_ATOMIC_OPS
     if (pattern->color.alpha_short <= 0x00ff)
 	return _pixman_transparent_image ();
@@ -1028,34 +1104,11 @@ _pixman_image_for_solid (const cairo_solid_pattern_t *pattern)
     }
 #endif
 
-    CAIRO_MUTEX_LOCK (_cairo_image_solid_cache_mutex);
-    for (i = 0; i < n_cached; i++) {
-	if (_cairo_color_equal (&cache[i].color, &pattern->color)) {
-	    image = pixman_image_ref (cache[i].image);
-	    goto UNLOCK;
-	}
-    }
-
-    color.red   = pattern->color.red_short;
-    color.green = pattern->color.green_short;
-    color.blue  = pattern->color.blue_short;
-    color.alpha = pattern->color.alpha_short;
-
-    image = pixman_image_create_solid_fill (&color);
-    if (image == NULL)
-	goto UNLOCK;
-
-    if (n_cached < ARRAY_LENGTH (cache)) {
-	i = n_cached++;
-    } else {
-	i = hars_petruska_f54_1_random () % ARRAY_LENGTH (cache);
-	pixman_image_unref (cache[i].image);
-    }
-    cache[i].image = pixman_image_ref (image);
-    cache[i].color = pattern->color;
+    cache = _cairo_thread_cache_get (&_cairo_image_solid_cache);
+    image = _cairo_image_solid_cache_lookup (cache, &pattern->color);
+    if (likely (cache != NULL))
+	_cairo_thread_cache_put (&_cairo_image_solid_cache, cache);
 
-UNLOCK:
-    CAIRO_MUTEX_UNLOCK (_cairo_image_solid_cache_mutex);
     return image;
 }
 
@@ -1338,6 +1391,259 @@ _pixel_to_solid (cairo_image_surface_t *image, int x, int y)
     }
 }
 
+static pixman_filter_t
+_pixman_filter (cairo_filter_t filter)
+{
+    switch (filter) {
+    case CAIRO_FILTER_FAST:
+	return PIXMAN_FILTER_FAST;
+    case CAIRO_FILTER_GOOD:
+    case CAIRO_FILTER_MIPMAP:
+	return PIXMAN_FILTER_GOOD;
+    case CAIRO_FILTER_BEST:
+	return PIXMAN_FILTER_BEST;
+    case CAIRO_FILTER_NEAREST:
+	return PIXMAN_FILTER_NEAREST;
+    case CAIRO_FILTER_BILINEAR:
+	return PIXMAN_FILTER_BILINEAR;
+    case CAIRO_FILTER_GAUSSIAN:
+	/* XXX: The GAUSSIAN value has no implementation in cairo
+	 * whatsoever, so it was really a mistake to have it in the
+	 * API. We could fix this by officially deprecating it, or
+	 * else inventing semantics and providing an actual
+	 * implementation for it. */
+    default:
+	return PIXMAN_FILTER_BEST;
+    }
+}
+
+static pixman_repeat_t
+_pixman_repeat (cairo_extend_t extend)
+{
+    switch (extend) {
+    default:
+    case CAIRO_EXTEND_NONE:
+	return PIXMAN_REPEAT_NONE;
+    case CAIRO_EXTEND_REPEAT:
+	return PIXMAN_REPEAT_NORMAL;
+    case CAIRO_EXTEND_REFLECT:
+	return PIXMAN_REPEAT_REFLECT;
+    case CAIRO_EXTEND_PAD:
+	return PIXMAN_REPEAT_PAD;
+    }
+}
+
+/* Sprite sheets and other atlases are painted over and over again with
+ * nothing more than a translation, so the few pixman images prepared to
+ * sample them, differing only in filter, repeat and sub-pixel offset,
+ * are kept on the source surface. As for the solid images above, the
+ * shared images are never modified once created; since they alias the
+ * pixels of the surface they need no invalidation until it is finished.
+ */
+#define CAIRO_IMAGE_SOURCE_CACHE_SIZE 4
+
+struct _cairo_image_source_cache {
+    struct {
+	pixman_image_t *image;
+	pixman_filter_t filter;
+	pixman_repeat_t repeat;
+	pixman_fixed_t x, y;
+    } entry[CAIRO_IMAGE_SOURCE_CACHE_SIZE];
+    int num_entries;
+};
+
+static void
+_cairo_image_source_cache_destroy (struct _cairo_image_source_cache *cache)
+{
+    int i;
+
+    for (i = 0; i < cache->num_entries; i++)
+	pixman_image_unref (cache->entry[i].image);
+    free (cache);
+}
+
+static pixman_image_t *
+_pixman_image_for_translated_image (cairo_image_surface_t *source,
+				    cairo_filter_t filter,
+				    cairo_extend_t extend,
+				    const cairo_matrix_t *matrix,
+				    int *ix, int *iy)
+{
+    struct _cairo_image_source_cache *cache;
+    pixman_image_t *pixman_image;
+    pixman_filter_t pixman_filter;
+    pixman_repeat_t pixman_repeat;
+    pixman_fixed_t x, y;
+    double tx, ty;
+    int i;
+
+    /* Leave only the sub-pixel part of the offset to the transform so
+     * that every position of the source shares the same image.
+     */
+    tx = matrix->x0;
+    ty = matrix->y0;
+    if (_nearest_sample (filter, &tx, &ty)) {
+	x = y = 0;
+    } else {
+	x = _cairo_fixed_16_16_from_double (tx - floor (tx));
+	y = _cairo_fixed_16_16_from_double (ty - floor (ty));
+	tx = floor (tx);
+	ty = floor (ty);
+    }
+    *ix = tx;
+    *iy = ty;
+
+    if (tx == matrix->x0 && ty == matrix->y0)
+	pixman_filter = PIXMAN_FILTER_NEAREST;
+    else
+	pixman_filter = _pixman_filter (filter);
+    pixman_repeat = _pixman_repeat (extend);
+
+    CAIRO_MUTEX_LOCK (_cairo_image_source_cache_mutex);
+    cache = source->source_cache;
+    if (cache == NULL)
+	cache = source->source_cache = calloc (1, sizeof (*cache));
+
+    if (cache != NULL) {
+	for (i = 0; i < cache->num_entries; i++) {
+	    if (cache->entry[i].filter == pixman_filter &&
+		cache->entry[i].repeat == pixman_repeat &&
+		cache->entry[i].x == x &&
+		cache->entry[i].y == y)
+	    {
+		pixman_image = pixman_image_ref (cache->entry[i].image);
+		goto UNLOCK;
+	    }
+	}
+    }
+
+    pixman_image = pixman_image_create_bits (source->pixman_format,
+					     source->width,
+					     source->height,
+					     (uint32_t *) source->data,
+					     source->stride);
+    if (unlikely (pixman_image == NULL))
+	goto UNLOCK;
+
+    if (x | y) {
+	pixman_transform_t pixman_transform;
+
+	pixman_transform_init_translate (&pixman_transform, x, y);
+	if (! pixman_image_set_transform (pixman_image, &pixman_transform)) {
+	    pixman_image_unref (pixman_image);
+	    pixman_image = NULL;
+	    goto UNLOCK;
+	}
+    }
+    pixman_image_set_filter (pixman_image, pixman_filter, NULL, 0);
+    pixman_image_set_repeat (pixman_image, pixman_repeat);
+
+    if (cache != NULL) {
+	if (cache->num_entries < CAIRO_IMAGE_SOURCE_CACHE_SIZE) {
+	    i = cache->num_entries++;
+	} else {
+	    i = hars_petruska_f54_1_random () % CAIRO_IMAGE_SOURCE_CACHE_SIZE;
+	    pixman_image_unref (cache->entry[i].image);
+	}
+	cache->entry[i].image = pixman_image_ref (pixman_image);
+	cache->entry[i].filter = pixman_filter;
+	cache->entry[i].repeat = pixman_repeat;
+	cache->entry[i].x = x;
+	cache->entry[i].y = y;
+    }
+
+UNLOCK:
+    CAIRO_MUTEX_UNLOCK (_cairo_image_source_cache_mutex);
+    return pixman_image;
+}
+
+/* Returns the image snapshot of a source from another backend, making
+ * one on first use, so that it is only read back or converted once for
+ * as long as it is left unmodified.
+ */
+static cairo_image_surface_t *
+_cairo_image_surface_source_snapshot (cairo_surface_t *surface)
+{
+    cairo_image_surface_t *image, *clone;
+    cairo_surface_t *snapshot;
+    void *extra;
+    cairo_status_t status;
+
+    snapshot = _cairo_surface_has_snapshot (surface, &_cairo_image_surface_backend);
+    if (snapshot != NULL)
+	return (cairo_image_surface_t *) snapshot;
+
+    status = _cairo_surface_acquire_source_image (surface, &image, &extra);
+    if (unlikely (status))
+	return NULL;
+
+    /* the backend may have kept the image as its own snapshot */
+    snapshot = _cairo_surface_has_snapshot (surface, &_cairo_image_surface_backend);
+    if (snapshot == NULL) {
+	clone = (cairo_image_surface_t *)
+	    _cairo_image_surface_create_with_pixman_format (NULL,
+							    image->pixman_format,
+							    image->width,
+							    image->height,
+							    0);
+	if (likely (clone->base.status == CAIRO_STATUS_SUCCESS)) {
+	    pixman_image_composite32 (PIXMAN_OP_SRC,
+				      image->pixman_image, NULL, clone->pixman_image,
+				      0, 0,
+				      0, 0,
+				      0, 0,
+				      image->width, image->height);
+	    clone->base.is_clear = FALSE;
+
+	    _cairo_surface_attach_snapshot (surface, &clone->base, NULL);
+	    snapshot = &clone->base;
+	}
+	cairo_surface_destroy (&clone->base);
+    }
+
+    _cairo_surface_release_source_image (surface, image, extra);
+    return (cairo_image_surface_t *) snapshot;
+}
+
+/* Replaces @source by the reduction closest to, but no smaller than, the
+ * size it is sampled at, and maps @matrix and @sample onto it.
+ */
+static cairo_image_surface_t *
+_cairo_image_surface_select_mipmap (cairo_image_surface_t *source,
+				    cairo_matrix_t *matrix,
+				    cairo_rectangle_int_t *sample)
+{
+    cairo_image_surface_t *mipmap;
+    cairo_matrix_t m;
+    double scale;
+    int level, x1, y1, x2, y2;
+
+    scale = MIN (hypot (matrix->xx, matrix->yx),
+		 hypot (matrix->xy, matrix->yy));
+    if (! (scale >= 2.))
+	return source;
+
+    level = floor (log2 (scale));
+    mipmap = _cairo_image_surface_get_mipmap (source, &level);
+    if (mipmap == NULL)
+	return source;
+
+    scale = 1. / (1 << level);
+    cairo_matrix_init_scale (&m, scale, scale);
+    cairo_matrix_multiply (matrix, matrix, &m);
+
+    x1 = floor (sample->x * scale);
+    y1 = floor (sample->y * scale);
+    x2 = ceil ((sample->x + sample->width)  * scale);
+    y2 = ceil ((sample->y + sample->height) * scale);
+    sample->x = x1;
+    sample->y = y1;
+    sample->width  = x2 - x1;
+    sample->height = y2 - y1;
+
+    return mipmap;
+}
+
 static pixman_image_t *
 _pixman_image_for_surface (const cairo_surface_pattern_t *pattern,
 			   cairo_bool_t is_mask,
@@ -1345,30 +1651,64 @@ _pixman_image_for_surface (const cairo_surface_pattern_t *pattern,
 			   int *ix, int *iy)
 {
     pixman_image_t *pixman_image;
+    cairo_surface_t *surface;
     cairo_rectangle_int_t sample;
     cairo_extend_t extend;
     cairo_filter_t filter;
+    cairo_matrix_t matrix;
     double tx, ty;
 
-    tx = pattern->base.matrix.x0;
-    ty = pattern->base.matrix.y0;
+    matrix = pattern->base.matrix;
+    tx = matrix.x0;
+    ty = matrix.y0;
 
     extend = pattern->base.extend;
     filter = sampled_area (pattern, extents, &sample);
 
+    /* Subsurfaces are not snapshotted as their target may be modified
+     * beneath them, nor are tiled images which are sampled in place.
+     */
+    surface = pattern->surface;
+    if (surface->type != CAIRO_SURFACE_TYPE_IMAGE &&
+	surface->backend->type != CAIRO_SURFACE_TYPE_SUBSURFACE &&
+	! _cairo_surface_is_tiled_image (surface))
+    {
+	cairo_image_surface_t *snapshot;
+
+	snapshot = _cairo_image_surface_source_snapshot (surface);
+	if (snapshot != NULL)
+	    surface = &snapshot->base;
+    }
+
     pixman_image = NULL;
-    if (pattern->surface->type == CAIRO_SURFACE_TYPE_IMAGE &&
+    if (surface->type == CAIRO_SURFACE_TYPE_IMAGE &&
 	(! is_mask || ! pattern->base.has_component_alpha ||
-	 (pattern->surface->content & CAIRO_CONTENT_COLOR) == 0))
+	 (surface->content & CAIRO_CONTENT_COLOR) == 0))
     {
-	cairo_image_surface_t *source = (cairo_image_surface_t *) pattern->surface;
+	cairo_image_surface_t *source = (cairo_image_surface_t *) surface;
 	cairo_surface_type_t type;
 
-	if (source->base.backend->type == CAIRO_INTERNAL_SURFACE_TYPE_SNAPSHOT)
-	    source = (cairo_image_surface_t *) ((cairo_surface_snapshot_t *) pattern->surface)->target;
+	/* a snapshot of a detached snapshot wraps another snapshot */
+	while (source->base.backend->type ==
+	       (cairo_surface_type_t) CAIRO_INTERNAL_SURFACE_TYPE_SNAPSHOT)
+	{
+	    source = (cairo_image_surface_t *)
+		_cairo_surface_snapshot_get_target (&source->base);
+	}
 
 	type = source->base.backend->type;
 	if (type == CAIRO_SURFACE_TYPE_IMAGE) {
+	    if (filter == CAIRO_FILTER_MIPMAP) {
+		source = _cairo_image_surface_select_mipmap (source,
+							     &matrix,
+							     &sample);
+		filter = CAIRO_FILTER_GOOD;
+		if (_cairo_matrix_is_pixel_exact (&matrix))
+		    filter = CAIRO_FILTER_NEAREST;
+		tx = matrix.x0;
+		ty = matrix.y0;
+	    }
+
 	    if (extend != CAIRO_EXTEND_NONE &&
 		sample.x >= 0 &&
 		sample.y >= 0 &&
@@ -1395,7 +1735,7 @@ _pixman_image_for_surface (const cairo_surface_pattern_t *pattern,
 
 	    /* avoid allocating a 'pattern' image if we can reuse the original */
 	    if (extend == CAIRO_EXTEND_NONE &&
-		_cairo_matrix_is_translation (&pattern->base.matrix) &&
+		_cairo_matrix_is_translation (&matrix) &&
 		_nearest_sample (filter, &tx, &ty))
 	    {
 		*ix = tx;
@@ -1403,6 +1743,15 @@ _pixman_image_for_surface (const cairo_surface_pattern_t *pattern,
 		return pixman_image_ref (source->pixman_image);
 	    }
 
+	    if (! pattern->base.has_component_alpha &&
+		_cairo_matrix_is_translation (&matrix) &&
+		fabs (matrix.x0) < PIXMAN_MAX_INT &&
+		fabs (matrix.y0) < PIXMAN_MAX_INT)
+	    {
+		return _pixman_image_for_translated_image (source, filter, extend,
+							   &matrix, ix, iy);
+	    }
+
 	    pixman_image = pixman_image_create_bits (source->pixman_format,
 						     source->width,
 						     source->height,
@@ -1456,6 +1805,38 @@ _pixman_image_for_surface (const cairo_surface_pattern_t *pattern,
 		    return NULL;
 	    }
 	}
+    } else if (_cairo_surface_is_tiled_image (pattern->surface)) {
+	cairo_tiled_image_surface_t *source = (cairo_tiled_image_surface_t *) pattern->surface;
+	cairo_rectangle_int_t source_extents;
+
+	if (extend != CAIRO_EXTEND_NONE &&
+	    sample.x >= 0 &&
+	    sample.y >= 0 &&
+	    sample.x + sample.width  <= source->width &&
+	    sample.y + sample.height <= source->height)
+	{
+	    extend = CAIRO_EXTEND_NONE;
+	}
+
+	/* only assemble the tiles that are actually sampled */
+	if (extend == CAIRO_EXTEND_NONE) {
+	    cairo_matrix_t m;
+
+	    source_extents.x = source_extents.y = 0;
+	    source_extents.width  = source->width;
+	    source_extents.height = source->height;
+	    if (! _cairo_rectangle_intersect (&sample, &source_extents))
+		return _pixman_transparent_image ();
+
+	    pixman_image = _cairo_tiled_image_surface_get_region (source, &sample);
+	    if (unlikely (pixman_image == NULL))
+		return NULL;
+
+	    cairo_matrix_init_translate (&m, -sample.x, -sample.y);
+	    cairo_matrix_multiply (&matrix, &matrix, &m);
+	    tx = matrix.x0;
+	    ty = matrix.y0;
+	}
     }
 
     if (pixman_image == NULL) {
@@ -1512,13 +1893,13 @@ _pixman_image_for_surface (const cairo_surface_pattern_t *pattern,
 					   _acquire_source_cleanup, cleanup);
     }
 
-    if (! _cairo_matrix_is_translation (&pattern->base.matrix) ||
+    if (! _cairo_matrix_is_translation (&matrix) ||
 	! _nearest_sample (filter, &tx, &ty))
     {
 	pixman_transform_t pixman_transform;
 	cairo_matrix_t m;
 
-	m = pattern->base.matrix;
+	m = matrix;
 	if (m.x0 != 0. || m.y0 != 0.) {
 	    cairo_matrix_t inv;
 	    cairo_status_t status;
@@ -1552,66 +1933,18 @@ _pixman_image_for_surface (const cairo_surface_pattern_t *pattern,
     *ix = tx;
     *iy = ty;
 
-    if (_cairo_matrix_has_unity_scale (&pattern->base.matrix) &&
-	tx == pattern->base.matrix.x0 &&
-	ty == pattern->base.matrix.y0)
+    if (_cairo_matrix_has_unity_scale (&matrix) &&
+	tx == matrix.x0 &&
+	ty == matrix.y0)
     {
 	pixman_image_set_filter (pixman_image, PIXMAN_FILTER_NEAREST, NULL, 0);
     }
     else
     {
-	pixman_filter_t pixman_filter;
-
-	switch (filter) {
-	case CAIRO_FILTER_FAST:
-	    pixman_filter = PIXMAN_FILTER_FAST;
-	    break;
-	case CAIRO_FILTER_GOOD:
-	    pixman_filter = PIXMAN_FILTER_GOOD;
-	    break;
-	case CAIRO_FILTER_BEST:
-	    pixman_filter = PIXMAN_FILTER_BEST;
-	    break;
-	case CAIRO_FILTER_NEAREST:
-	    pixman_filter = PIXMAN_FILTER_NEAREST;
-	    break;
-	case CAIRO_FILTER_BILINEAR:
-	    pixman_filter = PIXMAN_FILTER_BILINEAR;
-	    break;
-	case CAIRO_FILTER_GAUSSIAN:
-	    /* XXX: The GAUSSIAN value has no implementation in cairo
-	     * whatsoever, so it was really a mistake to have it in the
-	     * API. We could fix this by officially deprecating it, or
-	     * else inventing semantics and providing an actual
-	     * implementation for it. */
-	default:
-	    pixman_filter = PIXMAN_FILTER_BEST;
-	}
-
-	pixman_image_set_filter (pixman_image, pixman_filter, NULL, 0);
+	pixman_image_set_filter (pixman_image, _pixman_filter (filter), NULL, 0);
     }
 
-    {
-	pixman_repeat_t pixman_repeat;
-
-	switch (extend) {
-	default:
-	case CAIRO_EXTEND_NONE:
-	    pixman_repeat = PIXMAN_REPEAT_NONE;
-	    break;
-	case CAIRO_EXTEND_REPEAT:
-	    pixman_repeat = PIXMAN_REPEAT_NORMAL;
-	    break;
-	case CAIRO_EXTEND_REFLECT:
-	    pixman_repeat = PIXMAN_REPEAT_REFLECT;
-	    break;
-	case CAIRO_EXTEND_PAD:
-	    pixman_repeat = PIXMAN_REPEAT_PAD;
-	    break;
-	}
-
-	pixman_image_set_repeat (pixman_image, pixman_repeat);
-    }
+    pixman_image_set_repeat (pixman_image, _pixman_repeat (extend));
 
     if (pattern->base.has_component_alpha)
 	pixman_image_set_component_alpha (pixman_image, TRUE);
@@ -3185,6 +3518,49 @@ _clip_and_composite_trapezoids (cairo_image_surface_t *dst,
 				extents, clip);
 }
 
+static cairo_bool_t
+_clip_path_is_aligned_box (cairo_clip_path_t *clip_path)
+{
+    cairo_box_t box;
+
+    return _cairo_path_fixed_is_box (&clip_path->path, &box) &&
+	_cairo_fixed_is_integer (box.p1.x) &&
+	_cairo_fixed_is_integer (box.p1.y) &&
+	_cairo_fixed_is_integer (box.p2.x) &&
+	_cairo_fixed_is_integer (box.p2.y);
+}
+
+/* Returns whether the clip ends with a band of a larger rendering
+ * whose top cuts the operation, where it would be uncut without it. */
+static cairo_bool_t
+_clip_is_band (cairo_clip_t *clip,
+	       const cairo_composite_rectangles_t *extents)
+{
+    cairo_clip_path_t *clip_path;
+    int top;
+
+    if (clip == NULL || clip->path == NULL)
+	return FALSE;
+
+    clip_path = clip->path;
+    if ((clip_path->flags & CAIRO_CLIP_PATH_IS_BAND) == 0)
+	return FALSE;
+
+    top = 0;
+    if (clip_path->prev != NULL && clip_path->prev->extents.y > top)
+	top = clip_path->prev->extents.y;
+    if (extents->is_bounded & CAIRO_OPERATOR_BOUND_BY_SOURCE &&
+	extents->source.y > top)
+    {
+	top = extents->source.y;
+    }
+
+    return clip_path->extents.y > top;
+}
+
+/* Returns the only path of a clip that is otherwise made of pixel
+ * aligned boxes, which are then fully described by the extents of the
+ * operation. */
 static cairo_clip_path_t *
 _clip_get_single_path (cairo_clip_t *clip)
 {
@@ -3194,9 +3570,11 @@ _clip_get_single_path (cairo_clip_t *clip)
     do {
 	if ((iter->flags & CAIRO_CLIP_PATH_IS_BOX) == 0) {
 	    if (path != NULL)
-		return FALSE;
+		return NULL;
 
 	    path = iter;
+	} else if (! _clip_path_is_aligned_box (iter)) {
+	    return NULL;
 	}
 	iter = iter->prev;
     } while (iter != NULL);
@@ -3219,6 +3597,7 @@ _cairo_image_surface_paint (void			*abstract_surface,
     cairo_bool_t have_clip = FALSE;
     cairo_box_t boxes_stack[32], *clip_boxes = boxes_stack;
     int num_boxes = ARRAY_LENGTH (boxes_stack);
+    cairo_bool_t is_band;
     cairo_status_t status;
 
     status = _cairo_composite_rectangles_init_for_paint (&extents,
@@ -3229,6 +3608,8 @@ _cairo_image_surface_paint (void			*abstract_surface,
     if (unlikely (status))
 	return status;
 
+    is_band = _clip_is_band (clip, &extents);
+
     if (_cairo_clip_contains_extents (clip, &extents))
 	clip = NULL;
 
@@ -3254,12 +3635,23 @@ _cairo_image_surface_paint (void			*abstract_surface,
 	extents.is_bounded &&
 	(clip_path = _clip_get_single_path (clip)) != NULL)
     {
-	status = _cairo_image_surface_fill (surface, op, source,
-					    &clip_path->path,
-					    clip_path->fill_rule,
-					    clip_path->tolerance,
-					    clip_path->antialias,
-					    NULL);
+	cairo_clip_t box_clip;
+
+	/* Any boxes of the clip remain in the extents. */
+	_cairo_clip_init (&box_clip);
+	status = _cairo_clip_rectangle (&box_clip, &extents.bounded);
+	if (likely (status == CAIRO_STATUS_SUCCESS)) {
+	    if (is_band && box_clip.path != NULL)
+		box_clip.path->flags |= CAIRO_CLIP_PATH_IS_BAND;
+
+	    status = _cairo_image_surface_fill (surface, op, source,
+						&clip_path->path,
+						clip_path->fill_rule,
+						clip_path->tolerance,
+						clip_path->antialias,
+						&box_clip);
+	}
+	_cairo_clip_fini (&box_clip);
     }
     else
     {
@@ -3377,47 +3769,21 @@ typedef struct {
     cairo_antialias_t		 antialias;
 } composite_spans_info_t;
 
-//#define USE_BOTOR_SCAN_CONVERTER
 static cairo_status_t
-_composite_spans (void                          *closure,
-		  pixman_image_t		*dst,
-		  pixman_format_code_t		 dst_format,
-		  cairo_operator_t               op,
-		  const cairo_pattern_t         *pattern,
-		  int                            dst_x,
-		  int                            dst_y,
-		  const cairo_rectangle_int_t   *extents,
-		  cairo_region_t		*clip_region)
+_composite_scan_converter (cairo_scan_converter_t	*converter,
+			   pixman_image_t		*dst,
+			   pixman_format_code_t		 dst_format,
+			   cairo_operator_t		 op,
+			   const cairo_pattern_t	*pattern,
+			   int				 dst_x,
+			   int				 dst_y,
+			   const cairo_rectangle_int_t	*extents)
 {
     uint8_t mask_buf[CAIRO_STACK_BUFFER_SIZE];
-    composite_spans_info_t *info = closure;
     cairo_image_surface_span_renderer_t renderer;
-#if USE_BOTOR_SCAN_CONVERTER
-    cairo_box_t box;
-    cairo_botor_scan_converter_t converter;
-#else
-    cairo_scan_converter_t *converter;
-#endif
     pixman_image_t *mask;
     cairo_status_t status;
 
-#if USE_BOTOR_SCAN_CONVERTER
-    box.p1.x = _cairo_fixed_from_int (extents->x);
-    box.p1.y = _cairo_fixed_from_int (extents->y);
-    box.p2.x = _cairo_fixed_from_int (extents->x + extents->width);
-    box.p2.y = _cairo_fixed_from_int (extents->y + extents->height);
-    _cairo_botor_scan_converter_init (&converter, &box, info->fill_rule);
-    status = converter.base.add_polygon (&converter.base, info->polygon);
-#else
-    converter = _cairo_tor_scan_converter_create (extents->x, extents->y,
-						  extents->x + extents->width,
-						  extents->y + extents->height,
-						  info->fill_rule);
-    status = converter->add_polygon (converter, info->polygon);
-#endif
-    if (unlikely (status))
-	goto CLEANUP_CONVERTER;
-
     /* TODO: support rendering to A1 surfaces (or: go add span
      * compositing to pixman.) */
 
@@ -3438,10 +3804,8 @@ _composite_spans (void                          *closure,
 					 extents->height,
 					 (uint32_t *) data,
 					 stride);
-	if (unlikely (mask == NULL)) {
-	    status = _cairo_error (CAIRO_STATUS_NO_MEMORY);
-	    goto CLEANUP_CONVERTER;
-	}
+	if (unlikely (mask == NULL))
+	    return _cairo_error (CAIRO_STATUS_NO_MEMORY);
     }
 
     renderer.base.render_rows = _cairo_image_surface_span;
@@ -3452,11 +3816,7 @@ _composite_spans (void                          *closure,
     else
 	renderer.mask_data -= dst_y * renderer.mask_stride + dst_x;
 
-#if USE_BOTOR_SCAN_CONVERTER
-    status = converter.base.generate (&converter.base, &renderer.base);
-#else
     status = converter->generate (converter, &renderer.base);
-#endif
     if (unlikely (status))
 	goto CLEANUP_RENDERER;
 
@@ -3481,6 +3841,57 @@ _composite_spans (void                          *closure,
  CLEANUP_RENDERER:
     if (dst != NULL)
 	pixman_image_unref (mask);
+    return status;
+}
+
+//#define USE_BOTOR_SCAN_CONVERTER
+static cairo_status_t
+_composite_spans (void                          *closure,
+		  pixman_image_t		*dst,
+		  pixman_format_code_t		 dst_format,
+		  cairo_operator_t               op,
+		  const cairo_pattern_t         *pattern,
+		  int                            dst_x,
+		  int                            dst_y,
+		  const cairo_rectangle_int_t   *extents,
+		  cairo_region_t		*clip_region)
+{
+    composite_spans_info_t *info = closure;
+#if USE_BOTOR_SCAN_CONVERTER
+    cairo_box_t box;
+    cairo_botor_scan_converter_t converter;
+#else
+    cairo_scan_converter_t *converter;
+#endif
+    cairo_status_t status;
+
+#if USE_BOTOR_SCAN_CONVERTER
+    box.p1.x = _cairo_fixed_from_int (extents->x);
+    box.p1.y = _cairo_fixed_from_int (extents->y);
+    box.p2.x = _cairo_fixed_from_int (extents->x + extents->width);
+    box.p2.y = _cairo_fixed_from_int (extents->y + extents->height);
+    _cairo_botor_scan_converter_init (&converter, &box, info->fill_rule);
+    status = converter.base.add_polygon (&converter.base, info->polygon);
+#else
+    converter = _cairo_tor_scan_converter_create (extents->x, extents->y,
+						  extents->x + extents->width,
+						  extents->y + extents->height,
+						  info->fill_rule);
+    status = converter->add_polygon (converter, info->polygon);
+#endif
+    if (unlikely (status))
+	goto CLEANUP_CONVERTER;
+
+#if USE_BOTOR_SCAN_CONVERTER
+    status = _composite_scan_converter (&converter.base,
+#else
+    status = _composite_scan_converter (converter,
+#endif
+					dst, dst_format,
+					op, pattern,
+					dst_x, dst_y,
+					extents);
+
  CLEANUP_CONVERTER:
 #if USE_BOTOR_SCAN_CONVERTER
     converter.base.destroy (&converter.base);
@@ -3490,6 +3901,49 @@ _composite_spans (void                          *closure,
     return status;
 }
 
+typedef struct {
+    cairo_path_fixed_t		*path;
+    const cairo_stroke_style_t	*style;
+    const cairo_matrix_t	*ctm;
+    const cairo_matrix_t	*ctm_inverse;
+    double			 tolerance;
+} composite_hairlines_info_t;
+
+static cairo_status_t
+_composite_hairlines (void                          *closure,
+		      pixman_image_t		*dst,
+		      pixman_format_code_t	 dst_format,
+		      cairo_operator_t           op,
+		      const cairo_pattern_t     *pattern,
+		      int                        dst_x,
+		      int                        dst_y,
+		      const cairo_rectangle_int_t *extents,
+		      cairo_region_t		*clip_region)
+{
+    composite_hairlines_info_t *info = closure;
+    cairo_hairline_scan_converter_t converter;
+    cairo_status_t status;
+
+    _cairo_hairline_scan_converter_init (&converter, extents);
+
+    status = _cairo_path_fixed_stroke_to_hairlines (info->path,
+						    info->style,
+						    info->ctm,
+						    info->ctm_inverse,
+						    info->tolerance,
+						    &converter);
+    if (likely (status == CAIRO_STATUS_SUCCESS)) {
+	status = _composite_scan_converter (&converter.base,
+					    dst, dst_format,
+					    op, pattern,
+					    dst_x, dst_y,
+					    extents);
+    }
+
+    converter.base.destroy (&converter.base);
+    return status;
+}
+
 static cairo_status_t
 _clip_and_composite_polygon (cairo_image_surface_t *dst,
 			     cairo_operator_t op,
@@ -3570,6 +4024,7 @@ _cairo_image_surface_stroke (void			*abstract_surface,
     int num_boxes = ARRAY_LENGTH (boxes_stack);
     cairo_clip_t local_clip;
     cairo_bool_t have_clip = FALSE;
+    cairo_bool_t is_band;
     cairo_status_t status;
 
     status = _cairo_composite_rectangles_init_for_stroke (&extents,
@@ -3581,6 +4036,8 @@ _cairo_image_surface_stroke (void			*abstract_surface,
     if (unlikely (status))
 	return status;
 
+    is_band = _clip_is_band (clip, &extents);
+
     if (_cairo_clip_contains_extents (clip, &extents))
 	clip = NULL;
 
@@ -3617,11 +4074,34 @@ _cairo_image_surface_stroke (void			*abstract_surface,
 	_cairo_boxes_fini (&boxes);
     }
 
+    /* When allowed to trade quality for speed, hairlines bypass the
+     * construction of the stroke outline and are rendered directly to
+     * spans. As they are not limited to the clip boxes, they are only
+     * used when the clip has been reduced to the extents. */
+    if (status == CAIRO_INT_STATUS_UNSUPPORTED &&
+	antialias == CAIRO_ANTIALIAS_FAST &&
+	num_boxes == 1 &&
+	_cairo_stroke_style_is_hairline (style, ctm))
+    {
+	composite_hairlines_info_t info;
+
+	info.path = path;
+	info.style = style;
+	info.ctm = ctm;
+	info.ctm_inverse = ctm_inverse;
+	info.tolerance = tolerance;
+
+	status = _clip_and_composite (surface, op, source,
+				      _composite_hairlines, &info,
+				      &extents, clip);
+    }
+
     if (status == CAIRO_INT_STATUS_UNSUPPORTED) {
 	cairo_polygon_t polygon;
 
 	_cairo_polygon_init (&polygon);
 	_cairo_polygon_limit (&polygon, clip_boxes, num_boxes);
+	polygon.is_band = is_band;
 
 	status = _cairo_path_fixed_stroke_to_polygon (path,
 						      style,
@@ -3662,6 +4142,7 @@ _cairo_image_surface_fill (void				*abstract_surface,
     cairo_clip_t local_clip;
     cairo_bool_t have_clip = FALSE;
     int num_boxes = ARRAY_LENGTH (boxes_stack);
+    cairo_bool_t is_band;
     cairo_status_t status;
 
     status = _cairo_composite_rectangles_init_for_fill (&extents,
@@ -3672,6 +4153,8 @@ _cairo_image_surface_fill (void				*abstract_surface,
     if (unlikely (status))
 	return status;
 
+    is_band = _clip_is_band (clip, &extents);
+
     if (_cairo_clip_contains_extents (clip, &extents))
 	clip = NULL;
 
@@ -3721,8 +4204,14 @@ _cairo_image_surface_fill (void				*abstract_surface,
 
 	_cairo_polygon_init (&polygon);
 	_cairo_polygon_limit (&polygon, clip_boxes, num_boxes);
+	polygon.is_band = is_band;
 
-	status = _cairo_path_fixed_fill_to_polygon (path, tolerance, &polygon);
+	/* Flattening dominates the cost of filling curve-heavy paths,
+	 * so use the cheaper uniform decomposition if allowed. */
+	if (antialias == CAIRO_ANTIALIAS_FAST)
+	    status = _cairo_path_fixed_fill_to_polygon_uniform (path, tolerance, &polygon);
+	else
+	    status = _cairo_path_fixed_fill_to_polygon (path, tolerance, &polygon);
 	if (likely (status == CAIRO_STATUS_SUCCESS)) {
 	    status = _clip_and_composite_polygon (surface, op, source, &polygon,
 						  fill_rule, antialias,
@@ -4559,7 +5048,7 @@ const cairo_surface_backend_t _cairo_image_surface_backend = {
     _cairo_image_surface_get_extents,
     NULL, /* old_show_glyphs */
     _cairo_image_surface_get_font_options,
-    NULL, /* flush */
+    _cairo_image_surface_flush,
     NULL, /* mark dirty */
     NULL, /* font_fini */
     NULL, /* glyph_fini */
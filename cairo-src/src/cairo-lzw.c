@@ -34,147 +34,10 @@
  *	Carl D. Worth <cworth@cworth.org>
  */
 
+
 #include "cairoint.h"
 #include "cairo-error-private.h"
-
-typedef struct _lzw_buf {
-    cairo_status_t status;
-
-    unsigned char *data;
-    int data_size;
-    int num_data;
-    uint32_t pending;
-    unsigned int pending_bits;
-} lzw_buf_t;
-
-/* An lzw_buf_t is a simple, growable chunk of memory for holding
- * variable-size objects of up to 16 bits each.
- *
- * Initialize an lzw_buf_t to the given size in bytes.
- *
- * To store objects into the lzw_buf_t, call _lzw_buf_store_bits and
- * when finished, call _lzw_buf_store_pending, (which flushes out the
- * last few bits that hadn't yet made a complete byte yet).
- *
- * Instead of returning failure from any functions, lzw_buf_t provides
- * a status value that the caller can query, (and should query at
- * least once when done with the object). The status value will be
- * either %CAIRO_STATUS_SUCCESS or %CAIRO_STATUS_NO_MEMORY;
- */
-static void
-_lzw_buf_init (lzw_buf_t *buf, int size)
-{
-    if (size == 0)
-	size = 16;
-
-    buf->status = CAIRO_STATUS_SUCCESS;
-    buf->data_size = size;
-    buf->num_data = 0;
-    buf->pending = 0;
-    buf->pending_bits = 0;
-
-    buf->data = malloc (size);
-    if (unlikely (buf->data == NULL)) {
-	buf->data_size = 0;
-	buf->status = _cairo_error (CAIRO_STATUS_NO_MEMORY);
-	return;
-    }
-}
-
-/* Increase the buffer size by doubling.
- *
- * Returns %CAIRO_STATUS_SUCCESS or %CAIRO_STATUS_NO_MEMORY
- */
-static cairo_status_t
-_lzw_buf_grow (lzw_buf_t *buf)
-{
-    int new_size = buf->data_size * 2;
-    unsigned char *new_data;
-
-    if (buf->status)
-	return buf->status;
-
-    new_data = NULL;
-    /* check for integer overflow */
-    if (new_size / 2 == buf->data_size)
-	new_data = realloc (buf->data, new_size);
-
-    if (unlikely (new_data == NULL)) {
-	free (buf->data);
-	buf->data_size = 0;
-	buf->status = _cairo_error (CAIRO_STATUS_NO_MEMORY);
-	return buf->status;
-    }
-
-    buf->data = new_data;
-    buf->data_size = new_size;
-
-    return CAIRO_STATUS_SUCCESS;
-}
-
-/* Store the lowest num_bits bits of values into buf.
- *
- * Note: The bits of value above size_in_bits must be 0, (so don't lie
- * about the size).
- *
- * See also _lzw_buf_store_pending which must be called after the last
- * call to _lzw_buf_store_bits.
- *
- * Sets buf->status to either %CAIRO_STATUS_SUCCESS or %CAIRO_STATUS_NO_MEMORY.
- */
-static void
-_lzw_buf_store_bits (lzw_buf_t *buf, uint16_t value, int num_bits)
-{
-    cairo_status_t status;
-
-    assert (value <= (1 << num_bits) - 1);
-
-    if (buf->status)
-	return;
-
-    buf->pending = (buf->pending << num_bits) | value;
-    buf->pending_bits += num_bits;
-
-    while (buf->pending_bits >= 8) {
-	if (buf->num_data >= buf->data_size) {
-	    status = _lzw_buf_grow (buf);
-	    if (unlikely (status))
-		return;
-	}
-	buf->data[buf->num_data++] = buf->pending >> (buf->pending_bits - 8);
-	buf->pending_bits -= 8;
-    }
-}
-
-/* Store the last remaining pending bits into the buffer.
- *
- * Note: This function must be called after the last call to
- * _lzw_buf_store_bits.
- *
- * Sets buf->status to either %CAIRO_STATUS_SUCCESS or %CAIRO_STATUS_NO_MEMORY.
- */
-static void
-_lzw_buf_store_pending  (lzw_buf_t *buf)
-{
-    cairo_status_t status;
-
-    if (buf->status)
-	return;
-
-    if (buf->pending_bits == 0)
-	return;
-
-    assert (buf->pending_bits < 8);
-
-    if (buf->num_data >= buf->data_size) {
-	status = _lzw_buf_grow (buf);
-	if (unlikely (status))
-	    return;
-    }
-
-    buf->data[buf->num_data++] = buf->pending << (8 - buf->pending_bits);
-    buf->pending_bits = 0;
-}
+#include "cairo-output-stream-private.h"
 
 /* LZW defines a few magic code values */
 #define LZW_CODE_CLEAR_TABLE	256
@@ -192,8 +55,6 @@ typedef uint32_t lzw_symbol_t;
 #define LZW_SYMBOL_SET(sym, prev, next)			((sym) = ((prev) << 8)|(next))
 #define LZW_SYMBOL_SET_CODE(sym, code, prev, next)	((sym) = ((code << 20)|(prev) << 8)|(next))
 #define LZW_SYMBOL_GET_CODE(sym)			(((sym) >> 20))
-#define LZW_SYMBOL_GET_PREV(sym)			(((sym) >>  8) & 0x7ff)
-#define LZW_SYMBOL_GET_BYTE(sym)			(((sym) >>  0) & 0x0ff)
 
 /* The PREV+NEXT fields can be seen as the key used to fetch values
  * from the hash table, while the code is the value fetched.
@@ -217,91 +78,103 @@ typedef uint32_t lzw_symbol_t;
 #define LZW_BITS_BOUNDARY(bits)	((1<<(bits))-1)
 #define LZW_MAX_SYMBOLS		(1<<LZW_BITS_MAX)
 
-#define LZW_SYMBOL_TABLE_SIZE	9013
-#define LZW_SYMBOL_MOD1		LZW_SYMBOL_TABLE_SIZE
-#define LZW_SYMBOL_MOD2		9011
+/* At most LZW_MAX_SYMBOLS - LZW_CODE_FIRST symbols are live between
+ * two clear codes, so a table of twice LZW_MAX_SYMBOLS entries stays
+ * less than half full.  At 32 KiB it also fits in the L1 cache.
+ */
+#define LZW_SYMBOL_TABLE_BITS	13
+#define LZW_SYMBOL_TABLE_SIZE	(1 << LZW_SYMBOL_TABLE_BITS)
+#define LZW_SYMBOL_TABLE_MASK	(LZW_SYMBOL_TABLE_SIZE - 1)
+
+#define LZW_BUFFER_SIZE		4096
+
+typedef struct _cairo_lzw_stream {
+    cairo_output_stream_t base;
+    cairo_output_stream_t *output;
 
-typedef struct _lzw_symbol_table {
     lzw_symbol_t table[LZW_SYMBOL_TABLE_SIZE];
-} lzw_symbol_table_t;
+    int code_next;
+    int code_bits;
+    int prev;
+
+    uint32_t pending;
+    unsigned int pending_bits;
+    unsigned int num_data;
+    unsigned char data[LZW_BUFFER_SIZE];
+} cairo_lzw_stream_t;
 
 /* Initialize the hash table to entirely empty */
 static void
-_lzw_symbol_table_init (lzw_symbol_table_t *table)
+_lzw_symbol_table_init (cairo_lzw_stream_t *stream)
 {
-    memset (table->table, 0, LZW_SYMBOL_TABLE_SIZE * sizeof (lzw_symbol_t));
+    memset (stream->table, 0, sizeof (stream->table));
 }
 
 /* Lookup a symbol in the symbol table. The PREV and NEXT fields of
  * symbol form the key for the lookup.
  *
- * If successful, then this function returns %TRUE and slot_ret will be
- * left pointing at the result that will have the CODE field of
- * interest.
- *
- * If the lookup fails, then this function returns %FALSE and slot_ret
- * will be pointing at the location in the table to which a new CODE
- * value should be stored along with PREV and NEXT.
+ * This returns the slot holding the symbol if it is present, or the
+ * free slot at which it should be inserted otherwise.
  */
-static cairo_bool_t
-_lzw_symbol_table_lookup (lzw_symbol_table_t	 *table,
-			  lzw_symbol_t		  symbol,
-			  lzw_symbol_t		**slot_ret)
+static inline lzw_symbol_t *
+_lzw_symbol_table_lookup (cairo_lzw_stream_t *stream,
+			  lzw_symbol_t	      symbol)
 {
-    /* The algorithm here is identical to that in cairo-hash.c. We
-     * copy it here to allow for a rather more efficient
-     * implementation due to several circumstances that do not apply
-     * to the more general case:
+    /* The algorithm here is a simpler variant of that in cairo-hash.c:
      *
      * 1) We have a known bound on the total number of symbols, so we
-     *    have a fixed-size table without any copying when growing
+     *    have a fixed-size table without any copying when growing,
+     *    and since it is never more than half full a lookup always
+     *    terminates after a few probes.
      *
      * 2) We never delete any entries, so we don't need to
      *    support/check for DEAD entries during lookup.
      *
      * 3) The object fits in 32 bits so we store each object in its
      *    entirety within the table rather than storing objects
-     *    externally and putting pointers in the table, (which here
-     *    would just double the storage requirements and have negative
-     *    impacts on memory locality).
+     *    externally and putting pointers in the table.
+     *
+     * A multiplicative hash and linear probing keep collisions in
+     * neighbouring slots, usually the same cache line.
      */
-    int i, idx, step, hash = symbol & LZW_SYMBOL_KEY_MASK;
+    unsigned int idx;
     lzw_symbol_t candidate;
 
-    idx = hash % LZW_SYMBOL_MOD1;
-    step = 0;
-
-    *slot_ret = NULL;
-    for (i = 0; i < LZW_SYMBOL_TABLE_SIZE; i++)
-    {
-	candidate = table->table[idx];
-	if (candidate == LZW_SYMBOL_FREE)
-	{
-	    *slot_ret = &table->table[idx];
-	    return FALSE;
-	}
-	else /* candidate is LIVE */
+    idx = (symbol * 2654435761u) >> (32 - LZW_SYMBOL_TABLE_BITS);
+    while (1) {
+	candidate = stream->table[idx];
+	if (candidate == LZW_SYMBOL_FREE ||
+	    (candidate & LZW_SYMBOL_KEY_MASK) == symbol)
 	{
-	    if ((candidate & LZW_SYMBOL_KEY_MASK) ==
-		(symbol & LZW_SYMBOL_KEY_MASK))
-	    {
-		*slot_ret = &table->table[idx];
-		return TRUE;
-	    }
+	    return &stream->table[idx];
 	}
 
-	if (step == 0) {
-	    step = hash % LZW_SYMBOL_MOD2;
-	    if (step == 0)
-		step = 1;
-	}
+	idx = (idx + 1) & LZW_SYMBOL_TABLE_MASK;
+    }
+}
+
+/* Store the lowest num_bits bits of value into the output buffer,
+ * most significant bit first.  The buffer is passed on to the
+ * underlying stream whenever it fills up.
+ */
+static inline void
+_lzw_stream_store_bits (cairo_lzw_stream_t *stream, int value, int num_bits)
+{
+    assert (value <= LZW_BITS_BOUNDARY (num_bits));
 
-	idx += step;
-	if (idx >= LZW_SYMBOL_TABLE_SIZE)
-	    idx -= LZW_SYMBOL_TABLE_SIZE;
+    stream->pending = (stream->pending << num_bits) | value;
+    stream->pending_bits += num_bits;
+
+    while (stream->pending_bits >= 8) {
+	stream->pending_bits -= 8;
+	stream->data[stream->num_data++] = stream->pending >> stream->pending_bits;
     }
 
-    return FALSE;
+    if (stream->num_data > LZW_BUFFER_SIZE - 2) {
+	_cairo_output_stream_write (stream->output,
+				    stream->data, stream->num_data);
+	stream->num_data = 0;
+    }
 }
 
 /* Compress a bytestream using the LZW algorithm.
@@ -312,93 +185,122 @@ _lzw_symbol_table_lookup (lzw_symbol_table_t	 *table,
  * values mandated by PostScript, (symbols encoded with widths from 9
  * to 12 bits).
  *
- * This function returns a pointer to a newly allocated buffer holding
- * the compressed data, or %NULL if an out-of-memory situation
- * occurs.
- *
- * Notice that any one of the _lzw_buf functions called here could
- * trigger an out-of-memory condition. But lzw_buf_t uses cairo's
- * shutdown-on-error idiom, so it's safe to continue to call into
- * lzw_buf without having to check for errors, (until a final check at
- * the end).
+ * The string matched so far is carried over between writes in
+ * stream->prev, so the data may be fed in pieces of any size, (such
+ * as one scanline at a time), and the result is the same as
+ * compressing it in one go.
  */
-unsigned char *
-_cairo_lzw_compress (unsigned char *data, unsigned long *size_in_out)
+static cairo_status_t
+_cairo_lzw_stream_write (cairo_output_stream_t *base,
+			 const unsigned char   *data,
+			 unsigned int	        length)
 {
-    int bytes_remaining = *size_in_out;
-    lzw_buf_t buf;
-    lzw_symbol_table_t table;
-    lzw_symbol_t symbol, *slot = NULL; /* just to squelch a warning */
-    int code_next = LZW_CODE_FIRST;
-    int code_bits = LZW_BITS_MIN;
-    int prev, next = 0; /* just to squelch a warning */
-
-    if (*size_in_out == 0)
-	return NULL;
-
-    _lzw_buf_init (&buf, *size_in_out);
+    cairo_lzw_stream_t *stream = (cairo_lzw_stream_t *) base;
+    lzw_symbol_t symbol, *slot;
+    int prev, next;
 
-    _lzw_symbol_table_init (&table);
+    if (length == 0)
+	return CAIRO_STATUS_SUCCESS;
 
-    /* The LZW header is a clear table code. */
-    _lzw_buf_store_bits (&buf, LZW_CODE_CLEAR_TABLE, code_bits);
+    prev = stream->prev;
+    if (prev < 0) {
+	prev = *data++;
+	length--;
+    }
 
-    while (1) {
+    while (length--) {
+	/* Extend the current match for as long as the symbol table
+	 * holds the longer string. */
+	next = *data++;
+	LZW_SYMBOL_SET (symbol, prev, next);
+	slot = _lzw_symbol_table_lookup (stream, symbol);
+	if (*slot != LZW_SYMBOL_FREE) {
+	    prev = LZW_SYMBOL_GET_CODE (*slot);
+	    continue;
+	}
 
-	/* Find the longest existing code in the symbol table that
-	 * matches the current input, if any. */
-	prev = *data++;
-	bytes_remaining--;
-	if (bytes_remaining) {
-	    do
-	    {
-		next = *data++;
-		bytes_remaining--;
-		LZW_SYMBOL_SET (symbol, prev, next);
-		if (_lzw_symbol_table_lookup (&table, symbol, &slot))
-		    prev = LZW_SYMBOL_GET_CODE (*slot);
-	    } while (bytes_remaining && *slot != LZW_SYMBOL_FREE);
-	    if (*slot == LZW_SYMBOL_FREE) {
-		data--;
-		bytes_remaining++;
+	/* Write the code for the longest match into the output and
+	 * start the next match from the byte that did not fit. */
+	_lzw_stream_store_bits (stream, prev, stream->code_bits);
+
+	LZW_SYMBOL_SET_CODE (*slot, stream->code_next, prev, next);
+	stream->code_next++;
+
+	if (stream->code_next > LZW_BITS_BOUNDARY (stream->code_bits)) {
+	    stream->code_bits++;
+	    if (stream->code_bits > LZW_BITS_MAX) {
+		_lzw_symbol_table_init (stream);
+		_lzw_stream_store_bits (stream, LZW_CODE_CLEAR_TABLE,
+					stream->code_bits - 1);
+		stream->code_bits = LZW_BITS_MIN;
+		stream->code_next = LZW_CODE_FIRST;
 	    }
 	}
 
-	/* Write the code into the output. This is either a byte read
-	 * directly from the input, or a code from the last successful
-	 * lookup. */
-	_lzw_buf_store_bits (&buf, prev, code_bits);
+	prev = next;
+    }
 
-	if (bytes_remaining == 0)
-	    break;
+    stream->prev = prev;
 
-	LZW_SYMBOL_SET_CODE (*slot, code_next++, prev, next);
+    return _cairo_output_stream_get_status (stream->output);
+}
 
-	if (code_next > LZW_BITS_BOUNDARY(code_bits))
-	{
-	    code_bits++;
-	    if (code_bits > LZW_BITS_MAX) {
-		_lzw_symbol_table_init (&table);
-		_lzw_buf_store_bits (&buf, LZW_CODE_CLEAR_TABLE, code_bits - 1);
-		code_bits = LZW_BITS_MIN;
-		code_next = LZW_CODE_FIRST;
-	    }
-	}
-    }
+static cairo_status_t
+_cairo_lzw_stream_close (cairo_output_stream_t *base)
+{
+    cairo_lzw_stream_t *stream = (cairo_lzw_stream_t *) base;
+
+    if (stream->prev >= 0)
+	_lzw_stream_store_bits (stream, stream->prev, stream->code_bits);
 
     /* The LZW footer is an end-of-data code. */
-    _lzw_buf_store_bits (&buf, LZW_CODE_EOD, code_bits);
+    _lzw_stream_store_bits (stream, LZW_CODE_EOD, stream->code_bits);
+
+    /* Store the last remaining pending bits */
+    if (stream->pending_bits) {
+	assert (stream->pending_bits < 8);
+	stream->data[stream->num_data++] =
+	    stream->pending << (8 - stream->pending_bits);
+	stream->pending_bits = 0;
+    }
+
+    _cairo_output_stream_write (stream->output,
+				stream->data, stream->num_data);
+
+    return _cairo_output_stream_get_status (stream->output);
+}
 
-    _lzw_buf_store_pending (&buf);
+cairo_output_stream_t *
+_cairo_lzw_stream_create (cairo_output_stream_t *output)
+{
+    cairo_lzw_stream_t *stream;
+
+    if (output->status)
+	return _cairo_output_stream_create_in_error (output->status);
 
-    /* See if we ever ran out of memory while writing to buf. */
-    if (buf.status == CAIRO_STATUS_NO_MEMORY) {
-	*size_in_out = 0;
-	return NULL;
+    stream = malloc (sizeof (cairo_lzw_stream_t));
+    if (unlikely (stream == NULL)) {
+	_cairo_error_throw (CAIRO_STATUS_NO_MEMORY);
+	return (cairo_output_stream_t *) &_cairo_output_stream_nil;
     }
 
-    assert (buf.status == CAIRO_STATUS_SUCCESS);
+    _cairo_output_stream_init (&stream->base,
+			       _cairo_lzw_stream_write,
+			       NULL,
+			       _cairo_lzw_stream_close);
+    stream->output = output;
+
+    _lzw_symbol_table_init (stream);
+    stream->code_next = LZW_CODE_FIRST;
+    stream->code_bits = LZW_BITS_MIN;
+    stream->prev = -1;
+
+    stream->pending = 0;
+    stream->pending_bits = 0;
+    stream->num_data = 0;
+
+    /* The LZW header is a clear table code. */
+    _lzw_stream_store_bits (stream, LZW_CODE_CLEAR_TABLE, stream->code_bits);
 
-    *size_in_out = buf.num_data;
-    return buf.data;
+    return &stream->base;
 }
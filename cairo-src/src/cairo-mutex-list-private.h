@@ -39,6 +39,12 @@
 CAIRO_MUTEX_DECLARE (_cairo_pattern_solid_surface_cache_lock)
 
 CAIRO_MUTEX_DECLARE (_cairo_image_solid_cache_mutex)
+CAIRO_MUTEX_DECLARE (_cairo_image_source_cache_mutex)
+
+CAIRO_MUTEX_DECLARE (_cairo_pen_cache_mutex)
+CAIRO_MUTEX_DECLARE (_cairo_thread_cache_mutex)
+
+CAIRO_MUTEX_DECLARE (_cairo_clip_mask_cache_mutex)
 
 CAIRO_MUTEX_DECLARE (_cairo_error_mutex)
 CAIRO_MUTEX_DECLARE (_cairo_toy_font_face_mutex)
@@ -49,6 +55,7 @@ CAIRO_MUTEX_DECLARE (_cairo_scaled_font_error_mutex)
 
 #if CAIRO_HAS_FT_FONT
 CAIRO_MUTEX_DECLARE (_cairo_ft_unscaled_font_map_mutex)
+CAIRO_MUTEX_DECLARE (_cairo_ft_table_cache_mutex)
 #endif
 
 #if CAIRO_HAS_XLIB_SURFACE
@@ -135,6 +135,12 @@ _cairo_output_stream_printf (cairo_output_stream_t *stream,
 			     const char *fmt,
 			     ...) CAIRO_PRINTF_FORMAT (2, 3);
 
+cairo_private void
+_cairo_output_stream_print_numbers (cairo_output_stream_t *stream,
+				    const double	  *values,
+				    int			   num_values,
+				    const char		  *op);
+
 cairo_private long
 _cairo_output_stream_get_position (cairo_output_stream_t *stream);
 
@@ -169,6 +175,9 @@ cairo_private void
 _cairo_memory_stream_copy (cairo_output_stream_t *base,
 			   cairo_output_stream_t *dest);
 
+cairo_private void
+_cairo_memory_stream_reset (cairo_output_stream_t *stream);
+
 cairo_private int
 _cairo_memory_stream_length (cairo_output_stream_t *stream);
 
@@ -192,5 +201,31 @@ _cairo_base64_stream_create (cairo_output_stream_t *output);
 cairo_private cairo_output_stream_t *
 _cairo_deflate_stream_create (cairo_output_stream_t *output);
 
+typedef struct _cairo_deflate_job cairo_deflate_job_t;
+
+cairo_private cairo_bool_t
+_cairo_deflate_job_can_run_in_parallel (void);
+
+cairo_private cairo_deflate_job_t *
+_cairo_deflate_job_create (unsigned char *data,
+			   unsigned long  length);
+
+cairo_private void
+_cairo_deflate_job_compress (cairo_deflate_job_t *job);
+
+cairo_private cairo_bool_t
+_cairo_deflate_job_is_done (cairo_deflate_job_t *job);
+
+cairo_private cairo_status_t
+_cairo_deflate_job_write (cairo_deflate_job_t	*job,
+			  cairo_output_stream_t	*output);
+
+cairo_private void
+_cairo_deflate_job_destroy (cairo_deflate_job_t *job);
+
+/* cairo-lzw.c */
+cairo_private cairo_output_stream_t *
+_cairo_lzw_stream_create (cairo_output_stream_t *output);
+
 
 #endif /* CAIRO_OUTPUT_STREAM_PRIVATE_H */
@@ -267,31 +267,86 @@ _cairo_output_stream_write (cairo_output_stream_t *stream,
     stream->position += length;
 }
 
+#define HEX_LINE_LENGTH 38
+#define HEX_BUFFER_SIZE 4096
+
+#define LANES(x) ((uint64_t) (x) * ((((uint64_t) 0x01010101) << 32) | 0x01010101))
+#define NIBBLES ((((uint64_t) 0x000f000f) << 32) | 0x000f000f)
+
+static const char hex_chars[] = "0123456789abcdef";
+
+/* Convert four bytes into eight hex digits at once, one digit per byte
+ * of a 64-bit word: the nibbles are spread into the lanes, and the
+ * lanes holding 10 or more are moved up from '0'.. to 'a'.. */
+static void
+_hex_encode_4 (const unsigned char *src, unsigned char *dst)
+{
+    uint64_t x, nibbles, chr;
+
+#ifdef WORDS_BIGENDIAN
+    x = (uint64_t) src[0] << 48 | (uint64_t) src[1] << 32 | (uint64_t) src[2] << 16 | src[3];
+    nibbles = ((x << 4) & (NIBBLES << 8)) | (x & NIBBLES);
+#else
+    x = src[0] | (uint64_t) src[1] << 16 | (uint64_t) src[2] << 32 | (uint64_t) src[3] << 48;
+    nibbles = ((x >> 4) & NIBBLES) | ((x & NIBBLES) << 8);
+#endif
+
+    chr = nibbles + LANES ('0');
+    chr += (((nibbles + LANES (6)) >> 4) & LANES (1)) * ('a' - '0' - 10);
+
+    memcpy (dst, &chr, 8);
+}
+
+static void
+_hex_encode (const unsigned char *src, unsigned int length, unsigned char *dst)
+{
+    for (; length >= 4; length -= 4) {
+	_hex_encode_4 (src, dst);
+	src += 4;
+	dst += 8;
+    }
+
+    while (length--) {
+	*dst++ = hex_chars[(*src >> 4) & 0x0f];
+	*dst++ = hex_chars[*src++ & 0x0f];
+    }
+}
+
 void
 _cairo_output_stream_write_hex_string (cairo_output_stream_t *stream,
 				       const unsigned char *data,
 				       size_t length)
 {
-    const char hex_chars[] = "0123456789abcdef";
-    char buffer[2];
-    unsigned int i, column;
+    unsigned char buffer[HEX_BUFFER_SIZE];
+    unsigned int n, line;
+    cairo_bool_t first = TRUE;
 
     if (stream->status)
 	return;
 
-    for (i = 0, column = 0; i < length; i++, column++) {
-	if (column == 38) {
-	    _cairo_output_stream_write (stream, "\n", 1);
-	    column = 0;
+    n = 0;
+    while (length) {
+	line = MIN (length, HEX_LINE_LENGTH);
+	if (n + 1 + 2 * line > HEX_BUFFER_SIZE) {
+	    _cairo_output_stream_write (stream, buffer, n);
+	    n = 0;
 	}
-	buffer[0] = hex_chars[(data[i] >> 4) & 0x0f];
-	buffer[1] = hex_chars[data[i] & 0x0f];
-	_cairo_output_stream_write (stream, buffer, 2);
+
+	if (! first)
+	    buffer[n++] = '\n';
+	first = FALSE;
+
+	_hex_encode (data, line, buffer + n);
+	n += 2 * line;
+	data += line;
+	length -= line;
     }
+    _cairo_output_stream_write (stream, buffer, n);
 }
 
 /* Format a double in a locale independent way and trim trailing
- * zeros.  Based on code from Alex Larson <alexl@redhat.com>.
+ * zeros, using snprintf().  This is the fallback for _cairo_dtostr()
+ * below.  Based on code from Alex Larson <alexl@redhat.com>.
  * http://mail.gnome.org/archives/gtk-devel-list/2001-October/msg00087.html
  *
  * The code in the patch is copyright Red Hat, Inc under the LGPL, but
@@ -299,7 +354,7 @@ _cairo_output_stream_write_hex_string (cairo_output_stream_t *stream,
  * into cairo (see COPYING). -- Kristian Høgsberg <krh@redhat.com>
  */
 static void
-_cairo_dtostr (char *buffer, size_t size, double d, cairo_bool_t limited_precision)
+_cairo_dtostr_printf (char *buffer, size_t size, double d, cairo_bool_t limited_precision)
 {
     struct lconv *locale_data;
     const char *decimal_point;
@@ -382,6 +437,117 @@ _cairo_dtostr (char *buffer, size_t size, double d, cairo_bool_t limited_precisi
     }
 }
 
+static const double _cairo_dtostr_powers_of_ten[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7,
+    1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15
+};
+
+/* Print @d with @decimals digits after the decimal point, as
+ * snprintf("%.*f") would in the C locale, and trim trailing zeros.
+ *
+ * The fraction is scaled and rounded using doubles, which is exact
+ * enough to decide the rounding unless the scaled fraction lies very
+ * close to a half; we then return %FALSE and leave the number to
+ * snprintf(), which rounds the exact binary value.
+ */
+static cairo_bool_t
+_cairo_dtostr_fixed (char *buffer, double d, int decimals)
+{
+    char digits[32];
+    uint64_t integer, fraction, one;
+    double a, scaled, rem;
+    char *p = buffer;
+    int n;
+
+    a = fabs (d);
+    if (! (a < 1e15)) /* also catches NaN */
+	return FALSE;
+
+    one = (uint64_t) _cairo_dtostr_powers_of_ten[decimals];
+    integer = (uint64_t) a;
+    scaled = (a - integer) * _cairo_dtostr_powers_of_ten[decimals];
+    fraction = (uint64_t) scaled;
+    rem = scaled - fraction;
+    if (fabs (rem - .5) < 1e-7)
+	return FALSE;
+
+    if (rem > .5 && ++fraction == one) {
+	fraction = 0;
+	integer++;
+    }
+
+    if (d < 0)
+	*p++ = '-';
+
+    n = 0;
+    do {
+	digits[n++] = '0' + integer % 10;
+	integer /= 10;
+    } while (integer);
+    while (n)
+	*p++ = digits[--n];
+
+    if (fraction) {
+	while (fraction % 10 == 0) {
+	    fraction /= 10;
+	    decimals--;
+	}
+
+	*p++ = '.';
+	for (n = decimals; n--; fraction /= 10)
+	    p[n] = '0' + fraction % 10;
+	p += decimals;
+    }
+
+    *p = '\0';
+    return TRUE;
+}
+
+/* Format a double in a locale independent way and trim trailing zeros,
+ * without calling localeconv() or snprintf() for all but the rarest
+ * of numbers.
+ *
+ * %g prints FIXED_POINT_DECIMAL_DIGITS decimals. %f prints six decimals
+ * for numbers of at least 0.1, and otherwise six significant digits
+ * after the leading zeros of the fraction, so that small numbers keep
+ * their precision.
+ */
+static void
+_cairo_dtostr (char *buffer, size_t size, double d, cairo_bool_t limited_precision)
+{
+    double a;
+    int zeros;
+
+    /* Omit the minus sign from negative zero. */
+    if (d == 0.0)
+	d = 0.0;
+
+    if (limited_precision) {
+	if (_cairo_dtostr_fixed (buffer, d, FIXED_POINT_DECIMAL_DIGITS))
+	    return;
+    } else {
+	a = fabs (d);
+	if (a >= 0.1) {
+	    if (_cairo_dtostr_fixed (buffer, d, SIGNIFICANT_DIGITS_AFTER_DECIMAL))
+		return;
+	} else if (a == 0.0) {
+	    buffer[0] = '0';
+	    buffer[1] = '\0';
+	    return;
+	} else if (a >= 1e-9) {
+	    zeros = 1;
+	    while (a < 1 / _cairo_dtostr_powers_of_ten[zeros + 1])
+		zeros++;
+
+	    if (_cairo_dtostr_fixed (buffer, d,
+				     zeros + SIGNIFICANT_DIGITS_AFTER_DECIMAL))
+		return;
+	}
+    }
+
+    _cairo_dtostr_printf (buffer, size, d, limited_precision);
+}
+
 enum {
     LENGTH_MODIFIER_LONG = 0x100
 };
@@ -528,6 +694,40 @@ _cairo_output_stream_printf (cairo_output_stream_t *stream,
     va_end (ap);
 }
 
+/* Writes each of @values as %g would, followed by a space, and then
+ * @op, formatting them all into one buffer rather than parsing a
+ * format string. This is for the coordinates of path operators,
+ * e.g. "x y l ", which make up the bulk of vector output.
+ */
+void
+_cairo_output_stream_print_numbers (cairo_output_stream_t *stream,
+				    const double	  *values,
+				    int			   num_values,
+				    const char		  *op)
+{
+    char buffer[1024];
+    char *p;
+    int i;
+
+    if (stream->status)
+	return;
+
+    p = buffer;
+    for (i = 0; i < num_values; i++) {
+	if (p - buffer > (int) sizeof (buffer) - 512) {
+	    _cairo_output_stream_write (stream, buffer, p - buffer);
+	    p = buffer;
+	}
+
+	_cairo_dtostr (p, 512, values[i], TRUE);
+	p += strlen (p);
+	*p++ = ' ';
+    }
+    _cairo_output_stream_write (stream, buffer, p - buffer);
+
+    _cairo_output_stream_write (stream, op, strlen (op));
+}
+
 long
 _cairo_output_stream_get_position (cairo_output_stream_t *stream)
 {
@@ -713,6 +913,21 @@ _cairo_memory_stream_destroy (cairo_output_stream_t *abstract_stream,
     return _cairo_output_stream_destroy (abstract_stream);
 }
 
+/* Discards the contents of the stream, and frees its buffer, so that
+ * it can be reused for the next batch of output. */
+void
+_cairo_memory_stream_reset (cairo_output_stream_t *base)
+{
+    memory_stream_t *stream = (memory_stream_t *) base;
+
+    if (base->status)
+	return;
+
+    _cairo_array_fini (&stream->array);
+    _cairo_array_init (&stream->array, 1);
+    base->position = 0;
+}
+
 void
 _cairo_memory_stream_copy (cairo_output_stream_t *base,
 			   cairo_output_stream_t *dest)
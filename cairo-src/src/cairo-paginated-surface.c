@@ -49,6 +49,7 @@
 #include "cairo-recording-surface-private.h"
 #include "cairo-analysis-surface-private.h"
 #include "cairo-error-private.h"
+#include "cairo-parallel-private.h"
 
 static const cairo_surface_backend_t cairo_paginated_surface_backend;
 
@@ -221,7 +222,7 @@ _cairo_paginated_surface_acquire_source_image (void	       *abstract_surface,
 							   extents.width,
 							   extents.height);
 
-    status = _cairo_recording_surface_replay (surface->recording_surface, image);
+    status = _cairo_recording_surface_replay_tiled (surface->recording_surface, image);
     if (unlikely (status)) {
 	cairo_surface_destroy (image);
 	return status;
@@ -241,33 +242,42 @@ _cairo_paginated_surface_release_source_image (void	  *abstract_surface,
     cairo_surface_destroy (&image->base);
 }
 
+/* Creates the image, at fallback resolution, into which the page is
+ * rasterised for the fallback of @rect. */
+static cairo_surface_t *
+_create_fallback_image (cairo_paginated_surface_t *surface,
+			const cairo_rectangle_int_t *rect)
+{
+    double x_scale = surface->base.x_fallback_resolution / surface->target->x_resolution;
+    double y_scale = surface->base.y_fallback_resolution / surface->target->y_resolution;
+    cairo_surface_t *image;
+
+    image = _cairo_paginated_surface_create_image_surface (surface,
+							   ceil (rect->width  * x_scale),
+							   ceil (rect->height * y_scale));
+    _cairo_surface_set_device_scale (image, x_scale, y_scale);
+    /* set_device_offset just sets the x0/y0 components of the matrix;
+     * so we have to do the scaling manually. */
+    cairo_surface_set_device_offset (image, -rect->x*x_scale, -rect->y*y_scale);
+
+    return image;
+}
+
+/* Paints the rasterised fallback @image of @rect onto the target. */
 static cairo_int_status_t
 _paint_fallback_image (cairo_paginated_surface_t *surface,
-		       cairo_rectangle_int_t     *rect)
+		       cairo_rectangle_int_t     *rect,
+		       cairo_surface_t		 *image)
 {
     double x_scale = surface->base.x_fallback_resolution / surface->target->x_resolution;
     double y_scale = surface->base.y_fallback_resolution / surface->target->y_resolution;
-    int x, y, width, height;
+    int x, y;
     cairo_status_t status;
-    cairo_surface_t *image;
     cairo_surface_pattern_t pattern;
     cairo_clip_t clip;
 
     x = rect->x;
     y = rect->y;
-    width = rect->width;
-    height = rect->height;
-    image = _cairo_paginated_surface_create_image_surface (surface,
-							   ceil (width  * x_scale),
-							   ceil (height * y_scale));
-    _cairo_surface_set_device_scale (image, x_scale, y_scale);
-    /* set_device_offset just sets the x0/y0 components of the matrix;
-     * so we have to do the scaling manually. */
-    cairo_surface_set_device_offset (image, -x*x_scale, -y*y_scale);
-
-    status = _cairo_recording_surface_replay (surface->recording_surface, image);
-    if (unlikely (status))
-	goto CLEANUP_IMAGE;
 
     _cairo_pattern_init_for_surface (&pattern, image);
     cairo_matrix_init (&pattern.base.matrix,
@@ -287,8 +297,55 @@ _paint_fallback_image (cairo_paginated_surface_t *surface,
     _cairo_clip_fini (&clip);
     _cairo_pattern_fini (&pattern.base);
 
-CLEANUP_IMAGE:
-    cairo_surface_destroy (image);
+    return status;
+}
+
+/* Rasterises and paints the fallbacks of the unsupported @region, a
+ * batch of rectangles at a time. The rectangles of each batch are
+ * rasterised concurrently where possible, each replaying just the
+ * commands that touch it, and are then painted in order. */
+static cairo_int_status_t
+_paint_fallback_region (cairo_paginated_surface_t *surface,
+			cairo_region_t		  *region)
+{
+    cairo_surface_t *stack_images[CAIRO_STACK_ARRAY_LENGTH (cairo_surface_t *)];
+    cairo_surface_t **images = stack_images;
+    cairo_rectangle_int_t rect;
+    int num_rects, batch_size, first, num_images, i;
+    cairo_status_t status = CAIRO_STATUS_SUCCESS;
+
+    num_rects = cairo_region_num_rectangles (region);
+    batch_size = MIN (2 * _cairo_parallel_num_threads (), num_rects);
+    if (batch_size > ARRAY_LENGTH (stack_images)) {
+	images = _cairo_malloc_ab (batch_size, sizeof (cairo_surface_t *));
+	if (unlikely (images == NULL))
+	    return _cairo_error (CAIRO_STATUS_NO_MEMORY);
+    }
+
+    for (first = 0; first < num_rects; first += num_images) {
+	num_images = MIN (batch_size, num_rects - first);
+	for (i = 0; i < num_images; i++) {
+	    cairo_region_get_rectangle (region, first + i, &rect);
+	    images[i] = _create_fallback_image (surface, &rect);
+	}
+
+	status = _cairo_recording_surface_replay_multiple (surface->recording_surface,
+							   images, num_images);
+
+	for (i = 0; i < num_images; i++) {
+	    if (likely (status == CAIRO_STATUS_SUCCESS)) {
+		cairo_region_get_rectangle (region, first + i, &rect);
+		status = _paint_fallback_image (surface, &rect, images[i]);
+	    }
+	    cairo_surface_destroy (images[i]);
+	}
+
+	if (unlikely (status))
+	    break;
+    }
+
+    if (images != stack_images)
+	free (images);
 
     return status;
 }
@@ -372,6 +429,7 @@ _paint_page (cairo_paginated_surface_t *surface)
     if (has_page_fallback) {
 	cairo_rectangle_int_t extents;
 	cairo_bool_t is_bounded;
+	cairo_surface_t *image;
 
 	surface->backend->set_paginated_mode (surface->target,
 		                              CAIRO_PAGINATED_MODE_FALLBACK);
@@ -382,29 +440,24 @@ _paint_page (cairo_paginated_surface_t *surface)
 	    goto FAIL;
 	}
 
-	status = _paint_fallback_image (surface, &extents);
+	image = _create_fallback_image (surface, &extents);
+	status = _cairo_recording_surface_replay_tiled (surface->recording_surface,
+							image);
+	if (likely (status == CAIRO_STATUS_SUCCESS))
+	    status = _paint_fallback_image (surface, &extents, image);
+	cairo_surface_destroy (image);
 	if (unlikely (status))
 	    goto FAIL;
     }
 
     if (has_finegrained_fallback) {
-        cairo_region_t *region;
-        int num_rects, i;
-
 	surface->backend->set_paginated_mode (surface->target,
 		                              CAIRO_PAGINATED_MODE_FALLBACK);
 
-	region = _cairo_analysis_surface_get_unsupported (analysis);
-
-	num_rects = cairo_region_num_rectangles (region);
-	for (i = 0; i < num_rects; i++) {
-	    cairo_rectangle_int_t rect;
-
-	    cairo_region_get_rectangle (region, i, &rect);
-	    status = _paint_fallback_image (surface, &rect);
-	    if (unlikely (status))
-		goto FAIL;
-	}
+	status = _paint_fallback_region (surface,
+					 _cairo_analysis_surface_get_unsupported (analysis));
+	if (unlikely (status))
+	    goto FAIL;
     }
 
   FAIL:
@@ -0,0 +1,62 @@
+/* cairo - a vector graphics library with display and print output
+ *
+ * Copyright © 2010 the cairo graphics library authors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it either under the terms of the GNU Lesser General Public
+ * License version 2.1 as published by the Free Software Foundation
+ * (the "LGPL") or, at your option, under the terms of the Mozilla
+ * Public License Version 1.1 (the "MPL"). If you do not alter this
+ * notice, a recipient may use your version of this file under either
+ * the MPL or the LGPL.
+ *
+ * You should have received a copy of the LGPL along with this library
+ * in the file COPYING-LGPL-2.1; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA 02110-1335, USA
+ * You should have received a copy of the MPL along with this library
+ * in the file COPYING-MPL-1.1
+ *
+ * The contents of this file are subject to the Mozilla Public License
+ * Version 1.1 (the "License"); you may not use this file except in
+ * compliance with the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY
+ * OF ANY KIND, either express or implied. See the LGPL or the MPL for
+ * the specific language governing rights and limitations.
+ *
+ * The Original Code is the cairo graphics library.
+ */
+
+#ifndef CAIRO_PARALLEL_PRIVATE_H
+#define CAIRO_PARALLEL_PRIVATE_H
+
+#include "cairo-compiler-private.h"
+#include "cairo-types-private.h"
+
+/* A minimal fork/join helper for splitting a job into independent
+ * tasks. Tasks are handed out in order to a persistent pool of worker
+ * threads, in which the caller takes part as one of the workers.
+ * Without native threads the tasks are simply run in order on the
+ * calling thread.
+ *
+ * The task functions must only touch state that is private to the
+ * task or protected by its own locking.
+ */
+
+typedef cairo_status_t
+(*cairo_parallel_func_t) (void *closure, int task);
+
+cairo_private int
+_cairo_parallel_num_threads (void);
+
+cairo_private cairo_status_t
+_cairo_parallel_for (int			 num_tasks,
+		     int			 max_threads,
+		     cairo_parallel_func_t	 func,
+		     void			*closure);
+
+cairo_private void
+_cairo_parallel_reset_static_data (void);
+
+#endif /* CAIRO_PARALLEL_PRIVATE_H */
@@ -0,0 +1,294 @@
+/* cairo - a vector graphics library with display and print output
+ *
+ * Copyright © 2010 the cairo graphics library authors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it either under the terms of the GNU Lesser General Public
+ * License version 2.1 as published by the Free Software Foundation
+ * (the "LGPL") or, at your option, under the terms of the Mozilla
+ * Public License Version 1.1 (the "MPL"). If you do not alter this
+ * notice, a recipient may use your version of this file under either
+ * the MPL or the LGPL.
+ *
+ * You should have received a copy of the LGPL along with this library
+ * in the file COPYING-LGPL-2.1; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA 02110-1335, USA
+ * You should have received a copy of the MPL along with this library
+ * in the file COPYING-MPL-1.1
+ *
+ * The contents of this file are subject to the Mozilla Public License
+ * Version 1.1 (the "License"); you may not use this file except in
+ * compliance with the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY
+ * OF ANY KIND, either express or implied. See the LGPL or the MPL for
+ * the specific language governing rights and limitations.
+ *
+ * The Original Code is the cairo graphics library.
+ */
+
+#include "cairoint.h"
+
+#include "cairo-parallel-private.h"
+
+#if CAIRO_HAS_REAL_PTHREAD
+#include <pthread.h>
+#endif
+
+#if HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
+#define CAIRO_PARALLEL_MAX_THREADS 16
+
+typedef struct _cairo_parallel {
+    cairo_parallel_func_t func;
+    void *closure;
+    int num_tasks;
+
+    cairo_mutex_t mutex;
+    int next_task;
+    cairo_status_t status;
+} cairo_parallel_t;
+
+/**
+ * _cairo_parallel_num_threads:
+ *
+ * Returns the number of threads worth running concurrently, which is
+ * the number of online processors (capped to a small limit), or 1 if
+ * the platform provides no threads.
+ **/
+int
+_cairo_parallel_num_threads (void)
+{
+#if CAIRO_HAS_REAL_PTHREAD && defined (_SC_NPROCESSORS_ONLN)
+    long n = sysconf (_SC_NPROCESSORS_ONLN);
+
+    if (n < 1)
+	return 1;
+    if (n > CAIRO_PARALLEL_MAX_THREADS)
+	return CAIRO_PARALLEL_MAX_THREADS;
+    return n;
+#else
+    return 1;
+#endif
+}
+
+static void
+_cairo_parallel_run (cairo_parallel_t *parallel)
+{
+    cairo_status_t status;
+    int task;
+
+    while (TRUE) {
+	CAIRO_MUTEX_LOCK (parallel->mutex);
+	task = parallel->next_task;
+	if (parallel->status == CAIRO_STATUS_SUCCESS &&
+	    task < parallel->num_tasks)
+	{
+	    parallel->next_task++;
+	}
+	else
+	{
+	    task = -1;
+	}
+	CAIRO_MUTEX_UNLOCK (parallel->mutex);
+
+	if (task < 0)
+	    return;
+
+	status = parallel->func (parallel->closure, task);
+	if (unlikely (status)) {
+	    CAIRO_MUTEX_LOCK (parallel->mutex);
+	    if (parallel->status == CAIRO_STATUS_SUCCESS)
+		parallel->status = status;
+	    CAIRO_MUTEX_UNLOCK (parallel->mutex);
+	}
+    }
+}
+
+#if CAIRO_HAS_REAL_PTHREAD
+/* The workers are started on first use and then kept waiting for
+ * further jobs, so that frequent small jobs do not pay for creating
+ * and joining threads. A single job is served at a time: callers that
+ * find the pool busy (including tasks that themselves try to fork)
+ * simply run their tasks on their own thread.
+ */
+static struct {
+    pthread_mutex_t mutex;
+    pthread_cond_t wake;
+    pthread_cond_t idle;
+
+    pthread_t threads[CAIRO_PARALLEL_MAX_THREADS - 1];
+    int num_threads;
+
+    cairo_parallel_t *job;
+    int num_wanted;
+    int num_joined;
+    int num_busy;
+    cairo_bool_t exiting;
+} _cairo_parallel_pool = {
+    PTHREAD_MUTEX_INITIALIZER,
+    PTHREAD_COND_INITIALIZER,
+    PTHREAD_COND_INITIALIZER,
+};
+
+static void *
+_cairo_parallel_thread (void *closure)
+{
+    cairo_parallel_t *job;
+
+    pthread_mutex_lock (&_cairo_parallel_pool.mutex);
+    while (TRUE) {
+	while (! _cairo_parallel_pool.exiting &&
+	       (_cairo_parallel_pool.job == NULL ||
+		_cairo_parallel_pool.num_joined == _cairo_parallel_pool.num_wanted))
+	{
+	    pthread_cond_wait (&_cairo_parallel_pool.wake,
+			       &_cairo_parallel_pool.mutex);
+	}
+	if (_cairo_parallel_pool.exiting)
+	    break;
+
+	job = _cairo_parallel_pool.job;
+	_cairo_parallel_pool.num_joined++;
+	_cairo_parallel_pool.num_busy++;
+	pthread_mutex_unlock (&_cairo_parallel_pool.mutex);
+
+	_cairo_parallel_run (job);
+
+	pthread_mutex_lock (&_cairo_parallel_pool.mutex);
+	if (--_cairo_parallel_pool.num_busy == 0)
+	    pthread_cond_signal (&_cairo_parallel_pool.idle);
+    }
+    pthread_mutex_unlock (&_cairo_parallel_pool.mutex);
+
+    return NULL;
+}
+
+/* Posts @job to up to @num_workers pooled threads, starting more of
+ * them if required. Returns FALSE if the pool is already serving
+ * another job. Called with the pool mutex held. */
+static cairo_bool_t
+_cairo_parallel_pool_post (cairo_parallel_t *job, int num_workers)
+{
+    if (_cairo_parallel_pool.job != NULL)
+	return FALSE;
+
+    /* If a thread cannot be created, the remaining workers (or just
+     * the calling thread) pick up its share of the tasks. */
+    while (_cairo_parallel_pool.num_threads < num_workers) {
+	if (pthread_create (&_cairo_parallel_pool.threads[_cairo_parallel_pool.num_threads],
+			    NULL, _cairo_parallel_thread, NULL) != 0)
+	{
+	    break;
+	}
+	_cairo_parallel_pool.num_threads++;
+    }
+    if (num_workers > _cairo_parallel_pool.num_threads)
+	num_workers = _cairo_parallel_pool.num_threads;
+    if (num_workers == 0)
+	return FALSE;
+
+    _cairo_parallel_pool.job = job;
+    _cairo_parallel_pool.num_wanted = num_workers;
+    _cairo_parallel_pool.num_joined = 0;
+    pthread_cond_broadcast (&_cairo_parallel_pool.wake);
+
+    return TRUE;
+}
+
+/* Withdraws the current job and waits for the workers that joined it
+ * to finish their tasks. Called with the pool mutex held. */
+static void
+_cairo_parallel_pool_wait (void)
+{
+    _cairo_parallel_pool.job = NULL;
+    while (_cairo_parallel_pool.num_busy)
+	pthread_cond_wait (&_cairo_parallel_pool.idle,
+			   &_cairo_parallel_pool.mutex);
+}
+#endif
+
+/**
+ * _cairo_parallel_for:
+ * @num_tasks: the number of tasks
+ * @max_threads: the maximum number of threads to use, including the
+ * calling thread
+ * @func: called once for each task in [0, @num_tasks)
+ * @closure: user data passed to @func
+ *
+ * Runs @func for every task, spreading the tasks over up to
+ * @max_threads threads, and waits for all of them to complete. Once a
+ * task fails no further tasks are started.
+ *
+ * Return value: the first error returned by @func, or
+ * %CAIRO_STATUS_SUCCESS.
+ **/
+cairo_status_t
+_cairo_parallel_for (int			 num_tasks,
+		     int			 max_threads,
+		     cairo_parallel_func_t	 func,
+		     void			*closure)
+{
+    cairo_parallel_t parallel;
+#if CAIRO_HAS_REAL_PTHREAD
+    cairo_bool_t posted = FALSE;
+#endif
+
+    parallel.func = func;
+    parallel.closure = closure;
+    parallel.num_tasks = num_tasks;
+    parallel.next_task = 0;
+    parallel.status = CAIRO_STATUS_SUCCESS;
+    CAIRO_MUTEX_INIT (parallel.mutex);
+
+    if (max_threads > num_tasks)
+	max_threads = num_tasks;
+    if (max_threads > CAIRO_PARALLEL_MAX_THREADS)
+	max_threads = CAIRO_PARALLEL_MAX_THREADS;
+
+#if CAIRO_HAS_REAL_PTHREAD
+    if (max_threads > 1) {
+	pthread_mutex_lock (&_cairo_parallel_pool.mutex);
+	posted = _cairo_parallel_pool_post (&parallel, max_threads - 1);
+	pthread_mutex_unlock (&_cairo_parallel_pool.mutex);
+    }
+#endif
+
+    _cairo_parallel_run (&parallel);
+
+#if CAIRO_HAS_REAL_PTHREAD
+    if (posted) {
+	pthread_mutex_lock (&_cairo_parallel_pool.mutex);
+	_cairo_parallel_pool_wait ();
+	pthread_mutex_unlock (&_cairo_parallel_pool.mutex);
+    }
+#endif
+
+    CAIRO_MUTEX_FINI (parallel.mutex);
+
+    return parallel.status;
+}
+
+void
+_cairo_parallel_reset_static_data (void)
+{
+#if CAIRO_HAS_REAL_PTHREAD
+    int num_threads;
+
+    pthread_mutex_lock (&_cairo_parallel_pool.mutex);
+    _cairo_parallel_pool_wait ();
+    _cairo_parallel_pool.exiting = TRUE;
+    pthread_cond_broadcast (&_cairo_parallel_pool.wake);
+    num_threads = _cairo_parallel_pool.num_threads;
+    _cairo_parallel_pool.num_threads = 0;
+    pthread_mutex_unlock (&_cairo_parallel_pool.mutex);
+
+    while (num_threads--)
+	pthread_join (_cairo_parallel_pool.threads[num_threads], NULL);
+
+    _cairo_parallel_pool.exiting = FALSE;
+#endif
+}
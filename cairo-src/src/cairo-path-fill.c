@@ -42,15 +42,18 @@
 
 typedef struct cairo_filler {
     double tolerance;
+    cairo_bool_t uniform;
     cairo_polygon_t *polygon;
 } cairo_filler_t;
 
 static void
 _cairo_filler_init (cairo_filler_t *filler,
 		    double tolerance,
+		    cairo_bool_t uniform,
 		    cairo_polygon_t *polygon)
 {
     filler->tolerance = tolerance;
+    filler->uniform = uniform;
     filler->polygon = polygon;
 }
 
@@ -94,6 +97,9 @@ _cairo_filler_curve_to (void *closure,
 	return _cairo_filler_line_to (closure, d);
     }
 
+    if (filler->uniform)
+	return _cairo_spline_decompose_uniform (&spline, filler->tolerance);
+
     return _cairo_spline_decompose (&spline, filler->tolerance);
 }
 
@@ -104,15 +110,16 @@ _cairo_filler_close_path (void *closure)
     return _cairo_polygon_close (filler->polygon);
 }
 
-cairo_status_t
-_cairo_path_fixed_fill_to_polygon (const cairo_path_fixed_t *path,
-				   double tolerance,
-				   cairo_polygon_t *polygon)
+static cairo_status_t
+_cairo_path_fixed_fill_to_polygon_internal (const cairo_path_fixed_t *path,
+					    double tolerance,
+					    cairo_bool_t uniform,
+					    cairo_polygon_t *polygon)
 {
     cairo_filler_t filler;
     cairo_status_t status;
 
-    _cairo_filler_init (&filler, tolerance, polygon);
+    _cairo_filler_init (&filler, tolerance, uniform, polygon);
 
     status = _cairo_path_fixed_interpret (path,
 					  CAIRO_DIRECTION_FORWARD,
@@ -130,6 +137,28 @@ _cairo_path_fixed_fill_to_polygon (const cairo_path_fixed_t *path,
     return status;
 }
 
+cairo_status_t
+_cairo_path_fixed_fill_to_polygon (const cairo_path_fixed_t *path,
+				   double tolerance,
+				   cairo_polygon_t *polygon)
+{
+    return _cairo_path_fixed_fill_to_polygon_internal (path, tolerance,
+						       FALSE, polygon);
+}
+
+/* As _cairo_path_fixed_fill_to_polygon(), but flattens curves into
+ * uniform steps by forward differencing, which is considerably cheaper
+ * for curve-heavy paths at the cost of placing the vertices differently.
+ */
+cairo_status_t
+_cairo_path_fixed_fill_to_polygon_uniform (const cairo_path_fixed_t *path,
+					   double tolerance,
+					   cairo_polygon_t *polygon)
+{
+    return _cairo_path_fixed_fill_to_polygon_internal (path, tolerance,
+						       TRUE, polygon);
+}
+
 cairo_status_t
 _cairo_path_fixed_fill_to_traps (const cairo_path_fixed_t *path,
 				 cairo_fill_rule_t fill_rule,
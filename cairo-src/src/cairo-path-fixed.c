@@ -108,12 +108,26 @@ _cairo_path_fixed_init (cairo_path_fixed_t *path)
     path->extents.p2.x = path->extents.p2.y = INT_MIN;
 }
 
+static unsigned int
+_cairo_path_op_num_points (cairo_path_op_t op)
+{
+    switch (op) {
+    case CAIRO_PATH_OP_CURVE_TO:
+	return 3;
+    case CAIRO_PATH_OP_CLOSE_PATH:
+	return 0;
+    default:
+	return 1;
+    }
+}
+
 cairo_status_t
 _cairo_path_fixed_init_copy (cairo_path_fixed_t *path,
 			     const cairo_path_fixed_t *other)
 {
     cairo_path_buf_t *buf, *other_buf;
     unsigned int num_points, num_ops;
+    unsigned int base_points, base_ops;
 
     VG (VALGRIND_MAKE_MEM_UNDEFINED (path, sizeof (cairo_path_fixed_t)));
 
@@ -135,14 +149,34 @@ _cairo_path_fixed_init_copy (cairo_path_fixed_t *path,
 
     path->extents = other->extents;
 
-    path->buf.base.num_ops = other->buf.base.num_ops;
-    path->buf.base.num_points = other->buf.base.num_points;
+    /* The base buf of a compact path holds all of its ops and points,
+     * more than fit inline. Keep as many whole ops (with their points)
+     * inline as will fit and spill the remainder into the allocated
+     * buf, ahead of any further bufs. */
+    for (base_ops = base_points = 0;
+	 base_ops < other->buf.base.num_ops;
+	 base_ops++)
+    {
+	unsigned int n = _cairo_path_op_num_points (other->buf.base.op[base_ops]);
+
+	if (base_ops == ARRAY_LENGTH (path->buf.op) ||
+	    base_points + n > ARRAY_LENGTH (path->buf.points))
+	{
+	    break;
+	}
+
+	base_points += n;
+    }
+
+    path->buf.base.num_ops = base_ops;
+    path->buf.base.num_points = base_points;
     memcpy (path->buf.op, other->buf.base.op,
-	    other->buf.base.num_ops * sizeof (other->buf.op[0]));
-    memcpy (path->buf.points, other->buf.points,
-	    other->buf.base.num_points * sizeof (other->buf.points[0]));
+	    base_ops * sizeof (other->buf.op[0]));
+    memcpy (path->buf.points, other->buf.base.points,
+	    base_points * sizeof (other->buf.points[0]));
 
-    num_points = num_ops = 0;
+    num_ops = other->buf.base.num_ops - base_ops;
+    num_points = other->buf.base.num_points - base_points;
     for (other_buf = cairo_path_buf_next (cairo_path_head (other));
 	 other_buf != cairo_path_head (other);
 	 other_buf = cairo_path_buf_next (other_buf))
@@ -158,6 +192,13 @@ _cairo_path_fixed_init_copy (cairo_path_fixed_t *path,
 	    return _cairo_error (CAIRO_STATUS_NO_MEMORY);
 	}
 
+	buf->num_ops = other->buf.base.num_ops - base_ops;
+	memcpy (buf->op, other->buf.base.op + base_ops,
+		buf->num_ops * sizeof (buf->op[0]));
+	buf->num_points = other->buf.base.num_points - base_points;
+	memcpy (buf->points, other->buf.base.points + base_points,
+		buf->num_points * sizeof (buf->points[0]));
+
 	for (other_buf = cairo_path_buf_next (cairo_path_head (other));
 	     other_buf != cairo_path_head (other);
 	     other_buf = cairo_path_buf_next (other_buf))
@@ -177,6 +218,100 @@ _cairo_path_fixed_init_copy (cairo_path_fixed_t *path,
     return CAIRO_STATUS_SUCCESS;
 }
 
+/* A compact path is a read-only copy of another path in a single
+ * block of caller-provided storage. Instead of the fixed-size inline
+ * buffer, the ops and points follow the path header directly and are
+ * sized to fit, so a small path costs a small fraction of a
+ * #cairo_path_fixed_t. A compact path must never be modified, and
+ * it owns no memory other than the block itself, so it needs no
+ * finalisation.
+ */
+#define CAIRO_PATH_FIXED_COMPACT_HEADER offsetof (cairo_path_fixed_t, buf.op)
+
+static size_t
+_cairo_path_fixed_compact_points_offset (unsigned int num_ops)
+{
+    size_t offset = CAIRO_PATH_FIXED_COMPACT_HEADER + num_ops * sizeof (cairo_path_op_t);
+
+    return (offset + sizeof (cairo_fixed_t) - 1) & -sizeof (cairo_fixed_t);
+}
+
+size_t
+_cairo_path_fixed_compact_size (const cairo_path_fixed_t *path)
+{
+    const cairo_path_buf_t *buf;
+    unsigned int num_points, num_ops;
+
+    num_ops = num_points = 0;
+    cairo_path_foreach_buf_start (buf, path) {
+	num_ops    += buf->num_ops;
+	num_points += buf->num_points;
+    } cairo_path_foreach_buf_end (buf, path);
+
+    return _cairo_path_fixed_compact_points_offset (num_ops) +
+	   num_points * sizeof (cairo_point_t);
+}
+
+/**
+ * _cairo_path_fixed_init_compact_copy:
+ * @path: storage of at least _cairo_path_fixed_compact_size (@other) bytes
+ * @other: the path to copy
+ *
+ * Initializes @path as a compact, read-only copy of @other.
+ *
+ * Return value: @path as a #cairo_path_fixed_t
+ **/
+cairo_path_fixed_t *
+_cairo_path_fixed_init_compact_copy (void *path,
+				     const cairo_path_fixed_t *other)
+{
+    cairo_path_fixed_t *compact = path;
+    const cairo_path_buf_t *other_buf;
+    cairo_path_buf_t *buf = &compact->buf.base;
+    unsigned int num_points, num_ops;
+
+    num_ops = num_points = 0;
+    cairo_path_foreach_buf_start (other_buf, other) {
+	num_ops    += other_buf->num_ops;
+	num_points += other_buf->num_points;
+    } cairo_path_foreach_buf_end (other_buf, other);
+
+    VG (VALGRIND_MAKE_MEM_UNDEFINED (path, _cairo_path_fixed_compact_size (other)));
+
+    compact->current_point = other->current_point;
+    compact->last_move_point = other->last_move_point;
+    compact->has_last_move_point = other->has_last_move_point;
+    compact->has_current_point = other->has_current_point;
+    compact->has_curve_to = other->has_curve_to;
+    compact->is_rectilinear = other->is_rectilinear;
+    compact->maybe_fill_region = other->maybe_fill_region;
+    compact->is_empty_fill = other->is_empty_fill;
+
+    compact->extents = other->extents;
+
+    cairo_list_init (&buf->link);
+    buf->op = (cairo_path_op_t *) ((char *) path + CAIRO_PATH_FIXED_COMPACT_HEADER);
+    buf->points = (cairo_point_t *) ((char *) path +
+				     _cairo_path_fixed_compact_points_offset (num_ops));
+    buf->size_ops = buf->num_ops = 0;
+    buf->size_points = buf->num_points = 0;
+
+    cairo_path_foreach_buf_start (other_buf, other) {
+	memcpy (buf->op + buf->num_ops, other_buf->op,
+		other_buf->num_ops * sizeof (buf->op[0]));
+	buf->num_ops += other_buf->num_ops;
+
+	memcpy (buf->points + buf->num_points, other_buf->points,
+		other_buf->num_points * sizeof (buf->points[0]));
+	buf->num_points += other_buf->num_points;
+    } cairo_path_foreach_buf_end (other_buf, other);
+
+    buf->size_ops = buf->num_ops;
+    buf->size_points = buf->num_points;
+
+    return compact;
+}
+
 unsigned long
 _cairo_path_fixed_hash (const cairo_path_fixed_t *path)
 {
@@ -52,6 +52,7 @@ typedef struct _cairo_stroker_dash {
     double dash_remain;
 
     double dash_offset;
+    double dash_period;
     const double *dashes;
     unsigned int num_dashes;
 } cairo_stroker_dash_t;
@@ -137,6 +138,37 @@ _cairo_stroker_dash_step (cairo_stroker_dash_t *dash, double step)
     }
 }
 
+/* Advance the dash pattern over as many complete dashes as fit within
+ * distance, and return the length passed over.  Whole periods of the
+ * pattern are jumped at once, so the cost does not depend upon the
+ * number of dashes skipped.  The state afterwards is identical to having
+ * called _cairo_stroker_dash_step() for each of the dashes in turn.
+ */
+static double
+_cairo_stroker_dash_skip (cairo_stroker_dash_t *dash, double distance)
+{
+    double skipped, periods;
+
+    if (distance < dash->dash_remain)
+	return 0.;
+
+    skipped = dash->dash_remain;
+    distance -= dash->dash_remain;
+    _cairo_stroker_dash_step (dash, dash->dash_remain);
+
+    periods = floor (distance / dash->dash_period);
+    skipped += periods * dash->dash_period;
+    distance -= periods * dash->dash_period;
+
+    while (distance >= dash->dash_remain) {
+	skipped += dash->dash_remain;
+	distance -= dash->dash_remain;
+	_cairo_stroker_dash_step (dash, dash->dash_remain);
+    }
+
+    return skipped;
+}
+
 static void
 _cairo_stroker_dash_init (cairo_stroker_dash_t *dash,
 			  const cairo_stroke_style_t *style)
@@ -148,6 +180,7 @@ _cairo_stroker_dash_init (cairo_stroker_dash_t *dash,
     dash->dashes = style->dash;
     dash->num_dashes = style->num_dashes;
     dash->dash_offset = style->dash_offset;
+    dash->dash_period = _cairo_stroke_style_dash_period (style);
 
     _cairo_stroker_dash_start (dash);
 }
@@ -1019,6 +1052,50 @@ _cairo_stroker_line_to (void *closure,
     return CAIRO_STATUS_SUCCESS;
 }
 
+/* Find the portion of the segment p1-p2 that lies within the box, as
+ * fractions [*t0, *t1] of its length.  Returns FALSE if the segment
+ * misses the box entirely.
+ */
+static cairo_bool_t
+_segment_box_range (const cairo_box_t *box,
+		    const cairo_point_t *p1,
+		    const cairo_point_t *p2,
+		    double *t0, double *t1)
+{
+    double p[4], q[4];
+    double lo = 0., hi = 1.;
+    int i;
+
+    p[0] = -_cairo_fixed_to_double (p2->x - p1->x);
+    q[0] =  _cairo_fixed_to_double (p1->x - box->p1.x);
+    p[1] = -p[0];
+    q[1] =  _cairo_fixed_to_double (box->p2.x - p1->x);
+    p[2] = -_cairo_fixed_to_double (p2->y - p1->y);
+    q[2] =  _cairo_fixed_to_double (p1->y - box->p1.y);
+    p[3] = -p[2];
+    q[3] =  _cairo_fixed_to_double (box->p2.y - p1->y);
+
+    for (i = 0; i < 4; i++) {
+	if (p[i] == 0.) {
+	    if (q[i] < 0.)
+		return FALSE;
+	} else {
+	    double t = q[i] / p[i];
+	    if (p[i] < 0.) {
+		if (t > lo)
+		    lo = t;
+	    } else {
+		if (t < hi)
+		    hi = t;
+	    }
+	}
+    }
+
+    *t0 = lo;
+    *t1 = hi;
+    return lo <= hi;
+}
+
 /*
  * Dashed lines.  Cap each dash end, join around turns when on
  */
@@ -1028,6 +1105,7 @@ _cairo_stroker_line_to_dashed (void *closure,
 {
     cairo_stroker_t *stroker = closure;
     double mag, remain, step_length = 0;
+    double visible_start, visible_end;
     double slope_dx, slope_dy;
     double dx2, dy2;
     cairo_stroke_face_t sub_start, sub_end;
@@ -1061,9 +1139,58 @@ _cairo_stroker_line_to_dashed (void *closure,
 	return CAIRO_STATUS_SUCCESS;
     }
 
+    /* Only the dashes overlapping the bounds need any geometry; the rest
+     * of the segment is passed over without visiting every dash. */
+    visible_start = 0.;
+    visible_end = mag;
+    if (! fully_in_bounds) {
+	double t0, t1;
+
+	if (_segment_box_range (&stroker->bounds, p1, p2, &t0, &t1)) {
+	    visible_start = t0 * mag;
+	    visible_end = t1 * mag;
+	} else {
+	    visible_start = visible_end = mag;
+	}
+    }
+
     remain = mag;
     segment.p1 = *p1;
     while (remain) {
+	double position = mag - remain;
+
+	/* The first dash is always emitted, as its face may be needed to
+	 * close the sub-path. */
+	if ((position < visible_start || position >= visible_end) &&
+	    (stroker->has_first_face || ! stroker->dash.dash_starts_on))
+	{
+	    double skip;
+
+	    skip = _cairo_stroker_dash_skip (&stroker->dash,
+					     position < visible_start ?
+					     visible_start - position : remain);
+	    if (skip > 0.) {
+		if (stroker->has_current_face) {
+		    status = _cairo_stroker_add_trailing_cap (stroker,
+							      &stroker->current_face);
+		    if (unlikely (status))
+			return status;
+
+		    stroker->has_current_face = FALSE;
+		}
+
+		if (skip >= remain)
+		    break;
+
+		remain -= skip;
+		dx2 = slope_dx * (mag - remain);
+		dy2 = slope_dy * (mag - remain);
+		cairo_matrix_transform_distance (stroker->ctm, &dx2, &dy2);
+		segment.p1.x = _cairo_fixed_from_double (dx2) + p1->x;
+		segment.p1.y = _cairo_fixed_from_double (dy2) + p1->y;
+	    }
+	}
+
 	step_length = MIN (stroker->dash.dash_remain, remain);
 	remain -= step_length;
 	dx2 = slope_dx * (mag - remain);
@@ -1901,7 +2028,8 @@ _cairo_rectilinear_stroker_line_to_dashed (void		*closure,
     const cairo_point_t *a = &stroker->current_point;
     const cairo_point_t *b = point;
     cairo_bool_t fully_in_bounds;
-    double sign, remain;
+    double sign, remain, length;
+    double visible_start, visible_end;
     cairo_fixed_t mag;
     cairo_status_t status;
     cairo_line_t segment;
@@ -1935,11 +2063,51 @@ _cairo_rectilinear_stroker_line_to_dashed (void		*closure,
 	remain = _cairo_fixed_to_double (mag);
 	sign = -1.;
     }
+    length = remain;
+
+    visible_start = 0.;
+    visible_end = length;
+    if (! fully_in_bounds) {
+	double t0, t1;
+
+	if (_segment_box_range (&stroker->bounds, a, b, &t0, &t1)) {
+	    visible_start = t0 * length;
+	    visible_end = t1 * length;
+	} else {
+	    visible_start = visible_end = length;
+	}
+    }
 
     segment.p2 = segment.p1 = *a;
     while (remain > 0.) {
+	double position = length - remain;
 	double step_length;
 
+	/* Pass over the dashes lying entirely outside the bounds. */
+	if (position < visible_start || position >= visible_end) {
+	    double skip;
+
+	    skip = _cairo_stroker_dash_skip (&stroker->dash,
+					     position < visible_start ?
+					     visible_start - position : remain);
+	    if (skip > 0.) {
+		dash_on = FALSE;
+
+		if (skip >= remain) {
+		    segment.p2 = segment.p1 = *b;
+		    break;
+		}
+
+		remain -= skip;
+		mag = _cairo_fixed_from_double (sign*remain);
+		if (is_horizontal)
+		    segment.p1.x = b->x + mag;
+		else
+		    segment.p1.y = b->y + mag;
+		segment.p2 = segment.p1;
+	    }
+	}
+
 	step_length = MIN (stroker->dash.dash_remain, remain);
 	remain -= step_length;
 
@@ -2141,3 +2309,392 @@ BAIL:
     _cairo_boxes_clear (boxes);
     return status;
 }
+
+/*
+ * Hairlines.  Strokes no wider than a device pixel are handed straight
+ * to the hairline scan converter as thin lines, skipping construction
+ * of the stroke outline.  Joins are invisible at this width and are
+ * omitted, while caps are approximated by extending the line by half
+ * its width.
+ */
+typedef struct _cairo_hairline_piece {
+    double x1, y1, x2, y2;
+    double width;
+    double cap_dx, cap_dy;
+    cairo_bool_t start_cap, end_cap;
+    cairo_bool_t is_first;
+} cairo_hairline_piece_t;
+
+typedef struct _cairo_hairline_stroker {
+    double line_width;
+    cairo_line_cap_t line_cap;
+
+    const cairo_matrix_t *ctm;
+    const cairo_matrix_t *ctm_inverse;
+    double ctm_determinant;
+
+    cairo_hairline_scan_converter_t *converter;
+
+    cairo_point_t current_point;
+    cairo_point_t first_point;
+
+    cairo_bool_t has_initial_sub_path;
+    cairo_bool_t at_first_point;
+    cairo_bool_t continuing;
+
+    /* The most recent piece is held back until we know whether it is
+     * joined to the next or capped, and the first piece of each sub
+     * path until we know whether the sub path is closed. */
+    cairo_bool_t has_pending;
+    cairo_hairline_piece_t pending;
+    cairo_bool_t has_first;
+    cairo_hairline_piece_t first;
+
+    cairo_stroker_dash_t dash;
+} cairo_hairline_stroker_t;
+
+static cairo_status_t
+_cairo_hairline_stroker_emit (cairo_hairline_stroker_t *stroker,
+			      const cairo_hairline_piece_t *piece)
+{
+    double x1 = piece->x1, y1 = piece->y1;
+    double x2 = piece->x2, y2 = piece->y2;
+
+    if (stroker->line_cap != CAIRO_LINE_CAP_BUTT) {
+	if (piece->start_cap) {
+	    x1 -= piece->cap_dx;
+	    y1 -= piece->cap_dy;
+	}
+	if (piece->end_cap) {
+	    x2 += piece->cap_dx;
+	    y2 += piece->cap_dy;
+	}
+    }
+
+    return _cairo_hairline_scan_converter_add_line (stroker->converter,
+						    x1, y1, x2, y2,
+						    piece->width);
+}
+
+static cairo_status_t
+_cairo_hairline_stroker_flush (cairo_hairline_stroker_t *stroker,
+			       cairo_bool_t end_cap)
+{
+    if (! stroker->has_pending)
+	return CAIRO_STATUS_SUCCESS;
+
+    stroker->has_pending = FALSE;
+    stroker->pending.end_cap = end_cap;
+    if (stroker->pending.is_first) {
+	stroker->first = stroker->pending;
+	stroker->has_first = TRUE;
+	return CAIRO_STATUS_SUCCESS;
+    }
+
+    return _cairo_hairline_stroker_emit (stroker, &stroker->pending);
+}
+
+static cairo_status_t
+_cairo_hairline_stroker_add_piece (cairo_hairline_stroker_t *stroker,
+				   double x1, double y1,
+				   double x2, double y2,
+				   double width,
+				   double cap_dx, double cap_dy,
+				   cairo_bool_t is_first)
+{
+    cairo_hairline_piece_t *piece = &stroker->pending;
+
+    if (stroker->continuing) {
+	cairo_status_t status;
+
+	status = _cairo_hairline_stroker_flush (stroker, FALSE);
+	if (unlikely (status))
+	    return status;
+    }
+
+    piece->x1 = x1; piece->y1 = y1;
+    piece->x2 = x2; piece->y2 = y2;
+    piece->width = width;
+    piece->cap_dx = cap_dx;
+    piece->cap_dy = cap_dy;
+    piece->start_cap = ! stroker->continuing;
+    piece->end_cap = TRUE;
+    piece->is_first = is_first;
+
+    stroker->has_pending = TRUE;
+    stroker->continuing = TRUE;
+
+    return CAIRO_STATUS_SUCCESS;
+}
+
+static cairo_status_t
+_cairo_hairline_stroker_add_caps (cairo_hairline_stroker_t *stroker)
+{
+    cairo_status_t status;
+
+    status = _cairo_hairline_stroker_flush (stroker, TRUE);
+    if (unlikely (status))
+	return status;
+
+    stroker->continuing = FALSE;
+
+    if (stroker->has_first) {
+	stroker->has_first = FALSE;
+	return _cairo_hairline_stroker_emit (stroker, &stroker->first);
+    }
+
+    /* check for a degenerate sub_path, as per _cairo_stroker_add_caps() */
+    if (stroker->has_initial_sub_path &&
+	stroker->at_first_point &&
+	stroker->line_cap == CAIRO_LINE_CAP_ROUND)
+    {
+	double x, y, dx, dy, mag;
+
+	dx = stroker->line_width * .5;
+	dy = 0.;
+	cairo_matrix_transform_distance (stroker->ctm, &dx, &dy);
+	mag = hypot (dx, dy);
+	if (mag == 0.)
+	    return CAIRO_STATUS_SUCCESS;
+
+	x = _cairo_fixed_to_double (stroker->first_point.x);
+	y = _cairo_fixed_to_double (stroker->first_point.y);
+	return _cairo_hairline_scan_converter_add_line (stroker->converter,
+							x - dx, y - dy,
+							x + dx, y + dy,
+							stroker->ctm_determinant *
+							stroker->line_width *
+							stroker->line_width * .5 / mag);
+    }
+
+    return CAIRO_STATUS_SUCCESS;
+}
+
+static cairo_status_t
+_cairo_hairline_stroker_move_to (void *closure,
+				 const cairo_point_t *point)
+{
+    cairo_hairline_stroker_t *stroker = closure;
+    cairo_status_t status;
+
+    /* reset the dash pattern for new sub paths */
+    _cairo_stroker_dash_start (&stroker->dash);
+
+    /* Cap the start and end of the previous sub path as needed */
+    status = _cairo_hairline_stroker_add_caps (stroker);
+    if (unlikely (status))
+	return status;
+
+    stroker->first_point = *point;
+    stroker->current_point = *point;
+
+    stroker->has_initial_sub_path = FALSE;
+    stroker->at_first_point = TRUE;
+
+    return CAIRO_STATUS_SUCCESS;
+}
+
+/* Computes the device space vector and width of a segment, along with
+ * the extension applied by a cap, returning its length in user space. */
+static double
+_cairo_hairline_stroker_segment (cairo_hairline_stroker_t *stroker,
+				 const cairo_point_t *p1,
+				 const cairo_point_t *p2,
+				 double *dx, double *dy,
+				 double *width,
+				 double *cap_dx, double *cap_dy)
+{
+    double ux, uy, mag, scale;
+
+    *dx = ux = _cairo_fixed_to_double (p2->x - p1->x);
+    *dy = uy = _cairo_fixed_to_double (p2->y - p1->y);
+    cairo_matrix_transform_distance (stroker->ctm_inverse, &ux, &uy);
+    mag = hypot (ux, uy);
+    if (mag == 0.)
+	return 0.;
+
+    /* The parallelogram swept by the pen has area |det| * w * mag in
+     * device space, from which follows its width across the segment. */
+    *width = stroker->ctm_determinant * stroker->line_width * mag /
+	     hypot (*dx, *dy);
+
+    scale = stroker->line_width * .5 / mag;
+    *cap_dx = *dx * scale;
+    *cap_dy = *dy * scale;
+
+    return mag;
+}
+
+static cairo_status_t
+_cairo_hairline_stroker_line_to (void *closure,
+				 const cairo_point_t *point)
+{
+    cairo_hairline_stroker_t *stroker = closure;
+    cairo_point_t *p1 = &stroker->current_point;
+    double dx, dy, width, cap_dx, cap_dy;
+    cairo_status_t status;
+
+    stroker->has_initial_sub_path = TRUE;
+
+    if (p1->x == point->x && p1->y == point->y)
+	return CAIRO_STATUS_SUCCESS;
+
+    if (_cairo_hairline_stroker_segment (stroker, p1, point,
+					 &dx, &dy, &width,
+					 &cap_dx, &cap_dy) == 0.)
+    {
+	return CAIRO_STATUS_SUCCESS;
+    }
+
+    status = _cairo_hairline_stroker_add_piece (stroker,
+						_cairo_fixed_to_double (p1->x),
+						_cairo_fixed_to_double (p1->y),
+						_cairo_fixed_to_double (point->x),
+						_cairo_fixed_to_double (point->y),
+						width, cap_dx, cap_dy,
+						stroker->at_first_point);
+    if (unlikely (status))
+	return status;
+
+    stroker->at_first_point = FALSE;
+    stroker->current_point = *point;
+
+    return CAIRO_STATUS_SUCCESS;
+}
+
+static cairo_status_t
+_cairo_hairline_stroker_line_to_dashed (void *closure,
+					const cairo_point_t *point)
+{
+    cairo_hairline_stroker_t *stroker = closure;
+    cairo_point_t *p1 = &stroker->current_point;
+    double x1, y1, dx, dy, width, cap_dx, cap_dy;
+    double mag, remain, step;
+    cairo_status_t status;
+
+    stroker->has_initial_sub_path = stroker->dash.dash_starts_on;
+
+    if (p1->x == point->x && p1->y == point->y)
+	return CAIRO_STATUS_SUCCESS;
+
+    mag = _cairo_hairline_stroker_segment (stroker, p1, point,
+					   &dx, &dy, &width,
+					   &cap_dx, &cap_dy);
+    if (mag == 0.)
+	return CAIRO_STATUS_SUCCESS;
+
+    x1 = _cairo_fixed_to_double (p1->x);
+    y1 = _cairo_fixed_to_double (p1->y);
+
+    dx /= mag;
+    dy /= mag;
+
+    remain = mag;
+    while (remain > 0.) {
+	double t = mag - remain;
+
+	step = MIN (stroker->dash.dash_remain, remain);
+	remain -= step;
+
+	if (stroker->dash.dash_on) {
+	    status = _cairo_hairline_stroker_add_piece (stroker,
+							x1 + dx * t,
+							y1 + dy * t,
+							x1 + dx * (t + step),
+							y1 + dy * (t + step),
+							width, cap_dx, cap_dy,
+							stroker->at_first_point);
+	    if (unlikely (status))
+		return status;
+	}
+	stroker->at_first_point = FALSE;
+
+	_cairo_stroker_dash_step (&stroker->dash, step);
+	if (! stroker->dash.dash_on) {
+	    /* Cap the end of the dash */
+	    status = _cairo_hairline_stroker_flush (stroker, TRUE);
+	    if (unlikely (status))
+		return status;
+
+	    stroker->continuing = FALSE;
+	}
+    }
+
+    stroker->current_point = *point;
+
+    return CAIRO_STATUS_SUCCESS;
+}
+
+static cairo_status_t
+_cairo_hairline_stroker_close_path (void *closure)
+{
+    cairo_hairline_stroker_t *stroker = closure;
+    cairo_status_t status;
+
+    if (stroker->dash.dashed)
+	status = _cairo_hairline_stroker_line_to_dashed (stroker, &stroker->first_point);
+    else
+	status = _cairo_hairline_stroker_line_to (stroker, &stroker->first_point);
+    if (unlikely (status))
+	return status;
+
+    if (stroker->has_first && stroker->continuing) {
+	/* Join first and final pieces of sub path */
+	stroker->first.start_cap = FALSE;
+	status = _cairo_hairline_stroker_flush (stroker, FALSE);
+	if (unlikely (status))
+	    return status;
+    }
+
+    /* Cap the start and end of the sub path as needed */
+    status = _cairo_hairline_stroker_add_caps (stroker);
+    if (unlikely (status))
+	return status;
+
+    stroker->has_initial_sub_path = FALSE;
+    stroker->at_first_point = TRUE;
+
+    return CAIRO_STATUS_SUCCESS;
+}
+
+cairo_status_t
+_cairo_path_fixed_stroke_to_hairlines (const cairo_path_fixed_t	*path,
+				       const cairo_stroke_style_t	*stroke_style,
+				       const cairo_matrix_t	*ctm,
+				       const cairo_matrix_t	*ctm_inverse,
+				       double			 tolerance,
+				       cairo_hairline_scan_converter_t *converter)
+{
+    cairo_hairline_stroker_t stroker;
+    cairo_status_t status;
+
+    stroker.line_width = stroke_style->line_width;
+    stroker.line_cap = stroke_style->line_cap;
+    stroker.ctm = ctm;
+    stroker.ctm_inverse = ctm_inverse;
+    stroker.ctm_determinant = fabs (_cairo_matrix_compute_determinant (ctm));
+    stroker.converter = converter;
+
+    stroker.has_initial_sub_path = FALSE;
+    stroker.at_first_point = TRUE;
+    stroker.continuing = FALSE;
+    stroker.has_pending = FALSE;
+    stroker.has_first = FALSE;
+
+    _cairo_stroker_dash_init (&stroker.dash, stroke_style);
+
+    status = _cairo_path_fixed_interpret_flat (path,
+					       CAIRO_DIRECTION_FORWARD,
+					       _cairo_hairline_stroker_move_to,
+					       stroker.dash.dashed ?
+					       _cairo_hairline_stroker_line_to_dashed :
+					       _cairo_hairline_stroker_line_to,
+					       _cairo_hairline_stroker_close_path,
+					       &stroker,
+					       tolerance);
+    if (unlikely (status))
+	return status;
+
+    /* Cap the start and end of the final sub path as needed */
+    return _cairo_hairline_stroker_add_caps (&stroker);
+}
@@ -31,6 +31,7 @@
 #include "cairoint.h"
 #include "cairo-error-private.h"
 #include "cairo-freed-pool-private.h"
+#include "cairo-thread-cache-private.h"
 
 /**
  * SECTION:cairo-pattern
@@ -1553,15 +1554,33 @@ _cairo_pattern_acquire_surface_for_gradient (const cairo_gradient_pattern_t *pat
 }
 
 /* We maintain a small cache here, because we don't want to constantly
- * recreate surfaces for simple solid colors. */
+ * recreate surfaces for simple solid colors. The cache is kept per
+ * thread, see cairo-thread-cache-private.h. */
 #define MAX_SURFACE_CACHE_SIZE 16
-static struct {
+typedef struct _cairo_pattern_solid_surface_cache_set {
     struct _cairo_pattern_solid_surface_cache{
 	cairo_color_t    color;
 	cairo_surface_t *surface;
     } cache[MAX_SURFACE_CACHE_SIZE];
     int size;
-} solid_surface_cache;
+    int last;
+    int next;
+} cairo_pattern_solid_surface_cache_set_t;
+
+static void
+_cairo_pattern_solid_surface_cache_fini (void *closure)
+{
+    cairo_pattern_solid_surface_cache_set_t *set = closure;
+
+    while (set->size)
+	cairo_surface_destroy (set->cache[--set->size].surface);
+}
+
+static cairo_thread_cache_t solid_surface_cache =
+    CAIRO_THREAD_CACHE_INIT (CAIRO_THREAD_CACHE_SOLID_SURFACE,
+			     cairo_pattern_solid_surface_cache_set_t,
+			     NULL, _cairo_pattern_solid_surface_cache_fini,
+			     _cairo_pattern_solid_surface_cache_lock);
 
 static cairo_bool_t
 _cairo_pattern_solid_surface_matches (
@@ -1603,24 +1622,27 @@ _cairo_pattern_acquire_surface_for_solid (const cairo_solid_pattern_t	     *patt
 					  cairo_surface_t	     **out,
 					  cairo_surface_attributes_t *attribs)
 {
-    static int i;
-
+    cairo_pattern_solid_surface_cache_set_t *set;
     cairo_surface_t *surface, *to_destroy = NULL;
     cairo_status_t   status;
+    int i;
 
-    CAIRO_MUTEX_LOCK (_cairo_pattern_solid_surface_cache_lock);
+    set = _cairo_thread_cache_get (&solid_surface_cache);
+    if (unlikely (set == NULL))
+	return _cairo_error (CAIRO_STATUS_NO_MEMORY);
 
     /* Check cache first */
-    if (i < solid_surface_cache.size &&
-	_cairo_pattern_solid_surface_matches_color (&solid_surface_cache.cache[i],
+    i = set->last;
+    if (i < set->size &&
+	_cairo_pattern_solid_surface_matches_color (&set->cache[i],
 						    pattern,
 						    dst))
     {
 	goto DONE;
     }
 
-    for (i = 0 ; i < solid_surface_cache.size; i++) {
-	if (_cairo_pattern_solid_surface_matches_color (&solid_surface_cache.cache[i],
+    for (i = 0 ; i < set->size; i++) {
+	if (_cairo_pattern_solid_surface_matches_color (&set->cache[i],
 							pattern,
 							dst))
 	{
@@ -1630,11 +1652,12 @@ _cairo_pattern_acquire_surface_for_solid (const cairo_solid_pattern_t	     *patt
 
     /* Choose a surface to repaint/evict */
     surface = NULL;
-    if (solid_surface_cache.size == MAX_SURFACE_CACHE_SIZE) {
-	i = rand () % MAX_SURFACE_CACHE_SIZE;
-	surface = solid_surface_cache.cache[i].surface;
+    if (set->size == MAX_SURFACE_CACHE_SIZE) {
+	i = set->next;
+	set->next = (i + 1) % MAX_SURFACE_CACHE_SIZE;
+	surface = set->cache[i].surface;
 
-	if (_cairo_pattern_solid_surface_matches (&solid_surface_cache.cache[i],
+	if (_cairo_pattern_solid_surface_matches (&set->cache[i],
 						  pattern,
 						  dst))
 	{
@@ -1674,15 +1697,16 @@ _cairo_pattern_acquire_surface_for_solid (const cairo_solid_pattern_t	     *patt
 	}
     }
 
-    if (i == solid_surface_cache.size)
-	solid_surface_cache.size++;
+    if (i == set->size)
+	set->size++;
 
-    to_destroy = solid_surface_cache.cache[i].surface;
-    solid_surface_cache.cache[i].surface = surface;
-    solid_surface_cache.cache[i].color   = pattern->color;
+    to_destroy = set->cache[i].surface;
+    set->cache[i].surface = surface;
+    set->cache[i].color   = pattern->color;
 
 DONE:
-    *out = cairo_surface_reference (solid_surface_cache.cache[i].surface);
+    set->last = i;
+    *out = cairo_surface_reference (set->cache[i].surface);
 
 NOCACHE:
     attribs->x_offset = attribs->y_offset = 0;
@@ -1694,7 +1718,7 @@ NOCACHE:
     status = CAIRO_STATUS_SUCCESS;
 
 UNLOCK:
-    CAIRO_MUTEX_UNLOCK (_cairo_pattern_solid_surface_cache_lock);
+    _cairo_thread_cache_put (&solid_surface_cache, set);
 
     if (to_destroy)
       cairo_surface_destroy (to_destroy);
@@ -1702,30 +1726,6 @@ UNLOCK:
     return status;
 }
 
-static void
-_cairo_pattern_reset_solid_surface_cache (void)
-{
-    CAIRO_MUTEX_LOCK (_cairo_pattern_solid_surface_cache_lock);
-
-    /* remove surfaces starting from the end so that solid_surface_cache.cache
-     * is always in a consistent state when we release the mutex. */
-    while (solid_surface_cache.size) {
-	cairo_surface_t *surface;
-
-	solid_surface_cache.size--;
-	surface = solid_surface_cache.cache[solid_surface_cache.size].surface;
-	solid_surface_cache.cache[solid_surface_cache.size].surface = NULL;
-
-	/* release the lock to avoid the possibility of a recursive
-	 * deadlock when the surface destroy closure gets called */
-	CAIRO_MUTEX_UNLOCK (_cairo_pattern_solid_surface_cache_lock);
-	cairo_surface_destroy (surface);
-	CAIRO_MUTEX_LOCK (_cairo_pattern_solid_surface_cache_lock);
-    }
-
-    CAIRO_MUTEX_UNLOCK (_cairo_pattern_solid_surface_cache_lock);
-}
-
 static void
 _extents_to_linear_parameter (const cairo_linear_pattern_t *linear,
 			      const cairo_rectangle_int_t *extents,
@@ -2171,6 +2171,7 @@ _cairo_pattern_analyze_filter (const cairo_pattern_t	*pattern,
 
     switch (pattern->filter) {
     case CAIRO_FILTER_GOOD:
+    case CAIRO_FILTER_MIPMAP:
     case CAIRO_FILTER_BEST:
     case CAIRO_FILTER_BILINEAR:
 	/* If source pixels map 1:1 onto destination pixels, we do
@@ -3337,6 +3338,4 @@ _cairo_pattern_reset_static_data (void)
     for (i = 0; i < ARRAY_LENGTH (freed_pattern_pool); i++)
 	_freed_pool_reset (&freed_pattern_pool[i]);
 #endif
-
-    _cairo_pattern_reset_solid_surface_cache ();
 }
@@ -97,6 +97,18 @@ _cairo_pdf_operators_set_stream (cairo_pdf_operators_t	 *pdf_operators,
     pdf_operators->has_line_style = FALSE;
 }
 
+/* Change the font subsets that glyphs are mapped into. This may only
+ * be called between streams, when no text object is open.
+ */
+void
+_cairo_pdf_operators_set_font_subsets (cairo_pdf_operators_t	   *pdf_operators,
+				       cairo_scaled_font_subsets_t *font_subsets)
+{
+    assert (! pdf_operators->in_text_object);
+
+    pdf_operators->font_subsets = font_subsets;
+}
+
 void
 _cairo_pdf_operators_set_cairo_to_pdf_matrix (cairo_pdf_operators_t *pdf_operators,
 					      cairo_matrix_t	    *cairo_to_pdf)
@@ -332,14 +344,15 @@ _cairo_pdf_path_move_to (void *closure,
 			 const cairo_point_t *point)
 {
     pdf_path_info_t *info = closure;
-    double x = _cairo_fixed_to_double (point->x);
-    double y = _cairo_fixed_to_double (point->y);
+    double xy[2];
+
+    xy[0] = _cairo_fixed_to_double (point->x);
+    xy[1] = _cairo_fixed_to_double (point->y);
 
     info->last_move_to_point = *point;
     info->has_sub_path = FALSE;
-    cairo_matrix_transform_point (info->path_transform, &x, &y);
-    _cairo_output_stream_printf (info->output,
-				 "%g %g m ", x, y);
+    cairo_matrix_transform_point (info->path_transform, &xy[0], &xy[1]);
+    _cairo_output_stream_print_numbers (info->output, xy, 2, "m ");
 
     return _cairo_output_stream_get_status (info->output);
 }
@@ -349,8 +362,7 @@ _cairo_pdf_path_line_to (void *closure,
 			 const cairo_point_t *point)
 {
     pdf_path_info_t *info = closure;
-    double x = _cairo_fixed_to_double (point->x);
-    double y = _cairo_fixed_to_double (point->y);
+    double xy[2];
 
     if (info->line_cap != CAIRO_LINE_CAP_ROUND &&
 	! info->has_sub_path &&
@@ -361,9 +373,10 @@ _cairo_pdf_path_line_to (void *closure,
     }
 
     info->has_sub_path = TRUE;
-    cairo_matrix_transform_point (info->path_transform, &x, &y);
-    _cairo_output_stream_printf (info->output,
-				 "%g %g l ", x, y);
+    xy[0] = _cairo_fixed_to_double (point->x);
+    xy[1] = _cairo_fixed_to_double (point->y);
+    cairo_matrix_transform_point (info->path_transform, &xy[0], &xy[1]);
+    _cairo_output_stream_print_numbers (info->output, xy, 2, "l ");
 
     return _cairo_output_stream_get_status (info->output);
 }
@@ -375,20 +388,20 @@ _cairo_pdf_path_curve_to (void          *closure,
 			  const cairo_point_t *d)
 {
     pdf_path_info_t *info = closure;
-    double bx = _cairo_fixed_to_double (b->x);
-    double by = _cairo_fixed_to_double (b->y);
-    double cx = _cairo_fixed_to_double (c->x);
-    double cy = _cairo_fixed_to_double (c->y);
-    double dx = _cairo_fixed_to_double (d->x);
-    double dy = _cairo_fixed_to_double (d->y);
+    double xy[6];
+
+    xy[0] = _cairo_fixed_to_double (b->x);
+    xy[1] = _cairo_fixed_to_double (b->y);
+    xy[2] = _cairo_fixed_to_double (c->x);
+    xy[3] = _cairo_fixed_to_double (c->y);
+    xy[4] = _cairo_fixed_to_double (d->x);
+    xy[5] = _cairo_fixed_to_double (d->y);
 
     info->has_sub_path = TRUE;
-    cairo_matrix_transform_point (info->path_transform, &bx, &by);
-    cairo_matrix_transform_point (info->path_transform, &cx, &cy);
-    cairo_matrix_transform_point (info->path_transform, &dx, &dy);
-    _cairo_output_stream_printf (info->output,
-				 "%g %g %g %g %g %g c ",
-				 bx, by, cx, cy, dx, dy);
+    cairo_matrix_transform_point (info->path_transform, &xy[0], &xy[1]);
+    cairo_matrix_transform_point (info->path_transform, &xy[2], &xy[3]);
+    cairo_matrix_transform_point (info->path_transform, &xy[4], &xy[5]);
+    _cairo_output_stream_print_numbers (info->output, xy, 6, "c ");
     return _cairo_output_stream_get_status (info->output);
 }
 
@@ -416,12 +429,15 @@ _cairo_pdf_path_rectangle (pdf_path_info_t *info, cairo_box_t *box)
     double y1 = _cairo_fixed_to_double (box->p1.y);
     double x2 = _cairo_fixed_to_double (box->p2.x);
     double y2 = _cairo_fixed_to_double (box->p2.y);
+    double rect[4];
 
     cairo_matrix_transform_point (info->path_transform, &x1, &y1);
     cairo_matrix_transform_point (info->path_transform, &x2, &y2);
-    _cairo_output_stream_printf (info->output,
-				 "%g %g %g %g re ",
-				 x1, y1, x2 - x1, y2 - y1);
+    rect[0] = x1;
+    rect[1] = y1;
+    rect[2] = x2 - x1;
+    rect[3] = y2 - y1;
+    _cairo_output_stream_print_numbers (info->output, rect, 4, "re ");
 
     return _cairo_output_stream_get_status (info->output);
 }
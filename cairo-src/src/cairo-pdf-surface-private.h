@@ -68,6 +68,8 @@ typedef struct _cairo_pdf_source_surface_entry {
     cairo_hash_entry_t base;
     unsigned int id;
     cairo_bool_t interpolate;
+    cairo_bool_t by_content;
+    uint64_t content_hash;
     cairo_pdf_resource_t surface_res;
     int width;
     int height;
@@ -118,6 +120,16 @@ typedef struct _cairo_pdf_smask_group {
     cairo_scaled_font_t	 *scaled_font;
 } cairo_pdf_smask_group_t;
 
+/* A stream whose data is held by a deflate job; the object is written
+ * out once the job has been compressed. */
+typedef struct _cairo_pdf_deferred_stream {
+    cairo_pdf_resource_t self;
+    cairo_pdf_resource_t length;
+    unsigned char *header;
+    unsigned long header_length;
+    struct _cairo_deflate_job *job;
+} cairo_pdf_deferred_stream_t;
+
 typedef struct _cairo_pdf_surface cairo_pdf_surface_t;
 
 struct _cairo_pdf_surface {
@@ -138,12 +150,16 @@ struct _cairo_pdf_surface {
     cairo_array_t page_patterns;
     cairo_array_t page_surfaces;
     cairo_hash_table_t *all_surfaces;
+    cairo_bool_t deduplicate_sources;
     cairo_array_t smask_groups;
     cairo_array_t knockout_group;
 
     cairo_scaled_font_subsets_t *font_subsets;
     cairo_array_t fonts;
 
+    int pages_per_chunk;
+    int chunk_pages;
+
     cairo_pdf_resource_t next_available_resource;
     cairo_pdf_resource_t pages_resource;
 
@@ -163,8 +179,11 @@ struct _cairo_pdf_surface {
 	long start_offset;
 	cairo_bool_t compressed;
 	cairo_output_stream_t *old_output;
+	cairo_output_stream_t *header;
     } pdf_stream;
 
+    cairo_array_t deferred_streams;
+
     struct {
 	cairo_bool_t active;
 	cairo_output_stream_t *stream;
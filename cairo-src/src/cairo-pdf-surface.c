@@ -51,6 +51,7 @@
 #include "cairo-recording-surface-private.h"
 #include "cairo-output-stream-private.h"
 #include "cairo-paginated-private.h"
+#include "cairo-parallel-private.h"
 #include "cairo-scaled-font-subsets-private.h"
 #include "cairo-surface-clipper-private.h"
 #include "cairo-surface-subsurface-private.h"
@@ -96,6 +97,14 @@
  *   PDF Streams are written directly to the PDF file. They are used for
  *   fonts, images and patterns.
  *
+ *   Large streams such as images and fonts are opened with
+ *     _cairo_pdf_surface_open_deferred_stream ()
+ *   instead. When there is more than one processor these are buffered in
+ *   memory as deflate jobs, which are compressed together on all
+ *   processors once there is one per processor; the finished objects are
+ *   written out by _cairo_pdf_surface_write_deferred_streams () in
+ *   between other objects, so that their xref offsets are correct.
+ *
  * Content Stream:
  *   The Content Stream is opened and closed with the following functions:
  *     _cairo_pdf_surface_open_content_stream ()
@@ -192,8 +201,24 @@ _cairo_pdf_surface_open_stream (cairo_pdf_surface_t	*surface,
 				const char		*fmt,
 				...) CAIRO_PRINTF_FORMAT(4, 5);
 static cairo_status_t
+_cairo_pdf_surface_open_stream_va (cairo_pdf_surface_t	*surface,
+				   cairo_pdf_resource_t	*resource,
+				   cairo_bool_t		 compressed,
+				   cairo_bool_t		 deferred,
+				   const char		*fmt,
+				   va_list		 ap) CAIRO_PRINTF_FORMAT(5, 0);
+static cairo_status_t
+_cairo_pdf_surface_open_deferred_stream (cairo_pdf_surface_t	*surface,
+					 cairo_pdf_resource_t	*resource,
+					 const char		*fmt,
+					 ...) CAIRO_PRINTF_FORMAT(3, 4);
+static cairo_status_t
 _cairo_pdf_surface_close_stream (cairo_pdf_surface_t	*surface);
 
+static cairo_status_t
+_cairo_pdf_surface_write_deferred_streams (cairo_pdf_surface_t	*surface,
+					   cairo_bool_t		 wait);
+
 static cairo_status_t
 _cairo_pdf_surface_write_page (cairo_pdf_surface_t *surface);
 
@@ -343,6 +368,7 @@ _cairo_pdf_surface_create_for_stream_internal (cairo_output_stream_t	*output,
 
     _cairo_array_init (&surface->page_patterns, sizeof (cairo_pdf_pattern_t));
     _cairo_array_init (&surface->page_surfaces, sizeof (cairo_pdf_source_surface_t));
+    _cairo_array_init (&surface->deferred_streams, sizeof (cairo_pdf_deferred_stream_t));
     surface->all_surfaces = _cairo_hash_table_create (_cairo_pdf_source_surface_equal);
     if (unlikely (surface->all_surfaces == NULL)) {
 	status = _cairo_error (CAIRO_STATUS_NO_MEMORY);
@@ -366,8 +392,12 @@ _cairo_pdf_surface_create_for_stream_internal (cairo_output_stream_t	*output,
 
     surface->pdf_version = CAIRO_PDF_VERSION_1_5;
     surface->compress_content = TRUE;
+    surface->deduplicate_sources = FALSE;
+    surface->pages_per_chunk = 0;
+    surface->chunk_pages = 0;
     surface->pdf_stream.active = FALSE;
     surface->pdf_stream.old_output = NULL;
+    surface->pdf_stream.header = NULL;
     surface->group_stream.active = FALSE;
     surface->group_stream.stream = NULL;
     surface->group_stream.mem_stream = NULL;
@@ -654,6 +684,74 @@ cairo_pdf_surface_set_size (cairo_surface_t	*surface,
 					  height_in_points);
 }
 
+/**
+ * cairo_pdf_surface_set_deduplicate_sources:
+ * @surface: a PDF #cairo_surface_t
+ * @deduplicate: whether to embed identical sources only once
+ *
+ * Normally each surface used as a source is embedded in the PDF file
+ * once, however many times it is drawn, but distinct surfaces are
+ * embedded separately even when they hold the same image or drawing.
+ * With @deduplicate set, the pixels of each image source, and the
+ * drawing commands of each recording surface source, are hashed so
+ * that sources with identical contents are embedded only once and
+ * referenced from every page that draws them.
+ *
+ * Hashing costs a pass over the contents of every newly seen source,
+ * which is only worthwhile when the same contents are expected to be
+ * drawn from separate surfaces, such as an image decoded anew for
+ * each page.
+ *
+ * Since: 1.12
+ **/
+void
+cairo_pdf_surface_set_deduplicate_sources (cairo_surface_t	*surface,
+					   cairo_bool_t		 deduplicate)
+{
+    cairo_pdf_surface_t *pdf_surface = NULL; /* hide compiler warning */
+
+    if (! _extract_pdf_surface (surface, &pdf_surface))
+	return;
+
+    pdf_surface->deduplicate_sources = deduplicate;
+}
+
+/**
+ * cairo_pdf_surface_set_streaming:
+ * @surface: a PDF #cairo_surface_t
+ * @pages_per_chunk: the number of pages after which resources shared
+ * between pages are written out and released, or 0 to keep them until
+ * the surface is finished
+ *
+ * Pages are written out as they are completed, but normally the fonts
+ * used are only embedded once the surface is finished, and sources are
+ * remembered for the whole document so that each is embedded only
+ * once. Memory use thus grows with the length of the document.
+ *
+ * With a non-zero @pages_per_chunk, the font subsets collected over
+ * each run of that many pages are embedded and released at its end,
+ * along with the table of embedded sources. Memory use then no longer
+ * depends on the number of pages, beyond a few bytes for each object
+ * in the cross-reference table, at the cost of embedding again the
+ * fonts and sources used in more than one chunk.
+ *
+ * This function should only be called before any drawing operations
+ * have been performed on the current page.
+ *
+ * Since: 1.12
+ **/
+void
+cairo_pdf_surface_set_streaming (cairo_surface_t	*surface,
+				 int			 pages_per_chunk)
+{
+    cairo_pdf_surface_t *pdf_surface = NULL; /* hide compiler warning */
+
+    if (! _extract_pdf_surface (surface, &pdf_surface))
+	return;
+
+    pdf_surface->pages_per_chunk = MAX (pages_per_chunk, 0);
+}
+
 static void
 _cairo_pdf_surface_clear (cairo_pdf_surface_t *surface)
 {
@@ -1031,13 +1129,49 @@ _cairo_pdf_source_surface_equal (const void *key_a, const void *key_b)
     const cairo_pdf_source_surface_entry_t *a = key_a;
     const cairo_pdf_source_surface_entry_t *b = key_b;
 
-    return (a->id == b->id) && (a->interpolate == b->interpolate);
+    if (a->by_content != b->by_content || a->interpolate != b->interpolate)
+	return FALSE;
+
+    if (a->by_content)
+	return a->content_hash == b->content_hash;
+
+    return a->id == b->id;
 }
 
 static void
 _cairo_pdf_source_surface_init_key (cairo_pdf_source_surface_entry_t *key)
 {
-    key->base.hash = key->id;
+    if (key->by_content)
+	key->base.hash = key->content_hash ^ (key->content_hash >> 32);
+    else
+	key->base.hash = key->id;
+}
+
+/* Adds another key for an embedded source, so that it may also be
+ * found by @key. */
+static cairo_status_t
+_cairo_pdf_surface_add_source_surface_key (cairo_pdf_surface_t			*surface,
+					   const cairo_pdf_source_surface_entry_t	*entry,
+					   const cairo_pdf_source_surface_entry_t	*key)
+{
+    cairo_pdf_source_surface_entry_t *alias;
+    cairo_status_t status;
+
+    alias = malloc (sizeof (cairo_pdf_source_surface_entry_t));
+    if (unlikely (alias == NULL))
+	return _cairo_error (CAIRO_STATUS_NO_MEMORY);
+
+    *alias = *entry;
+    alias->id = key->id;
+    alias->by_content = key->by_content;
+    alias->content_hash = key->content_hash;
+    _cairo_pdf_source_surface_init_key (alias);
+
+    status = _cairo_hash_table_insert (surface->all_surfaces, &alias->base);
+    if (unlikely (status))
+	free (alias);
+
+    return status;
 }
 
 static cairo_int_status_t
@@ -1134,7 +1268,7 @@ _cairo_pdf_surface_add_source_surface (cairo_pdf_surface_t	*surface,
 				       int                      *height)
 {
     cairo_pdf_source_surface_t src_surface;
-    cairo_pdf_source_surface_entry_t surface_key;
+    cairo_pdf_source_surface_entry_t surface_key, content_key;
     cairo_pdf_source_surface_entry_t *surface_entry;
     cairo_status_t status;
     cairo_bool_t interpolate;
@@ -1142,6 +1276,7 @@ _cairo_pdf_surface_add_source_surface (cairo_pdf_surface_t	*surface,
     switch (filter) {
     default:
     case CAIRO_FILTER_GOOD:
+    case CAIRO_FILTER_MIPMAP:
     case CAIRO_FILTER_BEST:
     case CAIRO_FILTER_BILINEAR:
 	interpolate = TRUE;
@@ -1155,6 +1290,8 @@ _cairo_pdf_surface_add_source_surface (cairo_pdf_surface_t	*surface,
 
     surface_key.id  = source->unique_id;
     surface_key.interpolate = interpolate;
+    surface_key.by_content = FALSE;
+    surface_key.content_hash = 0;
     _cairo_pdf_source_surface_init_key (&surface_key);
     surface_entry = _cairo_hash_table_lookup (surface->all_surfaces, &surface_key.base);
     if (surface_entry) {
@@ -1165,13 +1302,39 @@ _cairo_pdf_surface_add_source_surface (cairo_pdf_surface_t	*surface,
 	return CAIRO_STATUS_SUCCESS;
     }
 
+    if (surface->deduplicate_sources) {
+	content_key = surface_key;
+	content_key.id = 0;
+	content_key.by_content = TRUE;
+	status = _cairo_surface_get_content_hash (source,
+						  &content_key.content_hash);
+	if (unlikely (status))
+	    return status;
+
+	_cairo_pdf_source_surface_init_key (&content_key);
+	surface_entry = _cairo_hash_table_lookup (surface->all_surfaces,
+						  &content_key.base);
+	if (surface_entry) {
+	    /* remember the surface itself, so as to hash it only once */
+	    status = _cairo_pdf_surface_add_source_surface_key (surface,
+								surface_entry,
+								&surface_key);
+	    if (unlikely (status))
+		return status;
+
+	    *surface_res = surface_entry->surface_res;
+	    *width = surface_entry->width;
+	    *height = surface_entry->height;
+
+	    return CAIRO_STATUS_SUCCESS;
+	}
+    }
+
     surface_entry = malloc (sizeof (cairo_pdf_source_surface_entry_t));
     if (surface_entry == NULL)
 	return _cairo_error (CAIRO_STATUS_NO_MEMORY);
 
-    surface_entry->id = surface_key.id;
-    surface_entry->interpolate = interpolate;
-    _cairo_pdf_source_surface_init_key (surface_entry);
+    *surface_entry = surface_key;
 
     src_surface.hash_entry = surface_entry;
     src_surface.surface = cairo_surface_reference (source);
@@ -1194,6 +1357,14 @@ _cairo_pdf_surface_add_source_surface (cairo_pdf_surface_t	*surface,
 
     status = _cairo_hash_table_insert (surface->all_surfaces,
 				       &surface_entry->base);
+    if (unlikely (status))
+	return status;
+
+    if (surface->deduplicate_sources) {
+	status = _cairo_pdf_surface_add_source_surface_key (surface,
+							    surface_entry,
+							    &content_key);
+    }
 
     *surface_res = surface_entry->surface_res;
     *width = surface_entry->width;
@@ -1268,19 +1439,28 @@ _cairo_pdf_surface_add_pdf_pattern (cairo_pdf_surface_t		*surface,
 }
 
 static cairo_status_t
-_cairo_pdf_surface_open_stream (cairo_pdf_surface_t	*surface,
-				cairo_pdf_resource_t    *resource,
-				cairo_bool_t             compressed,
-				const char		*fmt,
-				...)
+_cairo_pdf_surface_open_stream_va (cairo_pdf_surface_t	*surface,
+				   cairo_pdf_resource_t	*resource,
+				   cairo_bool_t		 compressed,
+				   cairo_bool_t		 deferred,
+				   const char		*fmt,
+				   va_list		 ap)
 {
-    va_list ap;
     cairo_pdf_resource_t self, length;
     cairo_output_stream_t *output = NULL;
+    cairo_output_stream_t *header;
+    cairo_status_t status, status2;
+
+    if (! surface->group_stream.active) {
+	status = _cairo_pdf_surface_write_deferred_streams (surface, FALSE);
+	if (unlikely (status))
+	    return status;
+    }
 
     if (resource) {
 	self = *resource;
-	_cairo_pdf_surface_update_object (surface, self);
+	if (! deferred)
+	    _cairo_pdf_surface_update_object (surface, self);
     } else {
 	self = _cairo_pdf_surface_new_object (surface);
 	if (self.id == 0)
@@ -1291,7 +1471,23 @@ _cairo_pdf_surface_open_stream (cairo_pdf_surface_t	*surface,
     if (length.id == 0)
 	return _cairo_error (CAIRO_STATUS_NO_MEMORY);
 
-    if (compressed) {
+    /* A deferred stream writes its header into memory and its data,
+     * uncompressed, into a second memory stream that is handed to a
+     * deflate job when the stream is closed. */
+    header = surface->output;
+    if (deferred) {
+	header = _cairo_memory_stream_create ();
+	output = _cairo_memory_stream_create ();
+	if (_cairo_output_stream_get_status (header) ||
+	    _cairo_output_stream_get_status (output))
+	{
+	    status = _cairo_output_stream_destroy (header);
+	    status2 = _cairo_output_stream_destroy (output);
+	    if (status == CAIRO_STATUS_SUCCESS)
+		status = status2;
+	    return status;
+	}
+    } else if (compressed) {
 	output = _cairo_deflate_stream_create (surface->output);
 	if (_cairo_output_stream_get_status (output))
 	    return _cairo_output_stream_destroy (output);
@@ -1301,26 +1497,24 @@ _cairo_pdf_surface_open_stream (cairo_pdf_surface_t	*surface,
     surface->pdf_stream.self = self;
     surface->pdf_stream.length = length;
     surface->pdf_stream.compressed = compressed;
+    surface->pdf_stream.header = deferred ? header : NULL;
     surface->current_pattern_is_solid_color = FALSE;
     surface->current_operator = CAIRO_OPERATOR_OVER;
     _cairo_pdf_operators_reset (&surface->pdf_operators);
 
-    _cairo_output_stream_printf (surface->output,
+    _cairo_output_stream_printf (header,
 				 "%d 0 obj\n"
 				 "<< /Length %d 0 R\n",
 				 surface->pdf_stream.self.id,
 				 surface->pdf_stream.length.id);
     if (compressed)
-	_cairo_output_stream_printf (surface->output,
+	_cairo_output_stream_printf (header,
 				     "   /Filter /FlateDecode\n");
 
-    if (fmt != NULL) {
-	va_start (ap, fmt);
-	_cairo_output_stream_vprintf (surface->output, fmt, ap);
-	va_end (ap);
-    }
+    if (fmt != NULL)
+	_cairo_output_stream_vprintf (header, fmt, ap);
 
-    _cairo_output_stream_printf (surface->output,
+    _cairo_output_stream_printf (header,
 				 ">>\n"
 				 "stream\n");
 
@@ -1336,6 +1530,203 @@ _cairo_pdf_surface_open_stream (cairo_pdf_surface_t	*surface,
     return _cairo_output_stream_get_status (surface->output);
 }
 
+static cairo_status_t
+_cairo_pdf_surface_open_stream (cairo_pdf_surface_t	*surface,
+				cairo_pdf_resource_t    *resource,
+				cairo_bool_t             compressed,
+				const char		*fmt,
+				...)
+{
+    va_list ap;
+    cairo_status_t status;
+
+    va_start (ap, fmt);
+    status = _cairo_pdf_surface_open_stream_va (surface, resource,
+						compressed, FALSE,
+						fmt, ap);
+    va_end (ap);
+
+    return status;
+}
+
+/* Opens a compressed stream that, if possible, is deflated in the
+ * background and written out once finished. Only the stream data may be
+ * written to surface->output and the stream must be closed before any
+ * other object is emitted.
+ */
+static cairo_status_t
+_cairo_pdf_surface_open_deferred_stream (cairo_pdf_surface_t	*surface,
+					 cairo_pdf_resource_t	*resource,
+					 const char		*fmt,
+					 ...)
+{
+    va_list ap;
+    cairo_status_t status;
+
+    va_start (ap, fmt);
+    status = _cairo_pdf_surface_open_stream_va (surface, resource, TRUE,
+						_cairo_deflate_job_can_run_in_parallel (),
+						fmt, ap);
+    va_end (ap);
+
+    return status;
+}
+
+static cairo_status_t
+_cairo_pdf_deferred_stream_compress (void *closure, int task)
+{
+    cairo_pdf_deferred_stream_t *deferred = closure;
+
+    _cairo_deflate_job_compress (deferred[task].job);
+
+    return CAIRO_STATUS_SUCCESS;
+}
+
+/* Compresses the deferred streams still pending, spread over all
+ * processors, provided there are at least @min_streams of them. Streams
+ * are compressed in order, so the pending ones are always the last. */
+static cairo_status_t
+_cairo_pdf_surface_compress_deferred_streams (cairo_pdf_surface_t *surface,
+					      int		   min_streams)
+{
+    cairo_pdf_deferred_stream_t *deferred;
+    int num_streams, first;
+
+    num_streams = _cairo_array_num_elements (&surface->deferred_streams);
+    for (first = num_streams; first > 0; first--) {
+	deferred = _cairo_array_index (&surface->deferred_streams, first - 1);
+	if (_cairo_deflate_job_is_done (deferred->job))
+	    break;
+    }
+
+    if (num_streams == first || num_streams - first < min_streams)
+	return CAIRO_STATUS_SUCCESS;
+
+    return _cairo_parallel_for (num_streams - first,
+				_cairo_parallel_num_threads (),
+				_cairo_pdf_deferred_stream_compress,
+				_cairo_array_index (&surface->deferred_streams, first));
+}
+
+static cairo_status_t
+_cairo_pdf_surface_close_deferred_stream (cairo_pdf_surface_t *surface)
+{
+    cairo_pdf_deferred_stream_t deferred;
+    unsigned char *data;
+    unsigned long length;
+    cairo_status_t status, status2;
+
+    status = _cairo_memory_stream_destroy (surface->output, &data, &length);
+
+    surface->output = surface->pdf_stream.old_output;
+    _cairo_pdf_operators_set_stream (&surface->pdf_operators, surface->output);
+    surface->pdf_stream.old_output = NULL;
+    surface->pdf_stream.active = FALSE;
+
+    status2 = _cairo_memory_stream_destroy (surface->pdf_stream.header,
+					    &deferred.header,
+					    &deferred.header_length);
+    surface->pdf_stream.header = NULL;
+    if (unlikely (status || status2)) {
+	if (status == CAIRO_STATUS_SUCCESS) {
+	    free (data);
+	    status = status2;
+	} else if (status2 == CAIRO_STATUS_SUCCESS) {
+	    free (deferred.header);
+	}
+	return status;
+    }
+
+    deferred.self = surface->pdf_stream.self;
+    deferred.length = surface->pdf_stream.length;
+    deferred.job = _cairo_deflate_job_create (data, length);
+    if (unlikely (deferred.job == NULL)) {
+	free (deferred.header);
+	return _cairo_error (CAIRO_STATUS_NO_MEMORY);
+    }
+
+    status = _cairo_array_append (&surface->deferred_streams, &deferred);
+    if (unlikely (status)) {
+	_cairo_deflate_job_destroy (deferred.job);
+	free (deferred.header);
+	return status;
+    }
+
+    /* Holding on to more uncompressed streams than there are processors
+     * to compress them only costs memory. */
+    return _cairo_pdf_surface_compress_deferred_streams (surface,
+							 _cairo_parallel_num_threads ());
+}
+
+/* Writes out the deferred streams in the order they were closed. Unless
+ * @wait is set this stops at the first one not yet compressed, so that
+ * it may be called between objects without compressing a lone stream. */
+static cairo_status_t
+_cairo_pdf_surface_write_deferred_streams (cairo_pdf_surface_t	*surface,
+					   cairo_bool_t		 wait)
+{
+    cairo_pdf_deferred_stream_t *deferred;
+    cairo_status_t status = CAIRO_STATUS_SUCCESS;
+    unsigned int num_streams, i;
+    long start_offset, length;
+
+    if (wait) {
+	status = _cairo_pdf_surface_compress_deferred_streams (surface, 1);
+	if (unlikely (status))
+	    return status;
+    }
+
+    num_streams = _cairo_array_num_elements (&surface->deferred_streams);
+    for (i = 0; i < num_streams; i++) {
+	deferred = _cairo_array_index (&surface->deferred_streams, i);
+	if (! wait && ! _cairo_deflate_job_is_done (deferred->job))
+	    break;
+
+	if (unlikely (status)) {
+	    _cairo_deflate_job_destroy (deferred->job);
+	    free (deferred->header);
+	    continue;
+	}
+
+	_cairo_pdf_surface_update_object (surface, deferred->self);
+	_cairo_output_stream_write (surface->output,
+				    deferred->header,
+				    deferred->header_length);
+	free (deferred->header);
+
+	start_offset = _cairo_output_stream_get_position (surface->output);
+	status = _cairo_deflate_job_write (deferred->job, surface->output);
+	length = _cairo_output_stream_get_position (surface->output) - start_offset;
+
+	_cairo_output_stream_printf (surface->output,
+				     "\n"
+				     "endstream\n"
+				     "endobj\n");
+
+	_cairo_pdf_surface_update_object (surface, deferred->length);
+	_cairo_output_stream_printf (surface->output,
+				     "%d 0 obj\n"
+				     "   %ld\n"
+				     "endobj\n",
+				     deferred->length.id,
+				     length);
+
+	if (likely (status == CAIRO_STATUS_SUCCESS))
+	    status = _cairo_output_stream_get_status (surface->output);
+    }
+
+    if (i == num_streams) {
+	_cairo_array_truncate (&surface->deferred_streams, 0);
+    } else if (i > 0) {
+	deferred = _cairo_array_index (&surface->deferred_streams, 0);
+	memmove (deferred, deferred + i,
+		 (num_streams - i) * sizeof (cairo_pdf_deferred_stream_t));
+	_cairo_array_truncate (&surface->deferred_streams, num_streams - i);
+    }
+
+    return status;
+}
+
 static cairo_status_t
 _cairo_pdf_surface_close_stream (cairo_pdf_surface_t *surface)
 {
@@ -1346,6 +1737,15 @@ _cairo_pdf_surface_close_stream (cairo_pdf_surface_t *surface)
 	return CAIRO_STATUS_SUCCESS;
 
     status = _cairo_pdf_operators_flush (&surface->pdf_operators);
+    if (surface->pdf_stream.header != NULL) {
+	cairo_status_t status2;
+
+	status2 = _cairo_pdf_surface_close_deferred_stream (surface);
+	if (likely (status == CAIRO_STATUS_SUCCESS))
+	    status = status2;
+
+	return status;
+    }
 
     if (surface->pdf_stream.compressed) {
 	cairo_status_t status2;
@@ -1620,11 +2020,16 @@ _cairo_pdf_surface_finish (void *abstract_surface)
     long offset;
     cairo_pdf_resource_t info, catalog;
     cairo_status_t status, status2;
+    int i;
 
     status = surface->base.status;
     if (status == CAIRO_STATUS_SUCCESS)
 	status = _cairo_pdf_surface_emit_font_subsets (surface);
 
+    status2 = _cairo_pdf_surface_write_deferred_streams (surface, TRUE);
+    if (status == CAIRO_STATUS_SUCCESS)
+	status = status2;
+
     _cairo_pdf_surface_write_pages (surface);
 
     info = _cairo_pdf_surface_write_info (surface);
@@ -1680,6 +2085,15 @@ _cairo_pdf_surface_finish (void *abstract_surface)
     if (surface->group_stream.active)
 	surface->output = surface->group_stream.old_output;
 
+    /* discard any deferred streams left over after fatal errors */
+    for (i = 0; i < _cairo_array_num_elements (&surface->deferred_streams); i++) {
+	cairo_pdf_deferred_stream_t *deferred;
+
+	deferred = _cairo_array_index (&surface->deferred_streams, i);
+	_cairo_deflate_job_destroy (deferred->job);
+	free (deferred->header);
+    }
+
     /* and finish the pdf surface */
     status2 = _cairo_output_stream_destroy (surface->output);
     if (status == CAIRO_STATUS_SUCCESS)
@@ -1694,6 +2108,7 @@ _cairo_pdf_surface_finish (void *abstract_surface)
     _cairo_array_fini (&surface->alpha_linear_functions);
     _cairo_array_fini (&surface->page_patterns);
     _cairo_array_fini (&surface->page_surfaces);
+    _cairo_array_fini (&surface->deferred_streams);
     _cairo_hash_table_foreach (surface->all_surfaces,
 			       _cairo_pdf_source_surface_entry_pluck,
 			       surface->all_surfaces);
@@ -1842,17 +2257,16 @@ _cairo_pdf_surface_emit_smask (cairo_pdf_surface_t	*surface,
     if (opaque)
 	goto CLEANUP_ALPHA;
 
-    status = _cairo_pdf_surface_open_stream (surface,
-					     NULL,
-					     TRUE,
-					     "   /Type /XObject\n"
-					     "   /Subtype /Image\n"
-					     "   /Width %d\n"
-					     "   /Height %d\n"
-					     "   /ColorSpace /DeviceGray\n"
-					     "   /BitsPerComponent %d\n",
-					     image->width, image->height,
-					     image->format == CAIRO_FORMAT_A1 ? 1 : 8);
+    status = _cairo_pdf_surface_open_deferred_stream (surface,
+						      NULL,
+						      "   /Type /XObject\n"
+						      "   /Subtype /Image\n"
+						      "   /Width %d\n"
+						      "   /Height %d\n"
+						      "   /ColorSpace /DeviceGray\n"
+						      "   /BitsPerComponent %d\n",
+						      image->width, image->height,
+						      image->format == CAIRO_FORMAT_A1 ? 1 : 8);
     if (unlikely (status))
 	goto CLEANUP_ALPHA;
 
@@ -1948,6 +2362,7 @@ _cairo_pdf_surface_emit_image (cairo_pdf_surface_t     *surface,
 
     switch (filter) {
     case CAIRO_FILTER_GOOD:
+    case CAIRO_FILTER_MIPMAP:
     case CAIRO_FILTER_BEST:
     case CAIRO_FILTER_BILINEAR:
 	interpolate = "true";
@@ -1968,21 +2383,19 @@ _cairo_pdf_surface_emit_image (cairo_pdf_surface_t     *surface,
 				"   /BitsPerComponent 8\n"
 
     if (need_smask)
-	status = _cairo_pdf_surface_open_stream (surface,
-						 image_res,
-						 TRUE,
-						 IMAGE_DICTIONARY
-						 "   /SMask %d 0 R\n",
-						 image->width, image->height,
-						 interpolate,
-						 smask.id);
+	status = _cairo_pdf_surface_open_deferred_stream (surface,
+							  image_res,
+							  IMAGE_DICTIONARY
+							  "   /SMask %d 0 R\n",
+							  image->width, image->height,
+							  interpolate,
+							  smask.id);
     else
-	status = _cairo_pdf_surface_open_stream (surface,
-						 image_res,
-						 TRUE,
-						 IMAGE_DICTIONARY,
-						 image->width, image->height,
-						 interpolate);
+	status = _cairo_pdf_surface_open_deferred_stream (surface,
+							  image_res,
+							  IMAGE_DICTIONARY,
+							  image->width, image->height,
+							  interpolate);
     if (unlikely (status))
 	goto CLEANUP_RGB;
 
@@ -2181,6 +2594,7 @@ _cairo_pdf_surface_emit_padded_image_surface (cairo_pdf_surface_t     *surface,
 
     switch (pdf_pattern->pattern->filter) {
     case CAIRO_FILTER_GOOD:
+    case CAIRO_FILTER_MIPMAP:
     case CAIRO_FILTER_BEST:
     case CAIRO_FILTER_BILINEAR:
 	interpolate = TRUE;
@@ -3547,6 +3961,34 @@ _cairo_pdf_surface_unselect_pattern (cairo_pdf_surface_t *surface)
     return CAIRO_STATUS_SUCCESS;
 }
 
+/* Embeds the font subsets used by the pages of the chunk just completed
+ * and starts afresh, so that a streaming surface does not accumulate
+ * fonts and sources for the whole document. */
+static cairo_status_t
+_cairo_pdf_surface_write_chunk_resources (cairo_pdf_surface_t *surface)
+{
+    cairo_scaled_font_subsets_t *font_subsets;
+    cairo_status_t status;
+
+    font_subsets = _cairo_scaled_font_subsets_create_composite ();
+    if (unlikely (font_subsets == NULL))
+	return _cairo_error (CAIRO_STATUS_NO_MEMORY);
+
+    status = _cairo_pdf_surface_emit_font_subsets (surface);
+    surface->font_subsets = font_subsets;
+    _cairo_pdf_operators_set_font_subsets (&surface->pdf_operators,
+					   font_subsets);
+    _cairo_array_truncate (&surface->fonts, 0);
+
+    _cairo_hash_table_foreach (surface->all_surfaces,
+			       _cairo_pdf_source_surface_entry_pluck,
+			       surface->all_surfaces);
+
+    surface->chunk_pages = 0;
+
+    return status;
+}
+
 static cairo_int_status_t
 _cairo_pdf_surface_show_page (void *abstract_surface)
 {
@@ -3561,8 +4003,20 @@ _cairo_pdf_surface_show_page (void *abstract_surface)
     if (unlikely (status))
 	return status;
 
+    status = _cairo_pdf_surface_write_deferred_streams (surface, TRUE);
+    if (unlikely (status))
+	return status;
+
     _cairo_pdf_surface_clear (surface);
 
+    if (surface->pages_per_chunk &&
+	++surface->chunk_pages == surface->pages_per_chunk)
+    {
+	status = _cairo_pdf_surface_write_chunk_resources (surface);
+	if (unlikely (status))
+	    return status;
+    }
+
     return CAIRO_STATUS_SUCCESS;
 }
 
@@ -3898,10 +4352,9 @@ _cairo_pdf_surface_emit_cff_font (cairo_pdf_surface_t		*surface,
     if (subset_resource.id == 0)
 	return CAIRO_STATUS_SUCCESS;
 
-    status = _cairo_pdf_surface_open_stream (surface,
-					     NULL,
-					     TRUE,
-					     "   /Subtype /CIDFontType0C\n");
+    status = _cairo_pdf_surface_open_deferred_stream (surface,
+						      NULL,
+						      "   /Subtype /CIDFontType0C\n");
     if (unlikely (status))
 	return status;
 
@@ -4018,48 +4471,6 @@ _cairo_pdf_surface_emit_cff_font (cairo_pdf_surface_t		*surface,
     return status;
 }
 
-static cairo_status_t
-_cairo_pdf_surface_emit_cff_font_subset (cairo_pdf_surface_t	     *surface,
-                                         cairo_scaled_font_subset_t  *font_subset)
-{
-    cairo_status_t status;
-    cairo_cff_subset_t subset;
-    char name[64];
-
-    snprintf (name, sizeof name, "CairoFont-%d-%d",
-              font_subset->font_id, font_subset->subset_id);
-    status = _cairo_cff_subset_init (&subset, name, font_subset);
-    if (unlikely (status))
-        return status;
-
-    status = _cairo_pdf_surface_emit_cff_font (surface, font_subset, &subset);
-
-    _cairo_cff_subset_fini (&subset);
-
-    return status;
-}
-
-static cairo_status_t
-_cairo_pdf_surface_emit_cff_fallback_font (cairo_pdf_surface_t	       *surface,
-                                           cairo_scaled_font_subset_t  *font_subset)
-{
-    cairo_status_t status;
-    cairo_cff_subset_t subset;
-    char name[64];
-
-    snprintf (name, sizeof name, "CairoFont-%d-%d",
-              font_subset->font_id, font_subset->subset_id);
-    status = _cairo_cff_fallback_init (&subset, name, font_subset);
-    if (unlikely (status))
-        return status;
-
-    status = _cairo_pdf_surface_emit_cff_font (surface, font_subset, &subset);
-
-    _cairo_cff_fallback_fini (&subset);
-
-    return status;
-}
-
 static cairo_status_t
 _cairo_pdf_surface_emit_type1_font (cairo_pdf_surface_t		*surface,
                                     cairo_scaled_font_subset_t	*font_subset,
@@ -4081,15 +4492,14 @@ _cairo_pdf_surface_emit_type1_font (cairo_pdf_surface_t		*surface,
 	return CAIRO_STATUS_SUCCESS;
 
     length = subset->header_length + subset->data_length + subset->trailer_length;
-    status = _cairo_pdf_surface_open_stream (surface,
-					     NULL,
-					     TRUE,
-					     "   /Length1 %lu\n"
-					     "   /Length2 %lu\n"
-					     "   /Length3 %lu\n",
-					     subset->header_length,
-					     subset->data_length,
-					     subset->trailer_length);
+    status = _cairo_pdf_surface_open_deferred_stream (surface,
+						      NULL,
+						      "   /Length1 %lu\n"
+						      "   /Length2 %lu\n"
+						      "   /Length3 %lu\n",
+						      subset->header_length,
+						      subset->data_length,
+						      subset->trailer_length);
     if (unlikely (status))
 	return status;
 
@@ -4175,57 +4585,15 @@ _cairo_pdf_surface_emit_type1_font (cairo_pdf_surface_t		*surface,
     return _cairo_array_append (&surface->fonts, &font);
 }
 
-#if CAIRO_HAS_FT_FONT
-static cairo_status_t
-_cairo_pdf_surface_emit_type1_font_subset (cairo_pdf_surface_t		*surface,
-					   cairo_scaled_font_subset_t	*font_subset)
-{
-    cairo_status_t status;
-    cairo_type1_subset_t subset;
-    char name[64];
-
-    snprintf (name, sizeof name, "CairoFont-%d-%d",
-	      font_subset->font_id, font_subset->subset_id);
-    status = _cairo_type1_subset_init (&subset, name, font_subset, FALSE);
-    if (unlikely (status))
-	return status;
-
-    status = _cairo_pdf_surface_emit_type1_font (surface, font_subset, &subset);
-
-    _cairo_type1_subset_fini (&subset);
-    return status;
-}
-#endif
-
-static cairo_status_t
-_cairo_pdf_surface_emit_type1_fallback_font (cairo_pdf_surface_t	*surface,
-                                             cairo_scaled_font_subset_t	*font_subset)
-{
-    cairo_status_t status;
-    cairo_type1_subset_t subset;
-    char name[64];
-
-    snprintf (name, sizeof name, "CairoFont-%d-%d",
-	      font_subset->font_id, font_subset->subset_id);
-    status = _cairo_type1_fallback_init_binary (&subset, name, font_subset);
-    if (unlikely (status))
-	return status;
-
-    status = _cairo_pdf_surface_emit_type1_font (surface, font_subset, &subset);
-
-    _cairo_type1_fallback_fini (&subset);
-    return status;
-}
-
 static cairo_status_t
-_cairo_pdf_surface_emit_truetype_font_subset (cairo_pdf_surface_t		*surface,
-					      cairo_scaled_font_subset_t	*font_subset)
+_cairo_pdf_surface_emit_truetype_font (cairo_pdf_surface_t		*surface,
+				       cairo_scaled_font_subset_t	*font_subset,
+				       cairo_truetype_subset_t		*subset)
 {
     cairo_pdf_resource_t stream, descriptor, cidfont_dict;
     cairo_pdf_resource_t subset_resource, to_unicode_stream;
     cairo_status_t status;
     cairo_pdf_font_t font;
-    cairo_truetype_subset_t subset;
     unsigned int i;
     char tag[10];
 
@@ -4235,44 +4603,31 @@ _cairo_pdf_surface_emit_truetype_font_subset (cairo_pdf_surface_t		*surface,
     if (subset_resource.id == 0)
 	return CAIRO_STATUS_SUCCESS;
 
-    status = _cairo_truetype_subset_init (&subset, font_subset);
-    if (unlikely (status))
-	return status;
-
-    _create_font_subset_tag (font_subset, subset.ps_name, tag);
+    _create_font_subset_tag (font_subset, subset->ps_name, tag);
 
-    status = _cairo_pdf_surface_open_stream (surface,
-					     NULL,
-					     TRUE,
-					     "   /Length1 %lu\n",
-					     subset.data_length);
-    if (unlikely (status)) {
-	_cairo_truetype_subset_fini (&subset);
+    status = _cairo_pdf_surface_open_deferred_stream (surface,
+						      NULL,
+						      "   /Length1 %lu\n",
+						      subset->data_length);
+    if (unlikely (status))
 	return status;
-    }
 
     stream = surface->pdf_stream.self;
     _cairo_output_stream_write (surface->output,
-				subset.data, subset.data_length);
+				subset->data, subset->data_length);
     status = _cairo_pdf_surface_close_stream (surface);
-    if (unlikely (status)) {
-	_cairo_truetype_subset_fini (&subset);
+    if (unlikely (status))
 	return status;
-    }
 
     status = _cairo_pdf_surface_emit_to_unicode_stream (surface,
 	                                                font_subset, TRUE,
 							&to_unicode_stream);
-    if (_cairo_status_is_error (status)) {
-	_cairo_truetype_subset_fini (&subset);
+    if (_cairo_status_is_error (status))
 	return status;
-    }
 
     descriptor = _cairo_pdf_surface_new_object (surface);
-    if (descriptor.id == 0) {
-	_cairo_truetype_subset_fini (&subset);
+    if (descriptor.id == 0)
 	return _cairo_error (CAIRO_STATUS_NO_MEMORY);
-    }
 
     _cairo_output_stream_printf (surface->output,
 				 "%d 0 obj\n"
@@ -4280,12 +4635,12 @@ _cairo_pdf_surface_emit_truetype_font_subset (cairo_pdf_surface_t		*surface,
 				 "   /FontName /%s+%s\n",
 				 descriptor.id,
 				 tag,
-				 subset.ps_name);
+				 subset->ps_name);
 
-    if (subset.font_name) {
+    if (subset->font_name) {
 	_cairo_output_stream_printf (surface->output,
 				     "   /FontFamily (%s)\n",
-				     subset.font_name);
+				     subset->font_name);
     }
 
     _cairo_output_stream_printf (surface->output,
@@ -4300,20 +4655,18 @@ _cairo_pdf_surface_emit_truetype_font_subset (cairo_pdf_surface_t		*surface,
 				 "   /FontFile2 %u 0 R\n"
 				 ">>\n"
 				 "endobj\n",
-				 (long)(subset.x_min*PDF_UNITS_PER_EM),
-				 (long)(subset.y_min*PDF_UNITS_PER_EM),
-                                 (long)(subset.x_max*PDF_UNITS_PER_EM),
-				 (long)(subset.y_max*PDF_UNITS_PER_EM),
-				 (long)(subset.ascent*PDF_UNITS_PER_EM),
-				 (long)(subset.descent*PDF_UNITS_PER_EM),
-				 (long)(subset.y_max*PDF_UNITS_PER_EM),
+				 (long)(subset->x_min*PDF_UNITS_PER_EM),
+				 (long)(subset->y_min*PDF_UNITS_PER_EM),
+                                 (long)(subset->x_max*PDF_UNITS_PER_EM),
+				 (long)(subset->y_max*PDF_UNITS_PER_EM),
+				 (long)(subset->ascent*PDF_UNITS_PER_EM),
+				 (long)(subset->descent*PDF_UNITS_PER_EM),
+				 (long)(subset->y_max*PDF_UNITS_PER_EM),
 				 stream.id);
 
     cidfont_dict = _cairo_pdf_surface_new_object (surface);
-    if (cidfont_dict.id == 0) {
-	_cairo_truetype_subset_fini (&subset);
+    if (cidfont_dict.id == 0)
 	return _cairo_error (CAIRO_STATUS_NO_MEMORY);
-    }
 
     _cairo_output_stream_printf (surface->output,
                                  "%d 0 obj\n"
@@ -4329,13 +4682,13 @@ _cairo_pdf_surface_emit_truetype_font_subset (cairo_pdf_surface_t		*surface,
                                  "   /W [0 [",
                                  cidfont_dict.id,
 				 tag,
-                                 subset.ps_name,
+                                 subset->ps_name,
                                  descriptor.id);
 
     for (i = 0; i < font_subset->num_glyphs; i++)
         _cairo_output_stream_printf (surface->output,
                                      " %ld",
-                                     (long)(subset.widths[i]*PDF_UNITS_PER_EM));
+                                     (long)(subset->widths[i]*PDF_UNITS_PER_EM));
 
     _cairo_output_stream_printf (surface->output,
                                  " ]]\n"
@@ -4352,7 +4705,7 @@ _cairo_pdf_surface_emit_truetype_font_subset (cairo_pdf_surface_t		*surface,
 				 "   /DescendantFonts [ %d 0 R]\n",
 				 subset_resource.id,
 				 tag,
-				 subset.ps_name,
+				 subset->ps_name,
 				 cidfont_dict.id);
 
     if (to_unicode_stream.id != 0)
@@ -4367,11 +4720,7 @@ _cairo_pdf_surface_emit_truetype_font_subset (cairo_pdf_surface_t		*surface,
     font.font_id = font_subset->font_id;
     font.subset_id = font_subset->subset_id;
     font.subset_resource = subset_resource;
-    status = _cairo_array_append (&surface->fonts, &font);
-
-    _cairo_truetype_subset_fini (&subset);
-
-    return status;
+    return _cairo_array_append (&surface->fonts, &font);
 }
 
 static cairo_status_t
@@ -4639,42 +4988,135 @@ _cairo_pdf_surface_emit_type3_font_subset (cairo_pdf_surface_t		*surface,
     return _cairo_array_append (&surface->fonts, &font);
 }
 
+typedef enum _cairo_pdf_font_subset_type {
+    CAIRO_PDF_FONT_SUBSET_CFF,
+    CAIRO_PDF_FONT_SUBSET_TRUETYPE,
+    CAIRO_PDF_FONT_SUBSET_CFF_FALLBACK,
+    CAIRO_PDF_FONT_SUBSET_TYPE1,
+    CAIRO_PDF_FONT_SUBSET_TYPE1_FALLBACK
+} cairo_pdf_font_subset_type_t;
+
+typedef struct _cairo_pdf_prepared_font_subset {
+    cairo_pdf_font_subset_type_t type;
+    union {
+	cairo_cff_subset_t cff;
+	cairo_truetype_subset_t truetype;
+	cairo_type1_subset_t type1;
+    } u;
+} cairo_pdf_prepared_font_subset_t;
+
+/* Generates the font program for the subset. This may be called from
+ * another thread, and so must not touch the surface. */
 static cairo_status_t
-_cairo_pdf_surface_emit_unscaled_font_subset (cairo_scaled_font_subset_t *font_subset,
-                                              void			 *closure)
+_cairo_pdf_surface_prepare_unscaled_font_subset (cairo_scaled_font_subset_t  *font_subset,
+						 void			     *closure,
+						 void			    **prepared)
 {
-    cairo_pdf_surface_t *surface = closure;
+    cairo_pdf_prepared_font_subset_t *font;
     cairo_status_t status;
+    char name[64];
+
+    font = malloc (sizeof (cairo_pdf_prepared_font_subset_t));
+    if (unlikely (font == NULL))
+	return _cairo_error (CAIRO_STATUS_NO_MEMORY);
+
+    snprintf (name, sizeof name, "CairoFont-%d-%d",
+              font_subset->font_id, font_subset->subset_id);
 
     if (font_subset->is_composite) {
-        status = _cairo_pdf_surface_emit_cff_font_subset (surface, font_subset);
-        if (status != CAIRO_INT_STATUS_UNSUPPORTED)
-            return status;
+	font->type = CAIRO_PDF_FONT_SUBSET_CFF;
+	status = _cairo_cff_subset_init (&font->u.cff, name, font_subset);
 
-        status = _cairo_pdf_surface_emit_truetype_font_subset (surface, font_subset);
-        if (status != CAIRO_INT_STATUS_UNSUPPORTED)
-            return status;
+	if (status == CAIRO_INT_STATUS_UNSUPPORTED) {
+	    font->type = CAIRO_PDF_FONT_SUBSET_TRUETYPE;
+	    status = _cairo_truetype_subset_init (&font->u.truetype, font_subset);
+	}
 
-        status = _cairo_pdf_surface_emit_cff_fallback_font (surface, font_subset);
-        if (status != CAIRO_INT_STATUS_UNSUPPORTED)
-            return status;
+	if (status == CAIRO_INT_STATUS_UNSUPPORTED) {
+	    font->type = CAIRO_PDF_FONT_SUBSET_CFF_FALLBACK;
+	    status = _cairo_cff_fallback_init (&font->u.cff, name, font_subset);
+	}
     } else {
+	status = CAIRO_INT_STATUS_UNSUPPORTED;
 #if CAIRO_HAS_FT_FONT
-        status = _cairo_pdf_surface_emit_type1_font_subset (surface, font_subset);
-        if (status != CAIRO_INT_STATUS_UNSUPPORTED)
-            return status;
+	font->type = CAIRO_PDF_FONT_SUBSET_TYPE1;
+	status = _cairo_type1_subset_init (&font->u.type1, name, font_subset, FALSE);
 #endif
 
-        status = _cairo_pdf_surface_emit_type1_fallback_font (surface, font_subset);
-        if (status != CAIRO_INT_STATUS_UNSUPPORTED)
-            return status;
+	if (status == CAIRO_INT_STATUS_UNSUPPORTED) {
+	    font->type = CAIRO_PDF_FONT_SUBSET_TYPE1_FALLBACK;
+	    status = _cairo_type1_fallback_init_binary (&font->u.type1, name, font_subset);
+	}
+    }
+
+    assert (status != CAIRO_INT_STATUS_UNSUPPORTED);
+    if (unlikely (status)) {
+	free (font);
+	return status;
+    }
+
+    *prepared = font;
+    return CAIRO_STATUS_SUCCESS;
+}
+
+static cairo_status_t
+_cairo_pdf_surface_emit_unscaled_font_subset (cairo_scaled_font_subset_t *font_subset,
+					      void			 *prepared,
+					      void			 *closure)
+{
+    cairo_pdf_surface_t *surface = closure;
+    cairo_pdf_prepared_font_subset_t *font = prepared;
+
+    switch (font->type) {
+    case CAIRO_PDF_FONT_SUBSET_CFF:
+    case CAIRO_PDF_FONT_SUBSET_CFF_FALLBACK:
+	return _cairo_pdf_surface_emit_cff_font (surface, font_subset, &font->u.cff);
+
+    case CAIRO_PDF_FONT_SUBSET_TRUETYPE:
+	return _cairo_pdf_surface_emit_truetype_font (surface, font_subset, &font->u.truetype);
 
+    case CAIRO_PDF_FONT_SUBSET_TYPE1:
+    case CAIRO_PDF_FONT_SUBSET_TYPE1_FALLBACK:
+	return _cairo_pdf_surface_emit_type1_font (surface, font_subset, &font->u.type1);
     }
 
     ASSERT_NOT_REACHED;
     return CAIRO_STATUS_SUCCESS;
 }
 
+static void
+_cairo_pdf_prepared_font_subset_destroy (void *abstract_font)
+{
+    cairo_pdf_prepared_font_subset_t *font = abstract_font;
+
+    switch (font->type) {
+    case CAIRO_PDF_FONT_SUBSET_CFF:
+	_cairo_cff_subset_fini (&font->u.cff);
+	break;
+    case CAIRO_PDF_FONT_SUBSET_CFF_FALLBACK:
+	_cairo_cff_fallback_fini (&font->u.cff);
+	break;
+    case CAIRO_PDF_FONT_SUBSET_TRUETYPE:
+	_cairo_truetype_subset_fini (&font->u.truetype);
+	break;
+    case CAIRO_PDF_FONT_SUBSET_TYPE1:
+#if CAIRO_HAS_FT_FONT
+	_cairo_type1_subset_fini (&font->u.type1);
+#else
+	/* only prepared when the type1 subsetter is available */
+	ASSERT_NOT_REACHED;
+#endif
+	break;
+    case CAIRO_PDF_FONT_SUBSET_TYPE1_FALLBACK:
+	_cairo_type1_fallback_fini (&font->u.type1);
+	break;
+    default:
+	ASSERT_NOT_REACHED;
+    }
+
+    free (font);
+}
+
 static cairo_status_t
 _cairo_pdf_surface_emit_scaled_font_subset (cairo_scaled_font_subset_t *font_subset,
                                             void		       *closure)
@@ -4701,9 +5143,11 @@ _cairo_pdf_surface_emit_font_subsets (cairo_pdf_surface_t *surface)
     if (unlikely (status))
 	goto BAIL;
 
-    status = _cairo_scaled_font_subsets_foreach_unscaled (surface->font_subsets,
-                                                          _cairo_pdf_surface_emit_unscaled_font_subset,
-                                                          surface);
+    status = _cairo_scaled_font_subsets_foreach_unscaled_parallel (surface->font_subsets,
+								   _cairo_pdf_surface_prepare_unscaled_font_subset,
+								   _cairo_pdf_surface_emit_unscaled_font_subset,
+								   _cairo_pdf_prepared_font_subset_destroy,
+								   surface);
     if (unlikely (status))
 	goto BAIL;
 
@@ -85,6 +85,14 @@ cairo_pdf_surface_set_size (cairo_surface_t	*surface,
 			    double		 width_in_points,
 			    double		 height_in_points);
 
+cairo_public void
+cairo_pdf_surface_set_deduplicate_sources (cairo_surface_t	*surface,
+					   cairo_bool_t		 deduplicate);
+
+cairo_public void
+cairo_pdf_surface_set_streaming (cairo_surface_t	*surface,
+				 int			 pages_per_chunk);
+
 CAIRO_END_DECLS
 
 #else  /* CAIRO_HAS_PDF_SURFACE */
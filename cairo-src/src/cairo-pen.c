@@ -40,6 +40,7 @@
 
 #include "cairo-error-private.h"
 #include "cairo-slope-private.h"
+#include "cairo-thread-cache-private.h"
 
 static int
 _cairo_pen_vertices_needed (double tolerance,
@@ -49,12 +50,158 @@ _cairo_pen_vertices_needed (double tolerance,
 static void
 _cairo_pen_compute_slopes (cairo_pen_t *pen);
 
+/* We maintain a small cache of the most recently computed pens, as
+ * strokes tend to come in runs with the same line width, transformation
+ * and tolerance, and deriving the polygonal approximation of the pen
+ * (and the slopes between its vertices) is comparatively expensive.
+ * The cache is kept per thread, see cairo-thread-cache-private.h. */
+#define MAX_PEN_CACHE_SIZE 8
+typedef struct _cairo_pen_cache_set {
+    struct _cairo_pen_cache {
+	double radius;
+	double tolerance;
+	double xx, yx, xy, yy;
+	int num_vertices;
+	cairo_pen_vertex_t *vertices;
+    } cache[MAX_PEN_CACHE_SIZE];
+    int size;
+    int last;
+    int next;
+} cairo_pen_cache_set_t;
+
+static void
+_cairo_pen_cache_set_fini (void *closure)
+{
+    cairo_pen_cache_set_t *set = closure;
+
+    while (set->size)
+	free (set->cache[--set->size].vertices);
+}
+
+static cairo_thread_cache_t pen_cache =
+    CAIRO_THREAD_CACHE_INIT (CAIRO_THREAD_CACHE_PEN,
+			     cairo_pen_cache_set_t,
+			     NULL, _cairo_pen_cache_set_fini,
+			     _cairo_pen_cache_mutex);
+
+static cairo_bool_t
+_cairo_pen_cache_matches (const struct _cairo_pen_cache *cache,
+			  double radius,
+			  double tolerance,
+			  const cairo_matrix_t *ctm)
+{
+    /* Only the linear part of the matrix affects the pen shape. */
+    return cache->radius == radius &&
+	   cache->tolerance == tolerance &&
+	   cache->xx == ctm->xx && cache->yx == ctm->yx &&
+	   cache->xy == ctm->xy && cache->yy == ctm->yy;
+}
+
+static cairo_int_status_t
+_cairo_pen_init_from_cache (cairo_pen_t *pen, const cairo_matrix_t *ctm)
+{
+    cairo_pen_cache_set_t *set;
+    cairo_int_status_t status = CAIRO_INT_STATUS_UNSUPPORTED;
+    int i;
+
+    set = _cairo_thread_cache_get (&pen_cache);
+    if (unlikely (set == NULL))
+	return CAIRO_INT_STATUS_UNSUPPORTED;
+
+    i = set->last;
+    if (i >= set->size ||
+	! _cairo_pen_cache_matches (&set->cache[i],
+				    pen->radius, pen->tolerance, ctm))
+    {
+	for (i = 0; i < set->size; i++) {
+	    if (_cairo_pen_cache_matches (&set->cache[i],
+					  pen->radius, pen->tolerance, ctm))
+	    {
+		break;
+	    }
+	}
+	if (i == set->size)
+	    goto UNLOCK;
+    }
+
+    pen->num_vertices = set->cache[i].num_vertices;
+    if (pen->num_vertices > ARRAY_LENGTH (pen->vertices_embedded)) {
+	pen->vertices = _cairo_malloc_ab (pen->num_vertices,
+					  sizeof (cairo_pen_vertex_t));
+	if (unlikely (pen->vertices == NULL)) {
+	    status = _cairo_error (CAIRO_STATUS_NO_MEMORY);
+	    goto UNLOCK;
+	}
+    } else {
+	pen->vertices = pen->vertices_embedded;
+    }
+
+    memcpy (pen->vertices, set->cache[i].vertices,
+	    pen->num_vertices * sizeof (cairo_pen_vertex_t));
+    set->last = i;
+    status = CAIRO_STATUS_SUCCESS;
+
+UNLOCK:
+    _cairo_thread_cache_put (&pen_cache, set);
+    return status;
+}
+
+static void
+_cairo_pen_cache_add (const cairo_pen_t *pen, const cairo_matrix_t *ctm)
+{
+    cairo_pen_cache_set_t *set;
+    cairo_pen_vertex_t *vertices, *to_free;
+    struct _cairo_pen_cache *cache;
+    int i;
+
+    /* Failing to cache the pen is not an error, we just recompute it
+     * the next time around. */
+    vertices = _cairo_malloc_ab (pen->num_vertices,
+				 sizeof (cairo_pen_vertex_t));
+    if (unlikely (vertices == NULL))
+	return;
+
+    memcpy (vertices, pen->vertices,
+	    pen->num_vertices * sizeof (cairo_pen_vertex_t));
+
+    set = _cairo_thread_cache_get (&pen_cache);
+    if (unlikely (set == NULL)) {
+	free (vertices);
+	return;
+    }
+
+    /* Evict the oldest entry once the cache is full. */
+    to_free = NULL;
+    if (set->size == MAX_PEN_CACHE_SIZE) {
+	i = set->next;
+	set->next = (i + 1) % MAX_PEN_CACHE_SIZE;
+	to_free = set->cache[i].vertices;
+    } else {
+	i = set->size++;
+    }
+
+    cache = &set->cache[i];
+
+    cache->radius = pen->radius;
+    cache->tolerance = pen->tolerance;
+    cache->xx = ctm->xx; cache->yx = ctm->yx;
+    cache->xy = ctm->xy; cache->yy = ctm->yy;
+    cache->num_vertices = pen->num_vertices;
+    cache->vertices = vertices;
+    set->last = i;
+
+    _cairo_thread_cache_put (&pen_cache, set);
+
+    free (to_free);
+}
+
 cairo_status_t
 _cairo_pen_init (cairo_pen_t	*pen,
 		 double		 radius,
 		 double		 tolerance,
 		 const cairo_matrix_t	*ctm)
 {
+    cairo_int_status_t status;
     int i;
     int reflect;
 
@@ -66,6 +213,10 @@ _cairo_pen_init (cairo_pen_t	*pen,
     pen->radius = radius;
     pen->tolerance = tolerance;
 
+    status = _cairo_pen_init_from_cache (pen, ctm);
+    if (status != CAIRO_INT_STATUS_UNSUPPORTED)
+	return status;
+
     reflect = _cairo_matrix_compute_determinant (ctm) < 0.;
 
     pen->num_vertices = _cairo_pen_vertices_needed (tolerance,
@@ -99,6 +250,8 @@ _cairo_pen_init (cairo_pen_t	*pen,
 
     _cairo_pen_compute_slopes (pen);
 
+    _cairo_pen_cache_add (pen, ctm);
+
     return CAIRO_STATUS_SUCCESS;
 }
 
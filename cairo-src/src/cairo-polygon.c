@@ -54,6 +54,7 @@ _cairo_polygon_init (cairo_polygon_t *polygon)
     polygon->has_current_point = FALSE;
     polygon->has_current_edge = FALSE;
     polygon->num_limits = 0;
+    polygon->is_band = FALSE;
 
     polygon->extents.p1.x = polygon->extents.p1.y = INT32_MAX;
     polygon->extents.p2.x = polygon->extents.p2.y = INT32_MIN;
@@ -213,10 +214,10 @@ _add_clipped_edge (cairo_polygon_t *polygon,
 	else if (p1->x <= limits->p1.x && p2->x <= limits->p1.x)
 	{
 	    p[0].x = limits->p1.x;
-	    p[0].y = limits->p1.y;
+	    p[0].y = polygon->is_band ? top : limits->p1.y;
 	    top_y = top;
-	    if (top_y < p[0].y)
-		top_y = p[0].y;
+	    if (top_y < limits->p1.y)
+		top_y = limits->p1.y;
 
 	    p[1].x = limits->p1.x;
 	    p[1].y = limits->p2.y;
@@ -229,10 +230,10 @@ _add_clipped_edge (cairo_polygon_t *polygon,
 	else if (p1->x >= limits->p2.x && p2->x >= limits->p2.x)
 	{
 	    p[0].x = limits->p2.x;
-	    p[0].y = limits->p1.y;
+	    p[0].y = polygon->is_band ? top : limits->p1.y;
 	    top_y = top;
-	    if (top_y < p[0].y)
-		top_y = p[0].y;
+	    if (top_y < limits->p1.y)
+		top_y = limits->p1.y;
 
 	    p[1].x = limits->p2.x;
 	    p[1].y = limits->p2.y;
@@ -261,10 +262,10 @@ _add_clipped_edge (cairo_polygon_t *polygon,
 	    if (left_y < right_y) {
 		if (p1->x < limits->p1.x && left_y > limits->p1.y) {
 		    p[0].x = limits->p1.x;
-		    p[0].y = limits->p1.y;
+		    p[0].y = polygon->is_band ? p1_y : limits->p1.y;
 		    top_y = p1_y;
-		    if (top_y < p[0].y)
-			top_y = p[0].y;
+		    if (top_y < limits->p1.y)
+			top_y = limits->p1.y;
 
 		    p[1].x = limits->p1.x;
 		    p[1].y = limits->p2.y;
@@ -279,10 +280,10 @@ _add_clipped_edge (cairo_polygon_t *polygon,
 
 		if (p2->x > limits->p2.x && right_y < limits->p2.y) {
 		    p[0].x = limits->p2.x;
-		    p[0].y = limits->p1.y;
+		    p[0].y = polygon->is_band ? right_y : limits->p1.y;
 		    top_y = right_y;
-		    if (top_y < p[0].y)
-			top_y = p[0].y;
+		    if (top_y < limits->p1.y)
+			top_y = limits->p1.y;
 
 		    p[1].x = limits->p2.x;
 		    p[1].y = limits->p2.y;
@@ -297,10 +298,10 @@ _add_clipped_edge (cairo_polygon_t *polygon,
 	    } else {
 		if (p1->x > limits->p2.x && right_y > limits->p1.y) {
 		    p[0].x = limits->p2.x;
-		    p[0].y = limits->p1.y;
+		    p[0].y = polygon->is_band ? p1_y : limits->p1.y;
 		    top_y = p1_y;
-		    if (top_y < p[0].y)
-			top_y = p[0].y;
+		    if (top_y < limits->p1.y)
+			top_y = limits->p1.y;
 
 		    p[1].x = limits->p2.x;
 		    p[1].y = limits->p2.y;
@@ -315,10 +316,10 @@ _add_clipped_edge (cairo_polygon_t *polygon,
 
 		if (p2->x < limits->p1.x && left_y < limits->p2.y) {
 		    p[0].x = limits->p1.x;
-		    p[0].y = limits->p1.y;
+		    p[0].y = polygon->is_band ? left_y : limits->p1.y;
 		    top_y = left_y;
-		    if (top_y < p[0].y)
-			top_y = p[0].y;
+		    if (top_y < limits->p1.y)
+			top_y = limits->p1.y;
 
 		    p[1].x = limits->p1.x;
 		    p[1].y = limits->p2.y;
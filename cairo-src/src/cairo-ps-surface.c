@@ -328,89 +328,37 @@ _cairo_ps_surface_emit_header (cairo_ps_surface_t *surface)
     }
 }
 
-#if CAIRO_HAS_FT_FONT
 static cairo_status_t
-_cairo_ps_surface_emit_type1_font_subset (cairo_ps_surface_t		*surface,
-					  cairo_scaled_font_subset_t	*font_subset)
-
-
+_cairo_ps_surface_emit_type1_font (cairo_ps_surface_t		*surface,
+				   cairo_type1_subset_t		*subset)
 {
-    cairo_type1_subset_t subset;
-    cairo_status_t status;
     int length;
-    char name[64];
-
-    snprintf (name, sizeof name, "f-%d-%d",
-	      font_subset->font_id, font_subset->subset_id);
-    status = _cairo_type1_subset_init (&subset, name, font_subset, TRUE);
-    if (unlikely (status))
-	return status;
 
     /* FIXME: Figure out document structure convention for fonts */
 
 #if DEBUG_PS
     _cairo_output_stream_printf (surface->final_stream,
-				 "%% _cairo_ps_surface_emit_type1_font_subset\n");
+				 "%% _cairo_ps_surface_emit_type1_font\n");
 #endif
 
-    length = subset.header_length + subset.data_length + subset.trailer_length;
-    _cairo_output_stream_write (surface->final_stream, subset.data, length);
-
-    _cairo_type1_subset_fini (&subset);
+    length = subset->header_length + subset->data_length + subset->trailer_length;
+    _cairo_output_stream_write (surface->final_stream, subset->data, length);
 
     return CAIRO_STATUS_SUCCESS;
 }
-#endif
 
 static cairo_status_t
-_cairo_ps_surface_emit_type1_font_fallback (cairo_ps_surface_t		*surface,
-                                            cairo_scaled_font_subset_t	*font_subset)
+_cairo_ps_surface_emit_truetype_font (cairo_ps_surface_t		*surface,
+				      cairo_scaled_font_subset_t	*font_subset,
+				      cairo_truetype_subset_t		*subset)
 {
-    cairo_type1_subset_t subset;
-    cairo_status_t status;
-    int length;
-    char name[64];
-
-    snprintf (name, sizeof name, "f-%d-%d",
-	      font_subset->font_id, font_subset->subset_id);
-    status = _cairo_type1_fallback_init_hex (&subset, name, font_subset);
-    if (unlikely (status))
-	return status;
-
-    /* FIXME: Figure out document structure convention for fonts */
-
-#if DEBUG_PS
-    _cairo_output_stream_printf (surface->final_stream,
-				 "%% _cairo_ps_surface_emit_type1_font_fallback\n");
-#endif
-
-    length = subset.header_length + subset.data_length + subset.trailer_length;
-    _cairo_output_stream_write (surface->final_stream, subset.data, length);
-
-    _cairo_type1_fallback_fini (&subset);
-
-    return CAIRO_STATUS_SUCCESS;
-}
-
-static cairo_status_t
-_cairo_ps_surface_emit_truetype_font_subset (cairo_ps_surface_t		*surface,
-					     cairo_scaled_font_subset_t	*font_subset)
-
-
-{
-    cairo_truetype_subset_t subset;
-    cairo_status_t status;
     unsigned int i, begin, end;
 
-    status = _cairo_truetype_subset_init (&subset, font_subset);
-    if (unlikely (status))
-	return status;
-
     /* FIXME: Figure out document structure convention for fonts */
 
 #if DEBUG_PS
     _cairo_output_stream_printf (surface->final_stream,
-				 "%% _cairo_ps_surface_emit_truetype_font_subset\n");
+				 "%% _cairo_ps_surface_emit_truetype_font\n");
 #endif
 
     _cairo_output_stream_printf (surface->final_stream,
@@ -422,7 +370,7 @@ _cairo_ps_surface_emit_truetype_font_subset (cairo_ps_surface_t		*surface,
 				 "/FontBBox [ 0 0 0 0 ] def\n"
 				 "/Encoding 256 array def\n"
 				 "0 1 255 { Encoding exch /.notdef put } for\n",
-				 subset.ps_name);
+				 subset->ps_name);
 
     /* FIXME: Figure out how subset->x_max etc maps to the /FontBBox */
 
@@ -460,18 +408,18 @@ _cairo_ps_surface_emit_truetype_font_subset (cairo_ps_surface_t		*surface,
 				 "/sfnts [\n");
     begin = 0;
     end = 0;
-    for (i = 0; i < subset.num_string_offsets; i++) {
-        end = subset.string_offsets[i];
+    for (i = 0; i < subset->num_string_offsets; i++) {
+        end = subset->string_offsets[i];
         _cairo_output_stream_printf (surface->final_stream,"<");
         _cairo_output_stream_write_hex_string (surface->final_stream,
-                                               subset.data + begin, end - begin);
+                                               subset->data + begin, end - begin);
         _cairo_output_stream_printf (surface->final_stream,"00>\n");
         begin = end;
     }
-    if (subset.data_length > end) {
+    if (subset->data_length > end) {
         _cairo_output_stream_printf (surface->final_stream,"<");
         _cairo_output_stream_write_hex_string (surface->final_stream,
-                                               subset.data + end, subset.data_length - end);
+                                               subset->data + end, subset->data_length - end);
         _cairo_output_stream_printf (surface->final_stream,"00>\n");
     }
 
@@ -481,8 +429,6 @@ _cairo_ps_surface_emit_truetype_font_subset (cairo_ps_surface_t		*surface,
 				 font_subset->font_id,
 				 font_subset->subset_id);
 
-    _cairo_truetype_subset_fini (&subset);
-
     return CAIRO_STATUS_SUCCESS;
 }
 
@@ -660,36 +606,116 @@ _cairo_ps_surface_emit_type3_font_subset (cairo_ps_surface_t		*surface,
     return CAIRO_STATUS_SUCCESS;
 }
 
+typedef enum _cairo_ps_font_subset_type {
+    CAIRO_PS_FONT_SUBSET_TYPE1,
+    CAIRO_PS_FONT_SUBSET_TRUETYPE,
+    CAIRO_PS_FONT_SUBSET_TYPE1_FALLBACK
+} cairo_ps_font_subset_type_t;
+
+typedef struct _cairo_ps_prepared_font_subset {
+    cairo_ps_font_subset_type_t type;
+    union {
+	cairo_truetype_subset_t truetype;
+	cairo_type1_subset_t type1;
+    } u;
+} cairo_ps_prepared_font_subset_t;
+
+/* Generates the font program for the subset. This may be called from
+ * another thread, and so must not touch the surface. */
 static cairo_status_t
-_cairo_ps_surface_emit_unscaled_font_subset (cairo_scaled_font_subset_t	*font_subset,
-				            void			*closure)
+_cairo_ps_surface_prepare_unscaled_font_subset (cairo_scaled_font_subset_t  *font_subset,
+						void			    *closure,
+						void			   **prepared)
 {
-    cairo_ps_surface_t *surface = closure;
+    cairo_ps_prepared_font_subset_t *font;
     cairo_status_t status;
-
+    char name[64];
 
     status = _cairo_scaled_font_subset_create_glyph_names (font_subset);
     if (_cairo_status_is_error (status))
 	return status;
 
+    font = malloc (sizeof (cairo_ps_prepared_font_subset_t));
+    if (unlikely (font == NULL))
+	return _cairo_error (CAIRO_STATUS_NO_MEMORY);
+
+    snprintf (name, sizeof name, "f-%d-%d",
+	      font_subset->font_id, font_subset->subset_id);
+
+    status = CAIRO_INT_STATUS_UNSUPPORTED;
 #if CAIRO_HAS_FT_FONT
-    status = _cairo_ps_surface_emit_type1_font_subset (surface, font_subset);
-    if (status != CAIRO_INT_STATUS_UNSUPPORTED)
-	return status;
+    font->type = CAIRO_PS_FONT_SUBSET_TYPE1;
+    status = _cairo_type1_subset_init (&font->u.type1, name, font_subset, TRUE);
 #endif
 
-    status = _cairo_ps_surface_emit_truetype_font_subset (surface, font_subset);
-    if (status != CAIRO_INT_STATUS_UNSUPPORTED)
-	return status;
+    if (status == CAIRO_INT_STATUS_UNSUPPORTED) {
+	font->type = CAIRO_PS_FONT_SUBSET_TRUETYPE;
+	status = _cairo_truetype_subset_init (&font->u.truetype, font_subset);
+    }
 
-    status = _cairo_ps_surface_emit_type1_font_fallback (surface, font_subset);
-    if (status != CAIRO_INT_STATUS_UNSUPPORTED)
+    if (status == CAIRO_INT_STATUS_UNSUPPORTED) {
+	font->type = CAIRO_PS_FONT_SUBSET_TYPE1_FALLBACK;
+	status = _cairo_type1_fallback_init_hex (&font->u.type1, name, font_subset);
+    }
+
+    assert (status != CAIRO_INT_STATUS_UNSUPPORTED);
+    if (unlikely (status)) {
+	free (font);
 	return status;
+    }
+
+    *prepared = font;
+    return CAIRO_STATUS_SUCCESS;
+}
+
+static cairo_status_t
+_cairo_ps_surface_emit_unscaled_font_subset (cairo_scaled_font_subset_t	*font_subset,
+					     void			*prepared,
+					     void			*closure)
+{
+    cairo_ps_surface_t *surface = closure;
+    cairo_ps_prepared_font_subset_t *font = prepared;
+
+    switch (font->type) {
+    case CAIRO_PS_FONT_SUBSET_TYPE1:
+    case CAIRO_PS_FONT_SUBSET_TYPE1_FALLBACK:
+	return _cairo_ps_surface_emit_type1_font (surface, &font->u.type1);
+
+    case CAIRO_PS_FONT_SUBSET_TRUETYPE:
+	return _cairo_ps_surface_emit_truetype_font (surface, font_subset, &font->u.truetype);
+    }
 
     ASSERT_NOT_REACHED;
     return CAIRO_STATUS_SUCCESS;
 }
 
+static void
+_cairo_ps_prepared_font_subset_destroy (void *abstract_font)
+{
+    cairo_ps_prepared_font_subset_t *font = abstract_font;
+
+    switch (font->type) {
+    case CAIRO_PS_FONT_SUBSET_TYPE1:
+#if CAIRO_HAS_FT_FONT
+	_cairo_type1_subset_fini (&font->u.type1);
+#else
+	/* only prepared when the type1 subsetter is available */
+	ASSERT_NOT_REACHED;
+#endif
+	break;
+    case CAIRO_PS_FONT_SUBSET_TRUETYPE:
+	_cairo_truetype_subset_fini (&font->u.truetype);
+	break;
+    case CAIRO_PS_FONT_SUBSET_TYPE1_FALLBACK:
+	_cairo_type1_fallback_fini (&font->u.type1);
+	break;
+    default:
+	ASSERT_NOT_REACHED;
+    }
+
+    free (font);
+}
+
 static cairo_status_t
 _cairo_ps_surface_emit_scaled_font_subset (cairo_scaled_font_subset_t *font_subset,
                                            void			      *closure)
@@ -725,9 +751,11 @@ _cairo_ps_surface_emit_font_subsets (cairo_ps_surface_t *surface)
     if (unlikely (status))
 	return status;
 
-    status = _cairo_scaled_font_subsets_foreach_unscaled (surface->font_subsets,
-                                                          _cairo_ps_surface_emit_unscaled_font_subset,
-                                                          surface);
+    status = _cairo_scaled_font_subsets_foreach_unscaled_parallel (surface->font_subsets,
+								   _cairo_ps_surface_prepare_unscaled_font_subset,
+								   _cairo_ps_surface_emit_unscaled_font_subset,
+								   _cairo_ps_prepared_font_subset_destroy,
+								   surface);
     if (unlikely (status))
 	return status;
 
@@ -1845,6 +1873,40 @@ typedef struct _string_array_stream {
     cairo_bool_t use_strings;
 } string_array_stream_t;
 
+/* Returns the number of leading bytes of data that need no escaping
+ * and fit on the current line and string, so that they can be copied
+ * through with a single write. */
+static unsigned int
+_string_array_stream_run_length (string_array_stream_t *stream,
+				 const unsigned char   *data,
+				 unsigned int		length)
+{
+    unsigned int run;
+    int max;
+
+    max = STRING_ARRAY_MAX_COLUMN - stream->column;
+    if (stream->use_strings)
+	max = MIN (max, STRING_ARRAY_MAX_STRING_SIZE - stream->string_size);
+    if (max <= 0)
+	return 0;
+
+    length = MIN (length, (unsigned int) max);
+    for (run = 0; run < length; run++) {
+	switch (data[run]) {
+	case '~':
+	    return run;
+	case '\\':
+	case '(':
+	case ')':
+	    if (stream->use_strings)
+		return run;
+	    break;
+	}
+    }
+
+    return run;
+}
+
 static cairo_status_t
 _string_array_stream_write (cairo_output_stream_t *base,
 			    const unsigned char   *data,
@@ -1852,43 +1914,55 @@ _string_array_stream_write (cairo_output_stream_t *base,
 {
     string_array_stream_t *stream = (string_array_stream_t *) base;
     unsigned char c;
+    unsigned int run;
     const unsigned char backslash = '\\';
 
     if (length == 0)
 	return CAIRO_STATUS_SUCCESS;
 
-    while (length--) {
+    while (length) {
 	if (stream->string_size == 0 && stream->use_strings) {
 	    _cairo_output_stream_printf (stream->output, "(");
 	    stream->column++;
 	}
 
-	c = *data++;
-	if (stream->use_strings) {
-	    switch (c) {
-	    case '\\':
-	    case '(':
-	    case ')':
-		_cairo_output_stream_write (stream->output, &backslash, 1);
+	run = _string_array_stream_run_length (stream, data, length);
+	if (run) {
+	    _cairo_output_stream_write (stream->output, data, run);
+	    stream->column += run;
+	    stream->string_size += run;
+	    data += run;
+	    length -= run;
+	} else {
+	    c = *data++;
+	    length--;
+	    if (stream->use_strings) {
+		switch (c) {
+		case '\\':
+		case '(':
+		case ')':
+		    _cairo_output_stream_write (stream->output, &backslash, 1);
+		    stream->column++;
+		    stream->string_size++;
+		    break;
+		}
+	    }
+	    /* Have to be careful to never split the final ~> sequence. */
+	    if (c == '~') {
+		_cairo_output_stream_write (stream->output, &c, 1);
 		stream->column++;
 		stream->string_size++;
-		break;
+
+		if (length == 0)
+		    break;
+
+		c = *data++;
+		length--;
 	    }
-	}
-	/* Have to be careful to never split the final ~> sequence. */
-        if (c == '~') {
 	    _cairo_output_stream_write (stream->output, &c, 1);
 	    stream->column++;
 	    stream->string_size++;
-
-	    if (length-- == 0)
-		break;
-
-	    c = *data++;
 	}
-	_cairo_output_stream_write (stream->output, &c, 1);
-	stream->column++;
-	stream->string_size++;
 
 	if (stream->use_strings &&
 	    stream->string_size >= STRING_ARRAY_MAX_STRING_SIZE)
@@ -2067,6 +2141,85 @@ _cairo_ps_surface_emit_base85_string (cairo_ps_surface_t    *surface,
     return status;
 }
 
+/* Emit the samples of image for the image operator, compressed and
+ * base85-encoded.  The image data is 3 bytes per pixel RGB format.
+ *
+ * With use_mask the mask is interleaved by row as for Type 2 (mask
+ * and image interleaved): the mask row is first, one bit per pixel
+ * with (bit 7 first), padded to byte boundaries.
+ *
+ * The rows are converted one at a time and fed straight into the
+ * compressor, so the uncompressed samples are never held in full.
+ */
+static cairo_status_t
+_cairo_ps_surface_emit_image_data (cairo_ps_surface_t    *surface,
+				   cairo_image_surface_t *image,
+				   cairo_bool_t		  use_mask,
+				   cairo_bool_t		  use_flate,
+				   cairo_bool_t		  use_strings)
+{
+    cairo_output_stream_t *string_array_stream, *base85_stream, *compress_stream;
+    cairo_status_t status, status2;
+    unsigned char *row, *dst;
+    const uint32_t *pixel;
+    int row_size, mask_size, x, y;
+
+    mask_size = use_mask ? (image->width + 7) / 8 : 0;
+    row_size = mask_size + 3 * image->width;
+    row = _cairo_malloc_ab (row_size, 1);
+    if (unlikely (row == NULL))
+	return _cairo_error (CAIRO_STATUS_NO_MEMORY);
+
+    if (use_strings)
+	string_array_stream = _string_array_stream_create (surface->stream);
+    else
+	string_array_stream = _base85_array_stream_create (surface->stream);
+
+    base85_stream = _cairo_base85_stream_create (string_array_stream);
+    if (use_flate)
+	compress_stream = _cairo_deflate_stream_create (base85_stream);
+    else
+	compress_stream = _cairo_lzw_stream_create (base85_stream);
+
+    for (y = 0; y < image->height; y++) {
+	pixel = (const uint32_t *) (image->data + y * image->stride);
+	dst = row;
+
+	if (use_mask) {
+	    memset (dst, 0, mask_size);
+	    for (x = 0; x < image->width; x++) {
+		if ((pixel[x] >> 24) > 0x80)
+		    dst[x >> 3] |= 0x80 >> (x & 7);
+	    }
+	    dst += mask_size;
+	}
+
+	for (x = 0; x < image->width; x++) {
+	    dst[0] = pixel[x] >> 16;
+	    dst[1] = pixel[x] >> 8;
+	    dst[2] = pixel[x];
+	    dst += 3;
+	}
+
+	_cairo_output_stream_write (compress_stream, row, row_size);
+    }
+
+    free (row);
+
+    status = _cairo_output_stream_destroy (compress_stream);
+    status2 = _cairo_output_stream_destroy (base85_stream);
+    if (status == CAIRO_STATUS_SUCCESS)
+	status = status2;
+
+    /* Mark end of base85 data */
+    _cairo_output_stream_printf (string_array_stream, "~>");
+    status2 = _cairo_output_stream_destroy (string_array_stream);
+    if (status == CAIRO_STATUS_SUCCESS)
+	status = status2;
+
+    return status;
+}
+
 static cairo_status_t
 _cairo_ps_surface_emit_image (cairo_ps_surface_t    *surface,
 			      cairo_image_surface_t *image,
@@ -2074,15 +2227,10 @@ _cairo_ps_surface_emit_image (cairo_ps_surface_t    *surface,
 			      cairo_filter_t         filter)
 {
     cairo_status_t status;
-    unsigned char *data, *data_compressed;
-    unsigned long data_size, data_compressed_size;
     cairo_image_surface_t *opaque_image = NULL;
-    int x, y, i;
     cairo_image_transparency_t transparency;
-    cairo_bool_t use_mask;
-    uint32_t *pixel;
-    int bit;
-    const char *interpolate;
+    cairo_bool_t use_mask, use_flate;
+    const char *interpolate, *decode_filter;
 
     if (image->base.status)
 	return image->base.status;
@@ -2090,6 +2238,7 @@ _cairo_ps_surface_emit_image (cairo_ps_surface_t    *surface,
     switch (filter) {
     default:
     case CAIRO_FILTER_GOOD:
+    case CAIRO_FILTER_MIPMAP:
     case CAIRO_FILTER_BEST:
     case CAIRO_FILTER_BILINEAR:
 	interpolate = "true";
@@ -2126,69 +2275,14 @@ _cairo_ps_surface_emit_image (cairo_ps_surface_t    *surface,
 	use_mask = TRUE;
     }
 
-    if (use_mask) {
-	/* Type 2 (mask and image interleaved) has the mask and image
-	 * samples interleaved by row.  The mask row is first, one bit
-	 * per pixel with (bit 7 first). The row is padded to byte
-	 * boundaries. The image data is 3 bytes per pixel RGB
-	 * format. */
-	data_size = image->height * ((image->width + 7)/8 + 3*image->width);
-    } else {
-	data_size = image->height * image->width * 3;
-    }
-    data = malloc (data_size);
-    if (unlikely (data == NULL)) {
-	status = _cairo_error (CAIRO_STATUS_NO_MEMORY);
-	goto bail1;
-    }
-
-    if (use_mask) {
-	i = 0;
-	for (y = 0; y < image->height; y++) {
-	    /* mask row */
-	    pixel = (uint32_t *) (image->data + y * image->stride);
-	    bit = 7;
-	    for (x = 0; x < image->width; x++, pixel++) {
-		if (bit == 7)
-		    data[i] = 0;
-		if (((*pixel & 0xff000000) >> 24) > 0x80)
-		    data[i] |= (1 << bit);
-		bit--;
-		if (bit < 0) {
-		    bit = 7;
-		    i++;
-		}
-	    }
-	    if (bit != 7)
-		i++;
-
-	    /* image row*/
-	    pixel = (uint32_t *) (image->data + y * image->stride);
-	    for (x = 0; x < image->width; x++, pixel++) {
-		data[i++] = (*pixel & 0x00ff0000) >> 16;
-		data[i++] = (*pixel & 0x0000ff00) >>  8;
-		data[i++] = (*pixel & 0x000000ff) >>  0;
-	    }
-	}
+    /* LanguageLevel 3 adds the FlateDecode filter, which compresses
+     * photographic images much better than LZW. */
+    use_flate = surface->ps_level == CAIRO_PS_LEVEL_3;
+    if (use_flate) {
+	surface->ps_level_used = CAIRO_PS_LEVEL_3;
+	decode_filter = "FlateDecode";
     } else {
-	i = 0;
-	for (y = 0; y < opaque_image->height; y++) {
-	    pixel = (uint32_t *) (opaque_image->data + y * opaque_image->stride);
-	    for (x = 0; x < opaque_image->width; x++, pixel++) {
-		data[i++] = (*pixel & 0x00ff0000) >> 16;
-		data[i++] = (*pixel & 0x0000ff00) >>  8;
-		data[i++] = (*pixel & 0x000000ff) >>  0;
-	    }
-	}
-    }
-
-    /* XXX: Should fix cairo-lzw to provide a stream-based interface
-     * instead. */
-    data_compressed_size = data_size;
-    data_compressed = _cairo_lzw_compress (data, &data_compressed_size);
-    if (unlikely (data_compressed == NULL)) {
-	status = _cairo_error (CAIRO_STATUS_NO_MEMORY);
-	goto bail2;
+	decode_filter = "LZWDecode";
     }
 
     if (surface->use_string_datasource) {
@@ -2197,12 +2291,13 @@ _cairo_ps_surface_emit_image (cairo_ps_surface_t    *surface,
 	_cairo_output_stream_printf (surface->stream,
 				     "/CairoImageData [\n");
 
-	status = _cairo_ps_surface_emit_base85_string (surface,
-						       data_compressed,
-						       data_compressed_size,
-						       TRUE);
+	status = _cairo_ps_surface_emit_image_data (surface,
+						    use_mask ? image : opaque_image,
+						    use_mask,
+						    use_flate,
+						    TRUE);
 	if (unlikely (status))
-	    goto bail3;
+	    goto bail;
 
 	_cairo_output_stream_printf (surface->stream,
 				     "] def\n");
@@ -2235,10 +2330,12 @@ _cairo_ps_surface_emit_image (cairo_ps_surface_t    *surface,
 					 "	/CairoImageDataIndex CairoImageDataIndex 1 add def\n"
 					 "	CairoImageDataIndex CairoImageData length 1 sub gt\n"
 					 "       { /CairoImageDataIndex 0 def } if\n"
-					 "    } /ASCII85Decode filter /LZWDecode filter def\n");
+					 "    } /ASCII85Decode filter /%s filter def\n",
+					 decode_filter);
 	} else {
 	    _cairo_output_stream_printf (surface->stream,
-					 "    /DataSource currentfile /ASCII85Decode filter /LZWDecode filter def\n");
+					 "    /DataSource currentfile /ASCII85Decode filter /%s filter def\n",
+					 decode_filter);
 	}
 
 	_cairo_output_stream_printf (surface->stream,
@@ -2279,10 +2376,12 @@ _cairo_ps_surface_emit_image (cairo_ps_surface_t    *surface,
 					 "    /CairoImageDataIndex CairoImageDataIndex 1 add def\n"
 					 "    CairoImageDataIndex CairoImageData length 1 sub gt\n"
 					 "     { /CairoImageDataIndex 0 def } if\n"
-					 "  } /ASCII85Decode filter /LZWDecode filter def\n");
+					 "  } /ASCII85Decode filter /%s filter def\n",
+					 decode_filter);
 	} else {
 	    _cairo_output_stream_printf (surface->stream,
-					 "  /DataSource currentfile /ASCII85Decode filter /LZWDecode filter def\n");
+					 "  /DataSource currentfile /ASCII85Decode filter /%s filter def\n",
+					 decode_filter);
 	}
 
 	_cairo_output_stream_printf (surface->stream,
@@ -2297,22 +2396,17 @@ _cairo_ps_surface_emit_image (cairo_ps_surface_t    *surface,
     if (!surface->use_string_datasource) {
 	/* Emit the image data as a base85-encoded string which will
 	 * be used as the data source for the image operator. */
-	status = _cairo_ps_surface_emit_base85_string (surface,
-						       data_compressed,
-						       data_compressed_size,
-						       FALSE);
+	status = _cairo_ps_surface_emit_image_data (surface,
+						    use_mask ? image : opaque_image,
+						    use_mask,
+						    use_flate,
+						    FALSE);
 	_cairo_output_stream_printf (surface->stream, "\n");
     } else {
 	status = CAIRO_STATUS_SUCCESS;
     }
 
-bail3:
-    free (data_compressed);
-
-bail2:
-    free (data);
-
-bail1:
+bail:
     if (!use_mask && opaque_image != image)
 	cairo_surface_destroy (&opaque_image->base);
 
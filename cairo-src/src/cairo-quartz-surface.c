@@ -570,6 +570,7 @@ _cairo_quartz_filter_to_quartz (cairo_filter_t filter)
 
 	case CAIRO_FILTER_BEST:
 	case CAIRO_FILTER_GOOD:
+	case CAIRO_FILTER_MIPMAP:
 	case CAIRO_FILTER_BILINEAR:
 	case CAIRO_FILTER_GAUSSIAN:
 	    return kCGInterpolationDefault;
@@ -2557,6 +2558,7 @@ _cairo_quartz_surface_show_glyphs_cg (void *abstract_surface,
 	    CGContextSetShouldAntialias (surface->cgContext, FALSE);
 	    break;
 	case CAIRO_ANTIALIAS_GRAY:
+	case CAIRO_ANTIALIAS_FAST:
 	    CGContextSetShouldAntialias (surface->cgContext, TRUE);
 	    CGContextSetShouldSmoothFonts (surface->cgContext, FALSE);
 	    break;
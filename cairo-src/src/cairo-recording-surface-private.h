@@ -60,25 +60,29 @@ typedef struct _cairo_command_header {
     cairo_command_type_t	 type;
     cairo_recording_region_type_t     region;
     cairo_operator_t		 op;
+    cairo_rectangle_int_t	 extents;
     cairo_clip_t		 clip;
 } cairo_command_header_t;
 
+/* The patterns, paths and stroke styles referenced by the commands
+ * are owned by the recording surface and may be shared between
+ * several commands. */
 typedef struct _cairo_command_paint {
     cairo_command_header_t       header;
-    cairo_pattern_union_t	 source;
+    cairo_pattern_t		*source;
 } cairo_command_paint_t;
 
 typedef struct _cairo_command_mask {
     cairo_command_header_t       header;
-    cairo_pattern_union_t	 source;
-    cairo_pattern_union_t	 mask;
+    cairo_pattern_t		*source;
+    cairo_pattern_t		*mask;
 } cairo_command_mask_t;
 
 typedef struct _cairo_command_stroke {
     cairo_command_header_t       header;
-    cairo_pattern_union_t	 source;
-    cairo_path_fixed_t		 path;
-    cairo_stroke_style_t	 style;
+    cairo_pattern_t		*source;
+    cairo_path_fixed_t		*path;
+    cairo_stroke_style_t	*style;
     cairo_matrix_t		 ctm;
     cairo_matrix_t		 ctm_inverse;
     double			 tolerance;
@@ -87,8 +91,8 @@ typedef struct _cairo_command_stroke {
 
 typedef struct _cairo_command_fill {
     cairo_command_header_t       header;
-    cairo_pattern_union_t	 source;
-    cairo_path_fixed_t		 path;
+    cairo_pattern_t		*source;
+    cairo_path_fixed_t		*path;
     cairo_fill_rule_t		 fill_rule;
     double			 tolerance;
     cairo_antialias_t		 antialias;
@@ -96,7 +100,7 @@ typedef struct _cairo_command_fill {
 
 typedef struct _cairo_command_show_text_glyphs {
     cairo_command_header_t       header;
-    cairo_pattern_union_t	 source;
+    cairo_pattern_t		*source;
     char			*utf8;
     int				 utf8_len;
     cairo_glyph_t		*glyphs;
@@ -117,6 +121,32 @@ typedef union _cairo_command {
     cairo_command_show_text_glyphs_t		show_text_glyphs;
 } cairo_command_t;
 
+/* A coarse grid over the extents of the recorded commands, so that
+ * replaying onto a small target only needs to visit the commands that
+ * touch it. Commands that cover a large part of the grid are kept
+ * separately rather than being added to every cell. */
+typedef struct _cairo_recording_index {
+    int num_indexed;
+
+    cairo_rectangle_int_t extents;
+    int cols, rows;
+    int cell_width, cell_height;
+    cairo_array_t *cells;
+
+    cairo_array_t large;
+} cairo_recording_index_t;
+
+/* The commands, and the paths, glyphs and strings they hold, are
+ * carved out of large blocks which are only released when the
+ * recording surface is finished. */
+typedef struct _cairo_recording_arena_block cairo_recording_arena_block_t;
+
+typedef struct _cairo_recording_arena {
+    cairo_recording_arena_block_t *blocks;
+    char *data;
+    size_t rem;
+} cairo_recording_arena_t;
+
 typedef struct _cairo_recording_surface {
     cairo_surface_t base;
 
@@ -132,6 +162,15 @@ typedef struct _cairo_recording_surface {
     cairo_clip_t clip;
 
     cairo_array_t commands;
+    cairo_recording_index_t index;
+
+    cairo_recording_arena_t arena;
+    cairo_array_t patterns;
+    cairo_array_t styles;
+    cairo_bool_t has_last_clip;
+    cairo_clip_t last_clip;
+    cairo_clip_t last_command_clip;
+    cairo_path_fixed_t *last_path;
 
     int replay_start_idx;
 } cairo_recording_surface_t;
@@ -146,6 +185,15 @@ cairo_private cairo_status_t
 _cairo_recording_surface_replay (cairo_surface_t *surface,
 				 cairo_surface_t *target);
 
+cairo_private cairo_status_t
+_cairo_recording_surface_replay_tiled (cairo_surface_t *surface,
+				       cairo_surface_t *target);
+
+cairo_private cairo_status_t
+_cairo_recording_surface_replay_multiple (cairo_surface_t  *surface,
+					  cairo_surface_t **targets,
+					  int		    num_targets);
+
 
 cairo_private cairo_status_t
 _cairo_recording_surface_replay_analyze_recording_pattern (cairo_surface_t *surface,
@@ -76,6 +76,7 @@
 #include "cairo-analysis-surface-private.h"
 #include "cairo-clip-private.h"
 #include "cairo-error-private.h"
+#include "cairo-parallel-private.h"
 #include "cairo-recording-surface-private.h"
 #include "cairo-surface-wrapper-private.h"
 
@@ -86,6 +87,287 @@ typedef enum {
 
 static const cairo_surface_backend_t cairo_recording_surface_backend;
 
+/* Below this many commands a linear scan of the command extents is
+ * cheaper than building and querying the index. */
+#define CAIRO_RECORDING_INDEX_MIN_COMMANDS 32
+#define CAIRO_RECORDING_INDEX_MAX_CELLS 64
+
+/* The height of the bands replayed by _cairo_recording_surface_replay_tiled(). */
+#define CAIRO_RECORDING_TILE_HEIGHT 64
+
+/* Allocations larger than a quarter of a block are given a block of
+ * their own. */
+#define CAIRO_RECORDING_ARENA_BLOCK_SIZE 65536
+#define CAIRO_RECORDING_ARENA_ALIGN 8
+
+/* How many of the most recently recorded patterns and stroke styles
+ * are searched for a duplicate before a new copy is made. */
+#define CAIRO_RECORDING_INTERN_WINDOW 8
+
+static void
+_cairo_recording_index_init (cairo_recording_index_t *index)
+{
+    index->num_indexed = 0;
+    index->cells = NULL;
+    index->cols = index->rows = 0;
+    _cairo_array_init (&index->large, sizeof (int));
+}
+
+static void
+_cairo_recording_index_fini (cairo_recording_index_t *index)
+{
+    int n;
+
+    if (index->cells != NULL) {
+	for (n = 0; n < index->cols * index->rows; n++)
+	    _cairo_array_fini (&index->cells[n]);
+	free (index->cells);
+    }
+
+    _cairo_array_fini (&index->large);
+}
+
+static cairo_bool_t
+_extents_is_unbounded (const cairo_rectangle_int_t *extents)
+{
+    return extents->x == CAIRO_RECT_INT_MIN ||
+	   extents->y == CAIRO_RECT_INT_MIN ||
+	   extents->x + extents->width  >= CAIRO_RECT_INT_MAX ||
+	   extents->y + extents->height >= CAIRO_RECT_INT_MAX;
+}
+
+static cairo_bool_t
+_cairo_recording_index_cell_range (const cairo_recording_index_t *index,
+				   const cairo_rectangle_int_t *extents,
+				   int *x1, int *y1, int *x2, int *y2)
+{
+    cairo_rectangle_int_t rect = *extents;
+
+    if (! _cairo_rectangle_intersect (&rect, &index->extents))
+	return FALSE;
+
+    *x1 = (rect.x - index->extents.x) / index->cell_width;
+    *y1 = (rect.y - index->extents.y) / index->cell_height;
+    *x2 = (rect.x + rect.width  - 1 - index->extents.x) / index->cell_width;
+    *y2 = (rect.y + rect.height - 1 - index->extents.y) / index->cell_height;
+    return TRUE;
+}
+
+static cairo_status_t
+_cairo_recording_index_build (cairo_recording_index_t *index,
+			      cairo_command_t **elements,
+			      int start, int num_elements)
+{
+    cairo_bool_t has_extents = FALSE;
+    int i, n, x, y, side;
+    cairo_status_t status;
+
+    _cairo_recording_index_fini (index);
+    _cairo_recording_index_init (index);
+
+    for (i = start; i < num_elements; i++) {
+	const cairo_rectangle_int_t *extents = &elements[i]->header.extents;
+
+	if (extents->width == 0 || extents->height == 0)
+	    continue;
+	if (_extents_is_unbounded (extents))
+	    continue;
+
+	if (! has_extents) {
+	    index->extents = *extents;
+	    has_extents = TRUE;
+	} else {
+	    int x2, y2;
+
+	    x2 = MAX (index->extents.x + index->extents.width,
+		      extents->x + extents->width);
+	    y2 = MAX (index->extents.y + index->extents.height,
+		      extents->y + extents->height);
+	    index->extents.x = MIN (index->extents.x, extents->x);
+	    index->extents.y = MIN (index->extents.y, extents->y);
+	    index->extents.width  = x2 - index->extents.x;
+	    index->extents.height = y2 - index->extents.y;
+	}
+    }
+
+    if (has_extents) {
+	side = sqrt (num_elements - start) / 2;
+	if (side < 1)
+	    side = 1;
+	if (side > CAIRO_RECORDING_INDEX_MAX_CELLS)
+	    side = CAIRO_RECORDING_INDEX_MAX_CELLS;
+
+	index->cols = MIN (side, index->extents.width);
+	index->rows = MIN (side, index->extents.height);
+	index->cell_width  = (index->extents.width  + index->cols - 1) / index->cols;
+	index->cell_height = (index->extents.height + index->rows - 1) / index->rows;
+
+	index->cells = _cairo_malloc_ab (index->rows * index->cols,
+					 sizeof (cairo_array_t));
+	if (unlikely (index->cells == NULL)) {
+	    index->cols = index->rows = 0;
+	    return _cairo_error (CAIRO_STATUS_NO_MEMORY);
+	}
+
+	for (n = 0; n < index->cols * index->rows; n++)
+	    _cairo_array_init (&index->cells[n], sizeof (int));
+    }
+
+    for (i = start; i < num_elements; i++) {
+	const cairo_rectangle_int_t *extents = &elements[i]->header.extents;
+	int x1, y1, x2, y2;
+
+	if (extents->width == 0 || extents->height == 0)
+	    continue;
+
+	if (! has_extents ||
+	    ! _cairo_recording_index_cell_range (index, extents,
+						 &x1, &y1, &x2, &y2) ||
+	    4 * (x2 - x1 + 1) * (y2 - y1 + 1) > index->cols * index->rows)
+	{
+	    status = _cairo_array_append (&index->large, &i);
+	    if (unlikely (status))
+		return status;
+
+	    continue;
+	}
+
+	for (y = y1; y <= y2; y++) {
+	    for (x = x1; x <= x2; x++) {
+		status = _cairo_array_append (&index->cells[y * index->cols + x],
+					      &i);
+		if (unlikely (status))
+		    return status;
+	    }
+	}
+    }
+
+    index->num_indexed = num_elements;
+    return CAIRO_STATUS_SUCCESS;
+}
+
+static int
+_int_cmp (const void *a, const void *b)
+{
+    return *(const int *) a - *(const int *) b;
+}
+
+/* Brings the spatial index up to date with the recorded commands. */
+static cairo_status_t
+_cairo_recording_surface_update_index (cairo_recording_surface_t *surface)
+{
+    cairo_recording_index_t *index = &surface->index;
+    int num_elements = surface->commands.num_elements;
+    cairo_status_t status;
+
+    if (num_elements - surface->replay_start_idx < CAIRO_RECORDING_INDEX_MIN_COMMANDS)
+	return CAIRO_STATUS_SUCCESS;
+
+    if (index->num_indexed == num_elements)
+	return CAIRO_STATUS_SUCCESS;
+
+    status = _cairo_recording_index_build (index,
+					   _cairo_array_index (&surface->commands, 0),
+					   surface->replay_start_idx,
+					   num_elements);
+    if (unlikely (status)) {
+	_cairo_recording_index_fini (index);
+	_cairo_recording_index_init (index);
+    }
+
+    return status;
+}
+
+/* Collects, in recording order, the indices of the commands which
+ * may touch @extents. */
+static cairo_status_t
+_cairo_recording_surface_get_visible_commands (cairo_recording_surface_t *surface,
+					       const cairo_rectangle_int_t *extents,
+					       cairo_array_t *visible)
+{
+    cairo_recording_index_t *index = &surface->index;
+    cairo_command_t **elements;
+    int num_elements, start;
+    int i, n, x, y, x1, y1, x2, y2;
+    int *indices, num_indices;
+    cairo_status_t status;
+
+    num_elements = surface->commands.num_elements;
+    elements = _cairo_array_index (&surface->commands, 0);
+    start = surface->replay_start_idx;
+
+    if (num_elements - start < CAIRO_RECORDING_INDEX_MIN_COMMANDS) {
+	for (i = start; i < num_elements; i++) {
+	    cairo_rectangle_int_t rect = elements[i]->header.extents;
+
+	    if (! _cairo_rectangle_intersect (&rect, extents))
+		continue;
+
+	    status = _cairo_array_append (visible, &i);
+	    if (unlikely (status))
+		return status;
+	}
+
+	return CAIRO_STATUS_SUCCESS;
+    }
+
+    status = _cairo_recording_surface_update_index (surface);
+    if (unlikely (status))
+	return status;
+
+    if (index->large.num_elements) {
+	status = _cairo_array_append_multiple (visible,
+					       _cairo_array_index (&index->large, 0),
+					       index->large.num_elements);
+	if (unlikely (status))
+	    return status;
+    }
+
+    if (index->cells != NULL &&
+	_cairo_recording_index_cell_range (index, extents, &x1, &y1, &x2, &y2))
+    {
+	for (y = y1; y <= y2; y++) {
+	    for (x = x1; x <= x2; x++) {
+		cairo_array_t *cell = &index->cells[y * index->cols + x];
+
+		if (cell->num_elements == 0)
+		    continue;
+
+		status = _cairo_array_append_multiple (visible,
+						       _cairo_array_index (cell, 0),
+						       cell->num_elements);
+		if (unlikely (status))
+		    return status;
+	    }
+	}
+    }
+
+    /* Merge the cells, dropping duplicates and the commands whose own
+     * extents miss the target. */
+    indices = _cairo_array_index (visible, 0);
+    num_indices = visible->num_elements;
+    if (num_indices == 0)
+	return CAIRO_STATUS_SUCCESS;
+
+    qsort (indices, num_indices, sizeof (int), _int_cmp);
+
+    for (i = n = 0; i < num_indices; i++) {
+	cairo_rectangle_int_t rect;
+
+	if (n && indices[n-1] == indices[i])
+	    continue;
+
+	rect = elements[indices[i]]->header.extents;
+	if (! _cairo_rectangle_intersect (&rect, extents))
+	    continue;
+
+	indices[n++] = indices[i];
+    }
+    _cairo_array_truncate (visible, n);
+
+    return CAIRO_STATUS_SUCCESS;
+}
+
 /* Currently all recording surfaces do have a size which should be passed
  * in as the maximum size of any target surface against which the
  * recording-surface will ever be replayed.
@@ -95,6 +377,243 @@ static const cairo_surface_backend_t cairo_recording_surface_backend;
  * according to the intended replay target).
  */
 
+struct _cairo_recording_arena_block {
+    cairo_recording_arena_block_t *next;
+};
+
+#define CAIRO_RECORDING_ARENA_HEADER \
+    ((sizeof (cairo_recording_arena_block_t) + CAIRO_RECORDING_ARENA_ALIGN - 1) & \
+     -CAIRO_RECORDING_ARENA_ALIGN)
+
+static void
+_cairo_recording_arena_init (cairo_recording_arena_t *arena)
+{
+    arena->blocks = NULL;
+    arena->data = NULL;
+    arena->rem = 0;
+}
+
+static void
+_cairo_recording_arena_fini (cairo_recording_arena_t *arena)
+{
+    while (arena->blocks != NULL) {
+	cairo_recording_arena_block_t *next = arena->blocks->next;
+
+	free (arena->blocks);
+	arena->blocks = next;
+    }
+}
+
+/* Memory allocated from the arena is only released, all at once, by
+ * _cairo_recording_arena_fini(). */
+static void *
+_cairo_recording_arena_alloc (cairo_recording_arena_t *arena,
+			      size_t size)
+{
+    cairo_recording_arena_block_t *block;
+    void *ptr;
+
+    if (size > (size_t) -1 - CAIRO_RECORDING_ARENA_HEADER - CAIRO_RECORDING_ARENA_ALIGN)
+	return NULL;
+
+    size = (size + CAIRO_RECORDING_ARENA_ALIGN - 1) & -CAIRO_RECORDING_ARENA_ALIGN;
+    if (size > arena->rem) {
+	if (size > CAIRO_RECORDING_ARENA_BLOCK_SIZE / 4) {
+	    block = malloc (CAIRO_RECORDING_ARENA_HEADER + size);
+	    if (unlikely (block == NULL))
+		return NULL;
+
+	    /* Keep filling the current block. */
+	    if (arena->blocks != NULL) {
+		block->next = arena->blocks->next;
+		arena->blocks->next = block;
+	    } else {
+		block->next = NULL;
+		arena->blocks = block;
+	    }
+
+	    return (char *) block + CAIRO_RECORDING_ARENA_HEADER;
+	}
+
+	block = malloc (CAIRO_RECORDING_ARENA_BLOCK_SIZE);
+	if (unlikely (block == NULL))
+	    return NULL;
+
+	block->next = arena->blocks;
+	arena->blocks = block;
+	arena->data = (char *) block + CAIRO_RECORDING_ARENA_HEADER;
+	arena->rem = CAIRO_RECORDING_ARENA_BLOCK_SIZE - CAIRO_RECORDING_ARENA_HEADER;
+    }
+
+    ptr = arena->data;
+    arena->data += size;
+    arena->rem -= size;
+
+    return ptr;
+}
+
+static void *
+_cairo_recording_arena_alloc_ab (cairo_recording_arena_t *arena,
+				 unsigned int n, unsigned int size)
+{
+    if (size != 0 && n >= INT32_MAX / size)
+	return NULL;
+
+    return _cairo_recording_arena_alloc (arena, n * size);
+}
+
+/* Snapshots @pattern, sharing the copy held by a recent command if
+ * there is an equal one. */
+static cairo_status_t
+_cairo_recording_surface_intern_pattern (cairo_recording_surface_t *surface,
+					 const cairo_pattern_t *pattern,
+					 cairo_pattern_t **interned)
+{
+    cairo_pattern_union_t snapshot;
+    cairo_pattern_t **patterns;
+    cairo_pattern_t *copy;
+    cairo_status_t status;
+    int i, num_patterns;
+
+    status = _cairo_pattern_init_snapshot (&snapshot.base, pattern);
+    if (unlikely (status))
+	return status;
+
+    num_patterns = surface->patterns.num_elements;
+    patterns = _cairo_array_index (&surface->patterns, 0);
+    for (i = num_patterns - 1;
+	 i >= 0 && i >= num_patterns - CAIRO_RECORDING_INTERN_WINDOW;
+	 i--)
+    {
+	if (_cairo_pattern_equal (patterns[i], &snapshot.base)) {
+	    _cairo_pattern_fini (&snapshot.base);
+	    *interned = patterns[i];
+	    return CAIRO_STATUS_SUCCESS;
+	}
+    }
+
+    /* The snapshot may point into itself (e.g. embedded gradient
+     * stops), so it is copied rather than moved into the arena. */
+    copy = _cairo_recording_arena_alloc (&surface->arena,
+					 sizeof (cairo_pattern_union_t));
+    if (unlikely (copy == NULL)) {
+	status = _cairo_error (CAIRO_STATUS_NO_MEMORY);
+	goto CLEANUP_SNAPSHOT;
+    }
+
+    status = _cairo_pattern_init_copy (copy, &snapshot.base);
+    if (unlikely (status))
+	goto CLEANUP_SNAPSHOT;
+
+    status = _cairo_array_append (&surface->patterns, &copy);
+    if (unlikely (status)) {
+	_cairo_pattern_fini (copy);
+	goto CLEANUP_SNAPSHOT;
+    }
+
+    *interned = copy;
+
+  CLEANUP_SNAPSHOT:
+    _cairo_pattern_fini (&snapshot.base);
+    return status;
+}
+
+static cairo_bool_t
+_stroke_style_equal (const cairo_stroke_style_t *a,
+		     const cairo_stroke_style_t *b)
+{
+    return a->line_width == b->line_width &&
+	   a->line_cap == b->line_cap &&
+	   a->line_join == b->line_join &&
+	   a->miter_limit == b->miter_limit &&
+	   a->num_dashes == b->num_dashes &&
+	   a->dash_offset == b->dash_offset &&
+	   memcmp (a->dash, b->dash, a->num_dashes * sizeof (double)) == 0;
+}
+
+static cairo_status_t
+_cairo_recording_surface_intern_stroke_style (cairo_recording_surface_t *surface,
+					      const cairo_stroke_style_t *style,
+					      cairo_stroke_style_t **interned)
+{
+    cairo_stroke_style_t **styles;
+    cairo_stroke_style_t *copy;
+    cairo_status_t status;
+    int i, num_styles;
+
+    num_styles = surface->styles.num_elements;
+    styles = _cairo_array_index (&surface->styles, 0);
+    for (i = num_styles - 1;
+	 i >= 0 && i >= num_styles - CAIRO_RECORDING_INTERN_WINDOW;
+	 i--)
+    {
+	if (_stroke_style_equal (styles[i], style)) {
+	    *interned = styles[i];
+	    return CAIRO_STATUS_SUCCESS;
+	}
+    }
+
+    copy = _cairo_recording_arena_alloc (&surface->arena,
+					 sizeof (cairo_stroke_style_t));
+    if (unlikely (copy == NULL))
+	return _cairo_error (CAIRO_STATUS_NO_MEMORY);
+
+    status = _cairo_stroke_style_init_copy (copy, style);
+    if (unlikely (status))
+	return status;
+
+    status = _cairo_array_append (&surface->styles, &copy);
+    if (unlikely (status)) {
+	_cairo_stroke_style_fini (copy);
+	return status;
+    }
+
+    *interned = copy;
+    return CAIRO_STATUS_SUCCESS;
+}
+
+/* Consecutive drawing commands usually operate on the same path, as
+ * in the fill_preserve() and stroke() idiom, in which case they
+ * share a single copy. */
+static cairo_status_t
+_cairo_recording_surface_copy_path (cairo_recording_surface_t *surface,
+				    const cairo_path_fixed_t *path,
+				    cairo_path_fixed_t **copy)
+{
+    void *storage;
+
+    if (surface->last_path != NULL &&
+	_cairo_path_fixed_is_equal (surface->last_path, path))
+    {
+	*copy = surface->last_path;
+	return CAIRO_STATUS_SUCCESS;
+    }
+
+    storage = _cairo_recording_arena_alloc (&surface->arena,
+					    _cairo_path_fixed_compact_size (path));
+    if (unlikely (storage == NULL))
+	return _cairo_error (CAIRO_STATUS_NO_MEMORY);
+
+    *copy = surface->last_path =
+	_cairo_path_fixed_init_compact_copy (storage, path);
+    return CAIRO_STATUS_SUCCESS;
+}
+
+static void
+_cairo_recording_surface_init_storage (cairo_recording_surface_t *surface)
+{
+    _cairo_array_init (&surface->commands, sizeof (cairo_command_t *));
+    _cairo_recording_index_init (&surface->index);
+
+    _cairo_recording_arena_init (&surface->arena);
+    _cairo_array_init (&surface->patterns, sizeof (cairo_pattern_t *));
+    _cairo_array_init (&surface->styles, sizeof (cairo_stroke_style_t *));
+    surface->has_last_clip = FALSE;
+    _cairo_clip_init (&surface->last_clip);
+    _cairo_clip_init (&surface->last_command_clip);
+    surface->last_path = NULL;
+}
+
 /**
  * cairo_recording_surface_create:
  * @content: the content of the recording surface
@@ -153,7 +672,7 @@ cairo_recording_surface_create (cairo_content_t		 content,
 	recording_surface->unbounded = FALSE;
     }
 
-    _cairo_array_init (&recording_surface->commands, sizeof (cairo_command_t *));
+    _cairo_recording_surface_init_storage (recording_surface);
 
     recording_surface->replay_start_idx = 0;
     recording_surface->base.is_clear = TRUE;
@@ -180,51 +699,40 @@ _cairo_recording_surface_finish (void *abstract_surface)
 {
     cairo_recording_surface_t *recording_surface = abstract_surface;
     cairo_command_t **elements;
+    cairo_pattern_t **patterns;
+    cairo_stroke_style_t **styles;
     int i, num_elements;
 
+    /* The commands themselves, their paths and their glyph and text
+     * arrays all live in the arena. */
     num_elements = recording_surface->commands.num_elements;
     elements = _cairo_array_index (&recording_surface->commands, 0);
     for (i = 0; i < num_elements; i++) {
 	cairo_command_t *command = elements[i];
 
-	switch (command->header.type) {
-	case CAIRO_COMMAND_PAINT:
-	    _cairo_pattern_fini (&command->paint.source.base);
-	    break;
-
-	case CAIRO_COMMAND_MASK:
-	    _cairo_pattern_fini (&command->mask.source.base);
-	    _cairo_pattern_fini (&command->mask.mask.base);
-	    break;
-
-	case CAIRO_COMMAND_STROKE:
-	    _cairo_pattern_fini (&command->stroke.source.base);
-	    _cairo_path_fixed_fini (&command->stroke.path);
-	    _cairo_stroke_style_fini (&command->stroke.style);
-	    break;
-
-	case CAIRO_COMMAND_FILL:
-	    _cairo_pattern_fini (&command->fill.source.base);
-	    _cairo_path_fixed_fini (&command->fill.path);
-	    break;
-
-	case CAIRO_COMMAND_SHOW_TEXT_GLYPHS:
-	    _cairo_pattern_fini (&command->show_text_glyphs.source.base);
-	    free (command->show_text_glyphs.utf8);
-	    free (command->show_text_glyphs.glyphs);
-	    free (command->show_text_glyphs.clusters);
+	if (command->header.type == CAIRO_COMMAND_SHOW_TEXT_GLYPHS)
 	    cairo_scaled_font_destroy (command->show_text_glyphs.scaled_font);
-	    break;
-
-	default:
-	    ASSERT_NOT_REACHED;
-	}
 
 	_cairo_clip_fini (&command->header.clip);
-	free (command);
     }
 
+    num_elements = recording_surface->patterns.num_elements;
+    patterns = _cairo_array_index (&recording_surface->patterns, 0);
+    for (i = 0; i < num_elements; i++)
+	_cairo_pattern_fini (patterns[i]);
+
+    num_elements = recording_surface->styles.num_elements;
+    styles = _cairo_array_index (&recording_surface->styles, 0);
+    for (i = 0; i < num_elements; i++)
+	_cairo_stroke_style_fini (styles[i]);
+
     _cairo_array_fini (&recording_surface->commands);
+    _cairo_array_fini (&recording_surface->patterns);
+    _cairo_array_fini (&recording_surface->styles);
+    _cairo_recording_arena_fini (&recording_surface->arena);
+    _cairo_recording_index_fini (&recording_surface->index);
+    _cairo_clip_fini (&recording_surface->last_clip);
+    _cairo_clip_fini (&recording_surface->last_command_clip);
     _cairo_clip_fini (&recording_surface->clip);
 
     return CAIRO_STATUS_SUCCESS;
@@ -278,6 +786,22 @@ _cairo_recording_surface_release_source_image (void			*abstract_surface,
     cairo_surface_destroy (&image->base);
 }
 
+static cairo_bool_t
+_clip_is_last (const cairo_recording_surface_t *recording_surface,
+	       const cairo_clip_t *clip)
+{
+    const cairo_clip_t *last = &recording_surface->last_clip;
+
+    if (! recording_surface->has_last_clip)
+	return FALSE;
+
+    if (clip == NULL)
+	return last->path == NULL && ! last->all_clipped;
+
+    /* Clip paths are immutable, so the same path is the same clip. */
+    return clip->path == last->path && clip->all_clipped == last->all_clipped;
+}
+
 static cairo_status_t
 _command_init (cairo_recording_surface_t *recording_surface,
 	       cairo_command_header_t *command,
@@ -290,13 +814,57 @@ _command_init (cairo_recording_surface_t *recording_surface,
     command->type = type;
     command->op = op;
     command->region = CAIRO_RECORDING_REGION_ALL;
-    _cairo_clip_init_copy (&command->clip, clip);
-    if (recording_surface->clip.path != NULL)
-	status = _cairo_clip_apply_clip (&command->clip, &recording_surface->clip);
+
+    /* Successive commands are normally drawn with the same clip, so
+     * reuse the previous result of combining it with the surface clip. */
+    if (_clip_is_last (recording_surface, clip)) {
+	_cairo_clip_init_copy (&command->clip,
+			       &recording_surface->last_command_clip);
+    } else {
+	_cairo_clip_init_copy (&command->clip, clip);
+	if (recording_surface->clip.path != NULL)
+	    status = _cairo_clip_apply_clip (&command->clip, &recording_surface->clip);
+
+	if (status == CAIRO_STATUS_SUCCESS) {
+	    _cairo_clip_fini (&recording_surface->last_clip);
+	    _cairo_clip_init_copy (&recording_surface->last_clip, clip);
+	    _cairo_clip_fini (&recording_surface->last_command_clip);
+	    _cairo_clip_init_copy (&recording_surface->last_command_clip,
+				   &command->clip);
+	    recording_surface->has_last_clip = TRUE;
+	}
+    }
 
     return status;
 }
 
+/* Bounds the pixels the command may touch by its clip and, for operators
+ * bounded by it, its source. The extents are refined by the caller for
+ * operators bounded by the mask. Returns FALSE if the command cannot
+ * touch any pixel, in which case it is not recorded at all. */
+static cairo_bool_t
+_command_init_extents (cairo_command_header_t *command,
+		       const cairo_pattern_t *source)
+{
+    const cairo_rectangle_int_t *clip_extents;
+    cairo_rectangle_int_t extents;
+
+    _cairo_unbounded_rectangle_init (&command->extents);
+    clip_extents = _cairo_clip_get_extents (&command->clip);
+    if (clip_extents != NULL &&
+	! _cairo_rectangle_intersect (&command->extents, clip_extents))
+    {
+	return FALSE;
+    }
+
+    if (_cairo_operator_bounded_by_source (command->op)) {
+	_cairo_pattern_get_extents (source, &extents);
+	return _cairo_rectangle_intersect (&command->extents, &extents);
+    }
+
+    return TRUE;
+}
+
 static cairo_int_status_t
 _cairo_recording_surface_paint (void			  *abstract_surface,
 				cairo_operator_t	   op,
@@ -307,7 +875,8 @@ _cairo_recording_surface_paint (void			  *abstract_surface,
     cairo_recording_surface_t *recording_surface = abstract_surface;
     cairo_command_paint_t *command;
 
-    command = malloc (sizeof (cairo_command_paint_t));
+    command = _cairo_recording_arena_alloc (&recording_surface->arena,
+					    sizeof (cairo_command_paint_t));
     if (unlikely (command == NULL))
 	return _cairo_error (CAIRO_STATUS_NO_MEMORY);
 
@@ -316,13 +885,17 @@ _cairo_recording_surface_paint (void			  *abstract_surface,
     if (unlikely (status))
 	goto CLEANUP_COMMAND;
 
-    status = _cairo_pattern_init_snapshot (&command->source.base, source);
+    status = _cairo_recording_surface_intern_pattern (recording_surface,
+						      source, &command->source);
     if (unlikely (status))
 	goto CLEANUP_COMMAND;
 
+    if (! _command_init_extents (&command->header, source))
+	goto CLEANUP_COMMAND;
+
     status = _cairo_array_append (&recording_surface->commands, &command);
     if (unlikely (status))
-	goto CLEANUP_SOURCE;
+	goto CLEANUP_COMMAND;
 
     /* An optimisation that takes care to not replay what was done
      * before surface is cleared. We don't erase recorded commands
@@ -332,11 +905,8 @@ _cairo_recording_surface_paint (void			  *abstract_surface,
 
     return CAIRO_STATUS_SUCCESS;
 
-  CLEANUP_SOURCE:
-    _cairo_pattern_fini (&command->source.base);
   CLEANUP_COMMAND:
     _cairo_clip_fini (&command->header.clip);
-    free (command);
     return status;
 }
 
@@ -350,8 +920,10 @@ _cairo_recording_surface_mask (void			*abstract_surface,
     cairo_status_t status;
     cairo_recording_surface_t *recording_surface = abstract_surface;
     cairo_command_mask_t *command;
+    cairo_bool_t visible;
 
-    command = malloc (sizeof (cairo_command_mask_t));
+    command = _cairo_recording_arena_alloc (&recording_surface->arena,
+					    sizeof (cairo_command_mask_t));
     if (unlikely (command == NULL))
 	return _cairo_error (CAIRO_STATUS_NO_MEMORY);
 
@@ -360,27 +932,35 @@ _cairo_recording_surface_mask (void			*abstract_surface,
     if (unlikely (status))
 	goto CLEANUP_COMMAND;
 
-    status = _cairo_pattern_init_snapshot (&command->source.base, source);
+    status = _cairo_recording_surface_intern_pattern (recording_surface,
+						      source, &command->source);
     if (unlikely (status))
 	goto CLEANUP_COMMAND;
 
-    status = _cairo_pattern_init_snapshot (&command->mask.base, mask);
+    status = _cairo_recording_surface_intern_pattern (recording_surface,
+						      mask, &command->mask);
     if (unlikely (status))
-	goto CLEANUP_SOURCE;
+	goto CLEANUP_COMMAND;
+
+    visible = _command_init_extents (&command->header, source);
+    if (visible && _cairo_operator_bounded_by_mask (op)) {
+	cairo_rectangle_int_t extents;
+
+	_cairo_pattern_get_extents (mask, &extents);
+	visible = _cairo_rectangle_intersect (&command->header.extents,
+					      &extents);
+    }
+    if (! visible)
+	goto CLEANUP_COMMAND;
 
     status = _cairo_array_append (&recording_surface->commands, &command);
     if (unlikely (status))
-	goto CLEANUP_MASK;
+	goto CLEANUP_COMMAND;
 
     return CAIRO_STATUS_SUCCESS;
 
-  CLEANUP_MASK:
-    _cairo_pattern_fini (&command->mask.base);
-  CLEANUP_SOURCE:
-    _cairo_pattern_fini (&command->source.base);
   CLEANUP_COMMAND:
     _cairo_clip_fini (&command->header.clip);
-    free (command);
     return status;
 }
 
@@ -399,8 +979,10 @@ _cairo_recording_surface_stroke (void			*abstract_surface,
     cairo_status_t status;
     cairo_recording_surface_t *recording_surface = abstract_surface;
     cairo_command_stroke_t *command;
+    cairo_bool_t visible;
 
-    command = malloc (sizeof (cairo_command_stroke_t));
+    command = _cairo_recording_arena_alloc (&recording_surface->arena,
+					    sizeof (cairo_command_stroke_t));
     if (unlikely (command == NULL))
 	return _cairo_error (CAIRO_STATUS_NO_MEMORY);
 
@@ -409,38 +991,46 @@ _cairo_recording_surface_stroke (void			*abstract_surface,
     if (unlikely (status))
 	goto CLEANUP_COMMAND;
 
-    status = _cairo_pattern_init_snapshot (&command->source.base, source);
+    status = _cairo_recording_surface_intern_pattern (recording_surface,
+						      source, &command->source);
     if (unlikely (status))
 	goto CLEANUP_COMMAND;
 
-    status = _cairo_path_fixed_init_copy (&command->path, path);
+    status = _cairo_recording_surface_copy_path (recording_surface,
+						 path, &command->path);
     if (unlikely (status))
-	goto CLEANUP_SOURCE;
+	goto CLEANUP_COMMAND;
 
-    status = _cairo_stroke_style_init_copy (&command->style, style);
+    status = _cairo_recording_surface_intern_stroke_style (recording_surface,
+							   style, &command->style);
     if (unlikely (status))
-	goto CLEANUP_PATH;
+	goto CLEANUP_COMMAND;
 
     command->ctm = *ctm;
     command->ctm_inverse = *ctm_inverse;
     command->tolerance = tolerance;
     command->antialias = antialias;
 
+    visible = _command_init_extents (&command->header, source);
+    if (visible && _cairo_operator_bounded_by_mask (op)) {
+	cairo_rectangle_int_t extents;
+
+	_cairo_path_fixed_approximate_stroke_extents (path, style, ctm,
+						      &extents);
+	visible = _cairo_rectangle_intersect (&command->header.extents,
+					      &extents);
+    }
+    if (! visible)
+	goto CLEANUP_COMMAND;
+
     status = _cairo_array_append (&recording_surface->commands, &command);
     if (unlikely (status))
-	goto CLEANUP_STYLE;
+	goto CLEANUP_COMMAND;
 
     return CAIRO_STATUS_SUCCESS;
 
-  CLEANUP_STYLE:
-    _cairo_stroke_style_fini (&command->style);
-  CLEANUP_PATH:
-    _cairo_path_fixed_fini (&command->path);
-  CLEANUP_SOURCE:
-    _cairo_pattern_fini (&command->source.base);
   CLEANUP_COMMAND:
     _cairo_clip_fini (&command->header.clip);
-    free (command);
     return status;
 }
 
@@ -457,8 +1047,10 @@ _cairo_recording_surface_fill (void			*abstract_surface,
     cairo_status_t status;
     cairo_recording_surface_t *recording_surface = abstract_surface;
     cairo_command_fill_t *command;
+    cairo_bool_t visible;
 
-    command = malloc (sizeof (cairo_command_fill_t));
+    command = _cairo_recording_arena_alloc (&recording_surface->arena,
+					    sizeof (cairo_command_fill_t));
     if (unlikely (command == NULL))
 	return _cairo_error (CAIRO_STATUS_NO_MEMORY);
 
@@ -467,31 +1059,39 @@ _cairo_recording_surface_fill (void			*abstract_surface,
     if (unlikely (status))
 	goto CLEANUP_COMMAND;
 
-    status = _cairo_pattern_init_snapshot (&command->source.base, source);
+    status = _cairo_recording_surface_intern_pattern (recording_surface,
+						      source, &command->source);
     if (unlikely (status))
 	goto CLEANUP_COMMAND;
 
-    status = _cairo_path_fixed_init_copy (&command->path, path);
+    status = _cairo_recording_surface_copy_path (recording_surface,
+						 path, &command->path);
     if (unlikely (status))
-	goto CLEANUP_SOURCE;
+	goto CLEANUP_COMMAND;
 
     command->fill_rule = fill_rule;
     command->tolerance = tolerance;
     command->antialias = antialias;
 
+    visible = _command_init_extents (&command->header, source);
+    if (visible && _cairo_operator_bounded_by_mask (op)) {
+	cairo_rectangle_int_t extents;
+
+	_cairo_path_fixed_approximate_fill_extents (path, &extents);
+	visible = _cairo_rectangle_intersect (&command->header.extents,
+					      &extents);
+    }
+    if (! visible)
+	goto CLEANUP_COMMAND;
+
     status = _cairo_array_append (&recording_surface->commands, &command);
     if (unlikely (status))
-	goto CLEANUP_PATH;
+	goto CLEANUP_COMMAND;
 
     return CAIRO_STATUS_SUCCESS;
 
-  CLEANUP_PATH:
-    _cairo_path_fixed_fini (&command->path);
-  CLEANUP_SOURCE:
-    _cairo_pattern_fini (&command->source.base);
   CLEANUP_COMMAND:
     _cairo_clip_fini (&command->header.clip);
-    free (command);
     return status;
 }
 
@@ -518,8 +1118,10 @@ _cairo_recording_surface_show_text_glyphs (void				*abstract_surface,
     cairo_status_t status;
     cairo_recording_surface_t *recording_surface = abstract_surface;
     cairo_command_show_text_glyphs_t *command;
+    cairo_bool_t visible;
 
-    command = malloc (sizeof (cairo_command_show_text_glyphs_t));
+    command = _cairo_recording_arena_alloc (&recording_surface->arena,
+					    sizeof (cairo_command_show_text_glyphs_t));
     if (unlikely (command == NULL))
 	return _cairo_error (CAIRO_STATUS_NO_MEMORY);
 
@@ -529,7 +1131,8 @@ _cairo_recording_surface_show_text_glyphs (void				*abstract_surface,
     if (unlikely (status))
 	goto CLEANUP_COMMAND;
 
-    status = _cairo_pattern_init_snapshot (&command->source.base, source);
+    status = _cairo_recording_surface_intern_pattern (recording_surface,
+						      source, &command->source);
     if (unlikely (status))
 	goto CLEANUP_COMMAND;
 
@@ -541,26 +1144,31 @@ _cairo_recording_surface_show_text_glyphs (void				*abstract_surface,
     command->num_clusters = num_clusters;
 
     if (utf8_len) {
-	command->utf8 = malloc (utf8_len);
+	command->utf8 = _cairo_recording_arena_alloc (&recording_surface->arena,
+						      utf8_len);
 	if (unlikely (command->utf8 == NULL)) {
 	    status = _cairo_error (CAIRO_STATUS_NO_MEMORY);
-	    goto CLEANUP_ARRAYS;
+	    goto CLEANUP_COMMAND;
 	}
 	memcpy (command->utf8, utf8, utf8_len);
     }
     if (num_glyphs) {
-	command->glyphs = _cairo_malloc_ab (num_glyphs, sizeof (glyphs[0]));
+	command->glyphs = _cairo_recording_arena_alloc_ab (&recording_surface->arena,
+							   num_glyphs,
+							   sizeof (glyphs[0]));
 	if (unlikely (command->glyphs == NULL)) {
 	    status = _cairo_error (CAIRO_STATUS_NO_MEMORY);
-	    goto CLEANUP_ARRAYS;
+	    goto CLEANUP_COMMAND;
 	}
 	memcpy (command->glyphs, glyphs, sizeof (glyphs[0]) * num_glyphs);
     }
     if (num_clusters) {
-	command->clusters = _cairo_malloc_ab (num_clusters, sizeof (clusters[0]));
+	command->clusters = _cairo_recording_arena_alloc_ab (&recording_surface->arena,
+							     num_clusters,
+							     sizeof (clusters[0]));
 	if (unlikely (command->clusters == NULL)) {
 	    status = _cairo_error (CAIRO_STATUS_NO_MEMORY);
-	    goto CLEANUP_ARRAYS;
+	    goto CLEANUP_COMMAND;
 	}
 	memcpy (command->clusters, clusters, sizeof (clusters[0]) * num_clusters);
     }
@@ -569,6 +1177,26 @@ _cairo_recording_surface_show_text_glyphs (void				*abstract_surface,
 
     command->scaled_font = cairo_scaled_font_reference (scaled_font);
 
+    visible = _command_init_extents (&command->header, source);
+    if (visible && _cairo_operator_bounded_by_mask (op)) {
+	cairo_rectangle_int_t extents;
+
+	/* On error, leave the extents unbounded and let the replay
+	 * report the failure. Glyphs without ink, such as spaces, are
+	 * still recorded if they carry text, for the benefit of text
+	 * extraction from the vector backends. */
+	if (_cairo_scaled_font_glyph_device_extents (scaled_font,
+						     glyphs, num_glyphs,
+						     &extents,
+						     NULL) == CAIRO_STATUS_SUCCESS &&
+	    ! _cairo_rectangle_intersect (&command->header.extents, &extents))
+	{
+	    visible = utf8_len != 0;
+	}
+    }
+    if (! visible)
+	goto CLEANUP_SCALED_FONT;
+
     status = _cairo_array_append (&recording_surface->commands, &command);
     if (unlikely (status))
 	goto CLEANUP_SCALED_FONT;
@@ -577,15 +1205,8 @@ _cairo_recording_surface_show_text_glyphs (void				*abstract_surface,
 
   CLEANUP_SCALED_FONT:
     cairo_scaled_font_destroy (command->scaled_font);
-  CLEANUP_ARRAYS:
-    free (command->utf8);
-    free (command->glyphs);
-    free (command->clusters);
-
-    _cairo_pattern_fini (&command->source.base);
   CLEANUP_COMMAND:
     _cairo_clip_fini (&command->header.clip);
-    free (command);
     return status;
 }
 
@@ -631,7 +1252,7 @@ _cairo_recording_surface_snapshot (void *abstract_other)
     recording_surface->replay_start_idx = 0;
     recording_surface->base.is_clear = TRUE;
 
-    _cairo_array_init (&recording_surface->commands, sizeof (cairo_command_t *));
+    _cairo_recording_surface_init_storage (recording_surface);
     status = _cairo_recording_surface_replay (&other->base, &recording_surface->base);
     if (unlikely (status)) {
 	cairo_surface_destroy (&recording_surface->base);
@@ -747,8 +1368,8 @@ _cairo_recording_surface_get_path (cairo_surface_t    *surface,
 	    _cairo_traps_init (&traps);
 
 	    /* XXX call cairo_stroke_to_path() when that is implemented */
-	    status = _cairo_path_fixed_stroke_to_traps (&command->stroke.path,
-							&command->stroke.style,
+	    status = _cairo_path_fixed_stroke_to_traps (command->stroke.path,
+							command->stroke.style,
 							&command->stroke.ctm,
 							&command->stroke.ctm_inverse,
 							command->stroke.tolerance,
@@ -763,7 +1384,7 @@ _cairo_recording_surface_get_path (cairo_surface_t    *surface,
 	case CAIRO_COMMAND_FILL:
 	{
 	    status = _cairo_path_fixed_append (path,
-					       &command->fill.path, CAIRO_DIRECTION_FORWARD,
+					       command->fill.path, CAIRO_DIRECTION_FORWARD,
 					       0, 0);
 	    break;
 	}
@@ -791,13 +1412,19 @@ _cairo_recording_surface_get_path (cairo_surface_t    *surface,
 static cairo_status_t
 _cairo_recording_surface_replay_internal (cairo_surface_t	     *surface,
 					  const cairo_rectangle_int_t *surface_extents,
+					  const cairo_rectangle_int_t *clip_extents,
 					  cairo_surface_t	     *target,
 					  cairo_recording_replay_type_t type,
-					  cairo_recording_region_type_t region)
+					  cairo_recording_region_type_t region,
+					  cairo_bool_t concurrent)
 {
     cairo_recording_surface_t *recording_surface;
     cairo_command_t **elements;
-    int i, num_elements;
+    cairo_clip_t clip_copy, *clip;
+    int i, n, num_elements;
+    int *visible_indices, num_visible;
+    cairo_array_t visible;
+    cairo_rectangle_int_t target_extents;
     cairo_int_status_t status;
     cairo_surface_wrapper_t wrapper;
 
@@ -817,6 +1444,7 @@ _cairo_recording_surface_replay_internal (cairo_surface_t	     *surface,
 
     _cairo_surface_wrapper_init (&wrapper, target);
     _cairo_surface_wrapper_set_extents (&wrapper, surface_extents);
+    _cairo_surface_wrapper_set_clip_extents (&wrapper, clip_extents);
 
     recording_surface = (cairo_recording_surface_t *) surface;
     status = CAIRO_STATUS_SUCCESS;
@@ -824,42 +1452,79 @@ _cairo_recording_surface_replay_internal (cairo_surface_t	     *surface,
     num_elements = recording_surface->commands.num_elements;
     elements = _cairo_array_index (&recording_surface->commands, 0);
 
-    for (i = recording_surface->replay_start_idx; i < num_elements; i++) {
-	cairo_command_t *command = elements[i];
+    /* Only visit the commands that can touch the target. Creating
+     * regions must classify every command, and the analysis surface
+     * applies its own ctm, so those always walk the full list. */
+    _cairo_array_init (&visible, sizeof (int));
+    visible_indices = NULL;
+    num_visible = num_elements - recording_surface->replay_start_idx;
+    if (type == CAIRO_RECORDING_REPLAY &&
+	target->backend->type != CAIRO_INTERNAL_SURFACE_TYPE_ANALYSIS &&
+	_cairo_surface_wrapper_get_target_extents (&wrapper, &target_extents))
+    {
+	status = _cairo_recording_surface_get_visible_commands (recording_surface,
+								&target_extents,
+								&visible);
+	if (unlikely (status)) {
+	    _cairo_array_fini (&visible);
+	    _cairo_surface_wrapper_fini (&wrapper);
+	    return _cairo_surface_set_error (surface, status);
+	}
+
+	visible_indices = _cairo_array_index (&visible, 0);
+	num_visible = visible.num_elements;
+    }
+
+    for (n = 0; n < num_visible; n++) {
+	cairo_command_t *command;
+
+	i = visible_indices ? visible_indices[n] : recording_surface->replay_start_idx + n;
+	command = elements[i];
 
 	if (type == CAIRO_RECORDING_REPLAY && region != CAIRO_RECORDING_REGION_ALL) {
 	    if (command->header.region != region)
 		continue;
         }
 
+	/* The clip caches are filled in as the clip is used, so other
+	 * threads replaying this surface must not share them. */
+	clip = _clip (command);
+	if (concurrent && clip != NULL) {
+	    status = _cairo_clip_init_deep_copy (&clip_copy, clip);
+	    if (unlikely (status))
+		break;
+
+	    clip = &clip_copy;
+	}
+
 	switch (command->header.type) {
 	case CAIRO_COMMAND_PAINT:
 	    status = _cairo_surface_wrapper_paint (&wrapper,
 						   command->header.op,
-						   &command->paint.source.base,
-						   _clip (command));
+						   command->paint.source,
+						   clip);
 	    break;
 
 	case CAIRO_COMMAND_MASK:
 	    status = _cairo_surface_wrapper_mask (&wrapper,
 						  command->header.op,
-						  &command->mask.source.base,
-						  &command->mask.mask.base,
-						  _clip (command));
+						  command->mask.source,
+						  command->mask.mask,
+						  clip);
 	    break;
 
 	case CAIRO_COMMAND_STROKE:
 	{
 	    status = _cairo_surface_wrapper_stroke (&wrapper,
 						    command->header.op,
-						    &command->stroke.source.base,
-						    &command->stroke.path,
-						    &command->stroke.style,
+						    command->stroke.source,
+						    command->stroke.path,
+						    command->stroke.style,
 						    &command->stroke.ctm,
 						    &command->stroke.ctm_inverse,
 						    command->stroke.tolerance,
 						    command->stroke.antialias,
-						    _clip (command));
+						    clip);
 	    break;
 	}
 	case CAIRO_COMMAND_FILL:
@@ -867,8 +1532,11 @@ _cairo_recording_surface_replay_internal (cairo_surface_t	     *surface,
 	    cairo_command_t *stroke_command;
 
 	    stroke_command = NULL;
-	    if (type != CAIRO_RECORDING_CREATE_REGIONS && i < num_elements - 1)
+	    if (type != CAIRO_RECORDING_CREATE_REGIONS && n < num_visible - 1 &&
+		(visible_indices == NULL || visible_indices[n + 1] == i + 1))
+	    {
 		stroke_command = elements[i + 1];
+	    }
 
 	    if (stroke_command != NULL &&
 		type == CAIRO_RECORDING_REPLAY &&
@@ -880,36 +1548,37 @@ _cairo_recording_surface_replay_internal (cairo_surface_t	     *surface,
 
 	    if (stroke_command != NULL &&
 		stroke_command->header.type == CAIRO_COMMAND_STROKE &&
-		_cairo_path_fixed_is_equal (&command->fill.path,
-					    &stroke_command->stroke.path))
+		(command->fill.path == stroke_command->stroke.path ||
+		 _cairo_path_fixed_is_equal (command->fill.path,
+					     stroke_command->stroke.path)))
 	    {
 		status = _cairo_surface_wrapper_fill_stroke (&wrapper,
 							     command->header.op,
-							     &command->fill.source.base,
+							     command->fill.source,
 							     command->fill.fill_rule,
 							     command->fill.tolerance,
 							     command->fill.antialias,
-							     &command->fill.path,
+							     command->fill.path,
 							     stroke_command->header.op,
-							     &stroke_command->stroke.source.base,
-							     &stroke_command->stroke.style,
+							     stroke_command->stroke.source,
+							     stroke_command->stroke.style,
 							     &stroke_command->stroke.ctm,
 							     &stroke_command->stroke.ctm_inverse,
 							     stroke_command->stroke.tolerance,
 							     stroke_command->stroke.antialias,
-							     _clip (command));
-		i++;
+							     clip);
+		n++;
 	    }
 	    else
 	    {
 		status = _cairo_surface_wrapper_fill (&wrapper,
 						      command->header.op,
-						      &command->fill.source.base,
-						      &command->fill.path,
+						      command->fill.source,
+						      command->fill.path,
 						      command->fill.fill_rule,
 						      command->fill.tolerance,
 						      command->fill.antialias,
-						      _clip (command));
+						      clip);
 	    }
 	    break;
 	}
@@ -933,13 +1602,13 @@ _cairo_recording_surface_replay_internal (cairo_surface_t	     *surface,
 
 	    status = _cairo_surface_wrapper_show_text_glyphs (&wrapper,
 							      command->header.op,
-							      &command->show_text_glyphs.source.base,
+							      command->show_text_glyphs.source,
 							      command->show_text_glyphs.utf8, command->show_text_glyphs.utf8_len,
 							      glyphs_copy, num_glyphs,
 							      command->show_text_glyphs.clusters, command->show_text_glyphs.num_clusters,
 							      command->show_text_glyphs.cluster_flags,
 							      command->show_text_glyphs.scaled_font,
-							      _clip (command));
+							      clip);
 	    free (glyphs_copy);
 	    break;
 	}
@@ -947,6 +1616,9 @@ _cairo_recording_surface_replay_internal (cairo_surface_t	     *surface,
 	    ASSERT_NOT_REACHED;
 	}
 
+	if (clip == &clip_copy)
+	    _cairo_clip_reset (&clip_copy);
+
 	if (type == CAIRO_RECORDING_CREATE_REGIONS) {
 	    if (status == CAIRO_STATUS_SUCCESS) {
 		command->header.region = CAIRO_RECORDING_REGION_NATIVE;
@@ -963,12 +1635,14 @@ _cairo_recording_surface_replay_internal (cairo_surface_t	     *surface,
     }
 
     /* free up any caches */
-    for (i = recording_surface->replay_start_idx; i < num_elements; i++) {
-	cairo_command_t *command = elements[i];
-
-	_cairo_clip_drop_cache (&command->header.clip);
+    if (! concurrent) {
+	for (n = 0; n < num_visible; n++) {
+	    i = visible_indices ? visible_indices[n] : recording_surface->replay_start_idx + n;
+	    _cairo_clip_drop_cache (&elements[i]->header.clip);
+	}
     }
 
+    _cairo_array_fini (&visible);
     _cairo_surface_wrapper_fini (&wrapper);
 
     return _cairo_surface_set_error (surface, status);
@@ -990,10 +1664,11 @@ cairo_status_t
 _cairo_recording_surface_replay (cairo_surface_t *surface,
 				 cairo_surface_t *target)
 {
-    return _cairo_recording_surface_replay_internal (surface, NULL,
+    return _cairo_recording_surface_replay_internal (surface, NULL, NULL,
 						     target,
 						     CAIRO_RECORDING_REPLAY,
-						     CAIRO_RECORDING_REGION_ALL);
+						     CAIRO_RECORDING_REGION_ALL,
+						     FALSE);
 }
 
 /* Replay recording to surface. When the return status of each operation is
@@ -1006,10 +1681,11 @@ cairo_status_t
 _cairo_recording_surface_replay_and_create_regions (cairo_surface_t *surface,
 						    cairo_surface_t *target)
 {
-    return _cairo_recording_surface_replay_internal (surface, NULL,
+    return _cairo_recording_surface_replay_internal (surface, NULL, NULL,
 						     target,
 						     CAIRO_RECORDING_CREATE_REGIONS,
-						     CAIRO_RECORDING_REGION_ALL);
+						     CAIRO_RECORDING_REGION_ALL,
+						     FALSE);
 }
 
 cairo_status_t
@@ -1018,10 +1694,395 @@ _cairo_recording_surface_replay_region (cairo_surface_t          *surface,
 					cairo_surface_t          *target,
 					cairo_recording_region_type_t  region)
 {
-    return _cairo_recording_surface_replay_internal (surface, surface_extents,
+    return _cairo_recording_surface_replay_internal (surface,
+						     surface_extents, NULL,
 						     target,
 						     CAIRO_RECORDING_REPLAY,
-						     region);
+						     region,
+						     FALSE);
+}
+
+static void
+_command_get_patterns (cairo_command_t	       *command,
+		       const cairo_pattern_t  **source,
+		       const cairo_pattern_t  **mask)
+{
+    *mask = NULL;
+
+    switch (command->header.type) {
+    case CAIRO_COMMAND_PAINT:
+	*source = command->paint.source;
+	break;
+    case CAIRO_COMMAND_MASK:
+	*source = command->mask.source;
+	*mask = command->mask.mask;
+	break;
+    case CAIRO_COMMAND_STROKE:
+	*source = command->stroke.source;
+	break;
+    case CAIRO_COMMAND_FILL:
+	*source = command->fill.source;
+	break;
+    case CAIRO_COMMAND_SHOW_TEXT_GLYPHS:
+	*source = command->show_text_glyphs.source;
+	break;
+    default:
+	ASSERT_NOT_REACHED;
+	*source = NULL;
+	break;
+    }
+}
+
+static cairo_bool_t
+_cairo_recording_surface_can_replay_concurrently (cairo_recording_surface_t *surface)
+{
+    cairo_command_t **elements;
+    int i, num_elements;
+
+    num_elements = surface->commands.num_elements;
+    elements = _cairo_array_index (&surface->commands, 0);
+
+    /* Surface patterns acquire (and may snapshot) their sources as
+     * they are drawn, which is not safe to do from several threads at
+     * once. Everything else only reads the recorded commands. */
+    for (i = surface->replay_start_idx; i < num_elements; i++) {
+	const cairo_pattern_t *source, *mask;
+
+	_command_get_patterns (elements[i], &source, &mask);
+	if (source == NULL)
+	    return FALSE;
+
+	if (source->type == CAIRO_PATTERN_TYPE_SURFACE)
+	    return FALSE;
+	if (mask != NULL && mask->type == CAIRO_PATTERN_TYPE_SURFACE)
+	    return FALSE;
+    }
+
+    return TRUE;
+}
+
+static cairo_bool_t
+_pattern_is_sampled_independently_of_extents (const cairo_pattern_t *pattern,
+					      const cairo_matrix_t  *device_transform)
+{
+    cairo_matrix_t m;
+
+    if (pattern == NULL || pattern->type == CAIRO_PATTERN_TYPE_SOLID)
+	return TRUE;
+
+    m = pattern->matrix;
+    if (pattern->type == CAIRO_PATTERN_TYPE_SURFACE) {
+	cairo_surface_t *surface = ((cairo_surface_pattern_t *) pattern)->surface;
+
+	if (_cairo_surface_has_device_transform (surface))
+	    cairo_matrix_multiply (&m, &surface->device_transform, &m);
+    }
+    cairo_matrix_multiply (&m, device_transform, &m);
+
+    return _cairo_matrix_has_unity_scale (&m);
+}
+
+/* The image backend anchors the transformation of scaled or rotated
+ * sources upon the extents of each operation, so clipping such
+ * operations to a band would sample them slightly differently. */
+static cairo_bool_t
+_cairo_recording_surface_can_replay_in_bands (cairo_recording_surface_t *surface,
+					      cairo_surface_t		*target)
+{
+    cairo_command_t **elements;
+    int i, num_elements;
+
+    num_elements = surface->commands.num_elements;
+    elements = _cairo_array_index (&surface->commands, 0);
+    for (i = surface->replay_start_idx; i < num_elements; i++) {
+	const cairo_pattern_t *source, *mask;
+
+	_command_get_patterns (elements[i], &source, &mask);
+	if (source == NULL)
+	    return FALSE;
+
+	if (! _pattern_is_sampled_independently_of_extents (source,
+							    &target->device_transform_inverse) ||
+	    ! _pattern_is_sampled_independently_of_extents (mask,
+							    &target->device_transform_inverse))
+	{
+	    return FALSE;
+	}
+    }
+
+    return TRUE;
+}
+
+/* Concurrent replays leave the shared clip caches untouched; this is
+ * the serial equivalent of the replay's own cleanup. */
+static void
+_cairo_recording_surface_drop_clip_caches (cairo_recording_surface_t *surface)
+{
+    cairo_command_t **elements;
+    int i, num_elements;
+
+    num_elements = surface->commands.num_elements;
+    elements = _cairo_array_index (&surface->commands, 0);
+    for (i = surface->replay_start_idx; i < num_elements; i++)
+	_cairo_clip_drop_cache (&elements[i]->header.clip);
+}
+
+typedef struct _cairo_recording_tiled_replay {
+    cairo_surface_t *surface;
+    cairo_image_surface_t *target;
+    cairo_font_options_t font_options;
+    cairo_bool_t concurrent;
+} cairo_recording_tiled_replay_t;
+
+static cairo_status_t
+_cairo_recording_surface_replay_tile (void *closure, int tile)
+{
+    cairo_recording_tiled_replay_t *replay = closure;
+    cairo_image_surface_t *target = replay->target;
+    cairo_surface_t *image;
+    cairo_rectangle_int_t band;
+    cairo_status_t status;
+
+    band.x = 0;
+    band.y = tile * CAIRO_RECORDING_TILE_HEIGHT;
+    band.width = target->width;
+    band.height = MIN (CAIRO_RECORDING_TILE_HEIGHT, target->height - band.y);
+
+    /* Each tile draws onto its own view of the whole target and is
+     * clipped to its band, so that everything is rasterised and
+     * sampled exactly as it would be by a serial replay. */
+    image = _cairo_image_surface_create_with_pixman_format (target->data,
+							    target->pixman_format,
+							    target->width,
+							    target->height,
+							    target->stride);
+    if (unlikely (image->status))
+	return image->status;
+
+    image->device_transform = target->base.device_transform;
+    image->device_transform_inverse = target->base.device_transform_inverse;
+    image->is_clear = target->base.is_clear;
+    _cairo_surface_set_font_options (image, &replay->font_options);
+
+    status = _cairo_recording_surface_replay_internal (replay->surface,
+						       NULL, &band,
+						       image,
+						       CAIRO_RECORDING_REPLAY,
+						       CAIRO_RECORDING_REGION_ALL,
+						       replay->concurrent);
+
+    cairo_surface_destroy (image);
+
+    return status;
+}
+
+/* Replays @surface onto each band of the image @target in turn, or on
+ * @num_threads threads if @concurrent. */
+static cairo_status_t
+_cairo_recording_surface_replay_tiles (cairo_surface_t *surface,
+				       cairo_surface_t *target,
+				       cairo_bool_t	concurrent,
+				       int		num_threads)
+{
+    cairo_recording_tiled_replay_t replay;
+    int num_tiles;
+    cairo_status_t status;
+
+    replay.surface = surface;
+    replay.target = (cairo_image_surface_t *) target;
+    cairo_surface_get_font_options (target, &replay.font_options);
+    replay.concurrent = concurrent;
+
+    num_tiles = (replay.target->height + CAIRO_RECORDING_TILE_HEIGHT - 1) /
+		CAIRO_RECORDING_TILE_HEIGHT;
+
+    cairo_surface_flush (target);
+
+    status = _cairo_parallel_for (num_tiles, num_threads,
+				  _cairo_recording_surface_replay_tile,
+				  &replay);
+
+    cairo_surface_mark_dirty (target);
+    target->is_clear = FALSE;
+
+    return status;
+}
+
+/**
+ * _cairo_recording_surface_replay_tiled:
+ * @surface: the #cairo_recording_surface_t
+ * @target: a target #cairo_surface_t onto which to replay the operations
+ *
+ * Replays @surface onto @target like _cairo_recording_surface_replay(),
+ * but for large image targets the target is split into bands of
+ * %CAIRO_RECORDING_TILE_HEIGHT rows, each of which is replayed
+ * separately, only visiting the commands that touch the band. When
+ * every recorded pattern can be safely shared, the bands are replayed
+ * concurrently on a pool of threads.
+ *
+ * Each band is drawn onto the whole target clipped to its rows, so the
+ * result is identical to that of _cairo_recording_surface_replay(),
+ * whatever the number of threads used. Recordings whose patterns
+ * would be sampled differently once clipped are replayed in one go.
+ **/
+cairo_status_t
+_cairo_recording_surface_replay_tiled (cairo_surface_t *surface,
+				       cairo_surface_t *target)
+{
+    cairo_recording_surface_t *recording_surface;
+    int num_threads;
+    cairo_bool_t concurrent;
+    cairo_status_t status;
+
+    recording_surface = (cairo_recording_surface_t *) surface;
+    if (surface->status || surface->finished || surface->is_clear ||
+	target->status || target->finished ||
+	! _cairo_surface_is_image (target) ||
+	((cairo_image_surface_t *) target)->height <= CAIRO_RECORDING_TILE_HEIGHT)
+    {
+	return _cairo_recording_surface_replay (surface, target);
+    }
+
+    assert (_cairo_surface_is_recording (surface));
+
+    if (! _cairo_recording_surface_can_replay_in_bands (recording_surface,
+							target))
+    {
+	return _cairo_recording_surface_replay (surface, target);
+    }
+
+    concurrent = FALSE;
+    num_threads = _cairo_parallel_num_threads ();
+    if (num_threads > 1 &&
+	_cairo_recording_surface_can_replay_concurrently (recording_surface))
+    {
+	/* The index is shared by all the tiles, so build it up front. */
+	status = _cairo_recording_surface_update_index (recording_surface);
+	if (unlikely (status))
+	    return _cairo_surface_set_error (surface, status);
+
+	concurrent = TRUE;
+    }
+    else
+    {
+	num_threads = 1;
+    }
+
+    status = _cairo_recording_surface_replay_tiles (surface, target,
+						    concurrent, num_threads);
+
+    if (concurrent)
+	_cairo_recording_surface_drop_clip_caches (recording_surface);
+
+    return _cairo_surface_set_error (surface, status);
+}
+
+/**
+ * cairo_recording_surface_replay_tiled:
+ * @surface: a #cairo_recording_surface_t
+ * @target: the surface onto which to replay the operations
+ *
+ * Replays the operations stored within the recording-surface directly
+ * onto @target, in the order in which they were recorded and with the
+ * recording's origin at the origin of @target.
+ *
+ * Image targets are split into bands that are replayed separately,
+ * each only visiting the operations that touch it. When every recorded
+ * pattern can be safely shared between threads, the bands are replayed
+ * concurrently on a pool of worker threads. The result is identical to
+ * replaying the whole recording serially, whatever the number of
+ * threads used.
+ *
+ * Return value: %CAIRO_STATUS_SUCCESS, or the error that occurred
+ * during the replay, which is also set on @surface. If @surface is not
+ * a recording surface, %CAIRO_STATUS_SURFACE_TYPE_MISMATCH is returned.
+ *
+ * Since: 1.12
+ **/
+cairo_status_t
+cairo_recording_surface_replay_tiled (cairo_surface_t *surface,
+				      cairo_surface_t *target)
+{
+    if (unlikely (surface->status))
+	return surface->status;
+    if (unlikely (target->status))
+	return target->status;
+
+    if (! _cairo_surface_is_recording (surface))
+	return _cairo_error (CAIRO_STATUS_SURFACE_TYPE_MISMATCH);
+
+    return _cairo_recording_surface_replay_tiled (surface, target);
+}
+
+typedef struct _cairo_recording_multiple_replay {
+    cairo_surface_t *surface;
+    cairo_surface_t **targets;
+} cairo_recording_multiple_replay_t;
+
+static cairo_status_t
+_cairo_recording_surface_replay_target (void *closure, int i)
+{
+    cairo_recording_multiple_replay_t *replay = closure;
+
+    return _cairo_recording_surface_replay_internal (replay->surface, NULL, NULL,
+						     replay->targets[i],
+						     CAIRO_RECORDING_REPLAY,
+						     CAIRO_RECORDING_REGION_ALL,
+						     TRUE);
+}
+
+/**
+ * _cairo_recording_surface_replay_multiple:
+ * @surface: the #cairo_recording_surface_t
+ * @targets: the image surfaces onto which to replay the operations
+ * @num_targets: the number of @targets
+ *
+ * Replays @surface onto each of @targets, exactly as
+ * _cairo_recording_surface_replay_tiled() would. When every recorded
+ * pattern can be safely shared the targets are replayed concurrently,
+ * one per thread, each only visiting the commands that touch it.
+ **/
+cairo_status_t
+_cairo_recording_surface_replay_multiple (cairo_surface_t  *surface,
+					  cairo_surface_t **targets,
+					  int		    num_targets)
+{
+    cairo_recording_surface_t *recording_surface;
+    cairo_recording_multiple_replay_t replay;
+    int num_threads, i;
+    cairo_status_t status;
+
+    recording_surface = (cairo_recording_surface_t *) surface;
+    num_threads = MIN (_cairo_parallel_num_threads (), num_targets);
+    if (num_threads <= 1 ||
+	surface->status || surface->finished || surface->is_clear ||
+	! _cairo_recording_surface_can_replay_concurrently (recording_surface))
+    {
+	for (i = 0; i < num_targets; i++) {
+	    status = _cairo_recording_surface_replay_tiled (surface, targets[i]);
+	    if (unlikely (status))
+		return status;
+	}
+
+	return CAIRO_STATUS_SUCCESS;
+    }
+
+    assert (_cairo_surface_is_recording (surface));
+
+    /* The index is shared by all the targets, so build it up front. */
+    status = _cairo_recording_surface_update_index (recording_surface);
+    if (unlikely (status))
+	return _cairo_surface_set_error (surface, status);
+
+    replay.surface = surface;
+    replay.targets = targets;
+    status = _cairo_parallel_for (num_targets, num_threads,
+				  _cairo_recording_surface_replay_target,
+				  &replay);
+
+    _cairo_recording_surface_drop_clip_caches (recording_surface);
+
+    return _cairo_surface_set_error (surface, status);
 }
 
 static cairo_status_t
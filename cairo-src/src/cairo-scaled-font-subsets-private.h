@@ -316,6 +316,48 @@ _cairo_scaled_font_subsets_foreach_user (cairo_scaled_font_subsets_t		  *font_su
 					 cairo_scaled_font_subset_callback_func_t  font_subset_callback,
 					 void					  *closure);
 
+typedef cairo_status_t
+(*cairo_scaled_font_subset_prepare_func_t) (cairo_scaled_font_subset_t	*font_subset,
+					    void			*closure,
+					    void		       **prepared);
+
+typedef cairo_status_t
+(*cairo_scaled_font_subset_emit_func_t) (cairo_scaled_font_subset_t	*font_subset,
+					 void				*prepared,
+					 void				*closure);
+
+/**
+ * _cairo_scaled_font_subsets_foreach_unscaled_parallel:
+ * @font_subsets: a #cairo_scaled_font_subsets_t
+ * @prepare_func: a function to be called for each font subset, possibly
+ * from another thread, to generate the subset
+ * @emit_func: a function to be called for each prepared font subset
+ * @destroy_func: a function to release what @prepare_func stored in
+ * its @prepared argument
+ * @closure: closure data for the callback functions
+ *
+ * Like _cairo_scaled_font_subsets_foreach_unscaled(), but with the
+ * work for each subset split in two. @prepare_func is called for every
+ * subset first, concurrently on a pool of threads where available, and
+ * may store its result in @prepared. @emit_func is then called on the
+ * calling thread for each subset in turn, in the same order as
+ * _cairo_scaled_font_subsets_foreach_unscaled() would visit them, with
+ * the corresponding @prepared value.
+ *
+ * @prepare_func must only touch the subset and the font it belongs to.
+ *
+ * Return value: %CAIRO_STATUS_SUCCESS if successful, or a non-zero
+ * value indicating an error, being the first error returned by either
+ * callback for the subsets in order. Possible errors include
+ * %CAIRO_STATUS_NO_MEMORY.
+ **/
+cairo_private cairo_status_t
+_cairo_scaled_font_subsets_foreach_unscaled_parallel (cairo_scaled_font_subsets_t		   *font_subsets,
+						      cairo_scaled_font_subset_prepare_func_t	    prepare_func,
+						      cairo_scaled_font_subset_emit_func_t	    emit_func,
+						      cairo_destroy_func_t			    destroy_func,
+						      void					   *closure);
+
 /**
  * _cairo_scaled_font_subset_create_glyph_names:
  * @font_subsets: a #cairo_scaled_font_subsets_t
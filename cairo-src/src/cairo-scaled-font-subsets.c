@@ -43,6 +43,7 @@
 #define _BSD_SOURCE /* for snprintf(), strdup() */
 #include "cairoint.h"
 #include "cairo-error-private.h"
+#include "cairo-parallel-private.h"
 
 #if CAIRO_HAS_FONT_SUBSET
 
@@ -944,6 +945,177 @@ _cairo_scaled_font_subsets_foreach_user (cairo_scaled_font_subsets_t		  *font_su
 							CAIRO_SUBSETS_FOREACH_USER);
 }
 
+typedef struct _cairo_sub_font_job {
+    cairo_scaled_font_subset_t subset;
+    void *prepared;
+    cairo_status_t status;
+} cairo_sub_font_job_t;
+
+typedef struct _cairo_sub_font_jobs {
+    cairo_array_t jobs;
+
+    cairo_scaled_font_subset_prepare_func_t prepare_func;
+    cairo_scaled_font_subset_emit_func_t emit_func;
+    cairo_destroy_func_t destroy_func;
+    void *closure;
+} cairo_sub_font_jobs_t;
+
+static cairo_status_t
+_cairo_sub_font_prepare_and_emit (cairo_scaled_font_subset_t	*font_subset,
+				  void				*closure)
+{
+    cairo_sub_font_jobs_t *jobs = closure;
+    void *prepared = NULL;
+    cairo_status_t status;
+
+    status = jobs->prepare_func (font_subset, jobs->closure, &prepared);
+    if (likely (status == CAIRO_STATUS_SUCCESS))
+	status = jobs->emit_func (font_subset, prepared, jobs->closure);
+
+    if (prepared != NULL)
+	jobs->destroy_func (prepared);
+
+    return status;
+}
+
+static void
+_cairo_sub_font_job_fini (cairo_sub_font_job_t *job,
+			  cairo_destroy_func_t	destroy_func)
+{
+    unsigned int i;
+
+    if (job->prepared != NULL)
+	destroy_func (job->prepared);
+
+    if (job->subset.glyph_names != NULL) {
+	for (i = 0; i < job->subset.num_glyphs; i++)
+	    free (job->subset.glyph_names[i]);
+	free (job->subset.glyph_names);
+    }
+
+    if (job->subset.to_unicode != NULL)
+	free (job->subset.to_unicode);
+
+    free (job->subset.utf8);
+    free (job->subset.glyphs);
+}
+
+/* The collection reuses its arrays for every subset, so take a copy
+ * of each one to be prepared later. The utf8 strings belong to the
+ * sub font and so remain valid for the lifetime of the subsets. */
+static cairo_status_t
+_cairo_sub_font_queue_job (cairo_scaled_font_subset_t	*font_subset,
+			   void				*closure)
+{
+    cairo_sub_font_jobs_t *jobs = closure;
+    cairo_sub_font_job_t job;
+    unsigned int num_glyphs = font_subset->num_glyphs;
+    cairo_status_t status;
+
+    job.subset = *font_subset;
+    job.subset.glyph_names = NULL;
+    job.subset.to_unicode = NULL;
+    job.prepared = NULL;
+    job.status = CAIRO_STATUS_SUCCESS;
+
+    job.subset.glyphs = _cairo_malloc_ab (num_glyphs, sizeof (unsigned long));
+    job.subset.utf8 = _cairo_malloc_ab (num_glyphs, sizeof (char *));
+    if (unlikely (job.subset.glyphs == NULL || job.subset.utf8 == NULL)) {
+	status = _cairo_error (CAIRO_STATUS_NO_MEMORY);
+	goto FAIL;
+    }
+
+    memcpy (job.subset.glyphs, font_subset->glyphs,
+	    num_glyphs * sizeof (unsigned long));
+    memcpy (job.subset.utf8, font_subset->utf8,
+	    num_glyphs * sizeof (char *));
+
+    /* As with the collection, a missing to_unicode is not an error. */
+    if (font_subset->to_unicode != NULL) {
+	job.subset.to_unicode = _cairo_malloc_ab (num_glyphs,
+						  sizeof (unsigned long));
+	if (job.subset.to_unicode != NULL) {
+	    memcpy (job.subset.to_unicode, font_subset->to_unicode,
+		    num_glyphs * sizeof (unsigned long));
+	}
+    }
+
+    status = _cairo_array_append (&jobs->jobs, &job);
+    if (unlikely (status))
+	goto FAIL;
+
+    return CAIRO_STATUS_SUCCESS;
+
+  FAIL:
+    _cairo_sub_font_job_fini (&job, jobs->destroy_func);
+    return status;
+}
+
+static cairo_status_t
+_cairo_sub_font_run_job (void *closure, int i)
+{
+    cairo_sub_font_jobs_t *jobs = closure;
+    cairo_sub_font_job_t *job = _cairo_array_index (&jobs->jobs, i);
+
+    /* Errors are reported in subset order once every job is done. */
+    job->status = jobs->prepare_func (&job->subset,
+				      jobs->closure,
+				      &job->prepared);
+
+    return CAIRO_STATUS_SUCCESS;
+}
+
+cairo_status_t
+_cairo_scaled_font_subsets_foreach_unscaled_parallel (cairo_scaled_font_subsets_t		   *font_subsets,
+						      cairo_scaled_font_subset_prepare_func_t	    prepare_func,
+						      cairo_scaled_font_subset_emit_func_t	    emit_func,
+						      cairo_destroy_func_t			    destroy_func,
+						      void					   *closure)
+{
+    cairo_sub_font_jobs_t jobs;
+    cairo_sub_font_job_t *job;
+    int num_threads, num_jobs, i;
+    cairo_status_t status;
+
+    jobs.prepare_func = prepare_func;
+    jobs.emit_func = emit_func;
+    jobs.destroy_func = destroy_func;
+    jobs.closure = closure;
+
+    num_threads = _cairo_parallel_num_threads ();
+    if (num_threads <= 1) {
+	return _cairo_scaled_font_subsets_foreach_internal (font_subsets,
+							    _cairo_sub_font_prepare_and_emit,
+							    &jobs,
+							    CAIRO_SUBSETS_FOREACH_UNSCALED);
+    }
+
+    _cairo_array_init (&jobs.jobs, sizeof (cairo_sub_font_job_t));
+    status = _cairo_scaled_font_subsets_foreach_internal (font_subsets,
+							  _cairo_sub_font_queue_job,
+							  &jobs,
+							  CAIRO_SUBSETS_FOREACH_UNSCALED);
+
+    num_jobs = _cairo_array_num_elements (&jobs.jobs);
+    if (status == CAIRO_STATUS_SUCCESS && num_jobs > 0) {
+	status = _cairo_parallel_for (num_jobs, MIN (num_threads, num_jobs),
+				      _cairo_sub_font_run_job, &jobs);
+    }
+
+    for (i = 0; i < num_jobs && status == CAIRO_STATUS_SUCCESS; i++) {
+	job = _cairo_array_index (&jobs.jobs, i);
+	status = job->status;
+	if (status == CAIRO_STATUS_SUCCESS)
+	    status = emit_func (&job->subset, job->prepared, closure);
+    }
+
+    for (i = 0; i < num_jobs; i++)
+	_cairo_sub_font_job_fini (_cairo_array_index (&jobs.jobs, i), destroy_func);
+    _cairo_array_fini (&jobs.jobs);
+
+    return status;
+}
+
 static cairo_bool_t
 _cairo_string_equal (const void *key_a, const void *key_b)
 {
@@ -335,6 +335,7 @@ _filter_to_string (cairo_filter_t filter)
 	"FILTER_NEAREST",	/* CAIRO_FILTER_NEAREST */
 	"FILTER_BILINEAR",	/* CAIRO_FILTER_BILINEAR */
 	"FILTER_GAUSSIAN",	/* CAIRO_FILTER_GAUSSIAN */
+	"FILTER_MIPMAP",	/* CAIRO_FILTER_MIPMAP */
     };
     assert (filter < ARRAY_LENGTH (names));
     return names[filter];
@@ -358,7 +359,8 @@ _antialias_to_string (cairo_antialias_t antialias)
 	"ANTIALIAS_DEFAULT",	/* CAIRO_ANTIALIAS_DEFAULT */
 	"ANTIALIAS_NONE",	/* CAIRO_ANTIALIAS_NONE */
 	"ANTIALIAS_GRAY",	/* CAIRO_ANTIALIAS_GRAY */
-	"ANTIALIAS_SUBPIXEL"	/* CAIRO_ANTIALIAS_SUBPIXEL */
+	"ANTIALIAS_SUBPIXEL",	/* CAIRO_ANTIALIAS_SUBPIXEL */
+	"ANTIALIAS_FAST"	/* CAIRO_ANTIALIAS_FAST */
     };
     assert (antialias < ARRAY_LENGTH (names));
     return names[antialias];
@@ -1420,7 +1422,7 @@ _emit_surface_pattern (cairo_script_surface_t *surface,
     source = surface_pattern->surface;
 
     if (source->backend->type == CAIRO_INTERNAL_SURFACE_TYPE_SNAPSHOT)
-	source = ((cairo_surface_snapshot_t *) source)->target;
+	source = _cairo_surface_snapshot_get_target (source);
 
     switch ((int) source->backend->type) {
     case CAIRO_SURFACE_TYPE_RECORDING:
@@ -383,6 +383,7 @@ pattern_filter_to_sk (const cairo_pattern_t *pattern)
 {
     switch (pattern->filter) {
     case CAIRO_FILTER_GOOD:
+    case CAIRO_FILTER_MIPMAP:
     case CAIRO_FILTER_BEST:
     case CAIRO_FILTER_BILINEAR:
     case CAIRO_FILTER_GAUSSIAN:
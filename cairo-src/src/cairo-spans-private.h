@@ -151,6 +151,32 @@ _cairo_botor_scan_converter_init (cairo_botor_scan_converter_t *self,
 				  const cairo_box_t *extents,
 				  cairo_fill_rule_t fill_rule);
 
+typedef struct _cairo_hairline_scan_converter {
+    cairo_scan_converter_t base;
+
+    int xmin, xmax;
+    int ymin, ymax;
+
+    struct _cairo_hairline_scan_converter_chunk {
+	struct _cairo_hairline_scan_converter_chunk *next;
+	void *base;
+	int count;
+	int size;
+    } chunks, *tail;
+    char buf[CAIRO_STACK_BUFFER_SIZE];
+    int num_lines;
+} cairo_hairline_scan_converter_t;
+
+cairo_private void
+_cairo_hairline_scan_converter_init (cairo_hairline_scan_converter_t *self,
+				     const cairo_rectangle_int_t *extents);
+
+cairo_private cairo_status_t
+_cairo_hairline_scan_converter_add_line (cairo_hairline_scan_converter_t *self,
+					 double x1, double y1,
+					 double x2, double y2,
+					 double width);
+
 /* cairo-spans.c: */
 
 cairo_private cairo_scan_converter_t *
@@ -216,6 +216,144 @@ _cairo_spline_decompose (cairo_spline_t *spline, double tolerance)
     return _cairo_spline_add_point (spline, &spline->knots.d);
 }
 
+/* The most segments we are prepared to flatten a single spline into.
+ * The forward differences below are kept exact by scaling every term
+ * by n³, which must therefore fit in 32 bits. */
+#define CAIRO_SPLINE_MAX_SEGMENTS 1024
+
+/* Return the number of uniform steps in t required to approximate the
+ * spline to within tolerance.
+ *
+ * The bound (due to Wang) follows from the maximum of the second
+ * derivative of the spline, which is itself bounded by the second
+ * differences of the control polygon:
+ *
+ *   n = ⌈√(3/4 · max(‖a - 2b + c‖, ‖b - 2c + d‖) / tolerance)⌉
+ *
+ * As the count is computed once per spline, the flattening error need
+ * not be reevaluated for every segment as with recursive subdivision.
+ */
+static int
+_cairo_spline_num_segments (const cairo_spline_knots_t *knots,
+			    double tolerance)
+{
+    double dx, dy, l1, l2;
+    double n;
+
+    dx = _cairo_fixed_to_double (knots->a.x - 2 * knots->b.x + knots->c.x);
+    dy = _cairo_fixed_to_double (knots->a.y - 2 * knots->b.y + knots->c.y);
+    l1 = dx * dx + dy * dy;
+
+    dx = _cairo_fixed_to_double (knots->b.x - 2 * knots->c.x + knots->d.x);
+    dy = _cairo_fixed_to_double (knots->b.y - 2 * knots->c.y + knots->d.y);
+    l2 = dx * dx + dy * dy;
+
+    n = ceil (sqrt (.75 * sqrt (MAX (l1, l2)) / tolerance));
+    if (! (n < CAIRO_SPLINE_MAX_SEGMENTS)) /* also catches NaN */
+	return CAIRO_SPLINE_MAX_SEGMENTS;
+
+    return n < 1 ? 1 : n;
+}
+
+/* Evaluates one coordinate of the spline at n evenly spaced steps using
+ * forward differencing.
+ *
+ * Writing the spline relative to its first knot as
+ *
+ *   P(t) = At³ + Bt² + Ct
+ *
+ * with A = -a + 3b - 3c + d, B = 3a - 6b + 3c and C = 3b - 3a, the
+ * value n³·P(i/n) is an integer cubic in i whose forward differences
+ * are exactly representable.  Stepping through them then needs only
+ * additions, with a single rounding division per point and no error
+ * accumulated along the curve.
+ */
+typedef struct _cairo_spline_stepper {
+    cairo_int64_t v, d1, d2, d3;
+} cairo_spline_stepper_t;
+
+static void
+_cairo_spline_stepper_init (cairo_spline_stepper_t *s,
+			    cairo_fixed_t a, cairo_fixed_t b,
+			    cairo_fixed_t c, cairo_fixed_t d,
+			    int n)
+{
+    cairo_int64_t A, B, C;
+
+    A = _cairo_int64_sub (_cairo_int32_to_int64 (d - a),
+			  _cairo_int32x32_64_mul (3, c - b));
+    B = _cairo_int32x32_64_mul (3, (c - b) - (b - a));
+    C = _cairo_int32x32_64_mul (3, b - a);
+
+    s->v = _cairo_int32_to_int64 (0);
+    /* d1 = A + Bn + Cn² */
+    s->d1 = _cairo_int64_add (A,
+			      _cairo_int64_mul (_cairo_int64_add (B,
+								  _cairo_int64_mul (C, _cairo_int32_to_int64 (n))),
+						_cairo_int32_to_int64 (n)));
+    /* d2 = 6A + 2Bn */
+    s->d3 = _cairo_int64_mul (A, _cairo_int32_to_int64 (6));
+    s->d2 = _cairo_int64_add (s->d3,
+			      _cairo_int64_mul (B, _cairo_int32_to_int64 (2 * n)));
+}
+
+static inline cairo_fixed_t
+_cairo_spline_stepper_next (cairo_spline_stepper_t *s, int n3)
+{
+    cairo_int64_t v;
+
+    s->v  = _cairo_int64_add (s->v,  s->d1);
+    s->d1 = _cairo_int64_add (s->d1, s->d2);
+    s->d2 = _cairo_int64_add (s->d2, s->d3);
+
+    /* round to nearest, away from zero on ties */
+    if (_cairo_int64_negative (s->v))
+	v = _cairo_int64_sub (s->v, _cairo_int32_to_int64 (n3 >> 1));
+    else
+	v = _cairo_int64_add (s->v, _cairo_int32_to_int64 (n3 >> 1));
+    return _cairo_int64_32_div (v, n3);
+}
+
+/* An alternative to _cairo_spline_decompose() which trades the adaptive
+ * subdivision for uniform steps in t.  The resulting polyline stays within
+ * tolerance of the curve, but uses slightly different (and sometimes more)
+ * vertices than the recursive decomposition. */
+cairo_status_t
+_cairo_spline_decompose_uniform (cairo_spline_t *spline, double tolerance)
+{
+    cairo_spline_knots_t *knots = &spline->knots;
+    cairo_spline_stepper_t x, y;
+    cairo_status_t status;
+    int n, n3, i;
+
+    spline->last_point = knots->a;
+
+    n = _cairo_spline_num_segments (knots, tolerance);
+    if (n > 1) {
+	n3 = n * n * n;
+	_cairo_spline_stepper_init (&x,
+				    knots->a.x, knots->b.x,
+				    knots->c.x, knots->d.x,
+				    n);
+	_cairo_spline_stepper_init (&y,
+				    knots->a.y, knots->b.y,
+				    knots->c.y, knots->d.y,
+				    n);
+
+	for (i = 1; i < n; i++) {
+	    cairo_point_t p;
+
+	    p.x = knots->a.x + _cairo_spline_stepper_next (&x, n3);
+	    p.y = knots->a.y + _cairo_spline_stepper_next (&y, n3);
+	    status = _cairo_spline_add_point (spline, &p);
+	    if (unlikely (status))
+		return status;
+	}
+    }
+
+    return _cairo_spline_add_point (spline, &knots->d);
+}
+
 /* Note: this function is only good for computing bounds in device space. */
 cairo_status_t
 _cairo_spline_bound (cairo_spline_add_point_func_t add_point_func,
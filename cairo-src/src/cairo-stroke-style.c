@@ -122,6 +122,19 @@ _cairo_stroke_style_max_distance_from_path (const cairo_stroke_style_t *style,
     *dy = style_expansion * hypot (ctm->yy, ctm->yx);
 }
 
+/*
+ * A hairline is a stroke no wider than a single device pixel in any
+ * direction, for which the joins are not visible and the stroke may be
+ * rendered as a set of thin lines rather than as a filled outline.
+ */
+cairo_bool_t
+_cairo_stroke_style_is_hairline (const cairo_stroke_style_t *style,
+				 const cairo_matrix_t *ctm)
+{
+    return _cairo_matrix_transformed_circle_major_axis (ctm,
+							style->line_width) <= 1.0;
+}
+
 /*
  * Computes the period of a dashed stroke style.
  * Returns 0 for non-dashed styles.
@@ -38,11 +38,24 @@
 
 #include "cairo-surface-private.h"
 
+typedef struct _cairo_surface_snapshot_tile cairo_surface_snapshot_tile_t;
+
 struct _cairo_surface_snapshot {
     cairo_surface_t base;
 
     cairo_surface_t *target;
     cairo_surface_t *clone;
+
+    /* The original contents of those tiles of an image target which
+     * have since been drawn over, or NULL if none have been. */
+    cairo_surface_snapshot_tile_t **tiles;
 };
 
+cairo_private cairo_bool_t
+_cairo_surface_snapshot_preserve (cairo_surface_t *surface,
+				  const cairo_rectangle_int_t *extents);
+
+cairo_private cairo_surface_t *
+_cairo_surface_snapshot_get_target (cairo_surface_t *surface);
+
 #endif /* CAIRO_SURFACE_SNAPSHOT_PRIVATE_H */
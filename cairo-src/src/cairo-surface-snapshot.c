@@ -42,6 +42,222 @@
 #include "cairo-error-private.h"
 #include "cairo-surface-snapshot-private.h"
 
+/* While the snapshot of an image surface is still attached, drawing
+ * to the image first saves the tiles it is about to overwrite, and
+ * the snapshot continues to share the remainder of the image. Only
+ * once the snapshot is read, or the image is modified in some way we
+ * cannot bound, is a complete copy made.
+ */
+#define CAIRO_SURFACE_SNAPSHOT_TILE_SIZE 64
+
+struct _cairo_surface_snapshot_tile {
+    cairo_reference_count_t ref_count;
+    uint8_t data[1];
+};
+
+static const cairo_surface_backend_t _cairo_surface_snapshot_backend;
+
+static int
+_tile_cols (const cairo_image_surface_t *image)
+{
+    return (image->width + CAIRO_SURFACE_SNAPSHOT_TILE_SIZE - 1) /
+	CAIRO_SURFACE_SNAPSHOT_TILE_SIZE;
+}
+
+static int
+_tile_rows (const cairo_image_surface_t *image)
+{
+    return (image->height + CAIRO_SURFACE_SNAPSHOT_TILE_SIZE - 1) /
+	CAIRO_SURFACE_SNAPSHOT_TILE_SIZE;
+}
+
+/* Locates tile (@tx, @ty) within an image of the same size and
+ * format as @image. */
+static void
+_tile_geometry (const cairo_image_surface_t *image,
+		int tx, int ty,
+		int *offset, int *row_bytes, int *height)
+{
+    int bpp = PIXMAN_FORMAT_BPP (image->pixman_format);
+    int x = tx * CAIRO_SURFACE_SNAPSHOT_TILE_SIZE;
+    int y = ty * CAIRO_SURFACE_SNAPSHOT_TILE_SIZE;
+
+    *offset = x * bpp / 8;
+    *row_bytes = (MIN (CAIRO_SURFACE_SNAPSHOT_TILE_SIZE, image->width - x) * bpp + 7) / 8;
+    *height = MIN (CAIRO_SURFACE_SNAPSHOT_TILE_SIZE, image->height - y);
+}
+
+static cairo_surface_snapshot_tile_t *
+_cairo_surface_snapshot_tile_create (const cairo_image_surface_t *image,
+				     int tx, int ty)
+{
+    cairo_surface_snapshot_tile_t *tile;
+    const uint8_t *src;
+    uint8_t *dst;
+    int offset, row_bytes, height;
+
+    _tile_geometry (image, tx, ty, &offset, &row_bytes, &height);
+
+    tile = malloc (sizeof (cairo_surface_snapshot_tile_t) + row_bytes * height);
+    if (unlikely (tile == NULL))
+	return NULL;
+
+    CAIRO_REFERENCE_COUNT_INIT (&tile->ref_count, 1);
+
+    src = image->data + ty * CAIRO_SURFACE_SNAPSHOT_TILE_SIZE * image->stride + offset;
+    dst = tile->data;
+    while (height--) {
+	memcpy (dst, src, row_bytes);
+	src += image->stride;
+	dst += row_bytes;
+    }
+
+    return tile;
+}
+
+static void
+_cairo_surface_snapshot_tile_destroy (cairo_surface_snapshot_tile_t *tile)
+{
+    if (_cairo_reference_count_dec_and_test (&tile->ref_count))
+	free (tile);
+}
+
+static void
+_cairo_surface_snapshot_drop_tiles (cairo_surface_snapshot_t *snapshot,
+				    int num_tiles)
+{
+    int i;
+
+    if (snapshot->tiles == NULL)
+	return;
+
+    for (i = 0; i < num_tiles; i++) {
+	if (snapshot->tiles[i] != NULL)
+	    _cairo_surface_snapshot_tile_destroy (snapshot->tiles[i]);
+    }
+
+    free (snapshot->tiles);
+    snapshot->tiles = NULL;
+}
+
+/* Writes the saved tiles back over @clone, a copy of the image target. */
+static void
+_cairo_surface_snapshot_restore_tiles (cairo_surface_snapshot_t *snapshot,
+				       cairo_image_surface_t *clone)
+{
+    int cols = _tile_cols (clone), rows = _tile_rows (clone);
+    int tx, ty;
+
+    for (ty = 0; ty < rows; ty++) {
+	for (tx = 0; tx < cols; tx++) {
+	    cairo_surface_snapshot_tile_t *tile = snapshot->tiles[ty * cols + tx];
+	    const uint8_t *src;
+	    uint8_t *dst;
+	    int offset, row_bytes, height;
+
+	    if (tile == NULL)
+		continue;
+
+	    _tile_geometry (clone, tx, ty, &offset, &row_bytes, &height);
+
+	    src = tile->data;
+	    dst = clone->data + ty * CAIRO_SURFACE_SNAPSHOT_TILE_SIZE * clone->stride + offset;
+	    while (height--) {
+		memcpy (dst, src, row_bytes);
+		src += row_bytes;
+		dst += clone->stride;
+	    }
+	}
+    }
+}
+
+/**
+ * _cairo_surface_snapshot_preserve:
+ * @surface: a snapshot attached to an image surface
+ * @extents: the area of the image about to be drawn to
+ *
+ * Saves the original contents of the tiles of @extents not saved
+ * previously, so that @surface may remain attached to its target
+ * across the modification. Successive snapshots of the same image
+ * share the saved tiles.
+ *
+ * Return value: %FALSE if @surface needs to be detached instead.
+ **/
+cairo_bool_t
+_cairo_surface_snapshot_preserve (cairo_surface_t *surface,
+				  const cairo_rectangle_int_t *extents)
+{
+    cairo_surface_snapshot_t *snapshot = (cairo_surface_snapshot_t *) surface;
+    cairo_surface_snapshot_t *newer = NULL;
+    cairo_image_surface_t *image;
+    cairo_rectangle_int_t rect;
+    int cols, x1, y1, x2, y2, tx, ty;
+
+    if (surface->backend != &_cairo_surface_snapshot_backend)
+	return FALSE;
+
+    if (! _cairo_surface_is_image (snapshot->target))
+	return FALSE;
+
+    /* Only the image itself holds onto the snapshot, so it can
+     * simply be discarded. */
+    if (CAIRO_REFERENCE_COUNT_GET_VALUE (&surface->ref_count) == 1)
+	return FALSE;
+
+    image = (cairo_image_surface_t *) snapshot->target;
+    rect.x = rect.y = 0;
+    rect.width  = image->width;
+    rect.height = image->height;
+    if (! _cairo_rectangle_intersect (&rect, extents))
+	return TRUE;
+
+    cols = _tile_cols (image);
+    if (snapshot->tiles == NULL) {
+	snapshot->tiles = calloc (cols * _tile_rows (image),
+				  sizeof (cairo_surface_snapshot_tile_t *));
+	if (unlikely (snapshot->tiles == NULL))
+	    return FALSE;
+    }
+
+    /* Snapshots are listed newest first and are all preserved in
+     * turn. Any tile we lack must also have been missing from a newer
+     * snapshot, so if that has it now, it saved it just before us. */
+    if (surface->snapshot.prev != &image->base.snapshots) {
+	cairo_surface_t *prev;
+
+	prev = cairo_list_entry (surface->snapshot.prev, cairo_surface_t, snapshot);
+	if (prev->backend == &_cairo_surface_snapshot_backend)
+	    newer = (cairo_surface_snapshot_t *) prev;
+	if (newer != NULL && newer->tiles == NULL)
+	    newer = NULL;
+    }
+
+    x1 = rect.x / CAIRO_SURFACE_SNAPSHOT_TILE_SIZE;
+    y1 = rect.y / CAIRO_SURFACE_SNAPSHOT_TILE_SIZE;
+    x2 = (rect.x + rect.width  - 1) / CAIRO_SURFACE_SNAPSHOT_TILE_SIZE;
+    y2 = (rect.y + rect.height - 1) / CAIRO_SURFACE_SNAPSHOT_TILE_SIZE;
+    for (ty = y1; ty <= y2; ty++) {
+	for (tx = x1; tx <= x2; tx++) {
+	    int i = ty * cols + tx;
+
+	    if (snapshot->tiles[i] != NULL)
+		continue;
+
+	    if (newer != NULL && newer->tiles[i] != NULL) {
+		snapshot->tiles[i] = newer->tiles[i];
+		_cairo_reference_count_inc (&snapshot->tiles[i]->ref_count);
+		continue;
+	    }
+
+	    snapshot->tiles[i] = _cairo_surface_snapshot_tile_create (image, tx, ty);
+	    if (unlikely (snapshot->tiles[i] == NULL))
+		return FALSE;
+	}
+    }
+
+    return TRUE;
+}
+
 static cairo_status_t
 _cairo_surface_snapshot_finish (void *abstract_surface)
 {
@@ -63,9 +279,8 @@ _cairo_surface_snapshot_acquire_source_image (void                    *abstract_
 					      cairo_image_surface_t  **image_out,
 					      void                   **extra_out)
 {
-    cairo_surface_snapshot_t *surface = abstract_surface;
-
-    return _cairo_surface_acquire_source_image (surface->target, image_out, extra_out);
+    return _cairo_surface_acquire_source_image (_cairo_surface_snapshot_get_target (abstract_surface),
+						image_out, extra_out);
 }
 
 static void
@@ -116,6 +331,16 @@ _cairo_surface_snapshot_copy_on_write (cairo_surface_t *surface)
     void *extra;
     cairo_status_t status;
 
+    /* Nobody is left to read the snapshot; it is about to be destroyed. */
+    if (CAIRO_REFERENCE_COUNT_GET_VALUE (&surface->ref_count) == 1) {
+	if (snapshot->tiles != NULL) {
+	    image = (cairo_image_surface_t *) snapshot->target;
+	    _cairo_surface_snapshot_drop_tiles (snapshot,
+						_tile_cols (image) * _tile_rows (image));
+	}
+	return;
+    }
+
     /* We need to make an image copy of the original surface since the
      * snapshot may exceed the lifetime of the original device, i.e.
      * when we later need to use the snapshot the data may have already
@@ -124,6 +349,11 @@ _cairo_surface_snapshot_copy_on_write (cairo_surface_t *surface)
 
     status = _cairo_surface_acquire_source_image (snapshot->target, &image, &extra);
     if (unlikely (status)) {
+	if (snapshot->tiles != NULL) {
+	    image = (cairo_image_surface_t *) snapshot->target;
+	    _cairo_surface_snapshot_drop_tiles (snapshot,
+						_tile_cols (image) * _tile_rows (image));
+	}
 	snapshot->target = _cairo_surface_create_in_error (status);
 	status = _cairo_surface_set_error (surface, status);
 	return;
@@ -148,17 +378,46 @@ _cairo_surface_snapshot_copy_on_write (cairo_surface_t *surface)
 	}
 	clone->base.is_clear = FALSE;
 
+	/* Put back what has been drawn over since the snapshot. */
+	if (snapshot->tiles != NULL)
+	    _cairo_surface_snapshot_restore_tiles (snapshot, clone);
+
 	snapshot->clone = &clone->base;
     } else {
 	snapshot->clone = &clone->base;
 	status = _cairo_surface_set_error (surface, clone->base.status);
     }
 
+    if (snapshot->tiles != NULL)
+	_cairo_surface_snapshot_drop_tiles (snapshot,
+					    _tile_cols (image) * _tile_rows (image));
+
     _cairo_surface_release_source_image (snapshot->target, image, extra);
     snapshot->target = snapshot->clone;
     snapshot->base.type = snapshot->target->type;
 }
 
+/**
+ * _cairo_surface_snapshot_get_target:
+ * @surface: a snapshot surface
+ *
+ * Returns the surface holding the contents of the snapshot. If the
+ * original surface has been partially drawn over since, the snapshot
+ * is first detached from it, leaving it with a complete copy.
+ *
+ * Return value: the target of the snapshot; a borrowed reference.
+ **/
+cairo_surface_t *
+_cairo_surface_snapshot_get_target (cairo_surface_t *surface)
+{
+    cairo_surface_snapshot_t *snapshot = (cairo_surface_snapshot_t *) surface;
+
+    if (snapshot->tiles != NULL && surface->snapshot_of != NULL)
+	_cairo_surface_detach_snapshot (surface);
+
+    return snapshot->target;
+}
+
 /**
  * _cairo_surface_snapshot
  * @surface: a #cairo_surface_t
@@ -220,9 +479,10 @@ _cairo_surface_snapshot (cairo_surface_t *surface)
 	}
     }
 
+    /* A snapshot which has saved any tiles is out of date. */
     snapshot = (cairo_surface_snapshot_t *)
 	_cairo_surface_has_snapshot (surface, &_cairo_surface_snapshot_backend);
-    if (snapshot != NULL)
+    if (snapshot != NULL && snapshot->tiles == NULL)
 	return cairo_surface_reference (&snapshot->base);
 
     snapshot = malloc (sizeof (cairo_surface_snapshot_t));
@@ -237,6 +497,7 @@ _cairo_surface_snapshot (cairo_surface_t *surface)
 
     snapshot->target = surface;
     snapshot->clone = NULL;
+    snapshot->tiles = NULL;
 
     status = _cairo_surface_copy_mime_data (&snapshot->base, surface);
     if (unlikely (status)) {
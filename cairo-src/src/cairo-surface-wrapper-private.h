@@ -48,6 +48,9 @@ struct _cairo_surface_wrapper {
 
     cairo_bool_t has_extents;
     cairo_rectangle_int_t extents;
+
+    cairo_bool_t has_clip_extents;
+    cairo_rectangle_int_t clip_extents;
 };
 
 cairo_private void
@@ -58,6 +61,10 @@ cairo_private void
 _cairo_surface_wrapper_set_extents (cairo_surface_wrapper_t *wrapper,
 				    const cairo_rectangle_int_t *extents);
 
+cairo_private void
+_cairo_surface_wrapper_set_clip_extents (cairo_surface_wrapper_t *wrapper,
+					 const cairo_rectangle_int_t *extents);
+
 cairo_private void
 _cairo_surface_wrapper_fini (cairo_surface_wrapper_t *wrapper);
 
@@ -147,6 +154,10 @@ cairo_private cairo_bool_t
 _cairo_surface_wrapper_get_extents (cairo_surface_wrapper_t *wrapper,
 				    cairo_rectangle_int_t   *extents);
 
+cairo_private cairo_bool_t
+_cairo_surface_wrapper_get_target_extents (cairo_surface_wrapper_t *wrapper,
+					   cairo_rectangle_int_t   *extents);
+
 cairo_private void
 _cairo_surface_wrapper_get_font_options (cairo_surface_wrapper_t    *wrapper,
 					 cairo_font_options_t	    *options);
@@ -77,6 +77,38 @@ _cairo_surface_wrapper_needs_extents_transform (cairo_surface_wrapper_t *wrapper
     return wrapper->has_extents && (wrapper->extents.x | wrapper->extents.y);
 }
 
+/* Restricts the device space clip of an operation to the clip extents
+ * of the wrapper, copying @clip into @clip_copy if it is still shared.
+ * The path added for the extents is marked as a band, so that the
+ * backend renders the rows it cuts as it would without it. */
+static cairo_status_t
+_cairo_surface_wrapper_clip_to_extents (cairo_surface_wrapper_t *wrapper,
+					cairo_clip_t		*clip,
+					cairo_clip_t		*clip_copy,
+					cairo_clip_t	       **dev_clip)
+{
+    cairo_clip_path_t *clip_path;
+    cairo_status_t status;
+
+    if (! wrapper->has_clip_extents)
+	return CAIRO_STATUS_SUCCESS;
+
+    if (*dev_clip == clip) {
+	_cairo_clip_init_copy (clip_copy, clip);
+	*dev_clip = clip_copy;
+    }
+
+    clip_path = (*dev_clip)->path;
+    status = _cairo_clip_rectangle (*dev_clip, &wrapper->clip_extents);
+    if (unlikely (status))
+	return status;
+
+    if ((*dev_clip)->path != NULL && (*dev_clip)->path != clip_path)
+	(*dev_clip)->path->flags |= CAIRO_CLIP_PATH_IS_BAND;
+
+    return CAIRO_STATUS_SUCCESS;
+}
+
 cairo_status_t
 _cairo_surface_wrapper_acquire_source_image (cairo_surface_wrapper_t *wrapper,
 					     cairo_image_surface_t  **image_out,
@@ -153,6 +185,14 @@ _cairo_surface_wrapper_paint (cairo_surface_wrapper_t *wrapper,
 	source = &source_copy.base;
     }
 
+    status = _cairo_surface_wrapper_clip_to_extents (wrapper, clip,
+						     &clip_copy, &dev_clip);
+    if (unlikely (status))
+	goto FINISH;
+
+    if (dev_clip != NULL && dev_clip->all_clipped)
+	goto FINISH;
+
     status = _cairo_surface_paint (wrapper->target, op, source, dev_clip);
 
   FINISH:
@@ -224,6 +264,14 @@ _cairo_surface_wrapper_mask (cairo_surface_wrapper_t *wrapper,
 	mask = &mask_copy.base;
     }
 
+    status = _cairo_surface_wrapper_clip_to_extents (wrapper, clip,
+						     &clip_copy, &dev_clip);
+    if (unlikely (status))
+	goto FINISH;
+
+    if (dev_clip != NULL && dev_clip->all_clipped)
+	goto FINISH;
+
     status = _cairo_surface_mask (wrapper->target, op, source, mask, dev_clip);
 
   FINISH:
@@ -317,6 +365,14 @@ _cairo_surface_wrapper_stroke (cairo_surface_wrapper_t *wrapper,
 	}
     }
 
+    status = _cairo_surface_wrapper_clip_to_extents (wrapper, clip,
+						     &clip_copy, &dev_clip);
+    if (unlikely (status))
+	goto FINISH;
+
+    if (dev_clip != NULL && dev_clip->all_clipped)
+	goto FINISH;
+
     status = _cairo_surface_stroke (wrapper->target, op, source,
 				    dev_path, stroke_style,
 				    &dev_ctm, &dev_ctm_inverse,
@@ -425,6 +481,14 @@ _cairo_surface_wrapper_fill_stroke (cairo_surface_wrapper_t *wrapper,
 	}
     }
 
+    status = _cairo_surface_wrapper_clip_to_extents (wrapper, clip,
+						     &clip_copy, &dev_clip);
+    if (unlikely (status))
+	goto FINISH;
+
+    if (dev_clip != NULL && dev_clip->all_clipped)
+	goto FINISH;
+
     status = _cairo_surface_fill_stroke (wrapper->target,
 					 fill_op, fill_source, fill_rule,
 					 fill_tolerance, fill_antialias,
@@ -520,6 +584,14 @@ _cairo_surface_wrapper_fill (cairo_surface_wrapper_t	*wrapper,
 	}
     }
 
+    status = _cairo_surface_wrapper_clip_to_extents (wrapper, clip,
+						     &clip_copy, &dev_clip);
+    if (unlikely (status))
+	goto FINISH;
+
+    if (dev_clip != NULL && dev_clip->all_clipped)
+	goto FINISH;
+
     status = _cairo_surface_fill (wrapper->target, op, source,
 				  dev_path, fill_rule,
 				  tolerance, antialias,
@@ -622,6 +694,14 @@ _cairo_surface_wrapper_show_text_glyphs (cairo_surface_wrapper_t *wrapper,
 	}
     }
 
+    status = _cairo_surface_wrapper_clip_to_extents (wrapper, clip,
+						     &clip_copy, &dev_clip);
+    if (unlikely (status))
+	goto FINISH;
+
+    if (dev_clip != NULL && dev_clip->all_clipped)
+	goto FINISH;
+
     status = _cairo_surface_show_text_glyphs (wrapper->target, op, source,
 					      utf8, utf8_len,
 					      dev_glyphs, num_glyphs,
@@ -666,6 +746,89 @@ _cairo_surface_wrapper_get_extents (cairo_surface_wrapper_t *wrapper,
     }
 }
 
+/* Returns the area of the target that may be modified by the wrapper,
+ * transformed back into the coordinate space of the wrapped operations.
+ */
+cairo_bool_t
+_cairo_surface_wrapper_get_target_extents (cairo_surface_wrapper_t *wrapper,
+					   cairo_rectangle_int_t   *extents)
+{
+    cairo_rectangle_int_t target;
+
+    if (! _cairo_surface_get_extents (wrapper->target, &target)) {
+	if (! wrapper->has_extents)
+	    return FALSE;
+
+	*extents = wrapper->extents;
+	return TRUE;
+    }
+
+    if (wrapper->has_clip_extents &&
+	! _cairo_rectangle_intersect (&target, &wrapper->clip_extents))
+    {
+	extents->x = extents->y = 0;
+	extents->width = extents->height = 0;
+	return TRUE;
+    }
+
+    if (_cairo_surface_wrapper_needs_device_transform (wrapper) ||
+	_cairo_surface_wrapper_needs_extents_transform (wrapper))
+    {
+	cairo_matrix_t m;
+	cairo_status_t status;
+	double x1, y1, x2, y2;
+
+	cairo_matrix_init_identity (&m);
+
+	if (_cairo_surface_wrapper_needs_extents_transform (wrapper))
+	    cairo_matrix_translate (&m, -wrapper->extents.x, -wrapper->extents.y);
+
+	if (_cairo_surface_wrapper_needs_device_transform (wrapper))
+	    cairo_matrix_multiply (&m, &wrapper->target->device_transform, &m);
+
+	status = cairo_matrix_invert (&m);
+	assert (status == CAIRO_STATUS_SUCCESS);
+
+	x1 = target.x;
+	y1 = target.y;
+	x2 = target.x + (double) target.width;
+	y2 = target.y + (double) target.height;
+	_cairo_matrix_transform_bounding_box (&m, &x1, &y1, &x2, &y2, NULL);
+
+	x1 = floor (x1);
+	y1 = floor (y1);
+	x2 = ceil (x2);
+	y2 = ceil (y2);
+	if (x1 < CAIRO_RECT_INT_MIN || y1 < CAIRO_RECT_INT_MIN ||
+	    x2 > CAIRO_RECT_INT_MAX || y2 > CAIRO_RECT_INT_MAX)
+	{
+	    if (! wrapper->has_extents)
+		return FALSE;
+
+	    *extents = wrapper->extents;
+	    return TRUE;
+	}
+
+	target.x = x1;
+	target.y = y1;
+	target.width  = x2 - x1;
+	target.height = y2 - y1;
+    }
+
+    if (wrapper->has_extents &&
+	! _cairo_rectangle_intersect (&target, &wrapper->extents))
+    {
+	/* No part of the target lies within the wrapper's extents, so
+	 * nothing may be modified: report the (now empty) area. */
+	extents->x = extents->y = 0;
+	extents->width = extents->height = 0;
+	return TRUE;
+    }
+
+    *extents = target;
+    return TRUE;
+}
+
 void
 _cairo_surface_wrapper_set_extents (cairo_surface_wrapper_t *wrapper,
 				    const cairo_rectangle_int_t *extents)
@@ -678,6 +841,21 @@ _cairo_surface_wrapper_set_extents (cairo_surface_wrapper_t *wrapper,
     }
 }
 
+/* Restricts all operations to @extents, given in the device space of
+ * the target: unlike the wrapper's extents, these are not used to
+ * translate the operations. */
+void
+_cairo_surface_wrapper_set_clip_extents (cairo_surface_wrapper_t *wrapper,
+					 const cairo_rectangle_int_t *extents)
+{
+    if (extents != NULL) {
+	wrapper->clip_extents = *extents;
+	wrapper->has_clip_extents = TRUE;
+    } else {
+	wrapper->has_clip_extents = FALSE;
+    }
+}
+
 void
 _cairo_surface_wrapper_get_font_options (cairo_surface_wrapper_t    *wrapper,
 					 cairo_font_options_t	    *options)
@@ -703,6 +881,7 @@ _cairo_surface_wrapper_init (cairo_surface_wrapper_t *wrapper,
 {
     wrapper->target = cairo_surface_reference (target);
     wrapper->has_extents = FALSE;
+    wrapper->has_clip_extents = FALSE;
 }
 
 void
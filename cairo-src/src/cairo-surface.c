@@ -44,6 +44,7 @@
 #include "cairo-error-private.h"
 #include "cairo-recording-surface-private.h"
 #include "cairo-region-private.h"
+#include "cairo-surface-snapshot-private.h"
 #include "cairo-tee-surface-private.h"
 
 /**
@@ -389,6 +390,36 @@ _cairo_surface_begin_modification (cairo_surface_t *surface)
     _cairo_surface_detach_mime_data (surface);
 }
 
+/* As _cairo_surface_begin_modification(), for a modification confined
+ * to @extents. Snapshots which are able to save just that part of the
+ * surface remain attached. */
+static void
+_cairo_surface_begin_modification_extents (cairo_surface_t *surface,
+					   const cairo_rectangle_int_t *extents)
+{
+    cairo_surface_t *snapshot, *next;
+
+    assert (surface->status == CAIRO_STATUS_SUCCESS);
+    assert (! surface->finished);
+    assert (surface->snapshot_of == NULL);
+
+    cairo_list_foreach_entry_safe (snapshot, next, cairo_surface_t,
+				   &surface->snapshots, snapshot)
+    {
+	if (! _cairo_surface_snapshot_preserve (snapshot, extents))
+	    _cairo_surface_detach_snapshot (snapshot);
+    }
+
+    _cairo_surface_detach_mime_data (surface);
+}
+
+static void
+_cairo_surface_operation_extents (cairo_surface_t *surface,
+				  cairo_operator_t op,
+				  const cairo_pattern_t *source,
+				  cairo_clip_t *clip,
+				  cairo_rectangle_int_t *extents);
+
 void
 _cairo_surface_init (cairo_surface_t			*surface,
 		     const cairo_surface_backend_t	*backend,
@@ -2016,7 +2047,13 @@ _cairo_surface_paint (cairo_surface_t	*surface,
     if (unlikely (status))
 	return status;
 
-    _cairo_surface_begin_modification (surface);
+    if (_cairo_surface_has_snapshots (surface)) {
+	cairo_rectangle_int_t extents;
+
+	_cairo_surface_operation_extents (surface, op, source, clip, &extents);
+	_cairo_surface_begin_modification_extents (surface, &extents);
+    } else
+	_cairo_surface_begin_modification (surface);
 
     if (surface->backend->paint != NULL) {
 	status = surface->backend->paint (surface, op, source, clip);
@@ -2071,7 +2108,17 @@ _cairo_surface_mask (cairo_surface_t		*surface,
     if (unlikely (status))
 	return status;
 
-    _cairo_surface_begin_modification (surface);
+    if (_cairo_surface_has_snapshots (surface)) {
+	cairo_rectangle_int_t extents;
+
+	status = _cairo_surface_mask_extents (surface, op, source, mask, clip,
+					      &extents);
+	if (unlikely (status))
+	    return _cairo_surface_set_error (surface, status);
+
+	_cairo_surface_begin_modification_extents (surface, &extents);
+    } else
+	_cairo_surface_begin_modification (surface);
 
     if (surface->backend->mask != NULL) {
 	status = surface->backend->mask (surface, op, source, mask, clip);
@@ -2127,12 +2174,14 @@ _cairo_surface_fill_stroke (cairo_surface_t	    *surface,
     if (unlikely (status))
 	return status;
 
-    _cairo_surface_begin_modification (surface);
-
+    /* Otherwise _cairo_surface_fill() and _cairo_surface_stroke()
+     * prepare the surface for modification themselves. */
     if (surface->backend->fill_stroke) {
 	cairo_matrix_t dev_ctm = *stroke_ctm;
 	cairo_matrix_t dev_ctm_inverse = *stroke_ctm_inverse;
 
+	_cairo_surface_begin_modification (surface);
+
 	status = surface->backend->fill_stroke (surface,
 						fill_op, fill_source, fill_rule,
 						fill_tolerance, fill_antialias,
@@ -2199,7 +2248,18 @@ _cairo_surface_stroke (cairo_surface_t		*surface,
     if (unlikely (status))
 	return status;
 
-    _cairo_surface_begin_modification (surface);
+    if (_cairo_surface_has_snapshots (surface)) {
+	cairo_rectangle_int_t extents, path_extents;
+
+	_cairo_surface_operation_extents (surface, op, source, clip, &extents);
+	if (_cairo_operator_bounded_by_mask (op)) {
+	    _cairo_path_fixed_approximate_stroke_extents (path, stroke_style, ctm,
+							  &path_extents);
+	    _cairo_rectangle_intersect (&extents, &path_extents);
+	}
+	_cairo_surface_begin_modification_extents (surface, &extents);
+    } else
+	_cairo_surface_begin_modification (surface);
 
     if (surface->backend->stroke != NULL) {
 	status = surface->backend->stroke (surface, op, source,
@@ -2255,7 +2315,17 @@ _cairo_surface_fill (cairo_surface_t	*surface,
     if (unlikely (status))
 	return status;
 
-    _cairo_surface_begin_modification (surface);
+    if (_cairo_surface_has_snapshots (surface)) {
+	cairo_rectangle_int_t extents, path_extents;
+
+	_cairo_surface_operation_extents (surface, op, source, clip, &extents);
+	if (_cairo_operator_bounded_by_mask (op)) {
+	    _cairo_path_fixed_approximate_fill_extents (path, &path_extents);
+	    _cairo_rectangle_intersect (&extents, &path_extents);
+	}
+	_cairo_surface_begin_modification_extents (surface, &extents);
+    } else
+	_cairo_surface_begin_modification (surface);
 
     if (surface->backend->fill != NULL) {
 	status = surface->backend->fill (surface, op, source,
@@ -2581,7 +2651,23 @@ _cairo_surface_show_text_glyphs (cairo_surface_t	    *surface,
     if (unlikely (status))
 	return status;
 
-    _cairo_surface_begin_modification (surface);
+    if (_cairo_surface_has_snapshots (surface) &&
+	_cairo_matrix_is_integer_translation (&surface->device_transform, NULL, NULL))
+    {
+	cairo_rectangle_int_t extents, glyph_extents;
+
+	_cairo_surface_operation_extents (surface, op, source, clip, &extents);
+	if (_cairo_operator_bounded_by_mask (op) &&
+	    _cairo_scaled_font_glyph_device_extents (scaled_font,
+						     glyphs, num_glyphs,
+						     &glyph_extents,
+						     NULL) == CAIRO_STATUS_SUCCESS)
+	{
+	    _cairo_rectangle_intersect (&extents, &glyph_extents);
+	}
+	_cairo_surface_begin_modification_extents (surface, &extents);
+    } else
+	_cairo_surface_begin_modification (surface);
 
     if (_cairo_surface_has_device_transform (surface) &&
 	! _cairo_matrix_is_integer_translation (&surface->device_transform, NULL, NULL))
@@ -71,8 +71,10 @@
  */
 
 typedef struct cairo_svg_page cairo_svg_page_t;
+typedef struct cairo_svg_def cairo_svg_def_t;
 
-static const int invalid_pattern_id = -1;
+/* Large enough for "glyph%d-%d" */
+#define CAIRO_SVG_ID_LENGTH 32
 
 static const cairo_svg_version_t _cairo_svg_versions[] =
 {
@@ -111,6 +113,14 @@ struct cairo_svg_page {
     cairo_output_stream_t *xml_node;
 };
 
+/* A definition written to the document, keyed by the hash of its
+ * content, so that later identical definitions can refer to it. */
+struct cairo_svg_def {
+    cairo_hash_entry_t base;
+    uint64_t content_hash;
+    char id[CAIRO_SVG_ID_LENGTH];
+};
+
 struct cairo_svg_document {
     cairo_output_stream_t *output_stream;
     unsigned long refcount;
@@ -135,6 +145,13 @@ struct cairo_svg_document {
     cairo_svg_version_t svg_version;
 
     cairo_scaled_font_subsets_t *font_subsets;
+    cairo_array_t num_glyphs_emitted;
+
+    cairo_hash_table_t *defs;
+
+    cairo_bool_t streaming;
+    cairo_bool_t header_emitted;
+    cairo_bool_t page_set_emitted;
 };
 
 static cairo_status_t
@@ -153,8 +170,8 @@ _cairo_svg_document_finish (cairo_svg_document_t *document);
 static cairo_svg_document_t *
 _cairo_svg_document_reference (cairo_svg_document_t *document);
 
-static unsigned int
-_cairo_svg_document_allocate_mask_id (cairo_svg_document_t *document);
+static cairo_status_t
+_cairo_svg_surface_stream_pages (cairo_svg_surface_t *surface);
 
 static cairo_surface_t *
 _cairo_svg_surface_create_for_document (cairo_svg_document_t	*document,
@@ -341,6 +358,38 @@ cairo_svg_surface_restrict_to_version (cairo_surface_t		*abstract_surface,
 	surface->document->svg_version = version;
 }
 
+/**
+ * cairo_svg_surface_set_streaming:
+ * @surface: a SVG #cairo_surface_t
+ * @streaming: whether to write out each page as it is finished
+ *
+ * By default the SVG surface keeps the whole document in memory and
+ * writes it out when the surface is finished. With @streaming set,
+ * the definitions collected so far are written out on each
+ * cairo_show_page(), followed by the page itself, so that memory use
+ * is bounded by the largest page rather than by the whole document.
+ *
+ * Each page then gets its own &lt;defs&gt; element. Documents restricted
+ * to SVG 1.1 can only show their last page, so there streaming only
+ * drops the earlier pages instead of keeping them until the end.
+ *
+ * This function should only be called before any drawing operations
+ * have been performed on the given surface.
+ *
+ * Since: 1.12
+ **/
+void
+cairo_svg_surface_set_streaming (cairo_surface_t	*abstract_surface,
+				 cairo_bool_t		 streaming)
+{
+    cairo_svg_surface_t *surface = NULL; /* hide compiler warning */
+
+    if (! _extract_svg_surface (abstract_surface, &surface))
+	return;
+
+    surface->document->streaming = streaming;
+}
+
 /**
  * cairo_svg_get_versions:
  * @versions: supported version list
@@ -383,6 +432,105 @@ cairo_svg_version_to_string (cairo_svg_version_t version)
     return _cairo_svg_version_strings[version];
 }
 
+static cairo_bool_t
+_cairo_svg_def_equal (const void *key_a, const void *key_b)
+{
+    const cairo_svg_def_t *a = key_a;
+    const cairo_svg_def_t *b = key_b;
+
+    return a->content_hash == b->content_hash;
+}
+
+static void
+_cairo_svg_def_pluck (void *entry, void *closure)
+{
+    cairo_hash_table_t *defs = closure;
+
+    _cairo_hash_table_remove (defs, entry);
+    free (entry);
+}
+
+/* Looks for an earlier definition with @content_hash. If there is one,
+ * its id is returned in @def_id, otherwise @id is recorded for the
+ * hash and returned instead. */
+static cairo_status_t
+_cairo_svg_document_lookup_def (cairo_svg_document_t	 *document,
+				uint64_t		  content_hash,
+				const char		 *id,
+				const char		**def_id)
+{
+    cairo_svg_def_t key, *def;
+    cairo_status_t status;
+
+    key.content_hash = content_hash;
+    key.base.hash = content_hash ^ (content_hash >> 32);
+
+    def = _cairo_hash_table_lookup (document->defs, &key.base);
+    if (def != NULL) {
+	*def_id = def->id;
+	return CAIRO_STATUS_SUCCESS;
+    }
+
+    def = malloc (sizeof (cairo_svg_def_t));
+    if (unlikely (def == NULL))
+	return _cairo_error (CAIRO_STATUS_NO_MEMORY);
+
+    def->base.hash = key.base.hash;
+    def->content_hash = content_hash;
+    strncpy (def->id, id, CAIRO_SVG_ID_LENGTH);
+    def->id[CAIRO_SVG_ID_LENGTH - 1] = '\0';
+
+    status = _cairo_hash_table_insert (document->defs, &def->base);
+    if (unlikely (status)) {
+	free (def);
+	return status;
+    }
+
+    *def_id = id;
+    return CAIRO_STATUS_SUCCESS;
+}
+
+/* Writes the definition held in the memory stream @def, whose opening
+ * tag has no id attribute yet, to @output with the given @id. If an
+ * identical definition was written before, nothing is written and
+ * @def_id is set to the id of that definition instead of @id. @def is
+ * destroyed in either case. */
+static cairo_status_t
+_cairo_svg_document_emit_def (cairo_svg_document_t	*document,
+			      cairo_output_stream_t	*output,
+			      cairo_output_stream_t	*def,
+			      const char		*id,
+			      const char	       **def_id)
+{
+    unsigned char *data;
+    unsigned long length, name_length;
+    cairo_status_t status;
+
+    status = _cairo_memory_stream_destroy (def, &data, &length);
+    if (unlikely (status))
+	return status;
+
+    status = _cairo_svg_document_lookup_def (document,
+					     _cairo_content_hash_bytes (0, data, length),
+					     id, def_id);
+    if (status == CAIRO_STATUS_SUCCESS && *def_id == id) {
+	for (name_length = 0; name_length < length; name_length++) {
+	    if (data[name_length] == ' ' || data[name_length] == '>')
+		break;
+	}
+
+	_cairo_output_stream_write (output, data, name_length);
+	_cairo_output_stream_printf (output, " id=\"%s\"", id);
+	_cairo_output_stream_write (output,
+				    data + name_length,
+				    length - name_length);
+    }
+
+    free (data);
+
+    return status;
+}
+
 static cairo_bool_t
 _cliprect_covers_surface (cairo_svg_surface_t *surface,
 			  cairo_path_fixed_t *path)
@@ -413,6 +561,10 @@ _cairo_svg_surface_clipper_intersect_clip_path (cairo_surface_clipper_t *clipper
 						       cairo_svg_surface_t,
 						       clipper);
     cairo_svg_document_t *document = surface->document;
+    cairo_output_stream_t *def;
+    char id[CAIRO_SVG_ID_LENGTH];
+    const char *def_id;
+    cairo_status_t status;
     unsigned int i;
 
     if (path == NULL) {
@@ -427,24 +579,36 @@ _cairo_svg_surface_clipper_intersect_clip_path (cairo_surface_clipper_t *clipper
     if (_cliprect_covers_surface (surface, path))
 	return CAIRO_STATUS_SUCCESS;
 
-    _cairo_output_stream_printf (document->xml_node_defs,
-				 "<clipPath id=\"clip%d\">\n"
-				 "  <path ",
-				 document->clip_id);
-    _cairo_svg_surface_emit_path (document->xml_node_defs, path, NULL);
+    def = _cairo_memory_stream_create ();
+    status = _cairo_output_stream_get_status (def);
+    if (unlikely (status))
+	return _cairo_output_stream_destroy (def);
 
-    _cairo_output_stream_printf (document->xml_node_defs,
+    _cairo_output_stream_printf (def,
+				 "<clipPath>\n"
+				 "  <path ");
+    _cairo_svg_surface_emit_path (def, path, NULL);
+
+    _cairo_output_stream_printf (def,
 				 "/>\n"
 				 "</clipPath>\n");
 
+    snprintf (id, sizeof id, "clip%d", document->clip_id);
+    status = _cairo_svg_document_emit_def (document, document->xml_node_defs,
+					   def, id, &def_id);
+    if (unlikely (status))
+	return status;
+
+    if (def_id == id)
+	document->clip_id++;
+
     _cairo_output_stream_printf (surface->xml_node,
-				 "<g clip-path=\"url(#clip%d)\" "
+				 "<g clip-path=\"url(#%s)\" "
 				 "clip-rule=\"%s\">\n",
-				 document->clip_id,
+				 def_id,
 				 fill_rule == CAIRO_FILL_RULE_EVEN_ODD ?
 				 "evenodd" : "nonzero");
 
-    document->clip_id++;
     surface->clip_level++;
 
     return CAIRO_STATUS_SUCCESS;
@@ -604,7 +768,7 @@ _cairo_svg_surface_copy_page (void *abstract_surface)
 
     _cairo_memory_stream_copy (page->xml_node, surface->xml_node);
 
-    return CAIRO_STATUS_SUCCESS;
+    return _cairo_svg_surface_stream_pages (surface);
 }
 
 static cairo_int_status_t
@@ -615,7 +779,7 @@ _cairo_svg_surface_show_page (void *abstract_surface)
     if (unlikely (_cairo_svg_surface_store_page (surface) == NULL))
 	return _cairo_error (CAIRO_STATUS_NO_MEMORY);
 
-    return CAIRO_STATUS_SUCCESS;
+    return _cairo_svg_surface_stream_pages (surface);
 }
 
 static void
@@ -737,7 +901,7 @@ _cairo_svg_surface_emit_path (cairo_output_stream_t	*output,
 }
 
 static cairo_int_status_t
-_cairo_svg_document_emit_outline_glyph_data (cairo_svg_document_t	*document,
+_cairo_svg_document_emit_outline_glyph_data (cairo_output_stream_t	*output,
 					     cairo_scaled_font_t	*scaled_font,
 					     unsigned long		 glyph_index)
 {
@@ -752,20 +916,20 @@ _cairo_svg_document_emit_outline_glyph_data (cairo_svg_document_t	*document,
     if (unlikely (status))
 	return status;
 
-    _cairo_output_stream_printf (document->xml_node_glyphs,
+    _cairo_output_stream_printf (output,
 				 "<path style=\"stroke:none;\" ");
 
-    _cairo_svg_surface_emit_path (document->xml_node_glyphs,
+    _cairo_svg_surface_emit_path (output,
 				  scaled_glyph->path, NULL);
 
-    _cairo_output_stream_printf (document->xml_node_glyphs,
+    _cairo_output_stream_printf (output,
 				 "/>\n");
 
     return status;
 }
 
 static cairo_int_status_t
-_cairo_svg_document_emit_bitmap_glyph_data (cairo_svg_document_t	*document,
+_cairo_svg_document_emit_bitmap_glyph_data (cairo_output_stream_t	*output,
 					    cairo_scaled_font_t		*scaled_font,
 					    unsigned long		 glyph_index)
 {
@@ -790,24 +954,24 @@ _cairo_svg_document_emit_bitmap_glyph_data (cairo_svg_document_t	*document,
     if (unlikely (status))
 	return status;
 
-    _cairo_output_stream_printf (document->xml_node_glyphs, "<g");
-    _cairo_svg_surface_emit_transform (document->xml_node_glyphs, " transform",
+    _cairo_output_stream_printf (output, "<g");
+    _cairo_svg_surface_emit_transform (output, " transform",
 				       &image->base.device_transform_inverse, NULL);
-    _cairo_output_stream_printf (document->xml_node_glyphs, ">/n");
+    _cairo_output_stream_printf (output, ">/n");
 
     for (y = 0, row = image->data, rows = image->height; rows; row += image->stride, rows--, y++) {
 	for (x = 0, byte = row, cols = (image->width + 7) / 8; cols; byte++, cols--) {
 	    uint8_t output_byte = CAIRO_BITSWAP8_IF_LITTLE_ENDIAN (*byte);
 	    for (bit = 7; bit >= 0 && x < image->width; bit--, x++) {
 		if (output_byte & (1 << bit)) {
-		    _cairo_output_stream_printf (document->xml_node_glyphs,
+		    _cairo_output_stream_printf (output,
 						 "<rect x=\"%d\" y=\"%d\" width=\"1\" height=\"1\"/>\n",
 						 x, y);
 		}
 	    }
 	}
     }
-    _cairo_output_stream_printf (document->xml_node_glyphs, "</g>\n");
+    _cairo_output_stream_printf (output, "</g>\n");
 
     cairo_surface_destroy (&image->base);
 
@@ -821,24 +985,47 @@ _cairo_svg_document_emit_glyph (cairo_svg_document_t	*document,
 				unsigned int		 font_id,
 				unsigned int		 subset_glyph_index)
 {
+    cairo_output_stream_t   *def;
+    char		     id[CAIRO_SVG_ID_LENGTH];
+    const char		    *def_id;
     cairo_status_t	     status;
 
-    _cairo_output_stream_printf (document->xml_node_glyphs,
-				 "<symbol overflow=\"visible\" id=\"glyph%d-%d\">\n",
-				 font_id,
-				 subset_glyph_index);
+    def = _cairo_memory_stream_create ();
+    status = _cairo_output_stream_get_status (def);
+    if (unlikely (status))
+	return _cairo_output_stream_destroy (def);
+
+    _cairo_output_stream_printf (def, "<symbol overflow=\"visible\">\n");
 
-    status = _cairo_svg_document_emit_outline_glyph_data (document,
+    status = _cairo_svg_document_emit_outline_glyph_data (def,
 							  scaled_font,
 							  scaled_font_glyph_index);
     if (status == CAIRO_INT_STATUS_UNSUPPORTED)
-	status = _cairo_svg_document_emit_bitmap_glyph_data (document,
+	status = _cairo_svg_document_emit_bitmap_glyph_data (def,
 							     scaled_font,
 							     scaled_font_glyph_index);
+    if (unlikely (status)) {
+	cairo_status_t status_ignored = _cairo_output_stream_destroy (def);
+	return status;
+	(void) status_ignored;
+    }
+
+    _cairo_output_stream_printf (def, "</symbol>\n");
+
+    snprintf (id, sizeof id, "glyph%d-%d", font_id, subset_glyph_index);
+    status = _cairo_svg_document_emit_def (document, document->xml_node_glyphs,
+					   def, id, &def_id);
     if (unlikely (status))
 	return status;
 
-    _cairo_output_stream_printf (document->xml_node_glyphs, "</symbol>\n");
+    /* the id is referenced by the pages, so alias identical glyphs */
+    if (def_id != id) {
+	_cairo_output_stream_printf (document->xml_node_glyphs,
+				     "<symbol overflow=\"visible\" id=\"%s\">\n"
+				     "  <use xlink:href=\"#%s\"/>\n"
+				     "</symbol>\n",
+				     id, def_id);
+    }
 
     return CAIRO_STATUS_SUCCESS;
 }
@@ -848,11 +1035,21 @@ _cairo_svg_document_emit_font_subset (cairo_scaled_font_subset_t	*font_subset,
 				      void				*closure)
 {
     cairo_svg_document_t *document = closure;
-    unsigned int i;
+    unsigned int *num_glyphs_emitted;
+    unsigned int i, zero = 0;
     cairo_status_t status = CAIRO_STATUS_SUCCESS;
 
+    /* glyphs already written out by an earlier page are skipped */
+    while (document->num_glyphs_emitted.num_elements <= font_subset->font_id) {
+	status = _cairo_array_append (&document->num_glyphs_emitted, &zero);
+	if (unlikely (status))
+	    return status;
+    }
+    num_glyphs_emitted = _cairo_array_index (&document->num_glyphs_emitted,
+					     font_subset->font_id);
+
     _cairo_scaled_font_freeze_cache (font_subset->scaled_font);
-    for (i = 0; i < font_subset->num_glyphs; i++) {
+    for (i = *num_glyphs_emitted; i < font_subset->num_glyphs; i++) {
 	status = _cairo_svg_document_emit_glyph (document,
 					         font_subset->scaled_font,
 					         font_subset->glyphs[i],
@@ -862,6 +1059,8 @@ _cairo_svg_document_emit_font_subset (cairo_scaled_font_subset_t	*font_subset,
     }
     _cairo_scaled_font_thaw_cache (font_subset->scaled_font);
 
+    *num_glyphs_emitted = i;
+
     return status;
 }
 
@@ -874,17 +1073,11 @@ _cairo_svg_document_emit_font_subsets (cairo_svg_document_t *document)
                                                         _cairo_svg_document_emit_font_subset,
                                                         document);
     if (unlikely (status))
-	goto FAIL;
-
-    status = _cairo_scaled_font_subsets_foreach_user (document->font_subsets,
-						      _cairo_svg_document_emit_font_subset,
-						      document);
-
-  FAIL:
-    _cairo_scaled_font_subsets_destroy (document->font_subsets);
-    document->font_subsets = NULL;
+	return status;
 
-    return status;
+    return _cairo_scaled_font_subsets_foreach_user (document->font_subsets,
+						    _cairo_svg_document_emit_font_subset,
+						    document);
 }
 
 static char const *
@@ -1019,66 +1212,13 @@ _cairo_svg_surface_emit_alpha_filter (cairo_svg_document_t *document)
     document->alpha_filter = TRUE;
 }
 
-typedef struct {
-    cairo_output_stream_t *output;
-    unsigned int in_mem;
-    unsigned int trailing;
-    unsigned char src[3];
-} base64_write_closure_t;
-
-static char const base64_table[64] =
-"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
-
 static cairo_status_t
-base64_write_func (void *closure,
-		   const unsigned char *data,
-		   unsigned int length)
+_cairo_svg_write_func (void *closure,
+		       const unsigned char *data,
+		       unsigned int length)
 {
-    base64_write_closure_t *info = (base64_write_closure_t *) closure;
-    unsigned int i;
-    unsigned char *src;
-
-    src = info->src;
-
-    if (info->in_mem + length < 3) {
-	for (i = 0; i < length; i++) {
-	    src[i + info->in_mem] = *data++;
-	}
-	info->in_mem += length;
-	return CAIRO_STATUS_SUCCESS;
-    }
-
-    do {
-	unsigned char dst[4];
-
-	for (i = info->in_mem; i < 3; i++) {
-	    src[i] = *data++;
-	    length--;
-	}
-	info->in_mem = 0;
-
-	dst[0] = base64_table[src[0] >> 2];
-	dst[1] = base64_table[(src[0] & 0x03) << 4 | src[1] >> 4];
-	dst[2] = base64_table[(src[1] & 0x0f) << 2 | src[2] >> 6];
-	dst[3] = base64_table[src[2] & 0xfc >> 2];
-	/* Special case for the last missing bits */
-	switch (info->trailing) {
-	    case 2:
-		dst[2] = '=';
-	    case 1:
-		dst[3] = '=';
-	    default:
-		break;
-	}
-	_cairo_output_stream_write (info->output, dst, 4);
-    } while (length >= 3);
-
-    for (i = 0; i < length; i++) {
-	src[i] = *data++;
-    }
-    info->in_mem = length;
-
-    return _cairo_output_stream_get_status (info->output);
+    _cairo_output_stream_write (closure, data, length);
+    return _cairo_output_stream_get_status (closure);
 }
 
 static cairo_int_status_t
@@ -1088,7 +1228,7 @@ _cairo_surface_base64_encode_jpeg (cairo_surface_t       *surface,
     const unsigned char *mime_data;
     unsigned long mime_data_length;
     cairo_image_info_t image_info;
-    base64_write_closure_t info;
+    cairo_output_stream_t *base64_stream;
     cairo_status_t status;
 
     cairo_surface_get_mime_data (surface, CAIRO_MIME_TYPE_JPEG,
@@ -1102,22 +1242,10 @@ _cairo_surface_base64_encode_jpeg (cairo_surface_t       *surface,
 
     _cairo_output_stream_printf (output, "data:image/jpeg;base64,");
 
-    info.output = output;
-    info.in_mem = 0;
-    info.trailing = 0;
-
-    status = base64_write_func (&info, mime_data, mime_data_length);
-    if (unlikely (status))
-	return status;
-
-    if (info.in_mem > 0) {
-	memset (info.src + info.in_mem, 0, 3 - info.in_mem);
-	info.trailing = 3 - info.in_mem;
-	info.in_mem = 3;
-	status = base64_write_func (&info, NULL, 0);
-    }
+    base64_stream = _cairo_base64_stream_create (output);
+    _cairo_output_stream_write (base64_stream, mime_data, mime_data_length);
 
-    return status;
+    return _cairo_output_stream_destroy (base64_stream);
 }
 
 static cairo_int_status_t
@@ -1126,8 +1254,7 @@ _cairo_surface_base64_encode_png (cairo_surface_t       *surface,
 {
     const unsigned char *mime_data;
     unsigned long mime_data_length;
-    base64_write_closure_t info;
-    cairo_status_t status;
+    cairo_output_stream_t *base64_stream;
 
     cairo_surface_get_mime_data (surface, CAIRO_MIME_TYPE_PNG,
 				 &mime_data, &mime_data_length);
@@ -1138,30 +1265,18 @@ _cairo_surface_base64_encode_png (cairo_surface_t       *surface,
 
     _cairo_output_stream_printf (output, "data:image/png;base64,");
 
-    info.output = output;
-    info.in_mem = 0;
-    info.trailing = 0;
+    base64_stream = _cairo_base64_stream_create (output);
+    _cairo_output_stream_write (base64_stream, mime_data, mime_data_length);
 
-    status = base64_write_func (&info, mime_data, mime_data_length);
-    if (unlikely (status))
-	return status;
-
-    if (info.in_mem > 0) {
-	memset (info.src + info.in_mem, 0, 3 - info.in_mem);
-	info.trailing = 3 - info.in_mem;
-	info.in_mem = 3;
-	status = base64_write_func (&info, NULL, 0);
-    }
-
-    return status;
+    return _cairo_output_stream_destroy (base64_stream);
 }
 
 static cairo_int_status_t
 _cairo_surface_base64_encode (cairo_surface_t       *surface,
 			      cairo_output_stream_t *output)
 {
-    cairo_status_t status;
-    base64_write_closure_t info;
+    cairo_output_stream_t *base64_stream;
+    cairo_status_t status, status2;
 
     status = _cairo_surface_base64_encode_jpeg (surface, output);
     if (status != CAIRO_INT_STATUS_UNSUPPORTED)
@@ -1171,24 +1286,15 @@ _cairo_surface_base64_encode (cairo_surface_t       *surface,
     if (status != CAIRO_INT_STATUS_UNSUPPORTED)
 	return status;
 
-    info.output = output;
-    info.in_mem = 0;
-    info.trailing = 0;
-
-    _cairo_output_stream_printf (info.output, "data:image/png;base64,");
-
-    status = cairo_surface_write_to_png_stream (surface, base64_write_func,
-						(void *) &info);
-
-    if (unlikely (status))
-	return status;
+    _cairo_output_stream_printf (output, "data:image/png;base64,");
 
-    if (info.in_mem > 0) {
-	memset (info.src + info.in_mem, 0, 3 - info.in_mem);
-	info.trailing = 3 - info.in_mem;
-	info.in_mem = 3;
-	status = base64_write_func (&info, NULL, 0);
-    }
+    base64_stream = _cairo_base64_stream_create (output);
+    status = cairo_surface_write_to_png_stream (surface,
+						_cairo_svg_write_func,
+						base64_stream);
+    status2 = _cairo_output_stream_destroy (base64_stream);
+    if (status == CAIRO_STATUS_SUCCESS)
+	status = status2;
 
     return status;
 }
@@ -1259,28 +1365,18 @@ _cairo_svg_surface_emit_attr_value (cairo_output_stream_t *stream,
 }
 
 static cairo_status_t
-_cairo_svg_surface_emit_surface (cairo_svg_document_t *document,
-				 cairo_surface_t *surface)
+_cairo_svg_surface_emit_image (cairo_svg_document_t	*document,
+			       cairo_surface_t		*surface,
+			       const cairo_rectangle_int_t *extents)
 {
-    cairo_rectangle_int_t extents;
-    cairo_bool_t is_bounded;
     cairo_status_t status;
     const unsigned char *uri;
     unsigned long uri_len;
 
-    if (_cairo_user_data_array_get_data (&surface->user_data,
-					 (cairo_user_data_key_t *) document))
-    {
-	return CAIRO_STATUS_SUCCESS;
-    }
-
-    is_bounded = _cairo_surface_get_extents (surface, &extents);
-    assert (is_bounded);
-
     _cairo_output_stream_printf (document->xml_node_defs,
 				 "<image id=\"image%d\" width=\"%d\" height=\"%d\"",
 				 surface->unique_id,
-				 extents.width, extents.height);
+				 extents->width, extents->height);
 
     _cairo_output_stream_printf (document->xml_node_defs, " xlink:href=\"");
 
@@ -1298,10 +1394,65 @@ _cairo_svg_surface_emit_surface (cairo_svg_document_t *document,
 
     _cairo_output_stream_printf (document->xml_node_defs, "\"/>\n");
 
-    /* and tag it */
-    return _cairo_user_data_array_set_data (&surface->user_data,
-					    (cairo_user_data_key_t *) document,
-					    document, NULL);
+    return CAIRO_STATUS_SUCCESS;
+}
+
+static cairo_status_t
+_cairo_svg_surface_emit_surface (cairo_svg_document_t *document,
+				 cairo_surface_t *surface,
+				 const char **image_id)
+{
+    cairo_rectangle_int_t extents;
+    cairo_bool_t is_bounded;
+    cairo_status_t status;
+    uint64_t content_hash;
+    char id[CAIRO_SVG_ID_LENGTH];
+    const char *def_id;
+    char *tag;
+
+    *image_id = _cairo_user_data_array_get_data (&surface->user_data,
+						 (cairo_user_data_key_t *) document);
+    if (*image_id != NULL)
+	return CAIRO_STATUS_SUCCESS;
+
+    is_bounded = _cairo_surface_get_extents (surface, &extents);
+    assert (is_bounded);
+
+    /* Different surfaces with the same contents share one image */
+    status = _cairo_surface_get_content_hash (surface, &content_hash);
+    if (unlikely (status))
+	return status;
+
+    content_hash = _cairo_content_hash_bytes (content_hash,
+					      &extents, sizeof (extents));
+
+    snprintf (id, sizeof id, "image%d", surface->unique_id);
+    status = _cairo_svg_document_lookup_def (document, content_hash,
+					     id, &def_id);
+    if (unlikely (status))
+	return status;
+
+    if (def_id == id) {
+	status = _cairo_svg_surface_emit_image (document, surface, &extents);
+	if (unlikely (status))
+	    return status;
+    }
+
+    /* and tag it with the id to use */
+    tag = strdup (def_id);
+    if (unlikely (tag == NULL))
+	return _cairo_error (CAIRO_STATUS_NO_MEMORY);
+
+    status = _cairo_user_data_array_set_data (&surface->user_data,
+					      (cairo_user_data_key_t *) document,
+					      tag, free);
+    if (unlikely (status)) {
+	free (tag);
+	return status;
+    }
+
+    *image_id = tag;
+    return CAIRO_STATUS_SUCCESS;
 }
 
 static cairo_status_t
@@ -1309,12 +1460,13 @@ _cairo_svg_surface_emit_composite_surface_pattern (cairo_output_stream_t   *outp
 						   cairo_svg_surface_t	 *svg_surface,
 						   cairo_operator_t	  op,
 						   cairo_surface_pattern_t *pattern,
-						   int			  pattern_id,
+						   cairo_bool_t		  is_pattern,
 						   const cairo_matrix_t	 *parent_matrix,
 						   const char		 *extra_attributes)
 {
     cairo_status_t status;
     cairo_matrix_t p2u;
+    const char *image_id;
 
     p2u = pattern->base.matrix;
     status = cairo_matrix_invert (&p2u);
@@ -1322,11 +1474,12 @@ _cairo_svg_surface_emit_composite_surface_pattern (cairo_output_stream_t   *outp
     assert (status == CAIRO_STATUS_SUCCESS);
 
     status = _cairo_svg_surface_emit_surface (svg_surface->document,
-					      pattern->surface);
+					      pattern->surface,
+					      &image_id);
     if (unlikely (status))
 	return status;
 
-    if (pattern_id != invalid_pattern_id) {
+    if (is_pattern) {
 	cairo_rectangle_int_t extents;
 	cairo_bool_t is_bounded;
 
@@ -1334,10 +1487,9 @@ _cairo_svg_surface_emit_composite_surface_pattern (cairo_output_stream_t   *outp
 	assert (is_bounded);
 
 	_cairo_output_stream_printf (output,
-				     "<pattern id=\"pattern%d\" "
+				     "<pattern "
 				     "patternUnits=\"userSpaceOnUse\" "
 				     "width=\"%d\" height=\"%d\" ",
-				     pattern_id,
 				     extents.width, extents.height);
 	_cairo_svg_surface_emit_transform (output,
 					   " patternTransform",
@@ -1346,12 +1498,12 @@ _cairo_svg_surface_emit_composite_surface_pattern (cairo_output_stream_t   *outp
     }
 
     _cairo_output_stream_printf (output,
-				 "<use xlink:href=\"#image%d\"",
-				 pattern->surface->unique_id);
+				 "<use xlink:href=\"#%s\"",
+				 image_id);
     if (extra_attributes)
 	_cairo_output_stream_printf (output, " %s", extra_attributes);
 
-    if (pattern_id == invalid_pattern_id) {
+    if (! is_pattern) {
 	_cairo_svg_surface_emit_operator (output, svg_surface, op);
 	_cairo_svg_surface_emit_transform (output,
 					   " transform",
@@ -1360,7 +1512,7 @@ _cairo_svg_surface_emit_composite_surface_pattern (cairo_output_stream_t   *outp
     _cairo_output_stream_printf (output, "/>\n");
 
 
-    if (pattern_id != invalid_pattern_id)
+    if (is_pattern)
 	_cairo_output_stream_printf (output, "</pattern>\n");
 
     return CAIRO_STATUS_SUCCESS;
@@ -1374,8 +1526,10 @@ _cairo_svg_surface_emit_recording_surface (cairo_svg_document_t      *document,
     cairo_surface_t *paginated_surface;
     cairo_svg_surface_t *svg_surface;
     cairo_array_t *page_set;
+    char id[CAIRO_SVG_ID_LENGTH];
+    const char *clip_id;
 
-    cairo_output_stream_t *contents;
+    cairo_output_stream_t *contents, *def;
 
     if (_cairo_user_data_array_get_data (&source->base.user_data,
 					 (cairo_user_data_key_t *) document))
@@ -1412,31 +1566,38 @@ _cairo_svg_surface_emit_recording_surface (cairo_svg_document_t      *document,
 	return status;
     }
 
-    if (! svg_surface->is_base_clip_emitted) {
-	svg_surface->is_base_clip_emitted = TRUE;
-	_cairo_output_stream_printf (document->xml_node_defs,
-				     "<clipPath id=\"clip%d\">\n"
-				     "  <rect width=\"%f\" height=\"%f\"/>\n"
-				     "</clipPath>\n",
-				     svg_surface->base_clip,
-				     svg_surface->width,
-				     svg_surface->height);
+    /* the base clip is shared by all sources of the same size */
+    def = _cairo_memory_stream_create ();
+    _cairo_output_stream_printf (def,
+				 "<clipPath>\n"
+				 "  <rect width=\"%f\" height=\"%f\"/>\n"
+				 "</clipPath>\n",
+				 svg_surface->width,
+				 svg_surface->height);
+
+    snprintf (id, sizeof id, "clip%d", svg_surface->base_clip);
+    status = _cairo_svg_document_emit_def (document, document->xml_node_defs,
+					   def, id, &clip_id);
+    if (unlikely (status)) {
+	cairo_surface_destroy (paginated_surface);
+	return status;
     }
+    svg_surface->is_base_clip_emitted = TRUE;
 
     if (source->content == CAIRO_CONTENT_ALPHA) {
 	_cairo_svg_surface_emit_alpha_filter (document);
 	_cairo_output_stream_printf (document->xml_node_defs,
 				     "<g id=\"surface%d\" "
-				     "clip-path=\"url(#clip%d)\" "
+				     "clip-path=\"url(#%s)\" "
 				     "filter=\"url(#alpha)\">\n",
 				     source->base.unique_id,
-				     svg_surface->base_clip);
+				     clip_id);
     } else {
 	_cairo_output_stream_printf (document->xml_node_defs,
 				     "<g id=\"surface%d\" "
-				     "clip-path=\"url(#clip%d)\">\n",
+				     "clip-path=\"url(#%s)\">\n",
 				     source->base.unique_id,
-				     svg_surface->base_clip);
+				     clip_id);
     }
 
     contents = svg_surface->xml_node;
@@ -1475,7 +1636,7 @@ _cairo_svg_surface_emit_composite_recording_pattern (cairo_output_stream_t	*outp
 						     cairo_svg_surface_t	*surface,
 						     cairo_operator_t	         op,
 						     cairo_surface_pattern_t	*pattern,
-						     int			 pattern_id,
+						     cairo_bool_t		 is_pattern,
 						     const cairo_matrix_t	*parent_matrix,
 						     const char			*extra_attributes)
 {
@@ -1494,12 +1655,11 @@ _cairo_svg_surface_emit_composite_recording_pattern (cairo_output_stream_t	*outp
     if (unlikely (status))
 	return status;
 
-    if (pattern_id != invalid_pattern_id) {
+    if (is_pattern) {
 	_cairo_output_stream_printf (output,
-				     "<pattern id=\"pattern%d\" "
+				     "<pattern "
 				     "patternUnits=\"userSpaceOnUse\" "
 				     "width=\"%d\" height=\"%d\"",
-				     pattern_id,
 				     recording_surface->extents.width,
 				     recording_surface->extents.height);
 	_cairo_svg_surface_emit_transform (output, " patternTransform", &p2u, parent_matrix);
@@ -1510,7 +1670,7 @@ _cairo_svg_surface_emit_composite_recording_pattern (cairo_output_stream_t	*outp
 				 "<use xlink:href=\"#surface%d\"",
 				 recording_surface->base.unique_id);
 
-    if (pattern_id == invalid_pattern_id) {
+    if (! is_pattern) {
 	_cairo_svg_surface_emit_operator (output, surface, op);
 	_cairo_svg_surface_emit_transform (output, " transform", &p2u, parent_matrix);
     }
@@ -1520,7 +1680,7 @@ _cairo_svg_surface_emit_composite_recording_pattern (cairo_output_stream_t	*outp
 
     _cairo_output_stream_printf (output, "/>\n");
 
-    if (pattern_id != invalid_pattern_id)
+    if (is_pattern)
 	_cairo_output_stream_printf (output, "</pattern>\n");
 
     return CAIRO_STATUS_SUCCESS;
@@ -1531,7 +1691,7 @@ _cairo_svg_surface_emit_composite_pattern (cairo_output_stream_t   *output,
 					   cairo_svg_surface_t	   *surface,
 					   cairo_operator_t	    op,
 					   cairo_surface_pattern_t *pattern,
-					   int			    pattern_id,
+					   cairo_bool_t		    is_pattern,
 					   const cairo_matrix_t	   *parent_matrix,
 					   const char		   *extra_attributes)
 {
@@ -1539,14 +1699,14 @@ _cairo_svg_surface_emit_composite_pattern (cairo_output_stream_t   *output,
     if (_cairo_surface_is_recording (pattern->surface)) {
 	return _cairo_svg_surface_emit_composite_recording_pattern (output, surface,
 								    op, pattern,
-								    pattern_id,
+								    is_pattern,
 								    parent_matrix,
 								    extra_attributes);
     }
 
     return _cairo_svg_surface_emit_composite_surface_pattern (output, surface,
 							      op, pattern,
-							      pattern_id,
+							      is_pattern,
 							      parent_matrix,
 							      extra_attributes);
 }
@@ -1576,20 +1736,38 @@ _cairo_svg_surface_emit_surface_pattern (cairo_svg_surface_t	 *surface,
 					 const cairo_matrix_t	 *parent_matrix)
 {
     cairo_svg_document_t *document = surface->document;
+    cairo_output_stream_t *def;
+    char id[CAIRO_SVG_ID_LENGTH];
+    const char *def_id;
     cairo_status_t status;
-    int pattern_id;
 
-    pattern_id = document->pattern_id++;
-    status = _cairo_svg_surface_emit_composite_pattern (document->xml_node_defs,
+    def = _cairo_memory_stream_create ();
+    status = _cairo_output_stream_get_status (def);
+    if (unlikely (status))
+	return _cairo_output_stream_destroy (def);
+
+    status = _cairo_svg_surface_emit_composite_pattern (def,
 	                                                surface, CAIRO_OPERATOR_SOURCE, pattern,
-							pattern_id, parent_matrix, NULL);
+							TRUE, parent_matrix, NULL);
+    if (unlikely (status)) {
+	cairo_status_t status_ignored = _cairo_output_stream_destroy (def);
+	return status;
+	(void) status_ignored;
+    }
+
+    snprintf (id, sizeof id, "pattern%d", document->pattern_id);
+    status = _cairo_svg_document_emit_def (document, document->xml_node_defs,
+					   def, id, &def_id);
     if (unlikely (status))
 	return status;
 
+    if (def_id == id)
+	document->pattern_id++;
+
     _cairo_output_stream_printf (style,
-				 "%s:url(#pattern%d);",
+				 "%s:url(#%s);",
 				 is_stroke ? "stroke" : "fill",
-				 pattern_id);
+				 def_id);
 
     return CAIRO_STATUS_SUCCESS;
 }
@@ -1782,6 +1960,9 @@ _cairo_svg_surface_emit_linear_pattern (cairo_svg_surface_t    *surface,
 					const cairo_matrix_t   *parent_matrix)
 {
     cairo_svg_document_t *document = surface->document;
+    cairo_output_stream_t *def;
+    char id[CAIRO_SVG_ID_LENGTH];
+    const char *def_id;
     double x0, y0, x1, y1;
     cairo_matrix_t p2u;
     cairo_status_t status;
@@ -1796,32 +1977,46 @@ _cairo_svg_surface_emit_linear_pattern (cairo_svg_surface_t    *surface,
     x1 = _cairo_fixed_to_double (pattern->p2.x);
     y1 = _cairo_fixed_to_double (pattern->p2.y);
 
-    _cairo_output_stream_printf (document->xml_node_defs,
-				 "<linearGradient id=\"linear%d\" "
+    def = _cairo_memory_stream_create ();
+    status = _cairo_output_stream_get_status (def);
+    if (unlikely (status))
+	return _cairo_output_stream_destroy (def);
+
+    _cairo_output_stream_printf (def,
+				 "<linearGradient "
 				 "gradientUnits=\"userSpaceOnUse\" "
 				 "x1=\"%f\" y1=\"%f\" x2=\"%f\" y2=\"%f\" ",
-				 document->linear_pattern_id,
 				 x0, y0, x1, y1);
 
-    _cairo_svg_surface_emit_pattern_extend (document->xml_node_defs, &pattern->base.base),
-    _cairo_svg_surface_emit_transform (document->xml_node_defs, "gradientTransform", &p2u, parent_matrix);
-    _cairo_output_stream_printf (document->xml_node_defs, ">\n");
+    _cairo_svg_surface_emit_pattern_extend (def, &pattern->base.base),
+    _cairo_svg_surface_emit_transform (def, "gradientTransform", &p2u, parent_matrix);
+    _cairo_output_stream_printf (def, ">\n");
 
-    status = _cairo_svg_surface_emit_pattern_stops (document->xml_node_defs,
+    status = _cairo_svg_surface_emit_pattern_stops (def,
 	                                            &pattern->base, 0.0,
 						    FALSE, FALSE);
-    if (unlikely (status))
+    if (unlikely (status)) {
+	cairo_status_t status_ignored = _cairo_output_stream_destroy (def);
 	return status;
+	(void) status_ignored;
+    }
 
-    _cairo_output_stream_printf (document->xml_node_defs,
+    _cairo_output_stream_printf (def,
 				 "</linearGradient>\n");
 
+    snprintf (id, sizeof id, "linear%d", document->linear_pattern_id);
+    status = _cairo_svg_document_emit_def (document, document->xml_node_defs,
+					   def, id, &def_id);
+    if (unlikely (status))
+	return status;
+
+    if (def_id == id)
+	document->linear_pattern_id++;
+
     _cairo_output_stream_printf (style,
-				 "%s:url(#linear%d);",
+				 "%s:url(#%s);",
 				 is_stroke ? "stroke" : "fill",
-				 document->linear_pattern_id);
-
-    document->linear_pattern_id++;
+				 def_id);
 
     return CAIRO_STATUS_SUCCESS;
 }
@@ -1834,6 +2029,9 @@ _cairo_svg_surface_emit_radial_pattern (cairo_svg_surface_t    *surface,
 					const cairo_matrix_t   *parent_matrix)
 {
     cairo_svg_document_t *document = surface->document;
+    cairo_output_stream_t *def;
+    char id[CAIRO_SVG_ID_LENGTH];
+    const char *def_id;
     cairo_matrix_t p2u;
     cairo_extend_t extend;
     double x0, y0, x1, y1, r0, r1;
@@ -1871,29 +2069,33 @@ _cairo_svg_surface_emit_radial_pattern (cairo_svg_surface_t    *surface,
     /* cairo_pattern_set_matrix ensures the matrix is invertible */
     assert (status == CAIRO_STATUS_SUCCESS);
 
+    def = _cairo_memory_stream_create ();
+    status = _cairo_output_stream_get_status (def);
+    if (unlikely (status))
+	return _cairo_output_stream_destroy (def);
+
     if (pattern->r1 == pattern->r2) {
 	unsigned int n_stops = pattern->base.n_stops;
 
-	_cairo_output_stream_printf (document->xml_node_defs,
-				     "<radialGradient id=\"radial%d\" "
+	_cairo_output_stream_printf (def,
+				     "<radialGradient "
 				     "gradientUnits=\"userSpaceOnUse\" "
 				     "cx=\"%f\" cy=\"%f\" "
 				     "fx=\"%f\" fy=\"%f\" r=\"%f\" ",
-				     document->radial_pattern_id,
 				     x1, y1,
 				     x1, y1, r1);
-	_cairo_svg_surface_emit_transform (document->xml_node_defs,
+	_cairo_svg_surface_emit_transform (def,
 					   "gradientTransform",
 					   &p2u, parent_matrix);
-	_cairo_output_stream_printf (document->xml_node_defs, ">\n");
+	_cairo_output_stream_printf (def, ">\n");
 
 	if (extend == CAIRO_EXTEND_NONE || n_stops < 1)
-	    _cairo_output_stream_printf (document->xml_node_defs,
+	    _cairo_output_stream_printf (def,
 					 "<stop offset=\"0\" style=\""
 					 "stop-color:rgb(0%%,0%%,0%%);"
 					 "stop-opacity:0;\"/>\n");
 	else {
-	    _cairo_output_stream_printf (document->xml_node_defs,
+	    _cairo_output_stream_printf (def,
 					 "<stop offset=\"0\" style=\""
 					 "stop-color:rgb(%f%%,%f%%,%f%%);"
 					 "stop-opacity %f;\"/>\n",
@@ -1902,7 +2104,7 @@ _cairo_svg_surface_emit_radial_pattern (cairo_svg_surface_t    *surface,
 					 pattern->base.stops[0].color.blue  * 100.0,
 					 pattern->base.stops[0].color.alpha);
 	    if (n_stops > 1)
-		_cairo_output_stream_printf (document->xml_node_defs,
+		_cairo_output_stream_printf (def,
 					     "<stop offset=\"0\" style=\""
 					     "stop-color:rgb(%f%%,%f%%,%f%%);"
 					     "stop-opacity:%f;\"/>\n",
@@ -1955,60 +2157,69 @@ _cairo_svg_surface_emit_radial_pattern (cairo_svg_surface_t    *surface,
 	    offset = r0 / r1;
 	}
 
-	_cairo_output_stream_printf (document->xml_node_defs,
-				     "<radialGradient id=\"radial%d\" "
+	_cairo_output_stream_printf (def,
+				     "<radialGradient "
 				     "gradientUnits=\"userSpaceOnUse\" "
 				     "cx=\"%f\" cy=\"%f\" "
 				     "fx=\"%f\" fy=\"%f\" r=\"%f\" ",
-				     document->radial_pattern_id,
 				     x1, y1,
 				     fx, fy, r1);
 
 	if (emulate_reflect)
-	    _cairo_output_stream_printf (document->xml_node_defs, "spreadMethod=\"repeat\" ");
+	    _cairo_output_stream_printf (def, "spreadMethod=\"repeat\" ");
 	else
-	    _cairo_svg_surface_emit_pattern_extend (document->xml_node_defs, &pattern->base.base);
-	_cairo_svg_surface_emit_transform (document->xml_node_defs, "gradientTransform", &p2u, parent_matrix);
-	_cairo_output_stream_printf (document->xml_node_defs, ">\n");
+	    _cairo_svg_surface_emit_pattern_extend (def, &pattern->base.base);
+	_cairo_svg_surface_emit_transform (def, "gradientTransform", &p2u, parent_matrix);
+	_cairo_output_stream_printf (def, ">\n");
 
 	/* To support cairo's EXTEND_NONE, (for which SVG has no similar
 	 * notion), we add transparent color stops on either end of the
 	 * user-provided stops. */
 	if (extend == CAIRO_EXTEND_NONE) {
-	    _cairo_output_stream_printf (document->xml_node_defs,
+	    _cairo_output_stream_printf (def,
 					 "<stop offset=\"0\" style=\""
 					 "stop-color:rgb(0%%,0%%,0%%);"
 					 "stop-opacity:0;\"/>\n");
 	    if (r0 != 0.0)
-		_cairo_output_stream_printf (document->xml_node_defs,
+		_cairo_output_stream_printf (def,
 					     "<stop offset=\"%f\" style=\""
 					     "stop-color:rgb(0%%,0%%,0%%);"
 					     "stop-opacity:0;\"/>\n",
 					     r0 / r1);
 	}
-	status = _cairo_svg_surface_emit_pattern_stops (document->xml_node_defs,
+	status = _cairo_svg_surface_emit_pattern_stops (def,
 		                                        &pattern->base, offset,
 							reverse_stops,
 							emulate_reflect);
-	if (unlikely (status))
+	if (unlikely (status)) {
+	    cairo_status_t status_ignored = _cairo_output_stream_destroy (def);
 	    return status;
+	    (void) status_ignored;
+	}
 
 	if (pattern->base.base.extend == CAIRO_EXTEND_NONE)
-	    _cairo_output_stream_printf (document->xml_node_defs,
+	    _cairo_output_stream_printf (def,
 					 "<stop offset=\"1.0\" style=\""
 					 "stop-color:rgb(0%%,0%%,0%%);"
 					 "stop-opacity:0;\"/>\n");
     }
 
-    _cairo_output_stream_printf (document->xml_node_defs,
+    _cairo_output_stream_printf (def,
 				 "</radialGradient>\n");
 
+    snprintf (id, sizeof id, "radial%d", document->radial_pattern_id);
+    status = _cairo_svg_document_emit_def (document, document->xml_node_defs,
+					   def, id, &def_id);
+    if (unlikely (status))
+	return status;
+
+    if (def_id == id)
+	document->radial_pattern_id++;
+
     _cairo_output_stream_printf (style,
-				 "%s:url(#radial%d);",
+				 "%s:url(#%s);",
 				 is_stroke ? "stroke" : "fill",
-				 document->radial_pattern_id);
-
-    document->radial_pattern_id++;
+				 def_id);
 
     return CAIRO_STATUS_SUCCESS;
 }
@@ -2250,7 +2461,7 @@ _cairo_svg_surface_emit_paint (cairo_output_stream_t *output,
 							  surface,
 							  op,
 							  (cairo_surface_pattern_t *) source,
-							  invalid_pattern_id,
+							  FALSE,
 							  mask_source ? &mask_source->matrix :NULL,
 							  extra_attributes);
 
@@ -2352,7 +2563,8 @@ _cairo_svg_surface_mask (void		    *abstract_surface,
     cairo_output_stream_t *mask_stream;
     char buffer[64];
     cairo_bool_t discard_filter = FALSE;
-    unsigned int mask_id;
+    char id[CAIRO_SVG_ID_LENGTH];
+    const char *def_id;
 
     if (surface->paginated_mode == CAIRO_PAGINATED_MODE_ANALYZE) {
 	cairo_status_t source_status, mask_status;
@@ -2397,12 +2609,9 @@ _cairo_svg_surface_mask (void		    *abstract_surface,
     if (_cairo_output_stream_get_status (mask_stream))
 	return _cairo_output_stream_destroy (mask_stream);
 
-    mask_id = _cairo_svg_document_allocate_mask_id (document);
-
     _cairo_output_stream_printf (mask_stream,
-				 "<mask id=\"mask%d\">\n"
+				 "<mask>\n"
 				 "%s",
-				 mask_id,
 				 discard_filter ? "" : "  <g filter=\"url(#alpha)\">\n");
     status = _cairo_svg_surface_emit_paint (mask_stream, surface, CAIRO_OPERATOR_OVER, mask, source, NULL);
     if (unlikely (status)) {
@@ -2415,14 +2624,17 @@ _cairo_svg_surface_mask (void		    *abstract_surface,
 				 "%s"
 				 "</mask>\n",
 				 discard_filter ? "" : "  </g>\n");
-    _cairo_memory_stream_copy (mask_stream, document->xml_node_defs);
 
-    status = _cairo_output_stream_destroy (mask_stream);
+    snprintf (id, sizeof id, "mask%d", document->mask_id);
+    status = _cairo_svg_document_emit_def (document, document->xml_node_defs,
+					   mask_stream, id, &def_id);
     if (unlikely (status))
 	return status;
 
-    snprintf (buffer, sizeof buffer, "mask=\"url(#mask%d)\"",
-	      mask_id);
+    if (def_id == id)
+	document->mask_id++;
+
+    snprintf (buffer, sizeof buffer, "mask=\"url(#%s)\"", def_id);
     status = _cairo_svg_surface_emit_paint (surface->xml_node, surface, op, source, 0, buffer);
     if (unlikely (status))
 	return status;
@@ -2657,10 +2869,22 @@ _cairo_svg_document_create (cairo_output_stream_t	 *output_stream,
     if (unlikely (status))
 	goto CLEANUP_NODE_GLYPHS;
 
+    document->defs = _cairo_hash_table_create (_cairo_svg_def_equal);
+    if (unlikely (document->defs == NULL)) {
+	status = _cairo_error (CAIRO_STATUS_NO_MEMORY);
+	goto CLEANUP_NODE_GLYPHS;
+    }
+
+    _cairo_array_init (&document->num_glyphs_emitted, sizeof (unsigned int));
+
     document->alpha_filter = FALSE;
 
     document->svg_version = version;
 
+    document->streaming = FALSE;
+    document->header_emitted = FALSE;
+    document->page_set_emitted = FALSE;
+
     *document_out = document;
     return CAIRO_STATUS_SUCCESS;
 
@@ -2682,12 +2906,6 @@ _cairo_svg_document_reference (cairo_svg_document_t *document)
     return document;
 }
 
-static unsigned int
-_cairo_svg_document_allocate_mask_id (cairo_svg_document_t *document)
-{
-    return document->mask_id++;
-}
-
 static cairo_status_t
 _cairo_svg_document_destroy (cairo_svg_document_t *document)
 {
@@ -2704,16 +2922,13 @@ _cairo_svg_document_destroy (cairo_svg_document_t *document)
     return status;
 }
 
-static cairo_status_t
-_cairo_svg_document_finish (cairo_svg_document_t *document)
+static void
+_cairo_svg_document_emit_header (cairo_svg_document_t *document)
 {
-    cairo_status_t status, status2;
     cairo_output_stream_t *output = document->output_stream;
-    cairo_svg_page_t *page;
-    unsigned int i;
 
-    if (document->finished)
-	return CAIRO_STATUS_SUCCESS;
+    if (document->header_emitted)
+	return;
 
     /*
      * Should we add DOCTYPE?
@@ -2747,6 +2962,16 @@ _cairo_svg_document_finish (cairo_svg_document_t *document)
 				 document->width, document->height,
 				 _cairo_svg_internal_version_strings [document->svg_version]);
 
+    document->header_emitted = TRUE;
+}
+
+/* Writes out the glyphs and definitions collected since the last call */
+static cairo_status_t
+_cairo_svg_document_emit_defs (cairo_svg_document_t *document)
+{
+    cairo_output_stream_t *output = document->output_stream;
+    cairo_status_t status;
+
     status = _cairo_svg_document_emit_font_subsets (document);
 
     if (_cairo_memory_stream_length (document->xml_node_glyphs) > 0 ||
@@ -2761,6 +2986,134 @@ _cairo_svg_document_finish (cairo_svg_document_t *document)
 	_cairo_output_stream_printf (output, "</defs>\n");
     }
 
+    _cairo_memory_stream_reset (document->xml_node_glyphs);
+    _cairo_memory_stream_reset (document->xml_node_defs);
+
+    return status;
+}
+
+/* Releases the first @num_pages pages stored by @surface */
+static cairo_status_t
+_cairo_svg_surface_drop_pages (cairo_svg_surface_t *surface,
+			       unsigned int	    num_pages)
+{
+    cairo_svg_page_t *pages;
+    unsigned int i, num_kept;
+    cairo_status_t status, status2;
+
+    status = CAIRO_STATUS_SUCCESS;
+
+    pages = _cairo_array_index (&surface->page_set, 0);
+    for (i = 0; i < num_pages; i++) {
+	status2 = _cairo_output_stream_destroy (pages[i].xml_node);
+	if (status == CAIRO_STATUS_SUCCESS)
+	    status = status2;
+    }
+
+    num_kept = surface->page_set.num_elements - num_pages;
+    if (num_kept)
+	memmove (pages, pages + num_pages, num_kept * sizeof (cairo_svg_page_t));
+    _cairo_array_truncate (&surface->page_set, num_kept);
+
+    return status;
+}
+
+/* Writes out the pages stored by the owner @surface. Before the
+ * document is finished, a lone page is held back as it goes into a
+ * pageSet only if more pages follow. */
+static cairo_status_t
+_cairo_svg_surface_emit_pages (cairo_svg_surface_t *surface,
+			       cairo_bool_t	    finish)
+{
+    cairo_svg_document_t *document = surface->document;
+    cairo_output_stream_t *output = document->output_stream;
+    cairo_svg_page_t *page;
+    unsigned int i, num_pages;
+
+    num_pages = surface->page_set.num_elements;
+
+    if (_cairo_svg_version_has_page_set_support (document->svg_version) &&
+	(num_pages > 1 || document->page_set_emitted))
+    {
+	if (! document->page_set_emitted) {
+	    _cairo_output_stream_printf (output, "<pageSet>\n");
+	    document->page_set_emitted = TRUE;
+	}
+	for (i = 0; i < num_pages; i++) {
+	    page = _cairo_array_index (&surface->page_set, i);
+	    _cairo_output_stream_printf (output, "<page>\n");
+	    _cairo_output_stream_printf (output,
+					 "<g id=\"surface%d\">\n",
+					 page->surface_id);
+	    _cairo_memory_stream_copy (page->xml_node, output);
+	    _cairo_output_stream_printf (output, "</g>\n</page>\n");
+	}
+	if (finish) {
+	    _cairo_output_stream_printf (output, "</pageSet>\n");
+	    return CAIRO_STATUS_SUCCESS;
+	}
+
+	return _cairo_svg_surface_drop_pages (surface, num_pages);
+    }
+
+    if (finish) {
+	if (num_pages > 0) {
+	    page = _cairo_array_index (&surface->page_set, num_pages - 1);
+	    _cairo_output_stream_printf (output,
+					 "<g id=\"surface%d\">\n",
+					 page->surface_id);
+	    _cairo_memory_stream_copy (page->xml_node, output);
+	    _cairo_output_stream_printf (output, "</g>\n");
+	}
+	return CAIRO_STATUS_SUCCESS;
+    }
+
+    /* without a pageSet only the last page is shown */
+    if (! _cairo_svg_version_has_page_set_support (document->svg_version) &&
+	num_pages > 1)
+    {
+	return _cairo_svg_surface_drop_pages (surface, num_pages - 1);
+    }
+
+    return CAIRO_STATUS_SUCCESS;
+}
+
+/* In streaming mode, writes out everything collected so far once the
+ * owner surface has shown a page. */
+static cairo_status_t
+_cairo_svg_surface_stream_pages (cairo_svg_surface_t *surface)
+{
+    cairo_svg_document_t *document = surface->document;
+    cairo_status_t status;
+
+    if (! document->streaming || document->owner == NULL ||
+	_cairo_paginated_surface_get_target (document->owner) != &surface->base)
+    {
+	return CAIRO_STATUS_SUCCESS;
+    }
+
+    _cairo_svg_document_emit_header (document);
+
+    status = _cairo_svg_document_emit_defs (document);
+    if (unlikely (status))
+	return status;
+
+    return _cairo_svg_surface_emit_pages (surface, FALSE);
+}
+
+static cairo_status_t
+_cairo_svg_document_finish (cairo_svg_document_t *document)
+{
+    cairo_status_t status, status2;
+    cairo_output_stream_t *output = document->output_stream;
+
+    if (document->finished)
+	return CAIRO_STATUS_SUCCESS;
+
+    _cairo_svg_document_emit_header (document);
+
+    status = _cairo_svg_document_emit_defs (document);
+
     if (document->owner != NULL) {
 	cairo_svg_surface_t *surface;
 
@@ -2773,31 +3126,22 @@ _cairo_svg_document_finish (cairo_svg_document_t *document)
 	    }
 	}
 
-	if (surface->page_set.num_elements > 1 &&
-	    _cairo_svg_version_has_page_set_support (document->svg_version)) {
-	    _cairo_output_stream_printf (output, "<pageSet>\n");
-	    for (i = 0; i < surface->page_set.num_elements; i++) {
-		page = _cairo_array_index (&surface->page_set, i);
-		_cairo_output_stream_printf (output, "<page>\n");
-		_cairo_output_stream_printf (output,
-					     "<g id=\"surface%d\">\n",
-					     page->surface_id);
-		_cairo_memory_stream_copy (page->xml_node, output);
-		_cairo_output_stream_printf (output, "</g>\n</page>\n");
-	    }
-	    _cairo_output_stream_printf (output, "</pageSet>\n");
-	} else if (surface->page_set.num_elements > 0) {
-	    page = _cairo_array_index (&surface->page_set, surface->page_set.num_elements - 1);
-	    _cairo_output_stream_printf (output,
-					 "<g id=\"surface%d\">\n",
-					 page->surface_id);
-	    _cairo_memory_stream_copy (page->xml_node, output);
-	    _cairo_output_stream_printf (output, "</g>\n");
-	}
+	status2 = _cairo_svg_surface_emit_pages (surface, TRUE);
+	if (status == CAIRO_STATUS_SUCCESS)
+	    status = status2;
     }
 
     _cairo_output_stream_printf (output, "</svg>\n");
 
+    _cairo_scaled_font_subsets_destroy (document->font_subsets);
+    document->font_subsets = NULL;
+
+    _cairo_array_fini (&document->num_glyphs_emitted);
+
+    _cairo_hash_table_foreach (document->defs,
+			       _cairo_svg_def_pluck, document->defs);
+    _cairo_hash_table_destroy (document->defs);
+
     status2 = _cairo_output_stream_destroy (document->xml_node_glyphs);
     if (status == CAIRO_STATUS_SUCCESS)
 	status = status2;
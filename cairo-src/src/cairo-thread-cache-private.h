@@ -0,0 +1,83 @@
+/* cairo - a vector graphics library with display and print output
+ *
+ * Copyright © 2010 the cairo graphics library authors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it either under the terms of the GNU Lesser General Public
+ * License version 2.1 as published by the Free Software Foundation
+ * (the "LGPL") or, at your option, under the terms of the Mozilla
+ * Public License Version 1.1 (the "MPL"). If you do not alter this
+ * notice, a recipient may use your version of this file under either
+ * the MPL or the LGPL.
+ *
+ * You should have received a copy of the LGPL along with this library
+ * in the file COPYING-LGPL-2.1; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA 02110-1335, USA
+ * You should have received a copy of the MPL along with this library
+ * in the file COPYING-MPL-1.1
+ *
+ * The contents of this file are subject to the Mozilla Public License
+ * Version 1.1 (the "License"); you may not use this file except in
+ * compliance with the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY
+ * OF ANY KIND, either express or implied. See the LGPL or the MPL for
+ * the specific language governing rights and limitations.
+ *
+ * The Original Code is the cairo graphics library.
+ */
+
+#ifndef CAIRO_THREAD_CACHE_PRIVATE_H
+#define CAIRO_THREAD_CACHE_PRIVATE_H
+
+#include "cairo-compiler-private.h"
+#include "cairo-types-private.h"
+#include "cairo-mutex-type-private.h"
+
+/* Small caches that each thread keeps for itself, so that they are
+ * used without taking a lock. They live in thread-specific data and
+ * are released as their threads exit. Without thread local storage, or
+ * when a thread's cache cannot be allocated, a single cache shared
+ * under @mutex is used instead.
+ *
+ * A cache only describes how its contents are set up and torn down;
+ * the storage, which starts out zeroed, is owned by this helper.
+ */
+
+enum {
+    CAIRO_THREAD_CACHE_PEN,
+    CAIRO_THREAD_CACHE_SOLID_SURFACE,
+    CAIRO_THREAD_CACHE_SOLID_IMAGE,
+    CAIRO_THREAD_CACHE_CLIP_MASK,
+
+    CAIRO_THREAD_CACHE_NUM_SLOTS
+};
+
+typedef struct _cairo_thread_cache cairo_thread_cache_t;
+struct _cairo_thread_cache {
+    int slot;
+    size_t size;
+    cairo_status_t (*init) (void *data);
+    void (*fini) (void *data);
+    cairo_mutex_t *mutex;
+
+    /* the shared fallback, guarded by @mutex */
+    void *shared;
+    cairo_bool_t registered;
+    cairo_thread_cache_t *next;
+};
+
+#define CAIRO_THREAD_CACHE_INIT(slot, type, init, fini, mutex) \
+    { slot, sizeof (type), init, fini, &(mutex), NULL, FALSE, NULL }
+
+cairo_private void *
+_cairo_thread_cache_get (cairo_thread_cache_t *cache);
+
+cairo_private void
+_cairo_thread_cache_put (cairo_thread_cache_t *cache, void *data);
+
+cairo_private void
+_cairo_thread_cache_reset_static_data (void);
+
+#endif /* CAIRO_THREAD_CACHE_PRIVATE_H */
@@ -0,0 +1,230 @@
+/* cairo - a vector graphics library with display and print output
+ *
+ * Copyright © 2010 the cairo graphics library authors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it either under the terms of the GNU Lesser General Public
+ * License version 2.1 as published by the Free Software Foundation
+ * (the "LGPL") or, at your option, under the terms of the Mozilla
+ * Public License Version 1.1 (the "MPL"). If you do not alter this
+ * notice, a recipient may use your version of this file under either
+ * the MPL or the LGPL.
+ *
+ * You should have received a copy of the LGPL along with this library
+ * in the file COPYING-LGPL-2.1; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA 02110-1335, USA
+ * You should have received a copy of the MPL along with this library
+ * in the file COPYING-MPL-1.1
+ *
+ * The contents of this file are subject to the Mozilla Public License
+ * Version 1.1 (the "License"); you may not use this file except in
+ * compliance with the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY
+ * OF ANY KIND, either express or implied. See the LGPL or the MPL for
+ * the specific language governing rights and limitations.
+ *
+ * The Original Code is the cairo graphics library.
+ */
+
+#include "cairoint.h"
+
+#include "cairo-thread-cache-private.h"
+
+#if CAIRO_HAS_REAL_PTHREAD
+#include <pthread.h>
+#endif
+
+/* The caches that have had a shared fallback, so that it can be
+ * released again. Caches are only ever prepended to the list. */
+static cairo_thread_cache_t *_cairo_thread_cache_shared;
+
+static void *
+_cairo_thread_cache_create (cairo_thread_cache_t *cache)
+{
+    void *data;
+
+    data = calloc (1, cache->size);
+    if (unlikely (data == NULL))
+	return NULL;
+
+    if (cache->init != NULL && unlikely (cache->init (data))) {
+	free (data);
+	return NULL;
+    }
+
+    return data;
+}
+
+static void
+_cairo_thread_cache_destroy (cairo_thread_cache_t *cache, void *data)
+{
+    cache->fini (data);
+    free (data);
+}
+
+#if CAIRO_HAS_REAL_PTHREAD
+typedef struct _cairo_thread_cache_slot {
+    cairo_thread_cache_t *cache;
+    void *data;
+} cairo_thread_cache_slot_t;
+
+static pthread_key_t _cairo_thread_cache_key;
+static pthread_once_t _cairo_thread_cache_once = PTHREAD_ONCE_INIT;
+static cairo_bool_t _cairo_thread_cache_key_valid;
+
+static void
+_cairo_thread_cache_slots_destroy (void *closure)
+{
+    cairo_thread_cache_slot_t *slots = closure;
+    int n;
+
+    for (n = 0; n < CAIRO_THREAD_CACHE_NUM_SLOTS; n++) {
+	if (slots[n].data != NULL)
+	    _cairo_thread_cache_destroy (slots[n].cache, slots[n].data);
+    }
+    free (slots);
+}
+
+static void
+_cairo_thread_cache_key_create (void)
+{
+    _cairo_thread_cache_key_valid =
+	pthread_key_create (&_cairo_thread_cache_key,
+			    _cairo_thread_cache_slots_destroy) == 0;
+}
+
+static void *
+_cairo_thread_cache_get_thread (cairo_thread_cache_t *cache)
+{
+    cairo_thread_cache_slot_t *slots;
+    void *data;
+
+    pthread_once (&_cairo_thread_cache_once, _cairo_thread_cache_key_create);
+    if (unlikely (! _cairo_thread_cache_key_valid))
+	return NULL;
+
+    slots = pthread_getspecific (_cairo_thread_cache_key);
+    if (likely (slots != NULL && slots[cache->slot].data != NULL))
+	return slots[cache->slot].data;
+
+    if (slots == NULL) {
+	slots = calloc (CAIRO_THREAD_CACHE_NUM_SLOTS,
+			sizeof (cairo_thread_cache_slot_t));
+	if (unlikely (slots == NULL))
+	    return NULL;
+
+	if (pthread_setspecific (_cairo_thread_cache_key, slots)) {
+	    free (slots);
+	    return NULL;
+	}
+    }
+
+    data = _cairo_thread_cache_create (cache);
+    if (unlikely (data == NULL))
+	return NULL;
+
+    slots[cache->slot].cache = cache;
+    slots[cache->slot].data = data;
+    return data;
+}
+#endif
+
+/**
+ * _cairo_thread_cache_get:
+ * @cache: the cache
+ *
+ * Returns the calling thread's instance of @cache, creating it on first
+ * use. Failing that, the shared instance is returned with its mutex
+ * held. Every instance returned must be handed back with
+ * _cairo_thread_cache_put().
+ *
+ * Return value: the instance, or %NULL if none could be created, in
+ * which case nothing needs to be put back.
+ **/
+void *
+_cairo_thread_cache_get (cairo_thread_cache_t *cache)
+{
+#if CAIRO_HAS_REAL_PTHREAD
+    void *data;
+
+    data = _cairo_thread_cache_get_thread (cache);
+    if (likely (data != NULL))
+	return data;
+#endif
+
+    CAIRO_MUTEX_LOCK (*cache->mutex);
+    if (cache->shared == NULL) {
+	cache->shared = _cairo_thread_cache_create (cache);
+	if (unlikely (cache->shared == NULL)) {
+	    CAIRO_MUTEX_UNLOCK (*cache->mutex);
+	    return NULL;
+	}
+
+	if (! cache->registered) {
+	    CAIRO_MUTEX_LOCK (_cairo_thread_cache_mutex);
+	    cache->next = _cairo_thread_cache_shared;
+	    _cairo_thread_cache_shared = cache;
+	    CAIRO_MUTEX_UNLOCK (_cairo_thread_cache_mutex);
+
+	    cache->registered = TRUE;
+	}
+    }
+
+    return cache->shared;
+}
+
+void
+_cairo_thread_cache_put (cairo_thread_cache_t *cache, void *data)
+{
+#if CAIRO_HAS_REAL_PTHREAD
+    if (likely (_cairo_thread_cache_key_valid)) {
+	cairo_thread_cache_slot_t *slots;
+
+	slots = pthread_getspecific (_cairo_thread_cache_key);
+	if (likely (slots != NULL && slots[cache->slot].data == data))
+	    return;
+    }
+#endif
+
+    CAIRO_MUTEX_UNLOCK (*cache->mutex);
+}
+
+void
+_cairo_thread_cache_reset_static_data (void)
+{
+    cairo_thread_cache_t *cache;
+
+#if CAIRO_HAS_REAL_PTHREAD
+    /* only the calling thread's caches can be reached, the caches of
+     * other threads are released as those threads exit */
+    if (_cairo_thread_cache_key_valid) {
+	cairo_thread_cache_slot_t *slots;
+
+	slots = pthread_getspecific (_cairo_thread_cache_key);
+	if (slots != NULL) {
+	    pthread_setspecific (_cairo_thread_cache_key, NULL);
+	    _cairo_thread_cache_slots_destroy (slots);
+	}
+    }
+#endif
+
+    CAIRO_MUTEX_LOCK (_cairo_thread_cache_mutex);
+    cache = _cairo_thread_cache_shared;
+    CAIRO_MUTEX_UNLOCK (_cairo_thread_cache_mutex);
+
+    for (; cache != NULL; cache = cache->next) {
+	void *data;
+
+	/* detach the shared instance before destroying it, so that the
+	 * lock is not held should its contents reach back into cairo */
+	CAIRO_MUTEX_LOCK (*cache->mutex);
+	data = cache->shared;
+	cache->shared = NULL;
+	CAIRO_MUTEX_UNLOCK (*cache->mutex);
+
+	if (data != NULL)
+	    _cairo_thread_cache_destroy (cache, data);
+    }
+}
@@ -0,0 +1,66 @@
+/* cairo - a vector graphics library with display and print output
+ *
+ * Copyright © 2010 the cairo graphics library authors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it either under the terms of the GNU Lesser General Public
+ * License version 2.1 as published by the Free Software Foundation
+ * (the "LGPL") or, at your option, under the terms of the Mozilla
+ * Public License Version 1.1 (the "MPL"). If you do not alter this
+ * notice, a recipient may use your version of this file under either
+ * the MPL or the LGPL.
+ *
+ * You should have received a copy of the LGPL along with this library
+ * in the file COPYING-LGPL-2.1; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA 02110-1335, USA
+ * You should have received a copy of the MPL along with this library
+ * in the file COPYING-MPL-1.1
+ *
+ * The contents of this file are subject to the Mozilla Public License
+ * Version 1.1 (the "License"); you may not use this file except in
+ * compliance with the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY
+ * OF ANY KIND, either express or implied. See the LGPL or the MPL for
+ * the specific language governing rights and limitations.
+ *
+ * The Original Code is the cairo graphics library.
+ */
+
+#ifndef CAIRO_TILED_IMAGE_SURFACE_PRIVATE_H
+#define CAIRO_TILED_IMAGE_SURFACE_PRIVATE_H
+
+#include "cairoint.h"
+
+/* A tiled image surface stores its pixels in fixed-size image tiles
+ * that are only allocated once something is drawn into them. Tiles
+ * that have never been touched read back as @background, and tiles
+ * that were completely covered by a solid colour only remember that
+ * colour, so neither costs any pixel storage.
+ */
+
+#define CAIRO_TILED_IMAGE_TILE_SIZE 256
+
+typedef struct _cairo_tiled_image_surface {
+    cairo_surface_t base;
+
+    cairo_format_t format;
+    pixman_format_code_t pixman_format;
+    int width;
+    int height;
+
+    cairo_color_t background;
+    cairo_hash_table_t *tiles;
+} cairo_tiled_image_surface_t;
+
+slim_hidden_proto (cairo_tiled_image_surface_create);
+
+cairo_private cairo_bool_t
+_cairo_surface_is_tiled_image (const cairo_surface_t *surface);
+
+cairo_private pixman_image_t *
+_cairo_tiled_image_surface_get_region (cairo_tiled_image_surface_t *surface,
+				       const cairo_rectangle_int_t *rect);
+
+#endif /* CAIRO_TILED_IMAGE_SURFACE_PRIVATE_H */
@@ -0,0 +1,956 @@
+/* cairo - a vector graphics library with display and print output
+ *
+ * Copyright © 2010 the cairo graphics library authors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it either under the terms of the GNU Lesser General Public
+ * License version 2.1 as published by the Free Software Foundation
+ * (the "LGPL") or, at your option, under the terms of the Mozilla
+ * Public License Version 1.1 (the "MPL"). If you do not alter this
+ * notice, a recipient may use your version of this file under either
+ * the MPL or the LGPL.
+ *
+ * You should have received a copy of the LGPL along with this library
+ * in the file COPYING-LGPL-2.1; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA 02110-1335, USA
+ * You should have received a copy of the MPL along with this library
+ * in the file COPYING-MPL-1.1
+ *
+ * The contents of this file are subject to the Mozilla Public License
+ * Version 1.1 (the "License"); you may not use this file except in
+ * compliance with the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY
+ * OF ANY KIND, either express or implied. See the LGPL or the MPL for
+ * the specific language governing rights and limitations.
+ *
+ * The Original Code is the cairo graphics library.
+ */
+
+/* A sparse image surface for very large canvases.
+ *
+ * The surface is divided into square tiles of CAIRO_TILED_IMAGE_TILE_SIZE
+ * pixels. Each drawing operation is clipped to and translated into every
+ * tile it touches and then handed to an ordinary image surface for that
+ * tile, which is only allocated on first use. A tile that is entirely
+ * covered by a solid source is reduced back to a single colour, and a
+ * whole-surface paint simply changes the background colour that every
+ * untouched tile reads back as.
+ */
+
+#include "cairoint.h"
+
+#include "cairo-clip-private.h"
+#include "cairo-error-private.h"
+#include "cairo-recording-surface-private.h"
+#include "cairo-surface-wrapper-private.h"
+#include "cairo-tiled-image-surface-private.h"
+
+/* keep the tile origins within the range of cairo_fixed_t */
+#define MAX_TILED_IMAGE_SIZE ((1 << 23) - 1)
+
+#define TILE_SIZE CAIRO_TILED_IMAGE_TILE_SIZE
+
+typedef struct _cairo_tiled_image_tile {
+    cairo_hash_entry_t base;
+
+    int x, y; /* column and row of the tile */
+
+    /* NULL whilst every pixel of the tile is @color */
+    cairo_image_surface_t *image;
+    cairo_color_t color;
+} cairo_tiled_image_tile_t;
+
+typedef struct _cairo_tiled_image_op {
+    cairo_command_type_t type;
+    cairo_operator_t op;
+    const cairo_pattern_t *source;
+    const cairo_pattern_t *mask;
+    cairo_path_fixed_t *path;
+    const cairo_stroke_style_t *style;
+    const cairo_matrix_t *ctm;
+    const cairo_matrix_t *ctm_inverse;
+    double tolerance;
+    cairo_antialias_t antialias;
+    cairo_fill_rule_t fill_rule;
+    cairo_glyph_t *glyphs;
+    int num_glyphs;
+    cairo_scaled_font_t *scaled_font;
+    cairo_clip_t *clip;
+} cairo_tiled_image_op_t;
+
+static const cairo_surface_backend_t _cairo_tiled_image_surface_backend;
+
+cairo_bool_t
+_cairo_surface_is_tiled_image (const cairo_surface_t *surface)
+{
+    return surface->backend == &_cairo_tiled_image_surface_backend;
+}
+
+static unsigned long
+_cairo_tiled_image_tile_hash (int x, int y)
+{
+    /* both indices fit within 16 bits */
+    return ((unsigned long) y << 16) | x;
+}
+
+static cairo_bool_t
+_cairo_tiled_image_tile_equal (const void *key_a, const void *key_b)
+{
+    const cairo_tiled_image_tile_t *a = key_a;
+    const cairo_tiled_image_tile_t *b = key_b;
+
+    return a->x == b->x && a->y == b->y;
+}
+
+static void
+_cairo_tiled_image_surface_tile_rect (cairo_tiled_image_surface_t *surface,
+				      int x, int y,
+				      cairo_rectangle_int_t *rect)
+{
+    rect->x = x * TILE_SIZE;
+    rect->y = y * TILE_SIZE;
+    rect->width  = MIN (TILE_SIZE, surface->width  - rect->x);
+    rect->height = MIN (TILE_SIZE, surface->height - rect->y);
+}
+
+static cairo_tiled_image_tile_t *
+_cairo_tiled_image_surface_lookup (cairo_tiled_image_surface_t *surface,
+				   int x, int y)
+{
+    cairo_tiled_image_tile_t key;
+
+    key.base.hash = _cairo_tiled_image_tile_hash (x, y);
+    key.x = x;
+    key.y = y;
+
+    return _cairo_hash_table_lookup (surface->tiles, &key.base);
+}
+
+static cairo_tiled_image_tile_t *
+_cairo_tiled_image_surface_add_tile (cairo_tiled_image_surface_t *surface,
+				     int x, int y)
+{
+    cairo_tiled_image_tile_t *tile;
+    cairo_status_t status;
+
+    tile = malloc (sizeof (cairo_tiled_image_tile_t));
+    if (unlikely (tile == NULL))
+	return NULL;
+
+    tile->base.hash = _cairo_tiled_image_tile_hash (x, y);
+    tile->x = x;
+    tile->y = y;
+    tile->image = NULL;
+    tile->color = surface->background;
+
+    status = _cairo_hash_table_insert (surface->tiles, &tile->base);
+    if (unlikely (status)) {
+	free (tile);
+	return NULL;
+    }
+
+    return tile;
+}
+
+static void
+_cairo_tiled_image_surface_remove_tile (void *entry, void *closure)
+{
+    cairo_tiled_image_tile_t *tile = entry;
+    cairo_tiled_image_surface_t *surface = closure;
+
+    _cairo_hash_table_remove (surface->tiles, &tile->base);
+    if (tile->image != NULL)
+	cairo_surface_destroy (&tile->image->base);
+    free (tile);
+}
+
+static cairo_status_t
+_fill_pixman_image (pixman_image_t *image,
+		    const cairo_color_t *color,
+		    const cairo_rectangle_int_t *rect)
+{
+    pixman_color_t pixman_color;
+    pixman_rectangle16_t pixman_rect;
+
+    pixman_color.red   = color->red_short;
+    pixman_color.green = color->green_short;
+    pixman_color.blue  = color->blue_short;
+    pixman_color.alpha = color->alpha_short;
+
+    pixman_rect.x = rect->x;
+    pixman_rect.y = rect->y;
+    pixman_rect.width  = rect->width;
+    pixman_rect.height = rect->height;
+
+    if (! pixman_image_fill_rectangles (PIXMAN_OP_SRC, image, &pixman_color,
+					1, &pixman_rect))
+    {
+	return _cairo_error (CAIRO_STATUS_NO_MEMORY);
+    }
+
+    return CAIRO_STATUS_SUCCESS;
+}
+
+/* Returns the tile at (@x, @y) with its pixels allocated. */
+static cairo_status_t
+_cairo_tiled_image_surface_get_tile (cairo_tiled_image_surface_t *surface,
+				     int x, int y,
+				     cairo_tiled_image_tile_t **tile_out)
+{
+    cairo_tiled_image_tile_t *tile;
+    cairo_image_surface_t *image;
+    cairo_rectangle_int_t rect;
+    cairo_status_t status;
+
+    tile = _cairo_tiled_image_surface_lookup (surface, x, y);
+    if (tile == NULL) {
+	tile = _cairo_tiled_image_surface_add_tile (surface, x, y);
+	if (unlikely (tile == NULL))
+	    return _cairo_error (CAIRO_STATUS_NO_MEMORY);
+    }
+
+    if (tile->image == NULL) {
+	_cairo_tiled_image_surface_tile_rect (surface, x, y, &rect);
+	image = (cairo_image_surface_t *)
+	    _cairo_image_surface_create_with_pixman_format (NULL,
+							    surface->pixman_format,
+							    rect.width,
+							    rect.height,
+							    0);
+	if (unlikely (image->base.status))
+	    return image->base.status;
+
+	if (! CAIRO_COLOR_IS_CLEAR (&tile->color)) {
+	    rect.x = rect.y = 0;
+	    status = _fill_pixman_image (image->pixman_image, &tile->color, &rect);
+	    if (unlikely (status)) {
+		cairo_surface_destroy (&image->base);
+		return status;
+	    }
+
+	    image->base.is_clear = FALSE;
+	}
+
+	tile->image = image;
+    }
+
+    *tile_out = tile;
+    return CAIRO_STATUS_SUCCESS;
+}
+
+/* Replaces the contents of the tile at (@x, @y) by @color. */
+static cairo_status_t
+_cairo_tiled_image_surface_set_tile_color (cairo_tiled_image_surface_t *surface,
+					   int x, int y,
+					   const cairo_color_t *color)
+{
+    cairo_tiled_image_tile_t *tile;
+
+    tile = _cairo_tiled_image_surface_lookup (surface, x, y);
+    if (_cairo_color_equal (color, &surface->background)) {
+	if (tile != NULL)
+	    _cairo_tiled_image_surface_remove_tile (tile, surface);
+	return CAIRO_STATUS_SUCCESS;
+    }
+
+    if (tile == NULL) {
+	tile = _cairo_tiled_image_surface_add_tile (surface, x, y);
+	if (unlikely (tile == NULL))
+	    return _cairo_error (CAIRO_STATUS_NO_MEMORY);
+    }
+
+    if (tile->image != NULL) {
+	cairo_surface_destroy (&tile->image->base);
+	tile->image = NULL;
+    }
+    tile->color = *color;
+
+    return CAIRO_STATUS_SUCCESS;
+}
+
+pixman_image_t *
+_cairo_tiled_image_surface_get_region (cairo_tiled_image_surface_t *surface,
+				       const cairo_rectangle_int_t *rect)
+{
+    pixman_image_t *pixman_image;
+    cairo_rectangle_int_t r;
+    cairo_status_t status;
+    int x, y;
+
+    pixman_image = pixman_image_create_bits (surface->pixman_format,
+					     rect->width, rect->height,
+					     NULL, 0);
+    if (unlikely (pixman_image == NULL))
+	return NULL;
+
+    if (! CAIRO_COLOR_IS_CLEAR (&surface->background)) {
+	r.x = r.y = 0;
+	r.width  = rect->width;
+	r.height = rect->height;
+	status = _fill_pixman_image (pixman_image, &surface->background, &r);
+	if (unlikely (status))
+	    goto FAIL;
+    }
+
+    r.x = r.y = 0;
+    r.width  = surface->width;
+    r.height = surface->height;
+    if (! _cairo_rectangle_intersect (&r, rect))
+	return pixman_image;
+
+    for (y = r.y / TILE_SIZE; y <= (r.y + r.height - 1) / TILE_SIZE; y++) {
+	for (x = r.x / TILE_SIZE; x <= (r.x + r.width - 1) / TILE_SIZE; x++) {
+	    cairo_tiled_image_tile_t *tile;
+	    cairo_rectangle_int_t tile_rect, dst;
+
+	    tile = _cairo_tiled_image_surface_lookup (surface, x, y);
+	    if (tile == NULL)
+		continue;
+
+	    _cairo_tiled_image_surface_tile_rect (surface, x, y, &tile_rect);
+	    dst = tile_rect;
+	    if (! _cairo_rectangle_intersect (&dst, &r))
+		continue;
+
+	    if (tile->image != NULL) {
+		pixman_image_composite32 (PIXMAN_OP_SRC,
+					  tile->image->pixman_image,
+					  NULL,
+					  pixman_image,
+					  dst.x - tile_rect.x, dst.y - tile_rect.y,
+					  0, 0,
+					  dst.x - rect->x, dst.y - rect->y,
+					  dst.width, dst.height);
+	    } else {
+		dst.x -= rect->x;
+		dst.y -= rect->y;
+		status = _fill_pixman_image (pixman_image, &tile->color, &dst);
+		if (unlikely (status))
+		    goto FAIL;
+	    }
+	}
+    }
+
+    return pixman_image;
+
+  FAIL:
+    pixman_image_unref (pixman_image);
+    return NULL;
+}
+
+static cairo_status_t
+_cairo_tiled_image_surface_apply (const cairo_tiled_image_op_t *op,
+				  cairo_surface_wrapper_t *wrapper)
+{
+    switch (op->type) {
+    case CAIRO_COMMAND_PAINT:
+	return _cairo_surface_wrapper_paint (wrapper,
+					     op->op, op->source,
+					     op->clip);
+    case CAIRO_COMMAND_MASK:
+	return _cairo_surface_wrapper_mask (wrapper,
+					    op->op, op->source, op->mask,
+					    op->clip);
+    case CAIRO_COMMAND_STROKE:
+	return _cairo_surface_wrapper_stroke (wrapper,
+					      op->op, op->source,
+					      op->path, op->style,
+					      op->ctm, op->ctm_inverse,
+					      op->tolerance, op->antialias,
+					      op->clip);
+    case CAIRO_COMMAND_FILL:
+	return _cairo_surface_wrapper_fill (wrapper,
+					    op->op, op->source,
+					    op->path, op->fill_rule,
+					    op->tolerance, op->antialias,
+					    op->clip);
+    case CAIRO_COMMAND_SHOW_TEXT_GLYPHS:
+	return _cairo_surface_wrapper_show_text_glyphs (wrapper,
+							op->op, op->source,
+							NULL, 0,
+							op->glyphs, op->num_glyphs,
+							NULL, 0, 0,
+							op->scaled_font,
+							op->clip);
+    default:
+	ASSERT_NOT_REACHED;
+	return CAIRO_STATUS_SUCCESS;
+    }
+}
+
+/* The colour every pixel ends up as wherever @op is fully applied, or
+ * NULL if that depends upon the destination or varies across the
+ * source.
+ */
+static const cairo_color_t *
+_cairo_tiled_image_op_solid_color (const cairo_tiled_image_op_t *op)
+{
+    const cairo_color_t *color;
+
+    if (op->op == CAIRO_OPERATOR_CLEAR)
+	return CAIRO_COLOR_TRANSPARENT;
+
+    if (op->source->type != CAIRO_PATTERN_TYPE_SOLID)
+	return NULL;
+
+    color = &((const cairo_solid_pattern_t *) op->source)->color;
+    if (op->op == CAIRO_OPERATOR_SOURCE)
+	return color;
+    if (op->op == CAIRO_OPERATOR_OVER && CAIRO_COLOR_IS_OPAQUE (color))
+	return color;
+
+    return NULL;
+}
+
+static cairo_bool_t
+_rectangle_contains (const cairo_rectangle_int_t *a,
+		     const cairo_rectangle_int_t *b)
+{
+    return a->x <= b->x && a->y <= b->y &&
+	   a->x + a->width  >= b->x + b->width &&
+	   a->y + a->height >= b->y + b->height;
+}
+
+/* Draws @op into each tile within @extents. Tiles lying completely
+ * inside @cover (and the clip) are instead replaced by the solid colour
+ * of the operation, if it has one.
+ */
+static cairo_status_t
+_cairo_tiled_image_surface_draw (cairo_tiled_image_surface_t *surface,
+				 const cairo_tiled_image_op_t *op,
+				 const cairo_rectangle_int_t *extents,
+				 const cairo_rectangle_int_t *cover)
+{
+    const cairo_color_t *color = NULL;
+    cairo_region_t *clip_region = NULL;
+    cairo_status_t status;
+    int x, y;
+
+    if (extents->width <= 0 || extents->height <= 0)
+	return CAIRO_STATUS_SUCCESS;
+
+    if (cover != NULL)
+	color = _cairo_tiled_image_op_solid_color (op);
+
+    if (color != NULL && op->clip != NULL) {
+	status = _cairo_clip_get_region (op->clip, &clip_region);
+	if (status == CAIRO_INT_STATUS_NOTHING_TO_DO)
+	    return CAIRO_STATUS_SUCCESS;
+	if (unlikely (_cairo_status_is_error (status)))
+	    return status;
+	if (status == CAIRO_INT_STATUS_UNSUPPORTED)
+	    color = NULL;
+    }
+
+    if (color != NULL && clip_region == NULL &&
+	cover->x <= 0 && cover->y <= 0 &&
+	cover->x + cover->width  >= surface->width &&
+	cover->y + cover->height >= surface->height)
+    {
+	_cairo_hash_table_foreach (surface->tiles,
+				   _cairo_tiled_image_surface_remove_tile,
+				   surface);
+	surface->background = *color;
+	return CAIRO_STATUS_SUCCESS;
+    }
+
+    for (y = extents->y / TILE_SIZE;
+	 y <= (extents->y + extents->height - 1) / TILE_SIZE;
+	 y++)
+    {
+	for (x = extents->x / TILE_SIZE;
+	     x <= (extents->x + extents->width - 1) / TILE_SIZE;
+	     x++)
+	{
+	    cairo_tiled_image_tile_t *tile;
+	    cairo_surface_wrapper_t wrapper;
+	    cairo_rectangle_int_t rect;
+
+	    _cairo_tiled_image_surface_tile_rect (surface, x, y, &rect);
+
+	    if (color != NULL && _rectangle_contains (cover, &rect) &&
+		(clip_region == NULL ||
+		 cairo_region_contains_rectangle (clip_region, &rect) == CAIRO_REGION_OVERLAP_IN))
+	    {
+		status = _cairo_tiled_image_surface_set_tile_color (surface,
+								    x, y,
+								    color);
+		if (unlikely (status))
+		    return status;
+
+		continue;
+	    }
+
+	    status = _cairo_tiled_image_surface_get_tile (surface, x, y, &tile);
+	    if (unlikely (status))
+		return status;
+
+	    _cairo_surface_wrapper_init (&wrapper, &tile->image->base);
+	    _cairo_surface_wrapper_set_extents (&wrapper, &rect);
+	    status = _cairo_tiled_image_surface_apply (op, &wrapper);
+	    _cairo_surface_wrapper_fini (&wrapper);
+	    if (unlikely (status))
+		return status;
+	}
+    }
+
+    return CAIRO_STATUS_SUCCESS;
+}
+
+static cairo_surface_t *
+_cairo_tiled_image_surface_create_similar (void		*abstract_surface,
+					   cairo_content_t	 content,
+					   int			 width,
+					   int			 height)
+{
+    return cairo_tiled_image_surface_create (_cairo_format_from_content (content),
+					     width, height);
+}
+
+static cairo_status_t
+_cairo_tiled_image_surface_finish (void *abstract_surface)
+{
+    cairo_tiled_image_surface_t *surface = abstract_surface;
+
+    _cairo_hash_table_foreach (surface->tiles,
+			       _cairo_tiled_image_surface_remove_tile,
+			       surface);
+    _cairo_hash_table_destroy (surface->tiles);
+
+    return CAIRO_STATUS_SUCCESS;
+}
+
+static cairo_status_t
+_cairo_tiled_image_surface_acquire_source_image (void			 *abstract_surface,
+						 cairo_image_surface_t	**image_out,
+						 void			**image_extra)
+{
+    cairo_tiled_image_surface_t *surface = abstract_surface;
+    cairo_rectangle_int_t rect;
+    pixman_image_t *pixman_image;
+    cairo_surface_t *image;
+
+    rect.x = rect.y = 0;
+    rect.width  = surface->width;
+    rect.height = surface->height;
+
+    pixman_image = _cairo_tiled_image_surface_get_region (surface, &rect);
+    if (unlikely (pixman_image == NULL))
+	return _cairo_error (CAIRO_STATUS_NO_MEMORY);
+
+    image = _cairo_image_surface_create_for_pixman_image (pixman_image,
+							  surface->pixman_format);
+    if (unlikely (image->status)) {
+	pixman_image_unref (pixman_image);
+	return image->status;
+    }
+
+    *image_out = (cairo_image_surface_t *) image;
+    *image_extra = NULL;
+    return CAIRO_STATUS_SUCCESS;
+}
+
+static void
+_cairo_tiled_image_surface_release_source_image (void			*abstract_surface,
+						 cairo_image_surface_t	*image,
+						 void			*image_extra)
+{
+    cairo_surface_destroy (&image->base);
+}
+
+static cairo_bool_t
+_cairo_tiled_image_surface_get_extents (void			*abstract_surface,
+					cairo_rectangle_int_t	*rectangle)
+{
+    cairo_tiled_image_surface_t *surface = abstract_surface;
+
+    rectangle->x = 0;
+    rectangle->y = 0;
+    rectangle->width  = surface->width;
+    rectangle->height = surface->height;
+
+    return TRUE;
+}
+
+static void
+_cairo_tiled_image_surface_get_font_options (void		  *abstract_surface,
+					     cairo_font_options_t *options)
+{
+    _cairo_font_options_init_default (options);
+
+    cairo_font_options_set_hint_metrics (options, CAIRO_HINT_METRICS_ON);
+}
+
+static cairo_int_status_t
+_cairo_tiled_image_surface_paint (void			*abstract_surface,
+				  cairo_operator_t	 op,
+				  const cairo_pattern_t	*source,
+				  cairo_clip_t		*clip)
+{
+    cairo_tiled_image_surface_t *surface = abstract_surface;
+    cairo_tiled_image_op_t command;
+    cairo_rectangle_int_t extents;
+    cairo_status_t status;
+
+    status = _cairo_surface_paint_extents (&surface->base,
+					   op, source, clip,
+					   &extents);
+    if (unlikely (status))
+	return status;
+
+    command.type = CAIRO_COMMAND_PAINT;
+    command.op = op;
+    command.source = source;
+    command.clip = clip;
+
+    return _cairo_tiled_image_surface_draw (surface, &command,
+					    &extents, &extents);
+}
+
+static cairo_int_status_t
+_cairo_tiled_image_surface_mask (void			*abstract_surface,
+				 cairo_operator_t	 op,
+				 const cairo_pattern_t	*source,
+				 const cairo_pattern_t	*mask,
+				 cairo_clip_t		*clip)
+{
+    cairo_tiled_image_surface_t *surface = abstract_surface;
+    cairo_tiled_image_op_t command;
+    cairo_rectangle_int_t extents;
+    cairo_status_t status;
+
+    status = _cairo_surface_mask_extents (&surface->base,
+					  op, source, mask, clip,
+					  &extents);
+    if (unlikely (status))
+	return status;
+
+    command.type = CAIRO_COMMAND_MASK;
+    command.op = op;
+    command.source = source;
+    command.mask = mask;
+    command.clip = clip;
+
+    return _cairo_tiled_image_surface_draw (surface, &command,
+					    &extents, NULL);
+}
+
+static cairo_int_status_t
+_cairo_tiled_image_surface_stroke (void				*abstract_surface,
+				   cairo_operator_t		 op,
+				   const cairo_pattern_t	*source,
+				   cairo_path_fixed_t		*path,
+				   const cairo_stroke_style_t	*style,
+				   const cairo_matrix_t		*ctm,
+				   const cairo_matrix_t		*ctm_inverse,
+				   double			 tolerance,
+				   cairo_antialias_t		 antialias,
+				   cairo_clip_t			*clip)
+{
+    cairo_tiled_image_surface_t *surface = abstract_surface;
+    cairo_tiled_image_op_t command;
+    cairo_rectangle_int_t extents;
+    cairo_status_t status;
+
+    /* the stroke is clipped to each tile, so a conservative bound
+     * avoids tessellating the whole stroke just to find its extents
+     */
+    status = _cairo_surface_paint_extents (&surface->base,
+					   op, source, clip,
+					   &extents);
+    if (unlikely (status))
+	return status;
+
+    if (_cairo_operator_bounded_by_mask (op)) {
+	cairo_rectangle_int_t stroke_extents;
+
+	_cairo_path_fixed_approximate_stroke_extents (path, style, ctm,
+						      &stroke_extents);
+	if (! _cairo_rectangle_intersect (&extents, &stroke_extents))
+	    return CAIRO_STATUS_SUCCESS;
+    }
+
+    command.type = CAIRO_COMMAND_STROKE;
+    command.op = op;
+    command.source = source;
+    command.path = path;
+    command.style = style;
+    command.ctm = ctm;
+    command.ctm_inverse = ctm_inverse;
+    command.tolerance = tolerance;
+    command.antialias = antialias;
+    command.clip = clip;
+
+    return _cairo_tiled_image_surface_draw (surface, &command,
+					    &extents, NULL);
+}
+
+static cairo_int_status_t
+_cairo_tiled_image_surface_fill (void			*abstract_surface,
+				 cairo_operator_t	 op,
+				 const cairo_pattern_t	*source,
+				 cairo_path_fixed_t	*path,
+				 cairo_fill_rule_t	 fill_rule,
+				 double			 tolerance,
+				 cairo_antialias_t	 antialias,
+				 cairo_clip_t		*clip)
+{
+    cairo_tiled_image_surface_t *surface = abstract_surface;
+    cairo_tiled_image_op_t command;
+    cairo_rectangle_int_t extents, cover, *cover_ptr = NULL;
+    cairo_status_t status;
+    cairo_box_t box;
+
+    status = _cairo_surface_fill_extents (&surface->base,
+					  op, source, path,
+					  fill_rule, tolerance, antialias,
+					  clip, &extents);
+    if (unlikely (status))
+	return status;
+
+    /* a pixel-aligned box covers whole pixels regardless of antialiasing */
+    if (_cairo_path_fixed_is_box (path, &box) &&
+	_cairo_fixed_is_integer (box.p1.x) &&
+	_cairo_fixed_is_integer (box.p1.y) &&
+	_cairo_fixed_is_integer (box.p2.x) &&
+	_cairo_fixed_is_integer (box.p2.y))
+    {
+	_cairo_box_round_to_rectangle (&box, &cover);
+	cover_ptr = &cover;
+    }
+
+    command.type = CAIRO_COMMAND_FILL;
+    command.op = op;
+    command.source = source;
+    command.path = path;
+    command.fill_rule = fill_rule;
+    command.tolerance = tolerance;
+    command.antialias = antialias;
+    command.clip = clip;
+
+    return _cairo_tiled_image_surface_draw (surface, &command,
+					    &extents, cover_ptr);
+}
+
+static cairo_int_status_t
+_cairo_tiled_image_surface_show_glyphs (void			*abstract_surface,
+					cairo_operator_t	 op,
+					const cairo_pattern_t	*source,
+					cairo_glyph_t		*glyphs,
+					int			 num_glyphs,
+					cairo_scaled_font_t	*scaled_font,
+					cairo_clip_t		*clip,
+					int			*remaining_glyphs)
+{
+    cairo_tiled_image_surface_t *surface = abstract_surface;
+    cairo_tiled_image_op_t command;
+    cairo_rectangle_int_t extents;
+    cairo_status_t status;
+
+    status = _cairo_surface_glyphs_extents (&surface->base,
+					    op, source,
+					    glyphs, num_glyphs,
+					    scaled_font, clip,
+					    &extents);
+    if (unlikely (status))
+	return status;
+
+    command.type = CAIRO_COMMAND_SHOW_TEXT_GLYPHS;
+    command.op = op;
+    command.source = source;
+    command.glyphs = glyphs;
+    command.num_glyphs = num_glyphs;
+    command.scaled_font = scaled_font;
+    command.clip = clip;
+
+    *remaining_glyphs = 0;
+    return _cairo_tiled_image_surface_draw (surface, &command,
+					    &extents, NULL);
+}
+
+typedef struct _cairo_tiled_image_copy {
+    cairo_tiled_image_surface_t *dst;
+    cairo_status_t status;
+} cairo_tiled_image_copy_t;
+
+static void
+_cairo_tiled_image_surface_copy_tile (void *entry, void *closure)
+{
+    cairo_tiled_image_tile_t *tile = entry;
+    cairo_tiled_image_copy_t *copy = closure;
+    cairo_tiled_image_tile_t *clone;
+    cairo_image_surface_t *image;
+
+    if (copy->status)
+	return;
+
+    clone = _cairo_tiled_image_surface_add_tile (copy->dst, tile->x, tile->y);
+    if (unlikely (clone == NULL)) {
+	copy->status = _cairo_error (CAIRO_STATUS_NO_MEMORY);
+	return;
+    }
+
+    clone->color = tile->color;
+    if (tile->image == NULL)
+	return;
+
+    image = (cairo_image_surface_t *)
+	_cairo_image_surface_create_with_pixman_format (NULL,
+							tile->image->pixman_format,
+							tile->image->width,
+							tile->image->height,
+							0);
+    if (unlikely (image->base.status)) {
+	copy->status = image->base.status;
+	return;
+    }
+
+    pixman_image_composite32 (PIXMAN_OP_SRC,
+			      tile->image->pixman_image, NULL, image->pixman_image,
+			      0, 0,
+			      0, 0,
+			      0, 0,
+			      image->width, image->height);
+    image->base.is_clear = tile->image->base.is_clear;
+
+    clone->image = image;
+}
+
+static cairo_surface_t *
+_cairo_tiled_image_surface_snapshot (void *abstract_surface)
+{
+    cairo_tiled_image_surface_t *surface = abstract_surface;
+    cairo_tiled_image_surface_t *snapshot;
+    cairo_tiled_image_copy_t copy;
+
+    snapshot = (cairo_tiled_image_surface_t *)
+	cairo_tiled_image_surface_create (surface->format,
+					  surface->width,
+					  surface->height);
+    if (unlikely (snapshot->base.status))
+	return &snapshot->base;
+
+    snapshot->background = surface->background;
+    snapshot->base.is_clear = surface->base.is_clear;
+
+    copy.dst = snapshot;
+    copy.status = CAIRO_STATUS_SUCCESS;
+    _cairo_hash_table_foreach (surface->tiles,
+			       _cairo_tiled_image_surface_copy_tile,
+			       &copy);
+    if (unlikely (copy.status)) {
+	cairo_surface_destroy (&snapshot->base);
+	return _cairo_surface_create_in_error (copy.status);
+    }
+
+    return &snapshot->base;
+}
+
+static const cairo_surface_backend_t _cairo_tiled_image_surface_backend = {
+    CAIRO_SURFACE_TYPE_TILED_IMAGE,
+    _cairo_tiled_image_surface_create_similar,
+    _cairo_tiled_image_surface_finish,
+
+    _cairo_tiled_image_surface_acquire_source_image,
+    _cairo_tiled_image_surface_release_source_image,
+    NULL, NULL, /* acquire, release dest */
+    NULL, /* clone similar */
+    NULL, /* composite */
+    NULL, /* fill rectangles */
+    NULL, /* composite trapezoids */
+    NULL, /* create span renderer */
+    NULL, /* check span renderer */
+    NULL, /* copy_page */
+    NULL, /* show_page */
+    _cairo_tiled_image_surface_get_extents,
+    NULL, /* old_show_glyphs */
+    _cairo_tiled_image_surface_get_font_options,
+    NULL, /* flush */
+    NULL, /* mark dirty */
+    NULL, /* font_fini */
+    NULL, /* glyph_fini */
+
+    _cairo_tiled_image_surface_paint,
+    _cairo_tiled_image_surface_mask,
+    _cairo_tiled_image_surface_stroke,
+    _cairo_tiled_image_surface_fill,
+    _cairo_tiled_image_surface_show_glyphs,
+
+    _cairo_tiled_image_surface_snapshot,
+};
+
+/**
+ * cairo_tiled_image_surface_create:
+ * @format: format of pixels in the surface to create
+ * @width: width of the surface, in pixels
+ * @height: height of the surface, in pixels
+ *
+ * Creates an image surface of the specified format and dimensions
+ * whose pixels are stored in square tiles that are only allocated once
+ * something is drawn into them. Until then every pixel is transparent,
+ * and areas that are painted with a single solid colour are remembered
+ * as that colour without allocating any pixels. This makes it suitable
+ * for very large, mostly empty canvases that would be too big for
+ * cairo_image_surface_create().
+ *
+ * Drawing operations are split across the tiles they touch and
+ * rendered by the image backend, so apart from small antialiasing
+ * differences in shapes that cross from one tile into another the
+ * results match those of an image surface. The surface can be used as
+ * a source like any other; sampling from it only assembles the tiles
+ * that are read.
+ *
+ * Return value: a pointer to the newly created surface. The caller
+ * owns the surface and should call cairo_surface_destroy() when done
+ * with it.
+ *
+ * This function always returns a valid pointer, but it will return a
+ * pointer to a "nil" surface if an error such as out of memory
+ * occurs. You can use cairo_surface_status() to check for this.
+ *
+ * Since: 1.12
+ **/
+cairo_surface_t *
+cairo_tiled_image_surface_create (cairo_format_t	format,
+				  int			width,
+				  int			height)
+{
+    cairo_tiled_image_surface_t *surface;
+
+    if (! CAIRO_FORMAT_VALID (format))
+	return _cairo_surface_create_in_error (_cairo_error (CAIRO_STATUS_INVALID_FORMAT));
+
+    if (width < 0 || width > MAX_TILED_IMAGE_SIZE ||
+	height < 0 || height > MAX_TILED_IMAGE_SIZE)
+    {
+	return _cairo_surface_create_in_error (_cairo_error (CAIRO_STATUS_INVALID_SIZE));
+    }
+
+    surface = malloc (sizeof (cairo_tiled_image_surface_t));
+    if (unlikely (surface == NULL))
+	return _cairo_surface_create_in_error (_cairo_error (CAIRO_STATUS_NO_MEMORY));
+
+    _cairo_surface_init (&surface->base,
+			 &_cairo_tiled_image_surface_backend,
+			 NULL, /* device */
+			 _cairo_content_from_format (format));
+
+    surface->tiles = _cairo_hash_table_create (_cairo_tiled_image_tile_equal);
+    if (unlikely (surface->tiles == NULL)) {
+	free (surface);
+	return _cairo_surface_create_in_error (_cairo_error (CAIRO_STATUS_NO_MEMORY));
+    }
+
+    surface->format = format;
+    surface->pixman_format = _cairo_format_to_pixman_format_code (format);
+    surface->width = width;
+    surface->height = height;
+    surface->background = *CAIRO_COLOR_TRANSPARENT;
+
+    surface->base.is_clear = TRUE;
+
+    return &surface->base;
+}
+slim_hidden_def (cairo_tiled_image_surface_create);
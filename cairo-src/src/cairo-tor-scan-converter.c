@@ -406,6 +406,12 @@ struct polygon {
     struct edge **y_buckets;
     struct edge *y_buckets_embedded[64];
 
+    /* Whether the polygon is one band of a larger one, and if so the
+     * edges that enter it across its top, which are already active on
+     * its first row. */
+    int is_band;
+    struct edge *clipped;
+
     struct {
 	struct pool base[1];
 	struct edge embedded[32];
@@ -1084,6 +1090,8 @@ polygon_reset (struct polygon *polygon,
     }
     memset (polygon->y_buckets, 0, num_buckets * sizeof (struct edge *));
 
+    polygon->is_band = FALSE;
+    polygon->clipped = NULL;
     polygon->ymin = ymin;
     polygon->ymax = ymax;
     return GLITTER_STATUS_SUCCESS;
@@ -1162,7 +1170,14 @@ polygon_add_edge (struct polygon *polygon,
 	}
     }
 
-    _polygon_insert_edge_into_its_y_bucket (polygon, e);
+    /* An edge cut by the top of a band must not mark the first row
+     * as holding edge starts, else that row would be subsampled
+     * whereas it is stepped over in full without the cut. */
+    if (polygon->is_band && ytop == ymin && edge->line.p1.y < ymin) {
+	e->next = polygon->clipped;
+	polygon->clipped = e;
+    } else
+	_polygon_insert_edge_into_its_y_bucket (polygon, e);
 
     e->x.rem -= dy;		/* Bias the remainder for faster
 				 * edge advancement. */
@@ -1868,6 +1883,14 @@ glitter_scan_converter_render(
     /* Let the coverage blitter initialise itself. */
     GLITTER_BLIT_COVERAGES_BEGIN;
 
+    /* Edges entering across the top are active from the outset. */
+    if (polygon->clipped != NULL) {
+	sort_edges (polygon->clipped, UINT_MAX, &polygon->clipped);
+	active->head = merge_sorted_edges (active->head, polygon->clipped);
+	polygon->clipped = NULL;
+	active->min_height = 0;
+    }
+
     /* Render each pixel row. */
     for (i = 0; i < h; i = j) {
 	int do_full_step = 0;
@@ -2098,6 +2121,9 @@ _cairo_tor_scan_converter_add_polygon (void		*converter,
     cairo_status_t status;
     int i;
 
+    if (polygon->is_band)
+	self->converter->polygon->is_band = TRUE;
+
     for (i = 0; i < polygon->num_edges; i++) {
 	status = glitter_scan_converter_add_edge (self->converter,
 						  &polygon->edges[i]);
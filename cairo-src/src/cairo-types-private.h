@@ -230,7 +230,8 @@ typedef enum _cairo_internal_surface_type {
     CAIRO_INTERNAL_SURFACE_TYPE_TEST_PAGINATED,
     CAIRO_INTERNAL_SURFACE_TYPE_TEST_WRAPPING,
     CAIRO_INTERNAL_SURFACE_TYPE_NULL,
-    CAIRO_INTERNAL_SURFACE_TYPE_TYPE3_GLYPH
+    CAIRO_INTERNAL_SURFACE_TYPE_TYPE3_GLYPH,
+    CAIRO_INTERNAL_SURFACE_TYPE_MIPMAP
 } cairo_internal_surface_type_t;
 
 #define CAIRO_HAS_TEST_PAGINATED_SURFACE 1
@@ -295,6 +296,10 @@ typedef struct _cairo_polygon {
     const cairo_box_t *limits;
     int num_limits;
 
+    /* The top of the limits merely splits a larger rendering into
+     * bands, so edges cut by the limits keep their true top. */
+    cairo_bool_t is_band;
+
     int num_edges;
     int edges_size;
     cairo_edge_t *edges;
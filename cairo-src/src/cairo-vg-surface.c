@@ -661,6 +661,7 @@ _vg_rendering_quality_from_cairo (cairo_antialias_t aa)
 	return VG_RENDERING_QUALITY_BETTER;
 
     case CAIRO_ANTIALIAS_GRAY:
+    case CAIRO_ANTIALIAS_FAST:
 	return VG_RENDERING_QUALITY_FASTER;
 
     case CAIRO_ANTIALIAS_NONE:
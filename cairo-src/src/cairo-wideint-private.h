@@ -41,6 +41,9 @@
 
 #include "cairo-compiler-private.h"
 
+#include <float.h>
+#include <math.h>
+
 /*
  * 64-bit datatypes.  Two separate implementations, one using
  * built-in 64-bit signed/unsigned types another implemented
@@ -317,4 +320,30 @@ _cairo_int_96by64_32x64_divrem (cairo_int128_t num,
 
 #undef I
 
+/* Determine the sign of L - (B - A), where each term is the product of
+ * three 32-bit deltas, using double precision arithmetic.  Each product
+ * suffers at most two roundings, and the sums two more, so the computed
+ * difference lies within 4·DBL_EPSILON·(|L| + |A| + |B|) of the exact
+ * value.  Outside that margin the sign is certain and we can avoid the
+ * (possibly software emulated) 128-bit arithmetic; returns FALSE if the
+ * caller needs to resolve the comparison exactly.
+ */
+static inline cairo_bool_t
+_cairo_filtered_sign (double l, double a, double b, int *sign)
+{
+    double d = l - (b - a);
+    double err = 4 * DBL_EPSILON * (fabs (l) + fabs (a) + fabs (b));
+
+    if (d > err) {
+	*sign = 1;
+	return TRUE;
+    }
+    if (d < -err) {
+	*sign = -1;
+	return TRUE;
+    }
+
+    return FALSE;
+}
+
 #endif /* CAIRO_WIDEINT_H */
@@ -121,6 +121,13 @@ typedef struct _cairo_quorem64 {
     cairo_int64_t	rem;
 } cairo_quorem64_t;
 
+/* Builds that are not configured by autoconf (such as the Xcode project)
+ * may still use the native 128-bit integers of compilers that advertise
+ * them. */
+#if !HAVE___UINT128_T && !HAVE_UINT128_T && defined (__SIZEOF_INT128__)
+#define HAVE___UINT128_T 1
+#endif
+
 /* gcc has a non-standard name. */
 #if HAVE___UINT128_T && !HAVE_UINT128_T
 typedef __uint128_t uint128_t;
@@ -673,6 +673,26 @@ _cairo_int128_divrem (cairo_int128_t num, cairo_int128_t den)
  * quotient is the largest representable 64 bit integer.  It is an
  * error to call this function with the high 32 bits of @num being
  * non-zero. */
+#if HAVE_UINT128_T
+cairo_uquorem64_t
+_cairo_uint_96by64_32x64_divrem (cairo_uint128_t num,
+				 cairo_uint64_t den)
+{
+    cairo_uquorem64_t result;
+
+    /* Initialise the result to indicate overflow. */
+    result.quo = _cairo_uint32s_to_uint64 (-1U, -1U);
+    result.rem = den;
+
+    /* Don't bother if the quotient is going to overflow. */
+    if (_cairo_uint64_ge (_cairo_uint128_to_uint64 (_cairo_uint128_rsl (num, 32)), den))
+	return /* overflow */ result;
+
+    result.quo = num / den;
+    result.rem = num % den;
+    return result;
+}
+#else
 cairo_uquorem64_t
 _cairo_uint_96by64_32x64_divrem (cairo_uint128_t num,
 				 cairo_uint64_t den)
@@ -783,6 +803,8 @@ _cairo_uint_96by64_32x64_divrem (cairo_uint128_t num,
     return result;
 }
 
+#endif
+
 cairo_quorem64_t
 _cairo_int_96by64_32x64_divrem (cairo_int128_t num, cairo_int64_t den)
 {
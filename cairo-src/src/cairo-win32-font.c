@@ -332,6 +332,7 @@ _win32_scaled_font_create (LOGFONTW                   *logfont,
 	    f->quality = NONANTIALIASED_QUALITY;
 	    break;
 	case CAIRO_ANTIALIAS_GRAY:
+	case CAIRO_ANTIALIAS_FAST:
 	    f->quality = ANTIALIASED_QUALITY;
 	    break;
 	case CAIRO_ANTIALIAS_SUBPIXEL:
@@ -532,6 +532,7 @@ _cairo_xcb_picture_set_filter (cairo_xcb_picture_t *picture,
 	break;
 
     case CAIRO_FILTER_GOOD:
+    case CAIRO_FILTER_MIPMAP:
 	render_filter = "good";
 	len = strlen ("good");
 	break;
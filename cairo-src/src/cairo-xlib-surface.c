@@ -1103,6 +1103,7 @@ _cairo_xlib_surface_set_precision (cairo_xlib_display_t	*display,
     switch (antialias) {
     case CAIRO_ANTIALIAS_DEFAULT:
     case CAIRO_ANTIALIAS_GRAY:
+    case CAIRO_ANTIALIAS_FAST:
 	precision = PolyModeImprecise;
 	break;
     case CAIRO_ANTIALIAS_NONE:
@@ -1669,6 +1670,7 @@ _cairo_xlib_surface_set_filter (cairo_xlib_display_t *display,
 	render_filter = FilterFast;
 	break;
     case CAIRO_FILTER_GOOD:
+    case CAIRO_FILTER_MIPMAP:
 	render_filter = FilterGood;
 	break;
     case CAIRO_FILTER_BEST:
@@ -2338,7 +2340,7 @@ _cairo_xlib_surface_upload(cairo_xlib_surface_t *surface,
 
     if (image->base.backend->type != CAIRO_SURFACE_TYPE_IMAGE) {
 	if (image->base.backend->type == CAIRO_INTERNAL_SURFACE_TYPE_SNAPSHOT) {
-	    image = (cairo_image_surface_t *) ((cairo_surface_snapshot_t *) image)->target;
+	    image = (cairo_image_surface_t *) _cairo_surface_snapshot_get_target (&image->base);
 	    extents.x = extents.y = 0;
 	    extents.width = image->width;
 	    extents.height = image->height;
@@ -2897,6 +2899,7 @@ _cairo_xlib_surface_composite_trapezoids (cairo_operator_t	op,
 	break;
     case CAIRO_ANTIALIAS_GRAY:
     case CAIRO_ANTIALIAS_SUBPIXEL:
+    case CAIRO_ANTIALIAS_FAST:
     case CAIRO_ANTIALIAS_DEFAULT:
     default:
 	pict_format =
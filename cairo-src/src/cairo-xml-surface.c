@@ -136,6 +136,7 @@ _filter_to_string (cairo_filter_t filter)
 	"FILTER_NEAREST",	/* CAIRO_FILTER_NEAREST */
 	"FILTER_BILINEAR",	/* CAIRO_FILTER_BILINEAR */
 	"FILTER_GAUSSIAN",	/* CAIRO_FILTER_GAUSSIAN */
+	"FILTER_MIPMAP",	/* CAIRO_FILTER_MIPMAP */
     };
     assert (filter < ARRAY_LENGTH (names));
     return names[filter];
@@ -159,7 +160,8 @@ _antialias_to_string (cairo_antialias_t antialias)
 	"ANTIALIAS_DEFAULT",	/* CAIRO_ANTIALIAS_DEFAULT */
 	"ANTIALIAS_NONE",	/* CAIRO_ANTIALIAS_NONE */
 	"ANTIALIAS_GRAY",	/* CAIRO_ANTIALIAS_GRAY */
-	"ANTIALIAS_SUBPIXEL"	/* CAIRO_ANTIALIAS_SUBPIXEL */
+	"ANTIALIAS_SUBPIXEL",	/* CAIRO_ANTIALIAS_SUBPIXEL */
+	"ANTIALIAS_FAST"	/* CAIRO_ANTIALIAS_FAST */
     };
     assert (antialias < ARRAY_LENGTH (names));
     return names[antialias];
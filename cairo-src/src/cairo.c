@@ -1129,6 +1129,11 @@ slim_hidden_def (cairo_set_tolerance);
  * a particular value.  At the current time, no backend supports
  * %CAIRO_ANTIALIAS_SUBPIXEL when drawing shapes.
  *
+ * With %CAIRO_ANTIALIAS_FAST, the image backend renders strokes that
+ * are no wider than a device pixel directly as antialiased lines,
+ * which is much quicker than the general stroker for dense line art
+ * such as charts, at the cost of small differences in coverage.
+ *
  * Note that this option does not affect text rendering, instead see
  * cairo_font_options_set_antialias().
  **/
@@ -576,6 +576,9 @@ cairo_set_tolerance (cairo_t *cr, double tolerance);
  * @CAIRO_ANTIALIAS_SUBPIXEL: Perform antialiasing by taking
  *  advantage of the order of subpixel elements on devices
  *  such as LCD panels
+ * @CAIRO_ANTIALIAS_FAST: Perform single-color antialiasing, but allow
+ *  the backend to trade some quality for speed, for example by
+ *  rendering thin strokes as simple antialiased lines (Since 1.12)
  *
  * Specifies the type of antialiasing to do when rendering text or shapes.
  **/
@@ -583,7 +586,8 @@ typedef enum _cairo_antialias {
     CAIRO_ANTIALIAS_DEFAULT,
     CAIRO_ANTIALIAS_NONE,
     CAIRO_ANTIALIAS_GRAY,
-    CAIRO_ANTIALIAS_SUBPIXEL
+    CAIRO_ANTIALIAS_SUBPIXEL,
+    CAIRO_ANTIALIAS_FAST
 } cairo_antialias_t;
 
 cairo_public void
@@ -2071,6 +2075,8 @@ cairo_surface_status (cairo_surface_t *surface);
  * @CAIRO_SURFACE_TYPE_SKIA: The surface is of type Skia, since 1.10
  * @CAIRO_SURFACE_TYPE_SUBSURFACE: The surface is a subsurface created with
  *   cairo_surface_create_for_rectangle(), since 1.10
+ * @CAIRO_SURFACE_TYPE_TILED_IMAGE: The surface is a sparse image surface
+ *   created with cairo_tiled_image_surface_create(), since 1.12
  *
  * #cairo_surface_type_t is used to describe the type of a given
  * surface. The surface types are also known as "backends" or "surface
@@ -2119,7 +2125,8 @@ typedef enum _cairo_surface_type {
     CAIRO_SURFACE_TYPE_TEE,
     CAIRO_SURFACE_TYPE_XML,
     CAIRO_SURFACE_TYPE_SKIA,
-    CAIRO_SURFACE_TYPE_SUBSURFACE
+    CAIRO_SURFACE_TYPE_SUBSURFACE,
+    CAIRO_SURFACE_TYPE_TILED_IMAGE
 } cairo_surface_type_t;
 
 cairo_public cairo_surface_type_t
@@ -2286,6 +2293,15 @@ cairo_image_surface_get_height (cairo_surface_t *surface);
 cairo_public int
 cairo_image_surface_get_stride (cairo_surface_t *surface);
 
+cairo_public cairo_surface_t *
+cairo_image_surface_create_for_file (const char	*filename,
+				     cairo_format_t	 format,
+				     int		 width,
+				     int		 height);
+
+cairo_public cairo_surface_t *
+cairo_image_surface_create_from_file (const char *filename);
+
 #if CAIRO_HAS_PNG_FUNCTIONS
 
 cairo_public cairo_surface_t *
@@ -2310,6 +2326,17 @@ cairo_recording_surface_ink_extents (cairo_surface_t *surface,
                                      double *width,
                                      double *height);
 
+cairo_public cairo_status_t
+cairo_recording_surface_replay_tiled (cairo_surface_t *surface,
+				      cairo_surface_t *target);
+
+/* Tiled-image-surface functions */
+
+cairo_public cairo_surface_t *
+cairo_tiled_image_surface_create (cairo_format_t	format,
+				  int			width,
+				  int			height);
+
 /* Pattern creation functions */
 
 cairo_public cairo_pattern_t *
@@ -2457,6 +2484,9 @@ cairo_pattern_get_extend (cairo_pattern_t *pattern);
  * @CAIRO_FILTER_BILINEAR: Linear interpolation in two dimensions
  * @CAIRO_FILTER_GAUSSIAN: This filter value is currently
  *     unimplemented, and should not be used in current code.
+ * @CAIRO_FILTER_MIPMAP: As %CAIRO_FILTER_GOOD, but allow the backend
+ *     to sample a heavily downscaled source from a cached, box-filtered
+ *     reduction of it (Since 1.12)
  *
  * #cairo_filter_t is used to indicate what filtering should be
  * applied when reading pixel values from patterns. See
@@ -2469,7 +2499,8 @@ typedef enum _cairo_filter {
     CAIRO_FILTER_BEST,
     CAIRO_FILTER_NEAREST,
     CAIRO_FILTER_BILINEAR,
-    CAIRO_FILTER_GAUSSIAN
+    CAIRO_FILTER_GAUSSIAN,
+    CAIRO_FILTER_MIPMAP
 } cairo_filter_t;
 
 cairo_public void
@@ -838,6 +838,7 @@ struct _cairo_image_surface {
     int depth;
 
     pixman_image_t *pixman_image;
+    struct _cairo_image_source_cache *source_cache;
 
     unsigned owns_data : 1;
     unsigned transparency : 2;
@@ -1083,10 +1084,6 @@ _cairo_font_options_get_lcd_filter (const cairo_font_options_t *options);
 cairo_private cairo_status_t
 _cairo_hull_compute (cairo_pen_vertex_t *vertices, int *num_vertices);
 
-/* cairo-lzw.c */
-cairo_private unsigned char *
-_cairo_lzw_compress (unsigned char *data, unsigned long *size_in_out);
-
 /* cairo-misc.c */
 cairo_private cairo_status_t
 _cairo_validate_text_clusters (const char		   *utf8,
@@ -1114,6 +1111,13 @@ cairo_private cairo_status_t
 _cairo_path_fixed_init_copy (cairo_path_fixed_t *path,
 			     const cairo_path_fixed_t *other);
 
+cairo_private size_t
+_cairo_path_fixed_compact_size (const cairo_path_fixed_t *path);
+
+cairo_private cairo_path_fixed_t *
+_cairo_path_fixed_init_compact_copy (void *path,
+				     const cairo_path_fixed_t *other);
+
 cairo_private cairo_bool_t
 _cairo_path_fixed_is_equal (const cairo_path_fixed_t *path,
 			    const cairo_path_fixed_t *other);
@@ -1260,6 +1264,11 @@ _cairo_path_fixed_fill_to_polygon (const cairo_path_fixed_t *path,
 				   double              tolerance,
 				   cairo_polygon_t      *polygon);
 
+cairo_private cairo_status_t
+_cairo_path_fixed_fill_to_polygon_uniform (const cairo_path_fixed_t *path,
+					   double              tolerance,
+					   cairo_polygon_t      *polygon);
+
 cairo_private cairo_int_status_t
 _cairo_path_fixed_fill_rectilinear_to_traps (const cairo_path_fixed_t *path,
 					     cairo_fill_rule_t fill_rule,
@@ -1290,6 +1299,14 @@ _cairo_path_fixed_stroke_to_polygon (const cairo_path_fixed_t	*path,
 				     double		 tolerance,
 				     cairo_polygon_t	*polygon);
 
+cairo_private cairo_status_t
+_cairo_path_fixed_stroke_to_hairlines (const cairo_path_fixed_t	*path,
+				       const cairo_stroke_style_t	*stroke_style,
+				       const cairo_matrix_t	*ctm,
+				       const cairo_matrix_t	*ctm_inverse,
+				       double			 tolerance,
+				       cairo_hairline_scan_converter_t *converter);
+
 cairo_private cairo_int_status_t
 _cairo_path_fixed_stroke_rectilinear_to_traps (const cairo_path_fixed_t	*path,
 					       const cairo_stroke_style_t	*stroke_style,
@@ -1456,6 +1473,10 @@ _cairo_stroke_style_max_distance_from_path (const cairo_stroke_style_t *style,
                                             const cairo_matrix_t *ctm,
                                             double *dx, double *dy);
 
+cairo_private cairo_bool_t
+_cairo_stroke_style_is_hairline (const cairo_stroke_style_t *style,
+				 const cairo_matrix_t *ctm);
+
 cairo_private double
 _cairo_stroke_style_dash_period (const cairo_stroke_style_t *style);
 
@@ -1921,6 +1942,22 @@ _cairo_image_surface_create_with_content (cairo_content_t	content,
 cairo_private void
 _cairo_image_surface_assume_ownership_of_data (cairo_image_surface_t *surface);
 
+cairo_private cairo_status_t
+_cairo_image_file_flush (cairo_image_surface_t *surface);
+
+cairo_private cairo_image_surface_t *
+_cairo_image_surface_get_mipmap (cairo_image_surface_t *image,
+				 int *level);
+
+cairo_private cairo_status_t
+_cairo_surface_get_content_hash (cairo_surface_t *surface,
+				 uint64_t *hash);
+
+cairo_private uint64_t
+_cairo_content_hash_bytes (uint64_t hash,
+			   const void *bytes,
+			   unsigned long length);
+
 cairo_private cairo_image_surface_t *
 _cairo_image_surface_coerce (cairo_image_surface_t	*surface);
 
@@ -2025,6 +2062,9 @@ _cairo_spline_init (cairo_spline_t *spline,
 cairo_private cairo_status_t
 _cairo_spline_decompose (cairo_spline_t *spline, double tolerance);
 
+cairo_private cairo_status_t
+_cairo_spline_decompose_uniform (cairo_spline_t *spline, double tolerance);
+
 cairo_private cairo_status_t
 _cairo_spline_bound (cairo_spline_add_point_func_t add_point_func,
 		     void *closure,
@@ -965,6 +965,7 @@ i915_texture_filter_is_nearest (cairo_filter_t filter)
     switch (filter) {
     case CAIRO_FILTER_BEST:
     case CAIRO_FILTER_GOOD:
+    case CAIRO_FILTER_MIPMAP:
     case CAIRO_FILTER_BILINEAR:
     case CAIRO_FILTER_GAUSSIAN:
 	return FALSE;
@@ -981,6 +982,7 @@ i915_texture_filter (cairo_filter_t filter)
     switch (filter) {
     case CAIRO_FILTER_BEST:
     case CAIRO_FILTER_GOOD:
+    case CAIRO_FILTER_MIPMAP:
     case CAIRO_FILTER_BILINEAR:
     case CAIRO_FILTER_GAUSSIAN:
         return
@@ -711,6 +711,7 @@ i965_filter (cairo_filter_t filter)
 	return BRW_MAPFILTER_NEAREST;
 
     case CAIRO_FILTER_GOOD:
+    case CAIRO_FILTER_MIPMAP:
     case CAIRO_FILTER_BEST:
     case CAIRO_FILTER_BILINEAR:
     case CAIRO_FILTER_GAUSSIAN:
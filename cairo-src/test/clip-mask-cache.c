@@ -0,0 +1,98 @@
+/*
+ * Copyright © 2010 the cairo graphics library authors
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include "cairo-test.h"
+
+/* Redraws the same frame with fresh contexts so that the later frames
+ * reuse the clip masks rasterised by the first, both for a single
+ * rounded rectangle and for a rounded rectangle intersected with a
+ * circle.
+ */
+
+#define SIZE 100
+#define FRAMES 3
+
+static void
+rounded_rectangle (cairo_t *cr, double x, double y, double w, double h, double r)
+{
+    cairo_new_sub_path (cr);
+    cairo_arc (cr, x + w - r, y + r, r, -M_PI / 2, 0);
+    cairo_arc (cr, x + w - r, y + h - r, r, 0, M_PI / 2);
+    cairo_arc (cr, x + r, y + h - r, r, M_PI / 2, M_PI);
+    cairo_arc (cr, x + r, y + r, r, M_PI, 3 * M_PI / 2);
+    cairo_close_path (cr);
+}
+
+static void
+draw_frame (cairo_surface_t *target)
+{
+    cairo_t *cr;
+
+    cr = cairo_create (target);
+    cairo_set_source_rgb (cr, 1, 1, 1);
+    cairo_paint (cr);
+
+    cairo_save (cr);
+    rounded_rectangle (cr, 5, 5, 50, 40, 12);
+    cairo_clip (cr);
+    cairo_set_source_rgb (cr, 0, 0, 1);
+    cairo_paint (cr);
+    cairo_restore (cr);
+
+    cairo_save (cr);
+    rounded_rectangle (cr, 45.5, 50.5, 50, 45, 10);
+    cairo_clip (cr);
+    cairo_arc (cr, 50, 95, 40, 0, 2 * M_PI);
+    cairo_clip (cr);
+    cairo_set_source_rgb (cr, 1, 0, 0);
+    cairo_paint (cr);
+    cairo_restore (cr);
+
+    /* the same shape again at a different position */
+    rounded_rectangle (cr, 60, 8, 35, 30, 8);
+    cairo_clip (cr);
+    cairo_set_source_rgb (cr, 0, 0.5, 0);
+    cairo_paint (cr);
+
+    cairo_destroy (cr);
+}
+
+static cairo_test_status_t
+draw (cairo_t *cr, int width, int height)
+{
+    int n;
+
+    for (n = 0; n < FRAMES; n++)
+	draw_frame (cairo_get_group_target (cr));
+
+    return CAIRO_TEST_SUCCESS;
+}
+
+CAIRO_TEST (clip_mask_cache,
+	    "Reuse cached clip masks across contexts",
+	    "clip", /* keywords */
+	    NULL, /* requirements */
+	    SIZE, SIZE,
+	    NULL, draw)
@@ -0,0 +1,77 @@
+/*
+ * Copyright © 2010 the cairo graphics library authors
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "cairo-test.h"
+
+/* Exercises filling curved paths with CAIRO_ANTIALIAS_FAST, for which
+ * the image backend flattens splines by uniform forward differencing
+ * rather than recursive subdivision.
+ */
+
+#define SIZE 100
+
+static cairo_test_status_t
+draw (cairo_t *cr, int width, int height)
+{
+    cairo_set_source_rgb (cr, 1, 1, 1);
+    cairo_paint (cr);
+
+    cairo_set_source_rgb (cr, 0, 0, 0);
+    cairo_set_antialias (cr, CAIRO_ANTIALIAS_FAST);
+
+    /* circles of decreasing size */
+    cairo_arc (cr, 25, 25, 20, 0, 2 * M_PI);
+    cairo_fill (cr);
+    cairo_arc (cr, 60, 15, 10, 0, 2 * M_PI);
+    cairo_fill (cr);
+    cairo_arc (cr, 85, 10, 4, 0, 2 * M_PI);
+    cairo_arc (cr, 85, 30, 1.5, 0, 2 * M_PI);
+    cairo_fill (cr);
+
+    /* a self-intersecting spline */
+    cairo_move_to (cr, 10, 90);
+    cairo_curve_to (cr, 110, 40, -10, 40, 90, 90);
+    cairo_close_path (cr);
+    cairo_fill (cr);
+
+    /* a highly curved spline under a non-uniform scale */
+    cairo_save (cr);
+    cairo_translate (cr, 50, 55);
+    cairo_scale (cr, 4, 0.5);
+    cairo_move_to (cr, -10, 0);
+    cairo_curve_to (cr, -10, -20, 10, -20, 10, 0);
+    cairo_curve_to (cr, 10, 20, 0, -20, -10, 0);
+    cairo_restore (cr);
+    cairo_set_source_rgba (cr, 0, 0, 1, .5);
+    cairo_fill (cr);
+
+    return CAIRO_TEST_SUCCESS;
+}
+
+CAIRO_TEST (fill_fast,
+	    "Test filling of curves with CAIRO_ANTIALIAS_FAST",
+	    "fill", /* keywords */
+	    NULL, /* requirements */
+	    SIZE, SIZE,
+	    NULL, draw)
@@ -0,0 +1,97 @@
+/*
+ * Copyright © 2010 the cairo graphics library authors
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "cairo-test.h"
+
+/* Exercises the rendering of strokes no wider than a pixel with
+ * CAIRO_ANTIALIAS_FAST, which the image backend sends directly to
+ * spans rather than through the general stroker.
+ */
+
+#define SIZE 100
+
+static void
+chart (cairo_t *cr, double y, double amplitude)
+{
+    int i;
+
+    cairo_move_to (cr, 5, y);
+    for (i = 1; i <= 45; i++)
+	cairo_line_to (cr, 5 + 2 * i, y + ((i * 7) % 11 - 5) * amplitude);
+}
+
+static cairo_test_status_t
+draw (cairo_t *cr, int width, int height)
+{
+    const double dash[] = { 4, 2 };
+
+    cairo_set_source_rgb (cr, 1, 1, 1);
+    cairo_paint (cr);
+
+    cairo_set_source_rgb (cr, 0, 0, 0);
+    cairo_set_antialias (cr, CAIRO_ANTIALIAS_FAST);
+
+    /* polylines of 1 and 0.5 pixels */
+    cairo_set_line_width (cr, 1.0);
+    chart (cr, 15, 1.5);
+    cairo_stroke (cr);
+
+    cairo_set_line_width (cr, 0.5);
+    chart (cr, 35, 1.5);
+    cairo_stroke (cr);
+
+    /* dashes with caps */
+    cairo_set_line_width (cr, 1.0);
+    cairo_set_line_cap (cr, CAIRO_LINE_CAP_SQUARE);
+    cairo_set_dash (cr, dash, 2, 1);
+    chart (cr, 55, 1.);
+    cairo_stroke (cr);
+    cairo_set_dash (cr, NULL, 0, 0);
+
+    /* a closed curve and a degenerate round cap */
+    cairo_set_line_cap (cr, CAIRO_LINE_CAP_ROUND);
+    cairo_arc (cr, 25, 80, 12, 0, 2 * M_PI);
+    cairo_close_path (cr);
+    cairo_move_to (cr, 50, 80);
+    cairo_close_path (cr);
+    cairo_stroke (cr);
+
+    /* a non-uniform transformation */
+    cairo_save (cr);
+    cairo_translate (cr, 75, 80);
+    cairo_scale (cr, 4, 0.25);
+    cairo_rotate (cr, M_PI / 6);
+    cairo_rectangle (cr, -3, -30, 6, 60);
+    cairo_restore (cr);
+    cairo_stroke (cr);
+
+    return CAIRO_TEST_SUCCESS;
+}
+
+CAIRO_TEST (hairline_fast,
+	    "Test rendering of thin strokes with CAIRO_ANTIALIAS_FAST",
+	    "stroke", /* keywords */
+	    NULL, /* requirements */
+	    SIZE, SIZE,
+	    NULL, draw)
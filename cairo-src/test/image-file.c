@@ -0,0 +1,143 @@
+/*
+ * Copyright © 2010 the cairo graphics library authors
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "cairo-test.h"
+
+/* Test that image surfaces mapped from files keep their pixels in the
+ * file, and that every mapping of the file shares them.
+ */
+
+#define WIDTH 100
+#define HEIGHT 50
+
+static uint32_t
+get_pixel (cairo_surface_t *surface, int x, int y)
+{
+    unsigned char *data;
+
+    cairo_surface_flush (surface);
+    data = cairo_image_surface_get_data (surface);
+    data += y * cairo_image_surface_get_stride (surface);
+    return ((uint32_t *) data)[x];
+}
+
+static cairo_test_status_t
+preamble (cairo_test_context_t *ctx)
+{
+    const char *filename = "image-file.out.raw";
+    cairo_test_status_t result = CAIRO_TEST_SUCCESS;
+    cairo_surface_t *surface, *a, *b;
+    cairo_status_t status;
+    cairo_t *cr;
+
+    surface = cairo_image_surface_create_for_file (filename,
+						   CAIRO_FORMAT_ARGB32,
+						   WIDTH, HEIGHT);
+    status = cairo_surface_status (surface);
+    if (status == CAIRO_STATUS_WRITE_ERROR) {
+	cairo_surface_destroy (surface);
+	return CAIRO_TEST_UNTESTED;
+    }
+    if (status) {
+	cairo_test_log (ctx, "Error creating %s: %s\n",
+			filename, cairo_status_to_string (status));
+	cairo_surface_destroy (surface);
+	return CAIRO_TEST_FAILURE;
+    }
+
+    cr = cairo_create (surface);
+    cairo_set_source_rgb (cr, 1, 0, 0);
+    cairo_rectangle (cr, 0, 0, WIDTH / 2, HEIGHT);
+    cairo_fill (cr);
+    cairo_destroy (cr);
+    cairo_surface_destroy (surface);
+
+    a = cairo_image_surface_create_from_file (filename);
+    b = cairo_image_surface_create_from_file (filename);
+    status = cairo_surface_status (a);
+    if (status == CAIRO_STATUS_SUCCESS)
+	status = cairo_surface_status (b);
+    if (status) {
+	cairo_test_log (ctx, "Error mapping %s: %s\n",
+			filename, cairo_status_to_string (status));
+	result = CAIRO_TEST_FAILURE;
+	goto FINISH;
+    }
+
+    if (cairo_image_surface_get_format (a) != CAIRO_FORMAT_ARGB32 ||
+	cairo_image_surface_get_width (a) != WIDTH ||
+	cairo_image_surface_get_height (a) != HEIGHT)
+    {
+	cairo_test_log (ctx, "Error mapping %s: wrong image size or format\n",
+			filename);
+	result = CAIRO_TEST_FAILURE;
+	goto FINISH;
+    }
+
+    if (get_pixel (a, 10, 10) != 0xffff0000 || get_pixel (a, 90, 10) != 0) {
+	cairo_test_log (ctx, "Error mapping %s: pixels were not preserved\n",
+			filename);
+	result = CAIRO_TEST_FAILURE;
+	goto FINISH;
+    }
+
+    /* drawing through one mapping is seen through the other */
+    cr = cairo_create (a);
+    cairo_set_source_rgb (cr, 0, 0, 1);
+    cairo_rectangle (cr, WIDTH / 2, 0, WIDTH / 2, HEIGHT);
+    cairo_fill (cr);
+    cairo_destroy (cr);
+    cairo_surface_flush (a);
+
+    if (get_pixel (b, 90, 10) != 0xff0000ff) {
+	cairo_test_log (ctx, "Error mapping %s: pixels are not shared\n",
+			filename);
+	result = CAIRO_TEST_FAILURE;
+	goto FINISH;
+    }
+
+  FINISH:
+    cairo_surface_destroy (a);
+    cairo_surface_destroy (b);
+    if (result != CAIRO_TEST_SUCCESS)
+	return result;
+
+    surface = cairo_image_surface_create_from_file ("image-file.missing.raw");
+    status = cairo_surface_status (surface);
+    cairo_surface_destroy (surface);
+    if (status != CAIRO_STATUS_FILE_NOT_FOUND) {
+	cairo_test_log (ctx, "Error expected file not found, but got: %s\n",
+			cairo_status_to_string (status));
+	return CAIRO_TEST_FAILURE;
+    }
+
+    return CAIRO_TEST_SUCCESS;
+}
+
+CAIRO_TEST (image_file,
+	    "Check that images mapped from files share their pixels",
+	    "image, api", /* keywords */
+	    NULL, /* requirements */
+	    0, 0,
+	    preamble, NULL)
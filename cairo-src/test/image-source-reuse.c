@@ -0,0 +1,96 @@
+/*
+ * Copyright © 2010 the cairo graphics library authors
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include "cairo-test.h"
+
+/* Paints one atlas many times, with every extend mode and filter and at
+ * both whole and fractional offsets, so that later sprites reuse the
+ * pixman images prepared for the earlier ones.
+ */
+
+#define CELL 40
+#define SPRITES 3
+#define WIDTH (3 * SPRITES * CELL)
+#define HEIGHT (4 * CELL)
+
+static cairo_surface_t *
+create_atlas (void)
+{
+    cairo_surface_t *atlas;
+    cairo_t *cr;
+
+    atlas = cairo_image_surface_create (CAIRO_FORMAT_ARGB32, 32, 32);
+    cr = cairo_create (atlas);
+    cairo_set_source_rgb (cr, 1, 0, 0);
+    cairo_paint (cr);
+    cairo_set_source_rgba (cr, 0, 0, 1, .7);
+    cairo_rectangle (cr, 4, 4, 15, 10);
+    cairo_fill (cr);
+    cairo_set_source_rgb (cr, 0, 1, 0);
+    cairo_arc (cr, 20, 20, 8, 0, 2 * M_PI);
+    cairo_fill (cr);
+    cairo_destroy (cr);
+
+    return atlas;
+}
+
+static cairo_test_status_t
+draw (cairo_t *cr, int width, int height)
+{
+    static const cairo_filter_t filters[] = {
+	CAIRO_FILTER_NEAREST, CAIRO_FILTER_BILINEAR, CAIRO_FILTER_GOOD
+    };
+    cairo_surface_t *atlas;
+    int extend, filter, n;
+
+    cairo_set_source_rgb (cr, 1, 1, 1);
+    cairo_paint (cr);
+
+    atlas = create_atlas ();
+    for (extend = 0; extend < 4; extend++) {
+	for (filter = 0; filter < 3; filter++) {
+	    for (n = 0; n < SPRITES; n++) {
+		double x = (filter * SPRITES + n) * CELL + 10 + (n ? .5 : 0);
+		double y = extend * CELL + 10 + (n == 2 ? .25 : 0);
+
+		cairo_set_source_surface (cr, atlas, x - 3 * n, y - 2 * n);
+		cairo_pattern_set_extend (cairo_get_source (cr), extend);
+		cairo_pattern_set_filter (cairo_get_source (cr), filters[filter]);
+		cairo_rectangle (cr, x - 6, y - 6, CELL - 8, CELL - 8);
+		cairo_fill (cr);
+	    }
+	}
+    }
+    cairo_surface_destroy (atlas);
+
+    return CAIRO_TEST_SUCCESS;
+}
+
+CAIRO_TEST (image_source_reuse,
+	    "Paint an image at many offsets with every extend and filter",
+	    "extend, filter", /* keywords */
+	    NULL, /* requirements */
+	    WIDTH, HEIGHT,
+	    NULL, draw)
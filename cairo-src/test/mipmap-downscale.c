@@ -0,0 +1,107 @@
+/*
+ * Copyright © 2010 the cairo graphics library authors
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include "cairo-test.h"
+
+/* Paints a fine pattern reduced eight times with CAIRO_FILTER_MIPMAP,
+ * modifies the source and paints it again to check that the cached
+ * reductions follow the changes.
+ */
+
+#define SRC_SIZE 256
+#define SIZE 32
+
+static cairo_surface_t *
+create_source (void)
+{
+    cairo_surface_t *image;
+    cairo_t *cr;
+    int i;
+
+    image = cairo_image_surface_create (CAIRO_FORMAT_ARGB32,
+					SRC_SIZE, SRC_SIZE);
+    cr = cairo_create (image);
+    cairo_set_source_rgb (cr, 1, 1, 1);
+    cairo_paint (cr);
+
+    cairo_set_source_rgb (cr, 0, 0, 1);
+    for (i = 0; i < SRC_SIZE; i += 4)
+	cairo_rectangle (cr, i, 0, 2, SRC_SIZE);
+    cairo_fill (cr);
+
+    cairo_set_source_rgba (cr, 1, 0, 0, .5);
+    cairo_arc (cr, SRC_SIZE / 2, SRC_SIZE / 2, SRC_SIZE / 3, 0, 2 * M_PI);
+    cairo_fill (cr);
+    cairo_destroy (cr);
+
+    return image;
+}
+
+static void
+paint_reduced (cairo_t *cr, cairo_surface_t *image, int x)
+{
+    cairo_pattern_t *pattern;
+    cairo_matrix_t matrix;
+
+    pattern = cairo_pattern_create_for_surface (image);
+    cairo_pattern_set_filter (pattern, CAIRO_FILTER_MIPMAP);
+    cairo_matrix_init_scale (&matrix, SRC_SIZE / SIZE, SRC_SIZE / SIZE);
+    cairo_matrix_translate (&matrix, -x, 0);
+    cairo_pattern_set_matrix (pattern, &matrix);
+
+    cairo_set_source (cr, pattern);
+    cairo_rectangle (cr, x, 0, SIZE, SIZE);
+    cairo_fill (cr);
+    cairo_pattern_destroy (pattern);
+}
+
+static cairo_test_status_t
+draw (cairo_t *cr, int width, int height)
+{
+    cairo_surface_t *image;
+    cairo_t *cr2;
+
+    image = create_source ();
+    paint_reduced (cr, image, 0);
+
+    cr2 = cairo_create (image);
+    cairo_set_source_rgb (cr2, 0, 1, 0);
+    cairo_rectangle (cr2, 0, 0, SRC_SIZE / 2, SRC_SIZE / 2);
+    cairo_fill (cr2);
+    cairo_destroy (cr2);
+
+    paint_reduced (cr, image, SIZE);
+
+    cairo_surface_destroy (image);
+
+    return CAIRO_TEST_SUCCESS;
+}
+
+CAIRO_TEST (mipmap_downscale,
+	    "Paint an image reduced with CAIRO_FILTER_MIPMAP, before and after modifying it",
+	    "filter, transform", /* keywords */
+	    NULL, /* requirements */
+	    2 * SIZE, SIZE,
+	    NULL, draw)
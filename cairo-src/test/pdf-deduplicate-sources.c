@@ -0,0 +1,204 @@
+/*
+ * Copyright © 2010 the cairo graphics library authors
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include "cairo-test.h"
+
+#include <cairo-pdf.h>
+
+/* Draws, on each page, an image and a recording surface created anew
+ * with the same contents, and counts the image and form XObjects
+ * embedded with and without deduplication of the sources.
+ */
+
+#define PAGES 3
+#define SIZE 32
+
+typedef struct _output {
+    char *data;
+    unsigned int length;
+} output_t;
+
+static cairo_status_t
+write_func (void *closure, const unsigned char *data, unsigned int length)
+{
+    output_t *output = closure;
+    char *new_data;
+
+    new_data = realloc (output->data, output->length + length);
+    if (new_data == NULL)
+	return CAIRO_STATUS_NO_MEMORY;
+
+    memcpy (new_data + output->length, data, length);
+    output->length += length;
+    output->data = new_data;
+
+    return CAIRO_STATUS_SUCCESS;
+}
+
+/* the output holds binary streams, so cannot be searched as a string */
+static int
+count (const output_t *output, const char *needle)
+{
+    unsigned int len = strlen (needle);
+    unsigned int i;
+    int n = 0;
+
+    for (i = 0; i + len <= output->length; i++) {
+	if (memcmp (output->data + i, needle, len) == 0)
+	    n++;
+    }
+
+    return n;
+}
+
+static cairo_surface_t *
+create_image (void)
+{
+    cairo_surface_t *image;
+    uint32_t *data;
+    int x, y, stride;
+
+    image = cairo_image_surface_create (CAIRO_FORMAT_RGB24, SIZE, SIZE);
+    cairo_surface_flush (image);
+    data = (uint32_t *) cairo_image_surface_get_data (image);
+    stride = cairo_image_surface_get_stride (image) / 4;
+    for (y = 0; y < SIZE; y++)
+	for (x = 0; x < SIZE; x++)
+	    data[y * stride + x] = (x * 8) << 16 | (y * 8) << 8 | (x ^ y);
+    cairo_surface_mark_dirty (image);
+
+    return image;
+}
+
+static cairo_surface_t *
+create_recording (void)
+{
+    cairo_rectangle_t extents = { 0, 0, SIZE, SIZE };
+    cairo_surface_t *recording;
+    cairo_t *cr;
+
+    recording = cairo_recording_surface_create (CAIRO_CONTENT_COLOR_ALPHA,
+						&extents);
+    cr = cairo_create (recording);
+    cairo_set_source_rgb (cr, 0, 0, 1);
+    cairo_arc (cr, SIZE / 2, SIZE / 2, SIZE / 3, 0, 2 * M_PI);
+    cairo_fill (cr);
+    cairo_set_source_rgb (cr, 1, 1, 0);
+    cairo_move_to (cr, 4, SIZE - 4);
+    cairo_set_font_size (cr, 12);
+    cairo_show_text (cr, "cairo");
+    cairo_destroy (cr);
+
+    return recording;
+}
+
+static cairo_status_t
+draw_pages (output_t *output, cairo_bool_t deduplicate)
+{
+    cairo_surface_t *surface, *source;
+    cairo_status_t status;
+    cairo_t *cr;
+    int page;
+
+    surface = cairo_pdf_surface_create_for_stream (write_func, output,
+						   2 * SIZE, SIZE);
+    cairo_pdf_surface_set_deduplicate_sources (surface, deduplicate);
+
+    cr = cairo_create (surface);
+    for (page = 0; page < PAGES; page++) {
+	source = create_image ();
+	cairo_set_source_surface (cr, source, 0, 0);
+	cairo_paint (cr);
+	cairo_surface_destroy (source);
+
+	source = create_recording ();
+	cairo_set_source_surface (cr, source, SIZE, 0);
+	cairo_paint (cr);
+	cairo_surface_destroy (source);
+
+	cairo_show_page (cr);
+    }
+    status = cairo_status (cr);
+    cairo_destroy (cr);
+
+    cairo_surface_finish (surface);
+    if (status == CAIRO_STATUS_SUCCESS)
+	status = cairo_surface_status (surface);
+    cairo_surface_destroy (surface);
+
+    return status;
+}
+
+static cairo_test_status_t
+preamble (cairo_test_context_t *ctx)
+{
+    output_t plain = { NULL, 0 }, deduplicated = { NULL, 0 };
+    cairo_test_status_t result = CAIRO_TEST_SUCCESS;
+    cairo_status_t status;
+    int images[2], forms[2];
+
+    if (! cairo_test_is_target_enabled (ctx, "pdf"))
+	return CAIRO_TEST_UNTESTED;
+
+    status = draw_pages (&plain, FALSE);
+    if (status == CAIRO_STATUS_SUCCESS)
+	status = draw_pages (&deduplicated, TRUE);
+    if (status) {
+	cairo_test_log (ctx, "Failed to create pdf output: %s\n",
+			cairo_status_to_string (status));
+	result = CAIRO_TEST_FAILURE;
+	goto CLEANUP;
+    }
+
+    images[0] = count (&plain, "/Subtype /Image");
+    images[1] = count (&deduplicated, "/Subtype /Image");
+    forms[0] = count (&plain, "/Subtype /Form");
+    forms[1] = count (&deduplicated, "/Subtype /Form");
+
+    if (images[0] != PAGES || images[1] != 1) {
+	cairo_test_log (ctx, "Expected %d and 1 images, found %d and %d\n",
+			PAGES, images[0], images[1]);
+	result = CAIRO_TEST_FAILURE;
+    }
+
+    if (forms[0] - forms[1] != PAGES - 1) {
+	cairo_test_log (ctx, "Expected %d fewer forms, found %d and %d\n",
+			PAGES - 1, forms[0], forms[1]);
+	result = CAIRO_TEST_FAILURE;
+    }
+
+CLEANUP:
+    free (plain.data);
+    free (deduplicated.data);
+
+    return result;
+}
+
+CAIRO_TEST (pdf_deduplicate_sources,
+	    "Check that identical sources are embedded once by the PDF surface",
+	    "pdf", /* keywords */
+	    NULL, /* requirements */
+	    0, 0,
+	    preamble, NULL)
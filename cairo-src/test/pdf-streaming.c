@@ -0,0 +1,182 @@
+/*
+ * Copyright © 2010 the cairo graphics library authors
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include "cairo-test.h"
+
+#include <cairo-pdf.h>
+
+/* Draws the same text and image on every page, and counts the fonts
+ * and images embedded with and without streaming, which embeds them
+ * once for each chunk of pages instead of once for the document.
+ */
+
+#define PAGES 6
+#define PAGES_PER_CHUNK 2
+#define SIZE 32
+
+typedef struct _output {
+    char *data;
+    unsigned int length;
+} output_t;
+
+static cairo_status_t
+write_func (void *closure, const unsigned char *data, unsigned int length)
+{
+    output_t *output = closure;
+    char *new_data;
+
+    new_data = realloc (output->data, output->length + length);
+    if (new_data == NULL)
+	return CAIRO_STATUS_NO_MEMORY;
+
+    memcpy (new_data + output->length, data, length);
+    output->length += length;
+    output->data = new_data;
+
+    return CAIRO_STATUS_SUCCESS;
+}
+
+/* the output holds binary streams, so cannot be searched as a string */
+static int
+count (const output_t *output, const char *needle)
+{
+    unsigned int len = strlen (needle);
+    unsigned int i;
+    int n = 0;
+
+    for (i = 0; i + len <= output->length; i++) {
+	if (memcmp (output->data + i, needle, len) == 0)
+	    n++;
+    }
+
+    return n;
+}
+
+static cairo_status_t
+draw_pages (output_t *output, int pages_per_chunk)
+{
+    cairo_surface_t *surface, *image;
+    cairo_status_t status;
+    cairo_t *cr;
+    int page;
+
+    image = cairo_image_surface_create (CAIRO_FORMAT_RGB24, SIZE, SIZE);
+    cr = cairo_create (image);
+    cairo_set_source_rgb (cr, 0, 0, 1);
+    cairo_paint (cr);
+    cairo_set_source_rgb (cr, 1, 1, 0);
+    cairo_arc (cr, SIZE / 2, SIZE / 2, SIZE / 3, 0, 2 * M_PI);
+    cairo_fill (cr);
+    cairo_destroy (cr);
+
+    surface = cairo_pdf_surface_create_for_stream (write_func, output,
+						   4 * SIZE, SIZE);
+    cairo_pdf_surface_set_streaming (surface, pages_per_chunk);
+
+    cr = cairo_create (surface);
+    for (page = 0; page < PAGES; page++) {
+	cairo_set_source_surface (cr, image, 0, 0);
+	cairo_paint (cr);
+
+	cairo_set_source_rgb (cr, 0, 0, 0);
+	cairo_select_font_face (cr, CAIRO_TEST_FONT_FAMILY " Sans",
+				CAIRO_FONT_SLANT_NORMAL,
+				CAIRO_FONT_WEIGHT_NORMAL);
+	cairo_set_font_size (cr, 12);
+	cairo_move_to (cr, SIZE + 4, SIZE - 4);
+	cairo_show_text (cr, "cairo");
+
+	cairo_show_page (cr);
+    }
+    status = cairo_status (cr);
+    cairo_destroy (cr);
+
+    cairo_surface_finish (surface);
+    if (status == CAIRO_STATUS_SUCCESS)
+	status = cairo_surface_status (surface);
+    cairo_surface_destroy (surface);
+
+    cairo_surface_destroy (image);
+
+    return status;
+}
+
+static cairo_test_status_t
+preamble (cairo_test_context_t *ctx)
+{
+    output_t whole = { NULL, 0 }, streamed = { NULL, 0 };
+    cairo_test_status_t result = CAIRO_TEST_SUCCESS;
+    cairo_status_t status;
+    int fonts[2], images[2], pages;
+
+    if (! cairo_test_is_target_enabled (ctx, "pdf"))
+	return CAIRO_TEST_UNTESTED;
+
+    status = draw_pages (&whole, 0);
+    if (status == CAIRO_STATUS_SUCCESS)
+	status = draw_pages (&streamed, PAGES_PER_CHUNK);
+    if (status) {
+	cairo_test_log (ctx, "Failed to create pdf output: %s\n",
+			cairo_status_to_string (status));
+	result = CAIRO_TEST_FAILURE;
+	goto CLEANUP;
+    }
+
+    pages = count (&streamed, "/Type /Page\n");
+    if (pages != PAGES) {
+	cairo_test_log (ctx, "Expected %d pages, found %d\n", PAGES, pages);
+	result = CAIRO_TEST_FAILURE;
+    }
+
+    fonts[0] = count (&whole, "/Type /Font\n");
+    fonts[1] = count (&streamed, "/Type /Font\n");
+    images[0] = count (&whole, "/Subtype /Image");
+    images[1] = count (&streamed, "/Subtype /Image");
+
+    if (fonts[0] == 0 || fonts[1] != fonts[0] * PAGES / PAGES_PER_CHUNK) {
+	cairo_test_log (ctx, "Expected %d chunks of fonts, found %d and %d\n",
+			PAGES / PAGES_PER_CHUNK, fonts[0], fonts[1]);
+	result = CAIRO_TEST_FAILURE;
+    }
+
+    if (images[0] != 1 || images[1] != PAGES / PAGES_PER_CHUNK) {
+	cairo_test_log (ctx, "Expected 1 and %d images, found %d and %d\n",
+			PAGES / PAGES_PER_CHUNK, images[0], images[1]);
+	result = CAIRO_TEST_FAILURE;
+    }
+
+CLEANUP:
+    free (whole.data);
+    free (streamed.data);
+
+    return result;
+}
+
+CAIRO_TEST (pdf_streaming,
+	    "Check that a streaming PDF surface embeds resources for each chunk of pages",
+	    "pdf", /* keywords */
+	    NULL, /* requirements */
+	    0, 0,
+	    preamble, NULL)
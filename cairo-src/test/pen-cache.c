@@ -0,0 +1,83 @@
+/*
+ * Copyright © 2010 the cairo graphics library authors
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include "cairo-test.h"
+
+/* Strokes the same curve with more distinct line widths and
+ * transformations than the pen cache holds, twice over, so that the
+ * second row reuses or recomputes evicted pens. Both rows must match.
+ */
+
+#define NUM_PENS 12
+#define CELL 30
+#define WIDTH (NUM_PENS * CELL)
+#define HEIGHT (2 * CELL)
+
+static void
+stroke_cell (cairo_t *cr, int n)
+{
+    cairo_save (cr);
+    cairo_translate (cr, CELL / 2., CELL / 2.);
+    cairo_scale (cr, 1., 1. + (n % 2) / 2.);
+    cairo_rotate (cr, n * M_PI / NUM_PENS);
+
+    cairo_move_to (cr, -6, 3);
+    cairo_curve_to (cr, -6, -6, 6, 6, 6, -3);
+    cairo_restore (cr);
+
+    cairo_set_line_width (cr, 1. + n / 3.);
+    cairo_stroke (cr);
+}
+
+static cairo_test_status_t
+draw (cairo_t *cr, int width, int height)
+{
+    int row, n;
+
+    cairo_set_source_rgb (cr, 1, 1, 1);
+    cairo_paint (cr);
+
+    cairo_set_source_rgb (cr, 0, 0, 0);
+    cairo_set_line_cap (cr, CAIRO_LINE_CAP_ROUND);
+    cairo_set_line_join (cr, CAIRO_LINE_JOIN_ROUND);
+
+    for (row = 0; row < 2; row++) {
+	for (n = 0; n < NUM_PENS; n++) {
+	    cairo_save (cr);
+	    cairo_translate (cr, n * CELL, row * CELL);
+	    stroke_cell (cr, n);
+	    cairo_restore (cr);
+	}
+    }
+
+    return CAIRO_TEST_SUCCESS;
+}
+
+CAIRO_TEST (pen_cache,
+	    "Reuse and evict cached pens across strokes",
+	    "stroke", /* keywords */
+	    NULL, /* requirements */
+	    WIDTH, HEIGHT,
+	    NULL, draw)
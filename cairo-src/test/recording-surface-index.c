@@ -0,0 +1,89 @@
+/*
+ * Copyright © 2010 the cairo graphics library authors
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include "cairo-test.h"
+
+/* Records enough operations, some of them falling outside the extents
+ * of the recording surface, for the replay to cull the commands through
+ * the spatial index rather than walking the list.
+ */
+
+#define SIZE 120
+#define STEP 10
+
+static cairo_test_status_t
+draw (cairo_t *cr, int width, int height)
+{
+    cairo_rectangle_t extents = { -20, -20, SIZE - 20, SIZE - 20 };
+    cairo_surface_t *recording;
+    cairo_t *cr2;
+    int x, y;
+
+    recording = cairo_recording_surface_create (CAIRO_CONTENT_COLOR_ALPHA,
+						&extents);
+    cr2 = cairo_create (recording);
+
+    for (y = -30; y < SIZE; y += STEP) {
+	for (x = -30; x < SIZE; x += STEP) {
+	    cairo_set_source_rgb (cr2,
+				  (x + 30) / (double) (SIZE + 30),
+				  (y + 30) / (double) (SIZE + 30),
+				  0.5);
+	    if ((x + y) / STEP & 1) {
+		cairo_arc (cr2, x + STEP / 2, y + STEP / 2, STEP / 3, 0, 2 * M_PI);
+		cairo_fill (cr2);
+	    } else {
+		cairo_rectangle (cr2, x + 2, y + 2, STEP - 4, STEP - 4);
+		cairo_stroke (cr2);
+	    }
+	}
+    }
+
+    /* an unbounded operation restricted only by its clip */
+    cairo_rectangle (cr2, 30, 30, 20, 20);
+    cairo_clip (cr2);
+    cairo_set_operator (cr2, CAIRO_OPERATOR_SOURCE);
+    cairo_set_source_rgba (cr2, 0, 0, 1, 0.5);
+    cairo_paint (cr2);
+
+    cairo_destroy (cr2);
+
+    cairo_set_source_rgb (cr, 1, 1, 1);
+    cairo_paint (cr);
+
+    cairo_set_source_surface (cr, recording, 20, 20);
+    cairo_paint (cr);
+
+    cairo_surface_destroy (recording);
+
+    return CAIRO_TEST_SUCCESS;
+}
+
+CAIRO_TEST (recording_surface_index,
+	    "Replay a recording surface with more commands than fit its extents",
+	    "recording", /* keywords */
+	    NULL, /* requirements */
+	    SIZE, SIZE,
+	    NULL, draw)
@@ -0,0 +1,75 @@
+/*
+ * Copyright © 2010 the cairo graphics library authors
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include "cairo-test.h"
+
+/* Records a fill of a path with many more segments than fit in a path
+ * buffer onto a recording surface with an offset origin, so that the
+ * replay copies the recorded path to apply the device offset.
+ */
+
+#define SIZE 200
+#define NUM_SEGMENTS 400
+
+static cairo_test_status_t
+draw (cairo_t *cr, int width, int height)
+{
+    cairo_rectangle_t extents = { 10, 10, SIZE, SIZE };
+    cairo_surface_t *recording;
+    cairo_t *cr2;
+    int n;
+
+    cairo_set_source_rgb (cr, 1, 1, 1);
+    cairo_paint (cr);
+
+    recording = cairo_recording_surface_create (CAIRO_CONTENT_COLOR_ALPHA,
+						&extents);
+    cr2 = cairo_create (recording);
+    cairo_set_source_rgb (cr2, 0, 0, 1);
+    for (n = 0; n < NUM_SEGMENTS; n++) {
+	double theta = 2 * M_PI * n / NUM_SEGMENTS;
+	double r = n & 1 ? 60 : 90;
+
+	cairo_line_to (cr2,
+		       110 + r * cos (theta),
+		       110 + r * sin (theta));
+    }
+    cairo_close_path (cr2);
+    cairo_fill (cr2);
+    cairo_destroy (cr2);
+
+    cairo_set_source_surface (cr, recording, -10, -10);
+    cairo_paint (cr);
+    cairo_surface_destroy (recording);
+
+    return CAIRO_TEST_SUCCESS;
+}
+
+CAIRO_TEST (recording_surface_large_path,
+	    "Replay a path longer than a path buffer through a device offset",
+	    "recording", /* keywords */
+	    NULL, /* requirements */
+	    SIZE, SIZE,
+	    NULL, draw)
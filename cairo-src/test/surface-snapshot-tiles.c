@@ -0,0 +1,104 @@
+/*
+ * Copyright © 2010 the cairo graphics library authors
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+
+#include "cairo-test.h"
+
+/* Takes snapshots of an image, by recording it as a source, in between
+ * drawing to parts of it. Each snapshot must keep showing the image as
+ * it was, whether its tiles were saved or are still shared.
+ */
+
+#define SIZE 100
+
+static cairo_surface_t *
+snapshot (cairo_surface_t *image)
+{
+    cairo_rectangle_t extents = { 0, 0, SIZE, SIZE };
+    cairo_surface_t *recording;
+    cairo_t *cr;
+
+    recording = cairo_recording_surface_create (CAIRO_CONTENT_COLOR_ALPHA,
+						&extents);
+    cr = cairo_create (recording);
+    cairo_set_source_surface (cr, image, 0, 0);
+    cairo_paint (cr);
+    cairo_destroy (cr);
+
+    return recording;
+}
+
+static cairo_test_status_t
+draw (cairo_t *cr, int width, int height)
+{
+    cairo_surface_t *image, *before, *between;
+    cairo_t *cr2;
+    int x, y;
+
+    image = cairo_image_surface_create (CAIRO_FORMAT_RGB24, SIZE, SIZE);
+    cr2 = cairo_create (image);
+    for (y = 0; y < SIZE; y += 10) {
+	for (x = 0; x < SIZE; x += 10) {
+	    cairo_set_source_rgb (cr2, x / (double) SIZE, y / (double) SIZE, 0.5);
+	    cairo_rectangle (cr2, x, y, 10, 10);
+	    cairo_fill (cr2);
+	}
+    }
+
+    before = snapshot (image);
+
+    cairo_set_source_rgb (cr2, 1, 1, 1);
+    cairo_rectangle (cr2, 10, 10, 30, 30);
+    cairo_fill (cr2);
+
+    between = snapshot (image);
+
+    cairo_set_source_rgb (cr2, 0, 0, 0);
+    cairo_set_line_width (cr2, 8);
+    cairo_move_to (cr2, 20, 80);
+    cairo_line_to (cr2, 80, 20);
+    cairo_stroke (cr2);
+    cairo_destroy (cr2);
+
+    cairo_set_source_surface (cr, before, 0, 0);
+    cairo_paint (cr);
+    cairo_set_source_surface (cr, between, SIZE, 0);
+    cairo_paint (cr);
+    cairo_set_source_surface (cr, image, 2 * SIZE, 0);
+    cairo_paint (cr);
+
+    cairo_surface_destroy (before);
+    cairo_surface_destroy (between);
+    cairo_surface_destroy (image);
+
+    return CAIRO_TEST_SUCCESS;
+}
+
+CAIRO_TEST (surface_snapshot_tiles,
+	    "Check that snapshots of an image survive partial changes to it",
+	    "snapshot", /* keywords */
+	    NULL, /* requirements */
+	    3 * SIZE, SIZE,
+	    NULL, draw)
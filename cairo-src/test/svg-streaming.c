@@ -0,0 +1,231 @@
+/*
+ * Copyright © 2010 the cairo graphics library authors
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include "cairo-test.h"
+
+#include <cairo-svg.h>
+
+/* Draws the same gradient, clip, text and image on every page of a
+ * SVG 1.2 document. Each of them should be defined only once, and with
+ * streaming the earlier pages should be written out before the surface
+ * is finished.
+ */
+
+#define PAGES 4
+#define SIZE 32
+
+#define ARRAY_LENGTH(array) (sizeof (array) / sizeof ((array)[0]))
+
+typedef struct _output {
+    char *data;
+    unsigned int length;
+} output_t;
+
+static cairo_status_t
+write_func (void *closure, const unsigned char *data, unsigned int length)
+{
+    output_t *output = closure;
+    char *new_data;
+
+    new_data = realloc (output->data, output->length + length);
+    if (new_data == NULL)
+	return CAIRO_STATUS_NO_MEMORY;
+
+    memcpy (new_data + output->length, data, length);
+    output->length += length;
+    output->data = new_data;
+
+    return CAIRO_STATUS_SUCCESS;
+}
+
+static int
+count (const output_t *output, const char *needle)
+{
+    unsigned int len = strlen (needle);
+    unsigned int i;
+    int n = 0;
+
+    for (i = 0; i + len <= output->length; i++) {
+	if (memcmp (output->data + i, needle, len) == 0)
+	    n++;
+    }
+
+    return n;
+}
+
+static cairo_surface_t *
+create_image (void)
+{
+    cairo_surface_t *image;
+    cairo_t *cr;
+
+    image = cairo_image_surface_create (CAIRO_FORMAT_RGB24, SIZE, SIZE);
+    cr = cairo_create (image);
+    cairo_set_source_rgb (cr, 0, 0, 1);
+    cairo_paint (cr);
+    cairo_set_source_rgb (cr, 1, 1, 0);
+    cairo_arc (cr, SIZE / 2, SIZE / 2, SIZE / 3, 0, 2 * M_PI);
+    cairo_fill (cr);
+    cairo_destroy (cr);
+
+    return image;
+}
+
+static cairo_status_t
+draw_pages (output_t *output, cairo_bool_t streaming,
+	    unsigned int *length_before_finish)
+{
+    cairo_surface_t *surface, *image;
+    cairo_pattern_t *gradient;
+    cairo_status_t status;
+    cairo_t *cr;
+    int page;
+
+    surface = cairo_svg_surface_create_for_stream (write_func, output,
+						   4 * SIZE, SIZE);
+    cairo_svg_surface_restrict_to_version (surface, CAIRO_SVG_VERSION_1_2);
+    cairo_svg_surface_set_streaming (surface, streaming);
+
+    cr = cairo_create (surface);
+    for (page = 0; page < PAGES; page++) {
+	/* a new, but identical, image and gradient on each page */
+	image = create_image ();
+	cairo_set_source_surface (cr, image, 0, 0);
+	cairo_paint (cr);
+	cairo_surface_destroy (image);
+
+	gradient = cairo_pattern_create_linear (SIZE, 0, 2 * SIZE, 0);
+	cairo_pattern_add_color_stop_rgb (gradient, 0, 1, 0, 0);
+	cairo_pattern_add_color_stop_rgb (gradient, 1, 0, 1, 0);
+	cairo_set_source (cr, gradient);
+	cairo_pattern_destroy (gradient);
+
+	cairo_save (cr);
+	cairo_new_path (cr);
+	cairo_arc (cr, 1.5 * SIZE, SIZE / 2, SIZE / 3, 0, 2 * M_PI);
+	cairo_clip (cr);
+	cairo_paint (cr);
+	cairo_restore (cr);
+
+	cairo_set_source_rgb (cr, 0, 0, 0);
+	cairo_select_font_face (cr, CAIRO_TEST_FONT_FAMILY " Sans",
+				CAIRO_FONT_SLANT_NORMAL,
+				CAIRO_FONT_WEIGHT_NORMAL);
+	cairo_set_font_size (cr, 12);
+	cairo_move_to (cr, 2 * SIZE + 4, SIZE - 4);
+	cairo_show_text (cr, "cairo");
+
+	cairo_show_page (cr);
+    }
+    status = cairo_status (cr);
+    cairo_destroy (cr);
+
+    *length_before_finish = output->length;
+
+    cairo_surface_finish (surface);
+    if (status == CAIRO_STATUS_SUCCESS)
+	status = cairo_surface_status (surface);
+    cairo_surface_destroy (surface);
+
+    return status;
+}
+
+static cairo_test_status_t
+check_output (cairo_test_context_t *ctx, const output_t *output,
+	      const char *name)
+{
+    cairo_test_status_t result = CAIRO_TEST_SUCCESS;
+    struct {
+	const char *element;
+	int expected;
+    } defs[] = {
+	{ "<page>", PAGES },
+	{ "<image ", 1 },
+	{ "<linearGradient ", 1 },
+	{ "<clipPath ", 1 },
+	{ "<symbol ", 5 },
+    };
+    unsigned int i;
+    int n;
+
+    for (i = 0; i < (unsigned int) ARRAY_LENGTH (defs); i++) {
+	n = count (output, defs[i].element);
+	if (n != defs[i].expected) {
+	    cairo_test_log (ctx, "Expected %d %s in %s output, found %d\n",
+			    defs[i].expected, defs[i].element, name, n);
+	    result = CAIRO_TEST_FAILURE;
+	}
+    }
+
+    return result;
+}
+
+static cairo_test_status_t
+preamble (cairo_test_context_t *ctx)
+{
+    output_t whole = { NULL, 0 }, streamed = { NULL, 0 };
+    unsigned int whole_length, streamed_length;
+    cairo_test_status_t result = CAIRO_TEST_SUCCESS;
+    cairo_status_t status;
+
+    if (! cairo_test_is_target_enabled (ctx, "svg12"))
+	return CAIRO_TEST_UNTESTED;
+
+    status = draw_pages (&whole, FALSE, &whole_length);
+    if (status == CAIRO_STATUS_SUCCESS)
+	status = draw_pages (&streamed, TRUE, &streamed_length);
+    if (status) {
+	cairo_test_log (ctx, "Failed to create svg output: %s\n",
+			cairo_status_to_string (status));
+	result = CAIRO_TEST_FAILURE;
+	goto CLEANUP;
+    }
+
+    if (check_output (ctx, &whole, "whole") != CAIRO_TEST_SUCCESS)
+	result = CAIRO_TEST_FAILURE;
+    if (check_output (ctx, &streamed, "streamed") != CAIRO_TEST_SUCCESS)
+	result = CAIRO_TEST_FAILURE;
+
+    if (whole_length != 0 || streamed_length == 0) {
+	cairo_test_log (ctx,
+			"Expected output before finishing only when streaming, "
+			"found %u and %u bytes\n",
+			whole_length, streamed_length);
+	result = CAIRO_TEST_FAILURE;
+    }
+
+CLEANUP:
+    free (whole.data);
+    free (streamed.data);
+
+    return result;
+}
+
+CAIRO_TEST (svg_streaming,
+	    "Check that SVG definitions are shared, and pages written out while streaming",
+	    "svg", /* keywords */
+	    NULL, /* requirements */
+	    0, 0,
+	    preamble, NULL)
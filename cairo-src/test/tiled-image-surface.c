@@ -0,0 +1,94 @@
+/*
+ * Copyright © 2010 the cairo graphics library authors
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include "cairo-test.h"
+
+/* Draws onto a tiled image surface across the boundaries of its tiles,
+ * mixing solid fills that replace whole tiles with antialiased shapes,
+ * and then uses it as a source both with and without repeating.
+ */
+
+#define SIZE 300
+
+static cairo_test_status_t
+draw (cairo_t *cr, int width, int height)
+{
+    cairo_surface_t *tiled;
+    cairo_t *cr2;
+    int i;
+
+    tiled = cairo_tiled_image_surface_create (CAIRO_FORMAT_ARGB32, 2 * SIZE, SIZE);
+    cr2 = cairo_create (tiled);
+
+    cairo_set_source_rgb (cr2, 0.9, 0.9, 0.8);
+    cairo_paint (cr2);
+
+    /* covers the first tile entirely and the next ones only in part */
+    cairo_rectangle (cr2, 0, 0, 384, 288);
+    cairo_set_source_rgb (cr2, 0.2, 0.6, 0.2);
+    cairo_fill (cr2);
+
+    for (i = 0; i < 8; i++) {
+	cairo_arc (cr2, 200 + 40 * i, 150 + 20 * (i & 1), 50, 0, 2 * M_PI);
+	cairo_set_source_rgba (cr2, i / 8., 0.2, 1 - i / 8., 0.6);
+	cairo_fill_preserve (cr2);
+	cairo_set_source_rgb (cr2, 0, 0, 0);
+	cairo_set_line_width (cr2, 3);
+	cairo_stroke (cr2);
+    }
+
+    cairo_save (cr2);
+    cairo_rectangle (cr2, 240, 20, 40, 260);
+    cairo_clip (cr2);
+    cairo_set_operator (cr2, CAIRO_OPERATOR_CLEAR);
+    cairo_paint (cr2);
+    cairo_restore (cr2);
+
+    cairo_destroy (cr2);
+
+    cairo_set_source_rgb (cr, 1, 1, 1);
+    cairo_paint (cr);
+
+    cairo_set_source_surface (cr, tiled, -150, 0);
+    cairo_rectangle (cr, 0, 0, SIZE / 2, SIZE);
+    cairo_fill (cr);
+
+    /* straddles the right edge of the tiled surface */
+    cairo_set_source_surface (cr, tiled, -350, 20);
+    cairo_pattern_set_extend (cairo_get_source (cr), CAIRO_EXTEND_REPEAT);
+    cairo_rectangle (cr, SIZE / 2, 0, SIZE / 2, SIZE);
+    cairo_fill (cr);
+
+    cairo_surface_destroy (tiled);
+
+    return CAIRO_TEST_SUCCESS;
+}
+
+CAIRO_TEST (tiled_image_surface,
+	    "Check drawing onto and sampling from a tiled image surface",
+	    "image", /* keywords */
+	    NULL, /* requirements */
+	    SIZE, SIZE,
+	    NULL, draw)
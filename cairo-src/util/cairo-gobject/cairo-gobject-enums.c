@@ -131,6 +131,7 @@ cairo_gobject_antialias_get_type (void)
           { CAIRO_ANTIALIAS_NONE, "CAIRO_ANTIALIAS_NONE", "none" },
           { CAIRO_ANTIALIAS_GRAY, "CAIRO_ANTIALIAS_GRAY", "gray" },
           { CAIRO_ANTIALIAS_SUBPIXEL, "CAIRO_ANTIALIAS_SUBPIXEL", "subpixel" },
+          { CAIRO_ANTIALIAS_FAST, "CAIRO_ANTIALIAS_FAST", "fast" },
           { 0, NULL, NULL }
       };
       GType type = g_enum_register_static (g_intern_static_string ("cairo_antialias_t"), values);
@@ -471,6 +472,7 @@ cairo_gobject_filter_get_type (void)
           { CAIRO_FILTER_NEAREST, "CAIRO_FILTER_NEAREST", "nearest" },
           { CAIRO_FILTER_BILINEAR, "CAIRO_FILTER_BILINEAR", "bilinear" },
           { CAIRO_FILTER_GAUSSIAN, "CAIRO_FILTER_GAUSSIAN", "gaussian" },
+          { CAIRO_FILTER_MIPMAP, "CAIRO_FILTER_MIPMAP", "mipmap" },
           { 0, NULL, NULL }
       };
       GType type = g_enum_register_static (g_intern_static_string ("cairo_filter_t"), values);
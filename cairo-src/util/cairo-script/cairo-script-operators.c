@@ -6181,6 +6181,7 @@ _integer_constants[] = {
     { "ANTIALIAS_NONE",		CAIRO_ANTIALIAS_NONE },
     { "ANTIALIAS_GRAY",		CAIRO_ANTIALIAS_GRAY },
     { "ANTIALIAS_SUBPIXEL",	CAIRO_ANTIALIAS_SUBPIXEL },
+    { "ANTIALIAS_FAST",		CAIRO_ANTIALIAS_FAST },
 
     { "LINE_CAP_BUTT",		CAIRO_LINE_CAP_BUTT },
     { "LINE_CAP_ROUND",		CAIRO_LINE_CAP_ROUND },
@@ -6201,6 +6202,7 @@ _integer_constants[] = {
     { "FILTER_BILINEAR",	CAIRO_FILTER_BILINEAR },
     { "FILTER_NEAREST",		CAIRO_FILTER_NEAREST },
     { "FILTER_GAUSSIAN",	CAIRO_FILTER_GAUSSIAN },
+    { "FILTER_MIPMAP",		CAIRO_FILTER_MIPMAP },
 
     { "SLANT_NORMAL",		CAIRO_FONT_SLANT_NORMAL },
     { "SLANT_ITALIC",		CAIRO_FONT_SLANT_ITALIC },
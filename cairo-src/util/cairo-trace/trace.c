@@ -2245,6 +2245,7 @@ _antialias_to_string (cairo_antialias_t antialias)
 	f(NONE);
 	f(GRAY);
 	f(SUBPIXEL);
+	f(FAST);
     };
 #undef f
     return "UNKNOWN_ANTIALIAS";
@@ -3927,6 +3928,7 @@ _filter_to_string (cairo_filter_t filter)
 	f(NEAREST);
 	f(BILINEAR);
 	f(GAUSSIAN);
+	f(MIPMAP);
     };
 #undef f
     return "UNKNOWN_FILTER";